@@ -24,6 +24,7 @@
 #include "storagefactory.h"
 #include "storagefactoryregistry.h"
 #include "plugin.h"
+#include "storagemigration.h"
 
 #include <Syndication/Constants>
 #include <Syndication/Atom/Atom>
@@ -338,6 +339,43 @@ static Plugin *createFromService(const KService::Ptr &service)
 static void printUsage()
 {
     std::cout << "akregatorstorageexporter [--base64] url" << std::endl;
+    std::cout << "akregatorstorageexporter --migrate backend" << std::endl;
+    std::cout << "akregatorstorageexporter --compact [backend]" << std::endl;
+}
+
+static Storage *createStorage(const QString &backend)
+{
+    const StorageFactory *const storageFactory = StorageFactoryRegistry::self()->getFactory(backend);
+    if (!storageFactory) {
+        qCritical("Could not create storage factory for %s.", qPrintable(backend));
+        return nullptr;
+    }
+
+    Storage *const storage = storageFactory->createStorage(QStringList());
+    if (!storage) {
+        qCritical("Could not create storage object for %s.", qPrintable(backend));
+    }
+    return storage;
+}
+
+/** rewrites the archive files of @p storage without their unused space. Deleted articles are kept,
+    as the archive settings of the feeds are only known to Akregator */
+static bool compact(Storage *storage)
+{
+    if (!storage->open(true)) {
+        return false;
+    }
+
+    Storage::CompactionResult result = { 0, 0, 0 };
+    const QStringList feeds = storage->feeds();
+    for (const QString &url : feeds) {
+        storage->compactArchive(url, 0, result);
+    }
+    storage->compactSharedFiles(result);
+    std::cerr << result.files << " files, " << result.sizeBefore << " -> " << result.sizeAfter << " bytes" << std::endl;
+
+    storage->close();
+    return true;
 }
 }
 
@@ -351,31 +389,68 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    const bool base64 = qstrcmp(argv[1], "--base64") == 0;
+    const bool migration = qstrcmp(argv[1], "--migrate") == 0;
 
-    if (base64 && argc < 3) {
+    if (migration && argc < 3) {
         printUsage();
         return 1;
     }
 
-    const int pos = base64 ? 2 : 1;
-    const QString url = QUrl::fromEncoded(base64 ? QByteArray::fromBase64(argv[pos]) : QByteArray(argv[pos])).toString();
-
     Q_FOREACH (const KService::Ptr &i, queryStoragePlugins()) {
         if (Plugin *const plugin = createFromService(i)) {
             plugin->initialize();
         }
     }
 
-    const StorageFactory *const storageFactory = StorageFactoryRegistry::self()->getFactory(backend);
-    if (!storageFactory) {
-        qCritical("Could not create storage factory for %s.", qPrintable(backend));
+    if (migration) {
+        const QString target = QString::fromLocal8Bit(argv[2]);
+        if (target == backend) {
+            qCritical("The archive is stored with %s already.", qPrintable(backend));
+            return 1;
+        }
+        Storage *const sourceStorage = createStorage(backend);
+        Storage *const targetStorage = sourceStorage ? createStorage(target) : nullptr;
+        if (!targetStorage) {
+            delete sourceStorage;
+            return 1;
+        }
+        const bool ok = migrateStorage(sourceStorage, targetStorage);
+        delete targetStorage;
+        delete sourceStorage;
+        if (!ok) {
+            qCritical("Could not migrate the archive to %s.", qPrintable(target));
+            return 1;
+        }
+        return 0;
+    }
+
+    if (qstrcmp(argv[1], "--compact") == 0) {
+        const QString name = argc > 2 ? QString::fromLocal8Bit(argv[2]) : backend;
+        Storage *const storage = createStorage(name);
+        if (!storage) {
+            return 1;
+        }
+        const bool ok = compact(storage);
+        delete storage;
+        if (!ok) {
+            qCritical("Could not compact the archive of %s.", qPrintable(name));
+            return 1;
+        }
+        return 0;
+    }
+
+    const bool base64 = qstrcmp(argv[1], "--base64") == 0;
+
+    if (base64 && argc < 3) {
+        printUsage();
         return 1;
     }
 
-    Storage *const storage = storageFactory->createStorage(QStringList());
+    const int pos = base64 ? 2 : 1;
+    const QString url = QUrl::fromEncoded(base64 ? QByteArray::fromBase64(argv[pos]) : QByteArray(argv[pos])).toString();
+
+    Storage *const storage = createStorage(backend);
     if (!storage) {
-        qCritical("Could not create storage object for %s.", qPrintable(backend));
         return 1;
     }
 
@@ -0,0 +1,187 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "storagemigrationtest.h"
+#include "feedstorage.h"
+#include "storagemigration.h"
+#include "storagemk4impl.h"
+#include "storagesqliteimpl.h"
+
+#include <QStandardPaths>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace Akregator::Backend;
+
+namespace
+{
+const QString firstUrl = QStringLiteral("http://www.example.com/feed.rss");
+const QString secondUrl = QStringLiteral("http://www.example.org/feed.atom");
+const QString feedList = QStringLiteral("<?xml version=\"1.0\"?><opml version=\"1.0\"><body><outline text=\"Feed\" xmlUrl=\"http://www.example.com/feed.rss\"/></body></opml>");
+const QString tagSet = QStringLiteral("<tagSet><tag id=\"tag\"/></tagSet>");
+
+FeedStorage::ArticleRecord sampleRecord(const QString &title)
+{
+    FeedStorage::ArticleRecord record;
+    record.title = title;
+    record.description = QStringLiteral("Description with äöü");
+    record.content = QStringLiteral("<p>Content</p>");
+    record.link = QStringLiteral("http://www.example.com/article");
+    record.hash = 4711;
+    record.pubDate = 1500000000;
+    record.status = FeedStorage::ReadFlag;
+    record.authorName = QStringLiteral("Author");
+    record.hasEnclosure = true;
+    record.enclosureUrl = QStringLiteral("http://www.example.com/podcast.ogg");
+    record.enclosureType = QStringLiteral("audio/ogg");
+    record.enclosureLength = 1024;
+    return record;
+}
+
+/** writes two feeds, one with a deleted article, and the feed list and tag set backups */
+void fillSource(const QString &archivePath)
+{
+    StorageMK4Impl source;
+    source.setArchivePath(archivePath);
+    QVERIFY(source.open(true));
+
+    FeedStorage *archive = source.archiveFor(firstUrl);
+    archive->writeRecord(QStringLiteral("guid1"), sampleRecord(QStringLiteral("First")));
+    archive->writeRecord(QStringLiteral("guid2"), sampleRecord(QStringLiteral("Second")));
+    archive->setStatus(QStringLiteral("guid2"), FeedStorage::DeletedFlag);
+    archive->setDeleted(QStringLiteral("guid2"));
+    archive->setUnread(1);
+    archive->setLastFetch(1500000100);
+    FetchValidators validators;
+    validators.eTag = QStringLiteral("\"etag\"");
+    validators.digest = QStringLiteral("0123456789abcdef0123456789abcdef01234567");
+    archive->setFetchValidators(validators);
+
+    source.archiveFor(secondUrl)->writeRecord(QStringLiteral("guid3"), sampleRecord(QStringLiteral("Third")));
+    source.storeFeedList(feedList);
+    source.storeTagSet(tagSet);
+    QVERIFY(source.commit());
+}
+}
+
+StorageMigrationTest::StorageMigrationTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+StorageMigrationTest::~StorageMigrationTest()
+{
+}
+
+void StorageMigrationTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void StorageMigrationTest::shouldCopyArchiveToOtherBackend()
+{
+    QTemporaryDir sourceDir;
+    QTemporaryDir targetDir;
+    QVERIFY(sourceDir.isValid() && targetDir.isValid());
+    fillSource(sourceDir.path());
+
+    {
+        StorageMK4Impl source;
+        source.setArchivePath(sourceDir.path());
+        StorageSQLiteImpl target;
+        target.setArchivePath(targetDir.path());
+        QVERIFY(migrateStorage(&source, &target));
+    }
+
+    StorageSQLiteImpl target;
+    target.setArchivePath(targetDir.path());
+    QVERIFY(target.open(true));
+    QStringList feeds = target.feeds();
+    feeds.sort();
+    QCOMPARE(feeds, QStringList() << firstUrl << secondUrl);
+    QCOMPARE(target.restoreFeedList(), feedList);
+    QCOMPARE(target.restoreTagSet(), tagSet);
+
+    QCOMPARE(target.unreadFor(firstUrl), 1);
+    QCOMPARE(target.totalCountFor(firstUrl), 1);
+    QCOMPARE(target.lastFetchFor(firstUrl), 1500000100);
+    QCOMPARE(target.fetchValidatorsFor(firstUrl).eTag, QStringLiteral("\"etag\""));
+    QCOMPARE(target.fetchValidatorsFor(firstUrl).digest, QStringLiteral("0123456789abcdef0123456789abcdef01234567"));
+    QCOMPARE(target.totalCountFor(secondUrl), 1);
+
+    FeedStorage *const archive = target.archiveFor(firstUrl);
+    const FeedStorage::ArticleRecord expected = sampleRecord(QStringLiteral("First"));
+    FeedStorage::ArticleRecord read;
+    QVERIFY(archive->readRecord(QStringLiteral("guid1"), read));
+    QCOMPARE(read.title, expected.title);
+    QCOMPARE(read.description, expected.description);
+    QCOMPARE(read.content, expected.content);
+    QCOMPARE(read.hash, expected.hash);
+    QCOMPARE(read.pubDate, expected.pubDate);
+    QCOMPARE(read.status, expected.status);
+    QCOMPARE(read.authorName, expected.authorName);
+    QCOMPARE(read.enclosureUrl, expected.enclosureUrl);
+    QCOMPARE(read.enclosureLength, expected.enclosureLength);
+
+    // the tombstone is migrated too, so the deleted article is not fetched again
+    QVERIFY(archive->contains(QStringLiteral("guid2")));
+    QCOMPARE(archive->status(QStringLiteral("guid2")), int(FeedStorage::DeletedFlag));
+    QVERIFY(archive->title(QStringLiteral("guid2")).isEmpty());
+
+    QCOMPARE(target.archiveFor(secondUrl)->title(QStringLiteral("guid3")), QStringLiteral("Third"));
+}
+
+void StorageMigrationTest::shouldReplaceArticlesInTarget()
+{
+    QTemporaryDir sourceDir;
+    QTemporaryDir targetDir;
+    QVERIFY(sourceDir.isValid() && targetDir.isValid());
+    fillSource(sourceDir.path());
+
+    {
+        StorageSQLiteImpl target;
+        target.setArchivePath(targetDir.path());
+        QVERIFY(target.open(true));
+        target.archiveFor(firstUrl)->writeRecord(QStringLiteral("guid1"), sampleRecord(QStringLiteral("Outdated")));
+        target.archiveFor(firstUrl)->writeRecord(QStringLiteral("other"), sampleRecord(QStringLiteral("Other")));
+        QVERIFY(target.commit());
+    }
+
+    {
+        StorageMK4Impl source;
+        source.setArchivePath(sourceDir.path());
+        StorageSQLiteImpl target;
+        target.setArchivePath(targetDir.path());
+        QVERIFY(migrateStorage(&source, &target));
+    }
+
+    StorageSQLiteImpl target;
+    target.setArchivePath(targetDir.path());
+    QVERIFY(target.open(true));
+    FeedStorage *const archive = target.archiveFor(firstUrl);
+    QCOMPARE(archive->title(QStringLiteral("guid1")), QStringLiteral("First"));
+    // articles only the target has are kept
+    QCOMPARE(archive->title(QStringLiteral("other")), QStringLiteral("Other"));
+}
+
+QTEST_GUILESS_MAIN(StorageMigrationTest)
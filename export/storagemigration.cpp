@@ -0,0 +1,48 @@
+/*
+ * This file is part of akregatorstorageexporter
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#include "storagemigration.h"
+#include "feedstorage.h"
+#include "storage.h"
+
+#include <QStringList>
+
+#include <iostream>
+
+bool Akregator::Backend::migrateStorage(Storage *source, Storage *target)
+{
+    if (!source->open(true) || !target->open(true)) {
+        return false;
+    }
+
+    const QStringList feeds = source->feeds();
+    int count = 0;
+    for (const QString &url : feeds) {
+        target->archiveFor(url)->add(source->archiveFor(url));
+        target->commit();
+        std::cerr << ++count << "/" << feeds.count() << " " << qPrintable(url) << std::endl;
+    }
+    target->storeFeedList(source->restoreFeedList());
+    target->storeTagSet(source->restoreTagSet());
+    const bool ok = target->commit();
+
+    target->close();
+    source->close();
+    return ok;
+}
@@ -0,0 +1,39 @@
+/*
+ * This file is part of akregatorstorageexporter
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AKREGATOR_STORAGEMIGRATION_H
+#define AKREGATOR_STORAGEMIGRATION_H
+
+namespace Akregator
+{
+namespace Backend
+{
+class Storage;
+
+/** copies all feeds, the feed list backup and the tag set from @p source into @p target,
+    committing after each feed so that a large archive is not copied in a single transaction.
+    Both storages are opened with autocommit and closed again.
+    @return false if a storage could not be opened or the last commit failed
+ */
+bool migrateStorage(Storage *source, Storage *target);
+} // namespace Backend
+} // namespace Akregator
+
+#endif // AKREGATOR_STORAGEMIGRATION_H
@@ -27,6 +27,7 @@
 #define AKREGATOR_ARTICLE_H
 
 #include "akregatorinterfaces_export.h"
+#include "feedstorage.h"
 #include "types.h"
 
 #include <Syndication/Person>
@@ -48,10 +49,6 @@ typedef QSharedPointer<Item> ItemPtr;
 }
 
 namespace Akregator {
-namespace Backend {
-class FeedStorage;
-}
-
 class Feed;
 /** A proxy class for Syndication::ItemPtr with some additional methods to assist sorting. */
 class AKREGATORINTERFACES_EXPORT Article
@@ -59,6 +56,7 @@ class AKREGATORINTERFACES_EXPORT Article
     friend class ArticleDeleteJob;
     friend class ArticleModifyJob;
     friend class Feed;
+    friend class FeedDiffJob;
 
 public:
     enum ContentOption {
@@ -97,6 +95,10 @@ public:
     QUrl link() const;
     QString description() const;
 
+    /** the description, read from the ArticleMetadataCache. Loads the descriptions of all articles
+        of the feed on first use, so use this only when going through many articles, e.g. to filter them */
+    QString cachedDescription() const;
+
     QString content(ContentOption opt = ContentAndOnlyContent) const;
 
     QString guid() const;
@@ -139,6 +141,22 @@ public:
     bool operator>=(const Article &other) const;
 
 private: //only for our friends
+    /** creates an article object for an item just added to the archive by Backend::FeedStorage::ingest(),
+        using the stored @c record instead of reading it back. The article is New, or Read if stored as read
+    */
+    Article(const QString &guid, Feed *feed, const Backend::FeedStorage::ArticleRecord &record);
+
+    /** converts a parsed item into the record stored for it by Article(const Syndication::ItemPtr &, Feed *).
+        @param markAsRead if @c true, the record is marked as read
+    */
+    static Backend::FeedStorage::ItemRecord recordForItem(const Syndication::ItemPtr &item, bool markAsRead = false);
+
+    /** returns the hash recordForItem() would store for @c item */
+    static uint hashForItem(const Syndication::ItemPtr &item);
+
+    /** updates the hash after the archived content was replaced by Backend::FeedStorage::ingest() */
+    void setHash(uint hash);
+
     void setStatus(int s);
     void setDeleted();
     void setKeep(bool keep);
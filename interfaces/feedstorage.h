@@ -26,8 +26,9 @@
 
 #include <QObject>
 #include <QList>
+#include <QString>
+#include <QVector>
 
-class QString;
 class QStringList;
 
 namespace Akregator {
@@ -60,17 +61,123 @@ public:
     }
 };
 
+/** the HTTP validators and the content digest of the last feed document that was fetched
+    and merged successfully. Used to skip downloading and parsing unchanged documents. */
+class FetchValidators
+{
+public:
+
+    QString eTag;
+    QString lastModified;
+    /** hex encoded SHA-1 of the document */
+    QString digest;
+
+    bool isEmpty() const
+    {
+        return eTag.isEmpty() && lastModified.isEmpty() && digest.isEmpty();
+    }
+};
+
 class Storage;
 
 class FeedStorage : public QObject //krazy:exclude=qobject
 {
 public:
 
+    /** A plain copy of the fields of one article. Used to read or write a whole
+        archive row with a single guid lookup instead of one lookup per field. */
+    struct ArticleRecord {
+        /** selects the fields affected by readRecord() and updateFields() */
+        enum Field {
+            Title = 0x0001,
+            Description = 0x0002,
+            Content = 0x0004,
+            Link = 0x0008,
+            CommentsLink = 0x0010,
+            Comments = 0x0020,
+            GuidIsHash = 0x0040,
+            GuidIsPermaLink = 0x0080,
+            Hash = 0x0100,
+            PubDate = 0x0200,
+            Status = 0x0400,
+            Author = 0x0800, /**< authorName, authorUri and authorEMail */
+            Enclosure = 0x1000, /**< hasEnclosure, enclosureUrl, enclosureType and enclosureLength */
+            AllFields = 0x1fff
+        };
+
+        ArticleRecord() : comments(0)
+            , guidIsHash(false)
+            , guidIsPermaLink(false)
+            , hash(0)
+            , pubDate(0)
+            , status(0)
+            , hasEnclosure(false)
+            , enclosureLength(-1)
+        {
+        }
+
+        QString title;
+        QString description;
+        QString content;
+        QString link;
+        QString commentsLink;
+        int comments;
+        bool guidIsHash;
+        bool guidIsPermaLink;
+        uint hash;
+        uint pubDate;
+        int status;
+        QString authorName;
+        QString authorUri;
+        QString authorEMail;
+        bool hasEnclosure;
+        QString enclosureUrl;
+        QString enclosureType;
+        int enclosureLength;
+    };
+
+    /** an article passed to ingest() */
+    struct ItemRecord {
+        ItemRecord() : fields(ArticleRecord::AllFields)
+        {
+        }
+
+        QString guid;
+        /** the fields to update if the article is archived already. New articles are always stored completely */
+        int fields;
+        ArticleRecord record;
+    };
+
+    /** what ingest() did with an item */
+    enum IngestResult {
+        Inserted, /**< the article was not archived and has been added */
+        Updated, /**< the article was archived with a different hash, the selected fields were updated */
+        Unchanged /**< the article was archived with the same hash, nothing was written */
+    };
+
+    /** the bits of an article status as stored by setStatus() */
+    enum StatusFlag {
+        DeletedFlag = 0x01, /**< the article was deleted, only its guid and status are kept */
+        TrashFlag = 0x02,
+        NewFlag = 0x04,
+        ReadFlag = 0x08,
+        KeepFlag = 0x10
+    };
+
+    /** the change of totalCount() when the status of an archived article changes from @c oldStatus to @c newStatus */
+    static int totalCountDelta(int oldStatus, int newStatus)
+    {
+        return ((oldStatus & DeletedFlag) ? 1 : 0) - ((newStatus & DeletedFlag) ? 1 : 0);
+    }
+
     virtual int unread() const = 0;
     virtual void setUnread(int unread) = 0;
+    /** the number of articles in this storage, not counting articles marked deleted */
     virtual int totalCount() const = 0;
     virtual int lastFetch() const = 0;
     virtual void setLastFetch(int lastFetch) = 0;
+    virtual FetchValidators fetchValidators() const = 0;
+    virtual void setFetchValidators(const FetchValidators &validators) = 0;
 
     /** returns the guids of all articles in this storage. If a tagID is given, only articles with this tag are returned */
     virtual QStringList articles(const QString &tagID = QString()) const = 0;
@@ -78,6 +185,9 @@ public:
     /** returns the guid of the articles in a given category */
     virtual QStringList articles(const Category &cat) const = 0;
 
+    /** returns the guids of the articles published before @c pubDate, leaving out articles marked deleted */
+    virtual QStringList articlesPublishedBefore(uint pubDate) const = 0;
+
     /** Appends all articles from another storage. If there is already an article in this feed with the same guid, it is replaced by the article from the source
     @param source the archive which articles should be appended
     */
@@ -137,6 +247,33 @@ public:
     virtual QString authorEMail(const QString &guid) const = 0;
 
     virtual void enclosure(const QString &guid, bool &hasEnclosure, QString &url, QString &type, int &length) const = 0;
+
+    /** reads the fields selected by @c fields (a combination of ArticleRecord::Field) of an article into @c record
+        @return @c false if the article is not in the archive, @c record is left untouched then
+    */
+    virtual bool readRecord(const QString &guid, ArticleRecord &record, int fields = ArticleRecord::AllFields) const = 0;
+
+    /** stores all fields of @c record, adding the article to the archive if it is not contained yet */
+    virtual void writeRecord(const QString &guid, const ArticleRecord &record) = 0;
+
+    /** stores only the fields selected by @c fields. Does nothing if the article is not in the archive */
+    virtual void updateFields(const QString &guid, int fields, const ArticleRecord &record) = 0;
+
+    /** stores a batch of articles, e.g. the items of a fetched feed, in one go: articles not in the archive
+        are added, archived articles are updated if their hash differs. The guids in @c items must be unique,
+        the caller removes duplicates. All changes are applied together and become persistent with a single commit.
+        @return what was done with each item, in the order of @c items
+    */
+    virtual QVector<IngestResult> ingest(const QVector<ItemRecord> &items) = 0;
+
+    /** the URL of the feed whose articles are stored */
+    virtual QString url() const = 0;
+
+    /** a number that changes whenever the stored articles may have changed in bulk, i.e. by rollback(),
+        clear() or the backend closing, reopening or compacting the archive file. Caches of article
+        fields compare it to know when they have to be reloaded */
+    virtual quint64 generation() const = 0;
+
     virtual void close() = 0;
     virtual void commit() = 0;
     virtual void rollback() = 0;
@@ -0,0 +1,273 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "persistenceservice.h"
+#include "akregatorconfig.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Akregator {
+namespace Backend {
+namespace {
+/** a queued write of one file, or a durability barrier syncing already written files when path is empty */
+struct Job {
+    QString path;
+    QByteArray data;
+    QStringList syncPaths;
+};
+
+bool syncToDisk(QFileDevice &file)
+{
+    if (!file.flush()) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    return ::_commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+}
+
+class Q_DECL_HIDDEN PersistenceService::PersistenceServicePrivate : public QThread
+{
+public:
+    explicit PersistenceServicePrivate(PersistenceService *qq);
+
+    void enqueue(const Job &job);
+    void recordFlush(const QString &name, qint64 msecs);
+
+    void run() override;
+
+    PersistenceService *const q;
+
+    mutable QMutex mutex;
+    /** signalled when a job was queued or the thread should stop */
+    QWaitCondition jobQueued;
+    /** signalled when the queue ran empty */
+    QWaitCondition idle;
+    QVector<Job> queue;
+    bool busy;
+    bool stopping;
+    QAtomicInt syncPolicy;
+    FlushStatistics statistics;
+
+private:
+    bool write(const Job &job, bool sync);
+    void sync(const QStringList &paths);
+};
+
+PersistenceService::PersistenceServicePrivate::PersistenceServicePrivate(PersistenceService *qq)
+    : q(qq)
+    , busy(false)
+    , stopping(false)
+    , syncPolicy(Settings::writeSyncPolicy())
+{
+    statistics.count = 0;
+    statistics.lastMsecs = 0;
+    statistics.maxMsecs = 0;
+    statistics.totalMsecs = 0;
+    setObjectName(QStringLiteral("Akregator I/O"));
+}
+
+void PersistenceService::PersistenceServicePrivate::enqueue(const Job &job)
+{
+    QMutexLocker locker(&mutex);
+    bool merged = false;
+    if (!job.path.isEmpty()) {
+        // the file is rewritten completely, an older pending write of it is obsolete
+        for (Job &i : queue) {
+            if (i.path == job.path) {
+                i.data = job.data;
+                merged = true;
+                break;
+            }
+        }
+    }
+    if (!merged) {
+        queue.append(job);
+    }
+
+    if (!isRunning()) {
+        start(QThread::LowPriority);
+    }
+    jobQueued.wakeOne();
+}
+
+void PersistenceService::PersistenceServicePrivate::recordFlush(const QString &name, qint64 msecs)
+{
+    {
+        QMutexLocker locker(&mutex);
+        ++statistics.count;
+        statistics.lastMsecs = msecs;
+        statistics.maxMsecs = qMax(statistics.maxMsecs, msecs);
+        statistics.totalMsecs += msecs;
+    }
+    Q_EMIT q->flushed(name, msecs);
+}
+
+bool PersistenceService::PersistenceServicePrivate::write(const Job &job, bool sync)
+{
+    QSaveFile file(job.path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    if (file.write(job.data) != job.data.size() || (sync && !syncToDisk(file))) {
+        file.cancelWriting();
+    }
+    return file.commit();
+}
+
+void PersistenceService::PersistenceServicePrivate::sync(const QStringList &paths)
+{
+    for (const QString &i : paths) {
+        QFile file(i);
+#ifdef Q_OS_WIN
+        const QIODevice::OpenMode mode = QIODevice::ReadWrite;
+#else
+        const QIODevice::OpenMode mode = QIODevice::ReadOnly;
+#endif
+        if (file.open(mode)) {
+            syncToDisk(file);
+        }
+    }
+}
+
+void PersistenceService::PersistenceServicePrivate::run()
+{
+    Q_FOREVER {
+        Job job;
+        {
+            QMutexLocker locker(&mutex);
+            while (queue.isEmpty()) {
+                busy = false;
+                idle.wakeAll();
+                if (stopping) {
+                    return;
+                }
+                jobQueued.wait(&mutex);
+            }
+            job = queue.takeFirst();
+            busy = true;
+        }
+
+        const int policy = syncPolicy.load();
+        QElapsedTimer timer;
+        timer.start();
+        if (!job.path.isEmpty()) {
+            if (!write(job, policy != SyncNever)) {
+                Q_EMIT q->writeFailed(job.path);
+            }
+            recordFlush(job.path, timer.elapsed());
+        } else if (policy == SyncAlways) {
+            sync(job.syncPaths);
+            recordFlush(QStringLiteral("archive sync"), timer.elapsed());
+        }
+    }
+}
+
+PersistenceService *PersistenceService::self()
+{
+    static PersistenceService instance;
+    return &instance;
+}
+
+PersistenceService::PersistenceService()
+    : QObject()
+    , d(new PersistenceServicePrivate(this))
+{
+}
+
+PersistenceService::~PersistenceService()
+{
+    {
+        QMutexLocker locker(&d->mutex);
+        d->stopping = true;
+        d->jobQueued.wakeOne();
+    }
+    d->wait();
+    delete d;
+}
+
+PersistenceService::SyncPolicy PersistenceService::syncPolicy() const
+{
+    return static_cast<SyncPolicy>(d->syncPolicy.load());
+}
+
+void PersistenceService::setSyncPolicy(SyncPolicy policy)
+{
+    d->syncPolicy.store(policy);
+}
+
+void PersistenceService::writeFile(const QString &path, const QByteArray &data)
+{
+    Job job;
+    job.path = path;
+    job.data = data;
+    d->enqueue(job);
+}
+
+void PersistenceService::syncFiles(const QStringList &paths)
+{
+    if (paths.isEmpty() || syncPolicy() != SyncAlways) {
+        return;
+    }
+    Job job;
+    job.syncPaths = paths;
+    job.syncPaths.removeDuplicates();
+    d->enqueue(job);
+}
+
+void PersistenceService::reportFlush(const QString &name, qint64 msecs)
+{
+    d->recordFlush(name, msecs);
+}
+
+void PersistenceService::waitForDone()
+{
+    QMutexLocker locker(&d->mutex);
+    while (d->busy || !d->queue.isEmpty()) {
+        d->idle.wait(&d->mutex);
+    }
+}
+
+PersistenceService::FlushStatistics PersistenceService::statistics() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->statistics;
+}
+} // namespace Backend
+} // namespace Akregator
@@ -0,0 +1,105 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef AKREGATOR_BACKEND_PERSISTENCESERVICE_H
+#define AKREGATOR_BACKEND_PERSISTENCESERVICE_H
+
+#include "akregatorinterfaces_export.h"
+
+#include <QObject>
+
+class QByteArray;
+class QString;
+class QStringList;
+
+namespace Akregator {
+namespace Backend {
+/** Performs the writes that make the feed list and the archive durable on a dedicated I/O thread,
+    so that slow disks do not stall the GUI.
+
+    Jobs run one after another in the order they were queued. A queued write of a file that has not
+    started yet is replaced by a newer write of the same file.
+    The service is created on the GUI thread and must only be called from there. */
+class AKREGATORINTERFACES_EXPORT PersistenceService : public QObject
+{
+    Q_OBJECT
+public:
+
+    /** which files are flushed from the OS buffers to disk after they were written */
+    enum SyncPolicy {
+        SyncNever = 0, /**< leave it to the operating system */
+        SyncFeedList, /**< sync the feed list file only */
+        SyncAlways /**< sync the feed list and the archive after every commit */
+    };
+
+    /** timings of the flushes done so far, in milliseconds */
+    struct FlushStatistics {
+        int count;
+        qint64 lastMsecs;
+        qint64 maxMsecs;
+        qint64 totalMsecs;
+    };
+
+    static PersistenceService *self();
+
+    ~PersistenceService();
+
+    SyncPolicy syncPolicy() const;
+    void setSyncPolicy(SyncPolicy policy);
+
+    /** atomically replaces the file at @p path with @p data on the I/O thread.
+        The file is synced to disk unless the policy is SyncNever. writeFailed() is emitted when the write fails */
+    void writeFile(const QString &path, const QByteArray &data);
+
+    /** flushes the files at @p paths, which were already written by the caller, to disk on the I/O thread.
+        Each call is one durability barrier: the files are synced together, after all previously queued jobs.
+        Does nothing unless the policy is SyncAlways */
+    void syncFiles(const QStringList &paths);
+
+    /** records a flush that ran outside of the service, e.g. a commit on the GUI thread */
+    void reportFlush(const QString &name, qint64 msecs);
+
+    /** blocks until all queued jobs are done. Call before quitting */
+    void waitForDone();
+
+    FlushStatistics statistics() const;
+
+Q_SIGNALS:
+    /** emitted after each flush. Emitted from the I/O thread, connections are queued to the GUI thread
+        @param name the written file, or the name passed to reportFlush()
+        @param msecs how long the flush took */
+    void flushed(const QString &name, qint64 msecs);
+
+    /** emitted when the file at @p path could not be written */
+    void writeFailed(const QString &path);
+
+private:
+    PersistenceService();
+    Q_DISABLE_COPY(PersistenceService)
+
+    class PersistenceServicePrivate;
+    PersistenceServicePrivate *const d;
+};
+} // namespace Backend
+} // namespace Akregator
+
+#endif // AKREGATOR_BACKEND_PERSISTENCESERVICE_H
@@ -26,15 +26,16 @@
 #define AKREGATOR_BACKEND_STORAGE_H
 
 #include "akregatorinterfaces_export.h"
+#include "feedstorage.h"
+
 #include <QObject>
+#include <QVector>
 
 class QString;
 class QStringList;
 
 namespace Akregator {
 namespace Backend {
-class FeedStorage;
-
 /** \brief Storage is the main interface to the article archive. It creates and manages FeedStorage objects handling the article list for a feed.
 
     An archive implementation must implement Storage, FeedStorage and StorageFactory. See mk4storage for an example.
@@ -43,6 +44,23 @@ class Storage : public QObject //krazy:exclude=qobject
 {
 public:
 
+    /** an article found by search() */
+    struct SearchHit {
+        QString feedUrl;
+        QString guid;
+        /** relevance of the article, only meaningful compared to the other hits of the same search */
+        double score;
+    };
+
+    /** what compactArchive() and compactSharedFiles() did */
+    struct CompactionResult {
+        /** number of files rewritten */
+        int files;
+        /** total size of these files before and after compaction, in bytes */
+        qint64 sizeBefore;
+        qint64 sizeAfter;
+    };
+
     virtual ~Storage()
     {
     }
@@ -87,6 +105,8 @@ public:
     virtual void setTotalCountFor(const QString &url, int total) = 0;
     virtual int lastFetchFor(const QString &url) const = 0;
     virtual void setLastFetchFor(const QString &url, int lastFetch) = 0;
+    virtual FetchValidators fetchValidatorsFor(const QString &url) const = 0;
+    virtual void setFetchValidatorsFor(const QString &url, const FetchValidators &validators) = 0;
 
     /** stores the feed list in the storage backend. This is a fallback for the case that the
         feeds.opml file gets corrupted
@@ -109,6 +129,27 @@ public:
 
     /** deletes all feed storages in this archive */
     virtual void clear() = 0;
+
+    /** returns the archived articles containing all words of @p query, best match first.
+        Backends without a search index return an empty list.
+        @param maxHits the maximum number of hits returned
+     */
+    virtual QVector<SearchHit> search(const QString &query, int maxHits) const = 0;
+
+    /** commits pending changes and rewrites the archive of @p feedUrl so that it no longer contains
+        space left by deleted or changed articles. The archive reports a new FeedStorage::generation() afterwards.
+        Deleted articles stay in the archive, so that they are not added again while the feed lists them.
+        @param purgeBefore deleted articles published before this date (as time_t) are dropped, 0 keeps all of them.
+        Only pass a date for feeds expiring their articles by age, which would expire such articles again.
+        @param result the rewritten files are added to it. Backends storing all feeds in one file rewrite
+        it in compactSharedFiles()
+     */
+    virtual void compactArchive(const QString &feedUrl, uint purgeBefore, CompactionResult &result) = 0;
+
+    /** rewrites the files shared by all feeds, like indexes, after the archives of the feeds were compacted.
+        Backends without anything to compact leave @p result alone.
+     */
+    virtual void compactSharedFiles(CompactionResult &result) = 0;
 };
 } // namespace Backend
 } // namespace Akregator
@@ -0,0 +1,424 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "feedstoragemk4impltest.h"
+#include "akregatorconfig.h"
+#include "feedstoragemk4impl.h"
+#include "storagemk4impl.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QVector>
+
+using namespace Akregator::Backend;
+
+typedef FeedStorage::ArticleRecord Record;
+
+namespace
+{
+const QString feedUrl = QStringLiteral("http://www.example.com/feed.rss");
+
+Record sampleRecord()
+{
+    Record record;
+    record.title = QStringLiteral("Title");
+    record.description = QStringLiteral("Description with äöü");
+    record.content = QStringLiteral("<p>Content</p>");
+    record.link = QStringLiteral("http://www.example.com/article");
+    record.commentsLink = QStringLiteral("http://www.example.com/article#comments");
+    record.comments = 3;
+    record.guidIsHash = false;
+    record.guidIsPermaLink = true;
+    record.hash = 4711;
+    record.pubDate = 1500000000;
+    record.status = 0x08;
+    record.authorName = QStringLiteral("Author");
+    record.authorUri = QStringLiteral("http://www.example.com/author");
+    record.authorEMail = QStringLiteral("author@example.com");
+    record.hasEnclosure = true;
+    record.enclosureUrl = QStringLiteral("http://www.example.com/podcast.ogg");
+    record.enclosureType = QStringLiteral("audio/ogg");
+    record.enclosureLength = 1024;
+    return record;
+}
+
+FeedStorage::ItemRecord sampleItem(const QString &guid, uint hash)
+{
+    FeedStorage::ItemRecord item;
+    item.guid = guid;
+    item.record = sampleRecord();
+    item.record.title = guid;
+    item.record.hash = hash;
+    item.record.status = 0;
+    return item;
+}
+
+void compareRecords(const Record &actual, const Record &expected)
+{
+    QCOMPARE(actual.title, expected.title);
+    QCOMPARE(actual.description, expected.description);
+    QCOMPARE(actual.content, expected.content);
+    QCOMPARE(actual.link, expected.link);
+    QCOMPARE(actual.commentsLink, expected.commentsLink);
+    QCOMPARE(actual.comments, expected.comments);
+    QCOMPARE(actual.guidIsHash, expected.guidIsHash);
+    QCOMPARE(actual.guidIsPermaLink, expected.guidIsPermaLink);
+    QCOMPARE(actual.hash, expected.hash);
+    QCOMPARE(actual.pubDate, expected.pubDate);
+    QCOMPARE(actual.status, expected.status);
+    QCOMPARE(actual.authorName, expected.authorName);
+    QCOMPARE(actual.authorUri, expected.authorUri);
+    QCOMPARE(actual.authorEMail, expected.authorEMail);
+    QCOMPARE(actual.hasEnclosure, expected.hasEnclosure);
+    QCOMPARE(actual.enclosureUrl, expected.enclosureUrl);
+    QCOMPARE(actual.enclosureType, expected.enclosureType);
+    QCOMPARE(actual.enclosureLength, expected.enclosureLength);
+}
+}
+
+FeedStorageMK4ImplTest::FeedStorageMK4ImplTest(QObject *parent)
+    : QObject(parent)
+    , m_dir(nullptr)
+    , m_storage(nullptr)
+{
+}
+
+FeedStorageMK4ImplTest::~FeedStorageMK4ImplTest()
+{
+}
+
+void FeedStorageMK4ImplTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void FeedStorageMK4ImplTest::init()
+{
+    m_dir = new QTemporaryDir;
+    QVERIFY(m_dir->isValid());
+    m_storage = new StorageMK4Impl;
+    m_storage->setArchivePath(m_dir->path());
+    QVERIFY(m_storage->open(true));
+}
+
+void FeedStorageMK4ImplTest::cleanup()
+{
+    delete m_storage;
+    m_storage = nullptr;
+    delete m_dir;
+    m_dir = nullptr;
+}
+
+void FeedStorageMK4ImplTest::reopen()
+{
+    QVERIFY(m_storage->commit());
+    delete m_storage;
+    m_storage = new StorageMK4Impl;
+    m_storage->setArchivePath(m_dir->path());
+    QVERIFY(m_storage->open(true));
+}
+
+void FeedStorageMK4ImplTest::shouldNotReadUnknownArticle()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    Record record;
+    record.title = QStringLiteral("untouched");
+    QVERIFY(!archive->readRecord(QStringLiteral("unknown"), record));
+    QCOMPARE(record.title, QStringLiteral("untouched"));
+    QVERIFY(!archive->contains(QStringLiteral("unknown")));
+}
+
+void FeedStorageMK4ImplTest::shouldReadWrittenRecord()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    const Record written = sampleRecord();
+    archive->writeRecord(QStringLiteral("guid1"), written);
+
+    QVERIFY(archive->contains(QStringLiteral("guid1")));
+    Record read;
+    QVERIFY(archive->readRecord(QStringLiteral("guid1"), read));
+    compareRecords(read, written);
+
+    // the per-field getters see the same row
+    QCOMPARE(archive->title(QStringLiteral("guid1")), written.title);
+    QCOMPARE(archive->hash(QStringLiteral("guid1")), written.hash);
+    QCOMPARE(archive->authorEMail(QStringLiteral("guid1")), written.authorEMail);
+}
+
+void FeedStorageMK4ImplTest::shouldReadSelectedFieldsOnly()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    archive->writeRecord(QStringLiteral("guid1"), sampleRecord());
+
+    Record read;
+    QVERIFY(archive->readRecord(QStringLiteral("guid1"), read, Record::Status | Record::Hash | Record::PubDate));
+    QCOMPARE(read.status, 0x08);
+    QCOMPARE(read.hash, 4711u);
+    QCOMPARE(read.pubDate, 1500000000u);
+    QVERIFY(read.title.isEmpty());
+    QVERIFY(read.description.isEmpty());
+    QVERIFY(!read.hasEnclosure);
+}
+
+void FeedStorageMK4ImplTest::shouldUpdateSelectedFieldsOnly()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    const Record original = sampleRecord();
+    archive->writeRecord(QStringLiteral("guid1"), original);
+
+    Record changes;
+    changes.title = QStringLiteral("New Title");
+    changes.hash = 42;
+    changes.description = QStringLiteral("not written");
+    archive->updateFields(QStringLiteral("guid1"), Record::Title | Record::Hash, changes);
+
+    Record expected = original;
+    expected.title = changes.title;
+    expected.hash = changes.hash;
+    Record read;
+    QVERIFY(archive->readRecord(QStringLiteral("guid1"), read));
+    compareRecords(read, expected);
+
+    // an enclosure can be removed through its field group
+    Record noEnclosure;
+    archive->updateFields(QStringLiteral("guid1"), Record::Enclosure, noEnclosure);
+    QVERIFY(archive->readRecord(QStringLiteral("guid1"), read, Record::Enclosure));
+    QVERIFY(!read.hasEnclosure);
+    QVERIFY(read.enclosureUrl.isEmpty());
+    QCOMPARE(read.enclosureLength, -1);
+}
+
+void FeedStorageMK4ImplTest::shouldNotUpdateUnknownArticle()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    archive->updateFields(QStringLiteral("unknown"), Record::AllFields, sampleRecord());
+    QVERIFY(!archive->contains(QStringLiteral("unknown")));
+    QVERIFY(archive->articles().isEmpty());
+}
+
+void FeedStorageMK4ImplTest::shouldKeepRecordsAfterReopening()
+{
+    const Record written = sampleRecord();
+    m_storage->archiveFor(feedUrl)->writeRecord(QStringLiteral("guid1"), written);
+    reopen();
+
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    QCOMPARE(archive->articles(), QStringList() << QStringLiteral("guid1"));
+    Record read;
+    QVERIFY(archive->readRecord(QStringLiteral("guid1"), read));
+    compareRecords(read, written);
+}
+
+void FeedStorageMK4ImplTest::shouldIngestNewItems()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    const QVector<FeedStorage::ItemRecord> items = { sampleItem(QStringLiteral("guid1"), 1), sampleItem(QStringLiteral("guid2"), 2) };
+
+    const QVector<FeedStorage::IngestResult> results = archive->ingest(items);
+    QCOMPARE(results, QVector<FeedStorage::IngestResult>({ FeedStorage::Inserted, FeedStorage::Inserted }));
+    QCOMPARE(archive->totalCount(), 2);
+
+    Record read;
+    QVERIFY(archive->readRecord(QStringLiteral("guid2"), read));
+    compareRecords(read, items.at(1).record);
+}
+
+void FeedStorageMK4ImplTest::shouldIngestChangedItemsOnly()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    archive->ingest({ sampleItem(QStringLiteral("guid1"), 1), sampleItem(QStringLiteral("guid2"), 2) });
+    archive->setStatus(QStringLiteral("guid1"), 0x08);
+
+    FeedStorage::ItemRecord changed = sampleItem(QStringLiteral("guid1"), 10);
+    changed.record.title = QStringLiteral("Changed");
+    changed.record.description = QStringLiteral("not written");
+    changed.fields = Record::Title | Record::Hash;
+    FeedStorage::ItemRecord unchanged = sampleItem(QStringLiteral("guid2"), 2);
+    unchanged.record.title = QStringLiteral("not written either");
+
+    const QVector<FeedStorage::IngestResult> results = archive->ingest({ changed, unchanged, sampleItem(QStringLiteral("guid3"), 3) });
+    QCOMPARE(results, QVector<FeedStorage::IngestResult>({ FeedStorage::Updated, FeedStorage::Unchanged, FeedStorage::Inserted }));
+    QCOMPARE(archive->totalCount(), 3);
+
+    Record read;
+    QVERIFY(archive->readRecord(QStringLiteral("guid1"), read));
+    QCOMPARE(read.title, QStringLiteral("Changed"));
+    QCOMPARE(read.hash, 10u);
+    QCOMPARE(read.description, sampleRecord().description);
+    // the status is not part of the selected fields, the article stays read
+    QCOMPARE(read.status, 0x08);
+
+    QVERIFY(archive->readRecord(QStringLiteral("guid2"), read));
+    QCOMPARE(read.title, QStringLiteral("guid2"));
+}
+
+void FeedStorageMK4ImplTest::shouldReleaseLeastRecentlyUsedArchives()
+{
+    const int maxOpenArchives = Akregator::Settings::maxOpenArchives();
+    Akregator::Settings::setMaxOpenArchives(2);
+    const QString urls[] = { QStringLiteral("http://a.example.com"), QStringLiteral("http://b.example.com"), QStringLiteral("http://c.example.com") };
+    QVector<FeedStorageMK4Impl *> archives;
+    for (const QString &url : urls) {
+        archives.append(static_cast<FeedStorageMK4Impl *>(m_storage->archiveFor(url)));
+        archives.last()->writeRecord(QStringLiteral("guid"), sampleRecord());
+    }
+    // the modified archives are kept open until the commit
+    QVERIFY(archives.at(0)->isOpen() && archives.at(1)->isOpen() && archives.at(2)->isOpen());
+    QVERIFY(m_storage->commit());
+    QCOMPARE(archives.at(0)->isOpen() + archives.at(1)->isOpen() + archives.at(2)->isOpen(), 2);
+
+    // using a and then b makes c the least recently used one
+    QVERIFY(archives.at(0)->contains(QStringLiteral("guid")));
+    QVERIFY(archives.at(1)->contains(QStringLiteral("guid")));
+    QVERIFY(archives.at(0)->isOpen());
+    QVERIFY(archives.at(1)->isOpen());
+    QVERIFY(!archives.at(2)->isOpen());
+
+    // released archives reopen on access, releasing the least recently used one
+    QCOMPARE(archives.at(2)->title(QStringLiteral("guid")), sampleRecord().title);
+    QVERIFY(archives.at(2)->isOpen());
+    QVERIFY(archives.at(1)->isOpen());
+    QVERIFY(!archives.at(0)->isOpen());
+    Akregator::Settings::setMaxOpenArchives(maxOpenArchives);
+}
+
+void FeedStorageMK4ImplTest::shouldNotReleaseModifiedArchives()
+{
+    const int maxOpenArchives = Akregator::Settings::maxOpenArchives();
+    Akregator::Settings::setMaxOpenArchives(2);
+    const QString urls[] = { QStringLiteral("http://a.example.com"), QStringLiteral("http://b.example.com"), QStringLiteral("http://c.example.com") };
+    QVector<FeedStorageMK4Impl *> archives;
+    for (const QString &url : urls) {
+        archives.append(static_cast<FeedStorageMK4Impl *>(m_storage->archiveFor(url)));
+        archives.last()->writeRecord(QStringLiteral("guid"), sampleRecord());
+    }
+    QVERIFY(m_storage->commit());
+
+    // a is modified, then b and c are used: a stays open although it is the least recently used
+    archives.at(0)->setTitle(QStringLiteral("guid"), QStringLiteral("changed"));
+    QVERIFY(archives.at(1)->contains(QStringLiteral("guid")));
+    QVERIFY(archives.at(2)->contains(QStringLiteral("guid")));
+    QVERIFY(archives.at(0)->isOpen());
+    QVERIFY(archives.at(0)->isModified());
+
+    // so its change is still uncommitted and can be rolled back
+    QVERIFY(m_storage->rollback());
+    QCOMPARE(archives.at(0)->title(QStringLiteral("guid")), sampleRecord().title);
+    reopen();
+    QCOMPARE(m_storage->archiveFor(urls[0])->title(QStringLiteral("guid")), sampleRecord().title);
+    Akregator::Settings::setMaxOpenArchives(maxOpenArchives);
+}
+
+void FeedStorageMK4ImplTest::shouldKeepArticlesWhenCompacting()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    for (int i = 0; i < 50; ++i) {
+        archive->writeRecord(QString::number(i), sampleRecord());
+    }
+    QVERIFY(m_storage->commit());
+    // rewriting the articles leaves free space behind in the file
+    for (int i = 0; i < 50; ++i) {
+        archive->setContent(QString::number(i), QString(1000, QLatin1Char('x')));
+        QVERIFY(m_storage->commit());
+        archive->setContent(QString::number(i), sampleRecord().content);
+        QVERIFY(m_storage->commit());
+    }
+
+    Storage::CompactionResult result = { 0, 0, 0 };
+    m_storage->compactArchive(feedUrl, 0, result);
+    m_storage->compactSharedFiles(result);
+    QVERIFY(result.files >= 1);
+    QVERIFY(result.sizeAfter <= result.sizeBefore);
+
+    QCOMPARE(archive->articles().count(), 50);
+    QCOMPARE(archive->totalCount(), 50);
+    Record read;
+    QVERIFY(archive->readRecord(QStringLiteral("49"), read));
+    compareRecords(read, sampleRecord());
+    QCOMPARE(m_storage->search(QStringLiteral("description"), 100).count(), 50);
+
+    reopen();
+    QCOMPARE(m_storage->archiveFor(feedUrl)->articles().count(), 50);
+}
+
+void FeedStorageMK4ImplTest::shouldPurgeOldDeletedArticlesWhenCompacting_data()
+{
+    QTest::addColumn<bool>("purge");
+    QTest::newRow("expiry by age") << true;
+    QTest::newRow("no expiry by age") << false;
+}
+
+void FeedStorageMK4ImplTest::shouldPurgeOldDeletedArticlesWhenCompacting()
+{
+    QFETCH(bool, purge);
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    const uint now = QDateTime::currentDateTime().toTime_t();
+    const QString guids[] = { QStringLiteral("old"), QStringLiteral("recent"), QStringLiteral("old deleted"), QStringLiteral("recent deleted") };
+    for (const QString &guid : guids) {
+        Record record = sampleRecord();
+        record.pubDate = guid.startsWith(QLatin1String("old")) ? 1000000000 : now;
+        archive->writeRecord(guid, record);
+        if (guid.endsWith(QLatin1String("deleted"))) {
+            archive->setStatus(guid, FeedStorage::DeletedFlag);
+            archive->setDeleted(guid);
+        }
+    }
+    QCOMPARE(archive->totalCount(), 2);
+    const quint64 generation = archive->generation();
+
+    Storage::CompactionResult result = { 0, 0, 0 };
+    m_storage->compactArchive(feedUrl, purge ? now - 60 * 24 * 3600 : 0, result);
+
+    // articles deleted recently keep their row, so that the feed does not add them again
+    QCOMPARE(archive->contains(QStringLiteral("old deleted")), !purge);
+    QVERIFY(archive->contains(QStringLiteral("recent deleted")));
+    QVERIFY(archive->contains(QStringLiteral("old")));
+    QVERIFY(archive->contains(QStringLiteral("recent")));
+    QCOMPARE(archive->totalCount(), 2);
+    // loaded articles are read again
+    QVERIFY(archive->generation() != generation);
+
+    reopen();
+    QCOMPARE(m_storage->archiveFor(feedUrl)->articles().count(), purge ? 3 : 4);
+}
+
+void FeedStorageMK4ImplTest::shouldRemoveFilesOfClearedArchives()
+{
+    FeedStorageMK4Impl *const archive = static_cast<FeedStorageMK4Impl *>(m_storage->archiveFor(feedUrl));
+    archive->writeRecord(QStringLiteral("guid1"), sampleRecord());
+    QVERIFY(m_storage->commit());
+    QVERIFY(QFile::exists(archive->filePath()));
+
+    m_storage->clear();
+    QVERIFY(!QFile::exists(archive->filePath()));
+
+    // the archive can be used again
+    archive->writeRecord(QStringLiteral("guid2"), sampleRecord());
+    reopen();
+    QCOMPARE(m_storage->archiveFor(feedUrl)->articles(), QStringList() << QStringLiteral("guid2"));
+}
+
+QTEST_GUILESS_MAIN(FeedStorageMK4ImplTest)
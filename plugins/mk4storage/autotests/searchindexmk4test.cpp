@@ -0,0 +1,319 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "searchindexmk4test.h"
+#include "searchindexmk4.h"
+#include "storagemk4impl.h"
+
+#include <QFile>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QVector>
+
+using namespace Akregator::Backend;
+
+typedef FeedStorage::ArticleRecord Record;
+
+namespace
+{
+const QString feedUrl = QStringLiteral("http://www.example.com/feed.rss");
+const QString otherFeedUrl = QStringLiteral("http://www.example.org/feed.rss");
+
+Record record(const QString &title, const QString &description = QString())
+{
+    Record record;
+    record.title = title;
+    record.description = description;
+    return record;
+}
+
+/** returns the guids of the hits, best match first */
+QStringList guids(const QVector<Storage::SearchHit> &hits)
+{
+    QStringList list;
+    for (const Storage::SearchHit &hit : hits) {
+        list += hit.guid;
+    }
+    return list;
+}
+
+QStringList sorted(QStringList list)
+{
+    list.sort();
+    return list;
+}
+}
+
+SearchIndexMK4Test::SearchIndexMK4Test(QObject *parent)
+    : QObject(parent)
+    , m_dir(nullptr)
+{
+}
+
+SearchIndexMK4Test::~SearchIndexMK4Test()
+{
+}
+
+void SearchIndexMK4Test::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void SearchIndexMK4Test::init()
+{
+    m_dir = new QTemporaryDir;
+    QVERIFY(m_dir->isValid());
+}
+
+void SearchIndexMK4Test::cleanup()
+{
+    delete m_dir;
+    m_dir = nullptr;
+}
+
+void SearchIndexMK4Test::shouldFindAddedArticles()
+{
+    SearchIndexMK4 index(m_dir->path());
+    index.addArticle(feedUrl, QStringLiteral("a"), record(QStringLiteral("Kernel Release"), QStringLiteral("<p>A new <b>kernel</b> is out&nbsp;now</p>")));
+    index.addArticle(otherFeedUrl, QStringLiteral("b"), record(QStringLiteral("Desktop news")));
+
+    const QVector<Storage::SearchHit> hits = index.search(QStringLiteral("KERNEL"), 10);
+    QCOMPARE(guids(hits), QStringList() << QStringLiteral("a"));
+    QCOMPARE(hits.at(0).feedUrl, feedUrl);
+    QCOMPARE(guids(index.search(QStringLiteral("news"), 10)), QStringList() << QStringLiteral("b"));
+    // markup is not indexed
+    QVERIFY(index.search(QStringLiteral("nbsp"), 10).isEmpty());
+    QVERIFY(index.search(QStringLiteral("unknown"), 10).isEmpty());
+}
+
+void SearchIndexMK4Test::shouldRequireAllQueryWords()
+{
+    SearchIndexMK4 index(m_dir->path());
+    index.addArticle(feedUrl, QStringLiteral("a"), record(QStringLiteral("kernel release")));
+    index.addArticle(feedUrl, QStringLiteral("b"), record(QStringLiteral("kernel bug")));
+    index.addArticle(feedUrl, QStringLiteral("c"), record(QStringLiteral("desktop release")));
+
+    QCOMPARE(guids(index.search(QStringLiteral("kernel release"), 10)), QStringList() << QStringLiteral("a"));
+    QCOMPARE(sorted(guids(index.search(QStringLiteral("release"), 10))), QStringList() << QStringLiteral("a") << QStringLiteral("c"));
+    QVERIFY(index.search(QStringLiteral("kernel desktop"), 10).isEmpty());
+    QCOMPARE(index.search(QStringLiteral("kernel"), 1).count(), 1);
+}
+
+void SearchIndexMK4Test::shouldIgnoreStopwords()
+{
+    SearchIndexMK4 index(m_dir->path());
+    index.addArticle(feedUrl, QStringLiteral("a"), record(QStringLiteral("The state of the kernel")));
+
+    QVERIFY(index.search(QStringLiteral("the"), 10).isEmpty());
+    // stopwords in the query do not prevent matches
+    QCOMPARE(guids(index.search(QStringLiteral("the kernel"), 10)), QStringList() << QStringLiteral("a"));
+}
+
+void SearchIndexMK4Test::shouldRemoveArticles()
+{
+    SearchIndexMK4 index(m_dir->path());
+    // the articles share their terms, so removing one moves the postings of the others
+    index.addArticle(feedUrl, QStringLiteral("a"), record(QStringLiteral("kernel release")));
+    index.addArticle(feedUrl, QStringLiteral("b"), record(QStringLiteral("kernel release")));
+    index.addArticle(feedUrl, QStringLiteral("c"), record(QStringLiteral("kernel release")));
+    index.addArticle(otherFeedUrl, QStringLiteral("a"), record(QStringLiteral("kernel")));
+
+    index.removeArticle(feedUrl, QStringLiteral("a"));
+    QCOMPARE(sorted(guids(index.search(QStringLiteral("kernel release"), 10))), QStringList() << QStringLiteral("b") << QStringLiteral("c"));
+
+    index.removeArticle(feedUrl, QStringLiteral("c"));
+    QCOMPARE(guids(index.search(QStringLiteral("kernel release"), 10)), QStringList() << QStringLiteral("b"));
+
+    index.removeArticle(feedUrl, QStringLiteral("b"));
+    QVERIFY(index.search(QStringLiteral("release"), 10).isEmpty());
+    // the same guid in another feed is a different article
+    const QVector<Storage::SearchHit> hits = index.search(QStringLiteral("kernel"), 10);
+    QCOMPARE(hits.count(), 1);
+    QCOMPARE(hits.at(0).feedUrl, otherFeedUrl);
+
+    // removing an unknown article does nothing
+    index.removeArticle(feedUrl, QStringLiteral("unknown"));
+    QCOMPARE(index.search(QStringLiteral("kernel"), 10).count(), 1);
+}
+
+void SearchIndexMK4Test::shouldReplaceChangedArticles()
+{
+    SearchIndexMK4 index(m_dir->path());
+    index.addArticle(feedUrl, QStringLiteral("a"), record(QStringLiteral("kernel release")));
+    index.addArticle(feedUrl, QStringLiteral("a"), record(QStringLiteral("desktop release")));
+
+    QVERIFY(index.search(QStringLiteral("kernel"), 10).isEmpty());
+    QCOMPARE(guids(index.search(QStringLiteral("desktop release"), 10)), QStringList() << QStringLiteral("a"));
+    QCOMPARE(index.search(QStringLiteral("release"), 10).count(), 1);
+}
+
+void SearchIndexMK4Test::shouldRankByTfIdf()
+{
+    SearchIndexMK4 index(m_dir->path());
+    // a title word weighs more than the same word in the text
+    index.addArticle(feedUrl, QStringLiteral("title"), record(QStringLiteral("kernel"), QStringLiteral("desktop")));
+    index.addArticle(feedUrl, QStringLiteral("text"), record(QStringLiteral("desktop"), QStringLiteral("kernel")));
+    QCOMPARE(guids(index.search(QStringLiteral("kernel"), 10)), QStringList() << QStringLiteral("title") << QStringLiteral("text"));
+
+    // more occurrences of a rare word beat more occurrences of a common one
+    index.addArticle(feedUrl, QStringLiteral("rare"), record(QString(), QStringLiteral("scheduler scheduler patch")));
+    index.addArticle(feedUrl, QStringLiteral("common"), record(QString(), QStringLiteral("scheduler patch patch")));
+    for (int i = 0; i < 5; ++i) {
+        index.addArticle(otherFeedUrl, QString::number(i), record(QString(), QStringLiteral("patch")));
+    }
+    const QVector<Storage::SearchHit> hits = index.search(QStringLiteral("scheduler patch"), 10);
+    QCOMPARE(guids(hits), QStringList() << QStringLiteral("rare") << QStringLiteral("common"));
+    QVERIFY(hits.at(0).score > hits.at(1).score);
+}
+
+void SearchIndexMK4Test::shouldKeepIndexAfterReopening()
+{
+    {
+        SearchIndexMK4 index(m_dir->path());
+        QVERIFY(!index.isComplete());
+        index.addArticle(feedUrl, QStringLiteral("a"), record(QStringLiteral("kernel release")));
+        index.addArticle(feedUrl, QStringLiteral("b"), record(QStringLiteral("kernel bug")));
+        index.setComplete();
+        index.commit();
+    }
+    SearchIndexMK4 index(m_dir->path());
+    QVERIFY(index.isComplete());
+    index.removeArticle(feedUrl, QStringLiteral("a"));
+    QCOMPARE(guids(index.search(QStringLiteral("kernel"), 10)), QStringList() << QStringLiteral("b"));
+
+    // uncommitted changes are rolled back
+    index.rollback();
+    QCOMPARE(index.search(QStringLiteral("kernel"), 10).count(), 2);
+}
+
+void SearchIndexMK4Test::shouldIndexQueuedArticlesOnCommit()
+{
+    StorageMK4Impl storage;
+    storage.setArchivePath(m_dir->path());
+    QVERIFY(storage.open(true));
+    SearchIndexMK4 *const index = storage.searchIndex();
+    QTRY_VERIFY(index->isComplete());
+
+    FeedStorage *const archive = storage.archiveFor(feedUrl);
+    archive->writeRecord(QStringLiteral("a"), record(QStringLiteral("kernel release")));
+    archive->setTitle(QStringLiteral("a"), QStringLiteral("kernel bug"));
+    QVERIFY(index->hasQueuedArticles());
+    // nothing is indexed before the batch
+    QVERIFY(index->search(QStringLiteral("kernel"), 10).isEmpty());
+
+    QVERIFY(storage.commit());
+    QVERIFY(!index->hasQueuedArticles());
+    QCOMPARE(guids(index->search(QStringLiteral("kernel bug"), 10)), QStringList() << QStringLiteral("a"));
+    QVERIFY(index->search(QStringLiteral("release"), 10).isEmpty());
+
+    // searching the storage indexes the queue first
+    archive->writeRecord(QStringLiteral("b"), record(QStringLiteral("kernel patch")));
+    QCOMPARE(guids(storage.search(QStringLiteral("patch"), 10)), QStringList() << QStringLiteral("b"));
+}
+
+void SearchIndexMK4Test::shouldDropDeletedArticles()
+{
+    StorageMK4Impl storage;
+    storage.setArchivePath(m_dir->path());
+    QVERIFY(storage.open(true));
+    QTRY_VERIFY(storage.searchIndex()->isComplete());
+
+    FeedStorage *const archive = storage.archiveFor(feedUrl);
+    archive->writeRecord(QStringLiteral("a"), record(QStringLiteral("kernel release")));
+    archive->writeRecord(QStringLiteral("b"), record(QStringLiteral("kernel bug")));
+    archive->writeRecord(QStringLiteral("c"), record(QStringLiteral("kernel patch")));
+    QVERIFY(storage.commit());
+    QCOMPARE(storage.search(QStringLiteral("kernel"), 10).count(), 3);
+
+    archive->setDeleted(QStringLiteral("a"));
+    archive->deleteArticle(QStringLiteral("b"));
+    QVERIFY(storage.commit());
+    QCOMPARE(guids(storage.search(QStringLiteral("kernel"), 10)), QStringList() << QStringLiteral("c"));
+
+    archive->clear();
+    QVERIFY(storage.commit());
+    QVERIFY(storage.search(QStringLiteral("kernel"), 10).isEmpty());
+}
+
+void SearchIndexMK4Test::shouldCommitOnlyChangedIndex()
+{
+    StorageMK4Impl storage;
+    storage.setArchivePath(m_dir->path());
+    QVERIFY(storage.open(true));
+    SearchIndexMK4 *const index = storage.searchIndex();
+    QTRY_VERIFY(index->isComplete());
+    QVERIFY(storage.commit());
+    QVERIFY(!index->isModified());
+
+    FeedStorage *const archive = storage.archiveFor(feedUrl);
+    archive->writeRecord(QStringLiteral("a"), record(QStringLiteral("kernel release")));
+    QVERIFY(storage.commit());
+    QVERIFY(!index->isModified());
+
+    // reading an article changes its status only, which is not indexed
+    archive->setStatus(QStringLiteral("a"), FeedStorage::ReadFlag);
+    QVERIFY(!index->hasQueuedArticles());
+    QVERIFY(storage.commit());
+    QVERIFY(!index->isModified());
+
+    archive->setTitle(QStringLiteral("a"), QStringLiteral("kernel bug"));
+    QVERIFY(index->hasQueuedArticles());
+    QVERIFY(!index->isModified());
+    QVERIFY(storage.commit());
+    QVERIFY(!index->isModified());
+    QCOMPARE(guids(index->search(QStringLiteral("bug"), 10)), QStringList() << QStringLiteral("a"));
+}
+
+void SearchIndexMK4Test::shouldIndexExistingArchiveInBackground()
+{
+    {
+        StorageMK4Impl storage;
+        storage.setArchivePath(m_dir->path());
+        QVERIFY(storage.open(true));
+        for (int i = 0; i < 3; ++i) {
+            FeedStorage *const archive = storage.archiveFor(QStringLiteral("http://www.example.com/%1.rss").arg(i));
+            archive->writeRecord(QStringLiteral("a"), record(QStringLiteral("kernel release %1").arg(i)));
+            archive->writeRecord(QStringLiteral("b"), record(QStringLiteral("desktop release %1").arg(i)));
+        }
+        QVERIFY(storage.commit());
+    }
+    // an archive written before the index existed
+    QVERIFY(QFile::remove(m_dir->path() + QLatin1String("/searchindex.mk4")));
+
+    {
+        StorageMK4Impl storage;
+        storage.setArchivePath(m_dir->path());
+        QVERIFY(storage.open(true));
+        QVERIFY(!storage.searchIndex()->isComplete());
+        QTRY_VERIFY(storage.searchIndex()->isComplete());
+        QCOMPARE(storage.search(QStringLiteral("kernel"), 10).count(), 3);
+        QCOMPARE(storage.search(QStringLiteral("release"), 10).count(), 6);
+        QVERIFY(storage.commit());
+    }
+    SearchIndexMK4 index(m_dir->path());
+    QVERIFY(index.isComplete());
+    QCOMPARE(index.search(QStringLiteral("desktop"), 10).count(), 3);
+}
+
+QTEST_GUILESS_MAIN(SearchIndexMK4Test)
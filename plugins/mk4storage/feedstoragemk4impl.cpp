@@ -24,6 +24,7 @@
 
 #include "feedstoragemk4impl.h"
 #include "storagemk4impl.h"
+#include "searchindexmk4.h"
 
 #include <Syndication/DocumentSource>
 #include <Syndication/Global>
@@ -90,11 +91,49 @@ public:
         ptags("tags"),
         ptaggedArticles("taggedArticles"),
         pcategorizedArticles("categorizedArticles"),
-        pcategories("categories")
-    {}
+        pcategories("categories"),
+        lastFoundIndex(-1)
+    {
+        storage = 0;
+        generation = 0;
+    }
+
+    /** returns the article view, opening the metakit file first if it was released */
+    c4_View &view()
+    {
+        if (!storage) {
+            open();
+        }
+        mainStorage->archiveAccessed(q);
+        return archiveView;
+    }
+
+    void open();
+
+    /** finds the article @p guid in @p view, the archive view of this feed. Returns -1 if it is not in the archive */
+    int findArticle(const c4_View &view, const QString &guid);
+    /** copies the fields selected by @c fields from @c record into @c row */
+    void recordToRow(c4_Row &row, int fields, const ArticleRecord &record);
+    /** copies the fields selected by @c fields from @c row into @c record */
+    void rowToRecord(const c4_RowRef &row, int fields, ArticleRecord &record) const;
+
+    /** queues the article for the full-text index of the archive, which indexes it on the next commit */
+    void queueIndexUpdate(const QString &guid);
+
+    /** forgets the cached result of the last findArticle() call. Must be called whenever rows are added or removed */
+    void resetLastFound()
+    {
+        lastFoundGuid.clear();
+        lastFoundIndex = -1;
+    }
 
+    FeedStorageMK4Impl *q;
     QString url;
+    QString filePath;
+    /** the open metakit file, 0 while the handle is released */
     c4_Storage *storage;
+    /** see FeedStorage::generation() */
+    quint64 generation;
     StorageMK4Impl *mainStorage;
     c4_View archiveView;
 
@@ -105,8 +144,122 @@ public:
     c4_StringProp pguid, ptitle, pdescription, pcontent, plink, pcommentsLink, ptag, pEnclosureType, pEnclosureUrl, pcatTerm, pcatScheme, pcatName, pauthorName, pauthorUri, pauthorEMail;
     c4_IntProp phash, pguidIsHash, pguidIsPermaLink, pcomments, pstatus, ppubDate, pHasEnclosure, pEnclosureLength;
     c4_ViewProp ptags, ptaggedArticles, pcategorizedArticles, pcategories;
+
+    // Article writes usually follow a read of the same guid, so the last lookup is cached
+    mutable QByteArray lastFoundGuid;
+    mutable int lastFoundIndex;
 };
 
+void FeedStorageMK4Impl::FeedStorageMK4ImplPrivate::recordToRow(c4_Row &row, int fields, const ArticleRecord &record)
+{
+    if (fields & ArticleRecord::Title) {
+        ptitle(row) = !record.title.isEmpty() ? record.title.toUtf8().data() : "";
+    }
+    if (fields & ArticleRecord::Description) {
+        pdescription(row) = !record.description.isEmpty() ? record.description.toUtf8().data() : "";
+    }
+    if (fields & ArticleRecord::Content) {
+        pcontent(row) = !record.content.isEmpty() ? record.content.toUtf8().data() : "";
+    }
+    if (fields & ArticleRecord::Link) {
+        plink(row) = !record.link.isEmpty() ? record.link.toLatin1().data() : "";
+    }
+    if (fields & ArticleRecord::CommentsLink) {
+        pcommentsLink(row) = !record.commentsLink.isEmpty() ? record.commentsLink.toUtf8().data() : "";
+    }
+    if (fields & ArticleRecord::Comments) {
+        pcomments(row) = record.comments;
+    }
+    if (fields & ArticleRecord::GuidIsHash) {
+        pguidIsHash(row) = record.guidIsHash;
+    }
+    if (fields & ArticleRecord::GuidIsPermaLink) {
+        pguidIsPermaLink(row) = record.guidIsPermaLink;
+    }
+    if (fields & ArticleRecord::Hash) {
+        phash(row) = record.hash;
+    }
+    if (fields & ArticleRecord::PubDate) {
+        ppubDate(row) = record.pubDate;
+    }
+    if (fields & ArticleRecord::Status) {
+        pstatus(row) = record.status;
+    }
+    if (fields & ArticleRecord::Author) {
+        pauthorName(row) = !record.authorName.isEmpty() ? record.authorName.toUtf8().data() : "";
+        pauthorUri(row) = !record.authorUri.isEmpty() ? record.authorUri.toUtf8().data() : "";
+        pauthorEMail(row) = !record.authorEMail.isEmpty() ? record.authorEMail.toUtf8().data() : "";
+    }
+    if (fields & ArticleRecord::Enclosure) {
+        if (record.hasEnclosure) {
+            pHasEnclosure(row) = true;
+            pEnclosureUrl(row) = !record.enclosureUrl.isEmpty() ? record.enclosureUrl.toUtf8().data() : "";
+            pEnclosureType(row) = !record.enclosureType.isEmpty() ? record.enclosureType.toUtf8().data() : "";
+            pEnclosureLength(row) = record.enclosureLength;
+        } else {
+            pHasEnclosure(row) = false;
+            pEnclosureUrl(row) = "";
+            pEnclosureType(row) = "";
+            pEnclosureLength(row) = -1;
+        }
+    }
+}
+
+void FeedStorageMK4Impl::FeedStorageMK4ImplPrivate::queueIndexUpdate(const QString &guid)
+{
+    if (SearchIndexMK4 *const index = mainStorage->searchIndex()) {
+        index->queueArticle(url, guid);
+    }
+}
+
+void FeedStorageMK4Impl::FeedStorageMK4ImplPrivate::rowToRecord(const c4_RowRef &row, int fields, ArticleRecord &record) const
+{
+    if (fields & ArticleRecord::Title) {
+        record.title = QString::fromUtf8(ptitle(row));
+    }
+    if (fields & ArticleRecord::Description) {
+        record.description = QString::fromUtf8(pdescription(row));
+    }
+    if (fields & ArticleRecord::Content) {
+        record.content = QString::fromUtf8(pcontent(row));
+    }
+    if (fields & ArticleRecord::Link) {
+        record.link = QString::fromLatin1(plink(row));
+    }
+    if (fields & ArticleRecord::CommentsLink) {
+        record.commentsLink = QString::fromLatin1(pcommentsLink(row));
+    }
+    if (fields & ArticleRecord::Comments) {
+        record.comments = pcomments(row);
+    }
+    if (fields & ArticleRecord::GuidIsHash) {
+        record.guidIsHash = pguidIsHash(row);
+    }
+    if (fields & ArticleRecord::GuidIsPermaLink) {
+        record.guidIsPermaLink = pguidIsPermaLink(row);
+    }
+    if (fields & ArticleRecord::Hash) {
+        record.hash = phash(row);
+    }
+    if (fields & ArticleRecord::PubDate) {
+        record.pubDate = ppubDate(row);
+    }
+    if (fields & ArticleRecord::Status) {
+        record.status = pstatus(row);
+    }
+    if (fields & ArticleRecord::Author) {
+        record.authorName = QString::fromUtf8(pauthorName(row));
+        record.authorUri = QString::fromUtf8(pauthorUri(row));
+        record.authorEMail = QString::fromUtf8(pauthorEMail(row));
+    }
+    if (fields & ArticleRecord::Enclosure) {
+        record.hasEnclosure = pHasEnclosure(row);
+        record.enclosureUrl = QLatin1String(pEnclosureUrl(row));
+        record.enclosureType = QLatin1String(pEnclosureType(row));
+        record.enclosureLength = pEnclosureLength(row);
+    }
+}
+
 void FeedStorageMK4Impl::convertOldArchive()
 {
     if (!d->convert) {
@@ -136,6 +289,7 @@ void FeedStorageMK4Impl::convertOldArchive()
 FeedStorageMK4Impl::FeedStorageMK4Impl(const QString &url, StorageMK4Impl *main)
 {
     d = new FeedStorageMK4ImplPrivate;
+    d->q = this;
     d->autoCommit = main->autoCommit();
     d->url = url;
     d->mainStorage = main;
@@ -152,12 +306,20 @@ FeedStorageMK4Impl::FeedStorageMK4Impl(const QString &url, StorageMK4Impl *main)
     QString filePath = main->archivePath() + QLatin1Char('/') + t.replace(QLatin1Char('/'), QLatin1Char('_')).replace(QLatin1Char(':'), QLatin1Char('_'));
     d->oldArchivePath = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/akregator/Archive/") + t2.replace(QLatin1Char('/'), QLatin1Char('_')).replace(QLatin1Char(':'), QLatin1Char('_')) + QLatin1String(".xml");
     d->convert = !QFile::exists(filePath + QLatin1String(".mk4")) && QFile::exists(d->oldArchivePath);
-    d->storage = new c4_Storage(QString(filePath + QLatin1String(".mk4")).toLocal8Bit(), true);
+    d->filePath = filePath + QLatin1String(".mk4");
+    // the file is opened on first access, see FeedStorageMK4ImplPrivate::view()
+}
 
-    d->archiveView = d->storage->GetAs("articles[guid:S,title:S,hash:I,guidIsHash:I,guidIsPermaLink:I,description:S,link:S,comments:I,commentsLink:S,status:I,pubDate:I,tags[tag:S],hasEnclosure:I,enclosureUrl:S,enclosureType:S,enclosureLength:I,categories[catTerm:S,catScheme:S,catName:S],authorName:S,content:S,authorUri:S,authorEMail:S]");
+void FeedStorageMK4Impl::FeedStorageMK4ImplPrivate::open()
+{
+    storage = new c4_Storage(filePath.toLocal8Bit(), true);
 
-    c4_View hash = d->storage->GetAs("archiveHash[_H:I,_R:I]");
-    d->archiveView = d->archiveView.Hash(hash, 1); // hash on guid
+    archiveView = storage->GetAs("articles[guid:S,title:S,hash:I,guidIsHash:I,guidIsPermaLink:I,description:S,link:S,comments:I,commentsLink:S,status:I,pubDate:I,tags[tag:S],hasEnclosure:I,enclosureUrl:S,enclosureType:S,enclosureLength:I,categories[catTerm:S,catScheme:S,catName:S],authorName:S,content:S,authorUri:S,authorEMail:S]");
+
+    c4_View hash = storage->GetAs("archiveHash[_H:I,_R:I]");
+    archiveView = archiveView.Hash(hash, 1); // hash on guid
+
+    mainStorage->archiveOpened(q);
 }
 
 FeedStorageMK4Impl::~FeedStorageMK4Impl()
@@ -171,21 +333,65 @@ void FeedStorageMK4Impl::markDirty()
     if (!d->modified) {
         d->modified = true;
         // Tell this to mainStorage
-        d->mainStorage->markDirty();
+        d->mainStorage->markDirty(this);
     }
 }
 
 void FeedStorageMK4Impl::commit()
 {
-    if (d->modified) {
+    if (d->modified && d->storage) {
         d->storage->Commit();
     }
     d->modified = false;
 }
 
+void FeedStorageMK4Impl::release()
+{
+    if (!d->storage) {
+        return;
+    }
+    commit();
+    d->archiveView = c4_View();
+    delete d->storage;
+    d->storage = 0;
+    d->resetLastFound();
+    // the file may be compacted or replaced until it is opened again
+    ++d->generation;
+}
+
+bool FeedStorageMK4Impl::isOpen() const
+{
+    return d->storage != 0;
+}
+
+bool FeedStorageMK4Impl::isModified() const
+{
+    return d->modified;
+}
+
+QString FeedStorageMK4Impl::filePath() const
+{
+    return d->filePath;
+}
+
 void FeedStorageMK4Impl::rollback()
 {
-    d->storage->Rollback();
+    if (d->storage) {
+        d->storage->Rollback();
+    }
+    d->modified = false;
+    d->resetLastFound();
+    ++d->generation;
+}
+
+QString FeedStorageMK4Impl::url() const
+{
+    return d->url;
+}
+
+quint64 FeedStorageMK4Impl::generation() const
+{
+    return d->generation;
 }
 
 void FeedStorageMK4Impl::close()
@@ -223,15 +429,26 @@ void FeedStorageMK4Impl::setLastFetch(int lastFetch)
     d->mainStorage->setLastFetchFor(d->url, lastFetch);
 }
 
+FetchValidators FeedStorageMK4Impl::fetchValidators() const
+{
+    return d->mainStorage->fetchValidatorsFor(d->url);
+}
+
+void FeedStorageMK4Impl::setFetchValidators(const FetchValidators &validators)
+{
+    d->mainStorage->setFetchValidatorsFor(d->url, validators);
+}
+
 QStringList FeedStorageMK4Impl::articles(const QString &tag) const
 {
     QStringList list;
 #if 0 //category and tag support disabled
     if (tag.isNull()) { // return all articles
 #endif
-        int size = d->archiveView.GetSize();
+        const c4_View &view = d->view();
+        int size = view.GetSize();
         for (int i = 0; i < size; ++i) { // fill with guids
-            list += QString::fromLatin1(d->pguid(d->archiveView.GetAt(i)));
+            list += QString::fromLatin1(d->pguid(view.GetAt(i)));
         }
 #if 0 //category and tag support disabled
     } else {
@@ -273,12 +490,47 @@ QStringList FeedStorageMK4Impl::articles(const Category &cat) const
     return list;
 }
 
+QStringList FeedStorageMK4Impl::articlesPublishedBefore(uint pubDate) const
+{
+    QStringList list;
+    const c4_View &view = d->view();
+    const int size = view.GetSize();
+    for (int i = 0; i < size; ++i) {
+        const c4_RowRef row = view[i];
+        if (static_cast<uint>(d->ppubDate(row)) < pubDate && !(d->pstatus(row) & DeletedFlag)) {
+            list += QString::fromLatin1(d->pguid(row));
+        }
+    }
+    return list;
+}
+
+int FeedStorageMK4Impl::purgeDeletedArticles(uint pubDate)
+{
+    // the deleted articles are blanked and not indexed any more, so only the rows are left to remove
+    int purged = 0;
+    c4_View &view = d->view();
+    for (int i = view.GetSize() - 1; i >= 0; --i) {
+        const c4_RowRef row = view[i];
+        if ((d->pstatus(row) & DeletedFlag) && static_cast<uint>(d->ppubDate(row)) < pubDate) {
+            view.RemoveAt(i);
+            ++purged;
+        }
+    }
+    if (purged > 0) {
+        d->resetLastFound();
+        markDirty();
+    }
+    return purged;
+}
+
 void FeedStorageMK4Impl::addEntry(const QString &guid)
 {
     c4_Row row;
     d->pguid(row) = guid.toLatin1();
-    if (!contains(guid)) {
-        d->archiveView.Add(row);
+    c4_View &view = d->view();
+    if (d->findArticle(view, guid) == -1) {
+        view.Add(row);
+        d->resetLastFound();
         markDirty();
         setTotalCount(totalCount() + 1);
     }
@@ -286,70 +538,90 @@ void FeedStorageMK4Impl::addEntry(const QString &guid)
 
 bool FeedStorageMK4Impl::contains(const QString &guid) const
 {
-    return findArticle(guid) != -1;
+    return d->findArticle(d->view(), guid) != -1;
 }
 
-int FeedStorageMK4Impl::findArticle(const QString &guid) const
+int FeedStorageMK4Impl::FeedStorageMK4ImplPrivate::findArticle(const c4_View &view, const QString &guid)
 {
+    const QByteArray guidLatin1 = guid.toLatin1();
+    if (lastFoundIndex != -1 && guidLatin1 == lastFoundGuid) {
+        return lastFoundIndex;
+    }
     c4_Row findrow;
-    d->pguid(findrow) = guid.toLatin1();
-    return d->archiveView.Find(findrow);
+    pguid(findrow) = guidLatin1.constData();
+    const int findidx = view.Find(findrow);
+    if (findidx != -1) {
+        lastFoundGuid = guidLatin1;
+        lastFoundIndex = findidx;
+    }
+    return findidx;
 }
 
 void FeedStorageMK4Impl::deleteArticle(const QString &guid)
 {
 
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx != -1) {
         QStringList list = tags(guid);
         for (QStringList::ConstIterator it = list.constBegin(); it != list.constEnd(); ++it) {
             removeTag(guid, *it);
         }
-        setTotalCount(totalCount() - 1);
-        d->archiveView.RemoveAt(findidx);
+        if (!(d->pstatus(view.GetAt(findidx)) & DeletedFlag)) {
+            setTotalCount(totalCount() - 1);
+        }
+        view.RemoveAt(findidx);
+        d->resetLastFound();
+        d->queueIndexUpdate(guid);
         markDirty();
     }
 }
 
 int FeedStorageMK4Impl::comments(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? d->pcomments(d->archiveView.GetAt(findidx)) : 0;
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
+    return findidx != -1 ? d->pcomments(view.GetAt(findidx)) : 0;
 }
 
 QString FeedStorageMK4Impl::commentsLink(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? QString::fromLatin1(d->pcommentsLink(d->archiveView.GetAt(findidx))) : QLatin1String("");
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
+    return findidx != -1 ? QString::fromLatin1(d->pcommentsLink(view.GetAt(findidx))) : QLatin1String("");
 }
 
 bool FeedStorageMK4Impl::guidIsHash(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? d->pguidIsHash(d->archiveView.GetAt(findidx)) : false;
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
+    return findidx != -1 ? d->pguidIsHash(view.GetAt(findidx)) : false;
 }
 
 bool FeedStorageMK4Impl::guidIsPermaLink(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? d->pguidIsPermaLink(d->archiveView.GetAt(findidx)) : false;
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
+    return findidx != -1 ? d->pguidIsPermaLink(view.GetAt(findidx)) : false;
 }
 
 uint FeedStorageMK4Impl::hash(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? d->phash(d->archiveView.GetAt(findidx)) : 0;
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
+    return findidx != -1 ? d->phash(view.GetAt(findidx)) : 0;
 }
 
 void FeedStorageMK4Impl::setDeleted(const QString &guid)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
 
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     QStringList list = tags(guid);
     for (QStringList::ConstIterator it = list.constBegin(); it != list.constEnd(); ++it) {
         removeTag(guid, *it);
@@ -362,255 +634,288 @@ void FeedStorageMK4Impl::setDeleted(const QString &guid)
     d->pauthorUri(row) = "";
     d->pauthorEMail(row) = "";
     d->pcommentsLink(row) = "";
-    d->archiveView.SetAt(findidx, row);
+    view.SetAt(findidx, row);
+    d->queueIndexUpdate(guid);
     markDirty();
 }
 
 QString FeedStorageMK4Impl::link(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? QString::fromLatin1(d->plink(d->archiveView.GetAt(findidx))) : QLatin1String("");
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
+    return findidx != -1 ? QString::fromLatin1(d->plink(view.GetAt(findidx))) : QLatin1String("");
 }
 
 uint FeedStorageMK4Impl::pubDate(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? d->ppubDate(d->archiveView.GetAt(findidx)) : 0;
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
+    return findidx != -1 ? d->ppubDate(view.GetAt(findidx)) : 0;
 }
 
 int FeedStorageMK4Impl::status(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? d->pstatus(d->archiveView.GetAt(findidx)) : 0;
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
+    return findidx != -1 ? d->pstatus(view.GetAt(findidx)) : 0;
 }
 
 void FeedStorageMK4Impl::setStatus(const QString &guid, int status)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
+    const int delta = totalCountDelta(d->pstatus(row), status);
     d->pstatus(row) = status;
-    d->archiveView.SetAt(findidx, row);
+    view.SetAt(findidx, row);
     markDirty();
+    if (delta != 0) {
+        setTotalCount(totalCount() + delta);
+    }
 }
 
 QString FeedStorageMK4Impl::title(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? QString::fromUtf8(d->ptitle(d->archiveView.GetAt(findidx))) : QLatin1String("");
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
+    return findidx != -1 ? QString::fromUtf8(d->ptitle(view.GetAt(findidx))) : QLatin1String("");
 }
 
 QString FeedStorageMK4Impl::description(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? QString::fromUtf8(d->pdescription(d->archiveView.GetAt(findidx))) : QLatin1String("");
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
+    return findidx != -1 ? QString::fromUtf8(d->pdescription(view.GetAt(findidx))) : QLatin1String("");
 }
 
 QString FeedStorageMK4Impl::content(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? QString::fromUtf8(d->pcontent(d->archiveView.GetAt(findidx))) : QLatin1String("");
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
+    return findidx != -1 ? QString::fromUtf8(d->pcontent(view.GetAt(findidx))) : QLatin1String("");
 }
 
 void FeedStorageMK4Impl::setPubDate(const QString &guid, uint pubdate)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     d->ppubDate(row) = pubdate;
-    d->archiveView.SetAt(findidx, row);
+    view.SetAt(findidx, row);
     markDirty();
 }
 
 void FeedStorageMK4Impl::setGuidIsHash(const QString &guid, bool isHash)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     d->pguidIsHash(row) = isHash;
-    d->archiveView.SetAt(findidx, row);
+    view.SetAt(findidx, row);
     markDirty();
 }
 
 void FeedStorageMK4Impl::setLink(const QString &guid, const QString &link)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     d->plink(row) = !link.isEmpty() ? link.toLatin1() : "";
-    d->archiveView.SetAt(findidx, row);
+    view.SetAt(findidx, row);
     markDirty();
 }
 
 void FeedStorageMK4Impl::setHash(const QString &guid, uint hash)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     d->phash(row) = hash;
-    d->archiveView.SetAt(findidx, row);
+    view.SetAt(findidx, row);
     markDirty();
 }
 
 void FeedStorageMK4Impl::setTitle(const QString &guid, const QString &title)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     d->ptitle(row) = !title.isEmpty() ? title.toUtf8().data() : "";
-    d->archiveView.SetAt(findidx, row);
+    view.SetAt(findidx, row);
+    d->queueIndexUpdate(guid);
     markDirty();
 }
 
 void FeedStorageMK4Impl::setDescription(const QString &guid, const QString &description)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     d->pdescription(row) = !description.isEmpty() ? description.toUtf8().data() : "";
-    d->archiveView.SetAt(findidx, row);
+    view.SetAt(findidx, row);
+    d->queueIndexUpdate(guid);
     markDirty();
 }
 
 void FeedStorageMK4Impl::setContent(const QString &guid, const QString &content)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     d->pcontent(row) = !content.isEmpty() ? content.toUtf8().data() : "";
-    d->archiveView.SetAt(findidx, row);
+    view.SetAt(findidx, row);
+    d->queueIndexUpdate(guid);
     markDirty();
 }
 
 void FeedStorageMK4Impl::setAuthorName(const QString &guid, const QString &author)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     d->pauthorName(row) = !author.isEmpty() ? author.toUtf8().data() : "";
-    d->archiveView.SetAt(findidx, row);
+    view.SetAt(findidx, row);
+    d->queueIndexUpdate(guid);
     markDirty();
 }
 
 void FeedStorageMK4Impl::setAuthorUri(const QString &guid, const QString &author)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     d->pauthorUri(row) = !author.isEmpty() ? author.toUtf8().data() : "";
-    d->archiveView.SetAt(findidx, row);
+    view.SetAt(findidx, row);
     markDirty();
 }
 
 void FeedStorageMK4Impl::setAuthorEMail(const QString &guid, const QString &author)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     d->pauthorEMail(row) = !author.isEmpty() ? author.toUtf8().data() : "";
-    d->archiveView.SetAt(findidx, row);
+    view.SetAt(findidx, row);
     markDirty();
 }
 
 QString FeedStorageMK4Impl::authorName(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? QString::fromUtf8(d->pauthorName(d->archiveView.GetAt(findidx))) : QString();
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
+    return findidx != -1 ? QString::fromUtf8(d->pauthorName(view.GetAt(findidx))) : QString();
 }
 
 QString FeedStorageMK4Impl::authorUri(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? QString::fromUtf8(d->pauthorUri(d->archiveView.GetAt(findidx))) : QString();
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
+    return findidx != -1 ? QString::fromUtf8(d->pauthorUri(view.GetAt(findidx))) : QString();
 }
 
 QString FeedStorageMK4Impl::authorEMail(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? QString::fromUtf8(d->pauthorEMail(d->archiveView.GetAt(findidx))) : QString();
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
+    return findidx != -1 ? QString::fromUtf8(d->pauthorEMail(view.GetAt(findidx))) : QString();
 }
 
 void FeedStorageMK4Impl::setCommentsLink(const QString &guid, const QString &commentsLink)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     d->pcommentsLink(row) = !commentsLink.isEmpty() ? commentsLink.toUtf8().data() : "";
-    d->archiveView.SetAt(findidx, row);
+    view.SetAt(findidx, row);
     markDirty();
 }
 
 void FeedStorageMK4Impl::setComments(const QString &guid, int comments)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     d->pcomments(row) = comments;
-    d->archiveView.SetAt(findidx, row);
+    view.SetAt(findidx, row);
     markDirty();
 }
 
 void FeedStorageMK4Impl::setGuidIsPermaLink(const QString &guid, bool isPermaLink)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     d->pguidIsPermaLink(row) = isPermaLink;
-    d->archiveView.SetAt(findidx, row);
+    view.SetAt(findidx, row);
     markDirty();
 }
 
 void FeedStorageMK4Impl::addCategory(const QString &guid, const Category &cat)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
 
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     c4_View catView = d->pcategories(row);
     c4_Row findrow;
 
@@ -622,7 +927,7 @@ void FeedStorageMK4Impl::addCategory(const QString &guid, const Category &cat)
         d->pcatName(findrow) = cat.name.toUtf8().data();
         catidx = catView.Add(findrow);
         d->pcategories(row) = catView;
-        d->archiveView.SetAt(findidx, row);
+        view.SetAt(findidx, row);
 
         // add to category->articles index
         c4_Row catrow;
@@ -659,13 +964,14 @@ QList<Category> FeedStorageMK4Impl::categories(const QString &guid) const
     QList<Category> list;
 
     if (!guid.isNull()) { // return categories for an article
-        int findidx = findArticle(guid);
+        c4_View &view = d->view();
+        int findidx = d->findArticle(view, guid);
         if (findidx == -1) {
             return list;
         }
 
         c4_Row row;
-        row = d->archiveView.GetAt(findidx);
+        row = view.GetAt(findidx);
         c4_View catView = d->pcategories(row);
         int size = catView.GetSize();
 
@@ -701,13 +1007,14 @@ QList<Category> FeedStorageMK4Impl::categories(const QString &guid) const
 void FeedStorageMK4Impl::addTag(const QString &guid, const QString &tag)
 {
 #if 0 //category and tag support disabled
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
 
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     c4_View tagView = d->ptags(row);
     c4_Row findrow;
     d->ptag(findrow) = tag.toUtf8().data();
@@ -715,7 +1022,7 @@ void FeedStorageMK4Impl::addTag(const QString &guid, const QString &tag)
     if (tagidx == -1) {
         tagidx = tagView.Add(findrow);
         d->ptags(row) = tagView;
-        d->archiveView.SetAt(findidx, row);
+        view.SetAt(findidx, row);
 
         // add to tag->articles index
         c4_Row tagrow;
@@ -744,13 +1051,14 @@ void FeedStorageMK4Impl::addTag(const QString &guid, const QString &tag)
 void FeedStorageMK4Impl::removeTag(const QString &guid, const QString &tag)
 {
 #if 0 //category and tag support disabled
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
 
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     c4_View tagView = d->ptags(row);
     c4_Row findrow;
     d->ptag(findrow) = tag.toUtf8().data();
@@ -758,7 +1066,7 @@ void FeedStorageMK4Impl::removeTag(const QString &guid, const QString &tag)
     if (tagidx != -1) {
         tagView.RemoveAt(tagidx);
         d->ptags(row) = tagView;
-        d->archiveView.SetAt(findidx, row);
+        view.SetAt(findidx, row);
 
         // remove from tag->articles index
         c4_Row tagrow;
@@ -790,13 +1098,14 @@ QStringList FeedStorageMK4Impl::tags(const QString &guid) const
     QStringList list;
 #if 0 //category and tag support disabled
     if (!guid.isNull()) { // return tags for an articles
-        int findidx = findArticle(guid);
+        c4_View &view = d->view();
+        int findidx = d->findArticle(view, guid);
         if (findidx == -1) {
             return list;
         }
 
         c4_Row row;
-        row = d->archiveView.GetAt(findidx);
+        row = view.GetAt(findidx);
         c4_View tagView = d->ptags(row);
         int size = tagView.GetSize();
 
@@ -821,27 +1130,15 @@ void FeedStorageMK4Impl::add(FeedStorage *source)
     }
     setUnread(source->unread());
     setLastFetch(source->lastFetch());
+    setFetchValidators(source->fetchValidators());
     setTotalCount(source->totalCount());
 }
 
 void FeedStorageMK4Impl::copyArticle(const QString &guid, FeedStorage *source)
 {
-    if (!contains(guid)) {
-        addEntry(guid);
-    }
-    setComments(guid, source->comments(guid));
-    setCommentsLink(guid, source->commentsLink(guid));
-    setDescription(guid, source->description(guid));
-    setGuidIsHash(guid, source->guidIsHash(guid));
-    setGuidIsPermaLink(guid, source->guidIsPermaLink(guid));
-    setHash(guid, source->hash(guid));
-    setLink(guid, source->link(guid));
-    setPubDate(guid, source->pubDate(guid));
-    setStatus(guid, source->status(guid));
-    setTitle(guid, source->title(guid));
-    setAuthorName(guid, source->authorName(guid));
-    setAuthorUri(guid, source->authorUri(guid));
-    setAuthorEMail(guid, source->authorEMail(guid));
+    ArticleRecord record;
+    source->readRecord(guid, record);
+    writeRecord(guid, record);
 
     QStringList tags = source->tags(guid);
     for (QStringList::ConstIterator it = tags.constBegin(); it != tags.constEnd(); ++it) {
@@ -851,41 +1148,44 @@ void FeedStorageMK4Impl::copyArticle(const QString &guid, FeedStorage *source)
 
 void FeedStorageMK4Impl::setEnclosure(const QString &guid, const QString &url, const QString &type, int length)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     d->pHasEnclosure(row) = true;
     d->pEnclosureUrl(row) = !url.isEmpty() ? url.toUtf8().data() : "";
     d->pEnclosureType(row) = !type.isEmpty() ? type.toUtf8().data() : "";
     d->pEnclosureLength(row) = length;
 
-    d->archiveView.SetAt(findidx, row);
+    view.SetAt(findidx, row);
     markDirty();
 }
 
 void FeedStorageMK4Impl::removeEnclosure(const QString &guid)
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         return;
     }
     c4_Row row;
-    row = d->archiveView.GetAt(findidx);
+    row = view.GetAt(findidx);
     d->pHasEnclosure(row) = false;
     d->pEnclosureUrl(row) = "";
     d->pEnclosureType(row) = "";
     d->pEnclosureLength(row) = -1;
 
-    d->archiveView.SetAt(findidx, row);
+    view.SetAt(findidx, row);
     markDirty();
 }
 
 void FeedStorageMK4Impl::enclosure(const QString &guid, bool &hasEnclosure, QString &url, QString &type, int &length) const
 {
-    int findidx = findArticle(guid);
+    c4_View &view = d->view();
+    int findidx = d->findArticle(view, guid);
     if (findidx == -1) {
         hasEnclosure = false;
         url.clear();
@@ -893,18 +1193,131 @@ void FeedStorageMK4Impl::enclosure(const QString &guid, bool &hasEnclosure, QStr
         length = -1;
         return;
     }
-    c4_Row row = d->archiveView.GetAt(findidx);
+    c4_Row row = view.GetAt(findidx);
     hasEnclosure = d->pHasEnclosure(row);
     url = QLatin1String(d->pEnclosureUrl(row));
     type = QLatin1String(d->pEnclosureType(row));
     length = d->pEnclosureLength(row);
 }
 
+bool FeedStorageMK4Impl::readRecord(const QString &guid, ArticleRecord &record, int fields) const
+{
+    c4_View &view = d->view();
+    const int findidx = d->findArticle(view, guid);
+    if (findidx == -1) {
+        return false;
+    }
+    d->rowToRecord(view.GetAt(findidx), fields, record);
+    return true;
+}
+
+void FeedStorageMK4Impl::writeRecord(const QString &guid, const ArticleRecord &record)
+{
+    c4_View &view = d->view();
+    const int findidx = d->findArticle(view, guid);
+    if (findidx == -1) {
+        c4_Row row;
+        d->pguid(row) = guid.toLatin1();
+        d->recordToRow(row, ArticleRecord::AllFields, record);
+        view.Add(row);
+        d->resetLastFound();
+        d->queueIndexUpdate(guid);
+        markDirty();
+        setTotalCount(totalCount() + totalCountDelta(DeletedFlag, record.status));
+        return;
+    }
+    c4_Row row;
+    row = view.GetAt(findidx);
+    const int delta = totalCountDelta(d->pstatus(row), record.status);
+    d->recordToRow(row, ArticleRecord::AllFields, record);
+    view.SetAt(findidx, row);
+    d->queueIndexUpdate(guid);
+    markDirty();
+    if (delta != 0) {
+        setTotalCount(totalCount() + delta);
+    }
+}
+
+void FeedStorageMK4Impl::updateFields(const QString &guid, int fields, const ArticleRecord &record)
+{
+    c4_View &view = d->view();
+    const int findidx = d->findArticle(view, guid);
+    if (findidx == -1 || fields == 0) {
+        return;
+    }
+    c4_Row row;
+    row = view.GetAt(findidx);
+    const int delta = (fields & ArticleRecord::Status) ? totalCountDelta(d->pstatus(row), record.status) : 0;
+    d->recordToRow(row, fields, record);
+    view.SetAt(findidx, row);
+    if (fields & SearchIndexMK4::IndexedFields) {
+        d->queueIndexUpdate(guid);
+    }
+    markDirty();
+    if (delta != 0) {
+        setTotalCount(totalCount() + delta);
+    }
+}
+
+QVector<FeedStorage::IngestResult> FeedStorageMK4Impl::ingest(const QVector<ItemRecord> &items)
+{
+    QVector<IngestResult> results;
+    results.reserve(items.count());
+    int added = 0;
+    bool modified = false;
+    c4_View &view = view;
+
+    for (const ItemRecord &item : items) {
+        c4_Row row;
+        d->pguid(row) = item.guid.toLatin1().constData();
+        const int findidx = view.Find(row);
+        if (findidx == -1) {
+            d->recordToRow(row, ArticleRecord::AllFields, item.record);
+            view.Add(row);
+            d->queueIndexUpdate(item.guid);
+            added += totalCountDelta(DeletedFlag, item.record.status);
+            modified = true;
+            results.append(Inserted);
+        } else if (static_cast<uint>(d->phash(view.GetAt(findidx))) == item.record.hash) {
+            results.append(Unchanged);
+        } else {
+            row = view.GetAt(findidx);
+            if (item.fields & ArticleRecord::Status) {
+                added += totalCountDelta(d->pstatus(row), item.record.status);
+            }
+            d->recordToRow(row, item.fields, item.record);
+            view.SetAt(findidx, row);
+            if (item.fields & SearchIndexMK4::IndexedFields) {
+                d->queueIndexUpdate(item.guid);
+            }
+            modified = true;
+            results.append(Updated);
+        }
+    }
+
+    d->resetLastFound();
+    if (added != 0) {
+        setTotalCount(totalCount() + added);
+    }
+    if (modified) {
+        markDirty();
+    }
+    return results;
+}
+
 void FeedStorageMK4Impl::clear()
 {
+    // the queued articles are no longer in the archive, so the index drops them
+    const QStringList guids = articles();
+    for (const QString &guid : guids) {
+        d->queueIndexUpdate(guid);
+    }
     d->storage->RemoveAll();
+    d->resetLastFound();
 
     setUnread(0);
+    setTotalCount(0);
+    ++d->generation;
     markDirty();
 }
 
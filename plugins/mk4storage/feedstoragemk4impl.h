@@ -46,10 +46,13 @@ public:
     int totalCount() const override;
     int lastFetch() const override;
     void setLastFetch(int lastFetch) override;
+    FetchValidators fetchValidators() const override;
+    void setFetchValidators(const FetchValidators &validators) override;
 
     QStringList articles(const QString &tag = QString()) const override;
 
     QStringList articles(const Category &cat) const override;
+    QStringList articlesPublishedBefore(uint pubDate) const override;
 
     bool contains(const QString &guid) const override;
     void addEntry(const QString &guid) override;
@@ -82,6 +85,11 @@ public:
     void removeEnclosure(const QString &guid) override;
     void enclosure(const QString &guid, bool &hasEnclosure, QString &url, QString &type, int &length) const override;
 
+    bool readRecord(const QString &guid, ArticleRecord &record, int fields = ArticleRecord::AllFields) const override;
+    void writeRecord(const QString &guid, const ArticleRecord &record) override;
+    void updateFields(const QString &guid, int fields, const ArticleRecord &record) override;
+    QVector<IngestResult> ingest(const QVector<ItemRecord> &items) override;
+
     void addTag(const QString &guid, const QString &tag) override;
     void removeTag(const QString &guid, const QString &tag) override;
     QStringList tags(const QString &guid = QString()) const override;
@@ -97,15 +105,28 @@ public:
     QString authorUri(const QString &guid) const override;
     QString authorEMail(const QString &guid) const override;
 
+    QString url() const override;
+    quint64 generation() const override;
     void close() override;
     void commit() override;
     void rollback() override;
 
+    /** commits pending changes and closes the metakit file. It is reopened transparently on the next access */
+    void release();
+    /** returns whether the metakit file is open */
+    bool isOpen() const;
+
+    /** returns whether there are changes that were not committed yet */
+    bool isModified() const;
+    /** returns the path of the metakit file of this feed */
+    QString filePath() const;
+    /** removes the rows of articles marked deleted that were published before @p pubDate.
+        @return the number of rows removed */
+    int purgeDeletedArticles(uint pubDate);
+
     void convertOldArchive() override;
 private:
     void markDirty();
-    /** finds article by guid, returns -1 if not in archive **/
-    int findArticle(const QString &guid) const;
     void setTotalCount(int total);
     class FeedStorageMK4ImplPrivate;
     FeedStorageMK4ImplPrivate *d;
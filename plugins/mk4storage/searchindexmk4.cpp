@@ -0,0 +1,449 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "searchindexmk4.h"
+
+#include <mk4.h>
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QSet>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+const int minTermLength = 2;
+const int maxTermLength = 40;
+
+const int titleWeight = 4;
+const int authorWeight = 2;
+const int textWeight = 1;
+
+/** words too common to tell articles apart, they are neither indexed nor searched for */
+bool isStopword(const QString &term)
+{
+    static const QSet<QString> stopwords = {
+        QStringLiteral("a"), QStringLiteral("an"), QStringLiteral("and"), QStringLiteral("are"),
+        QStringLiteral("as"), QStringLiteral("at"), QStringLiteral("be"), QStringLiteral("but"),
+        QStringLiteral("by"), QStringLiteral("for"), QStringLiteral("from"), QStringLiteral("has"),
+        QStringLiteral("have"), QStringLiteral("he"), QStringLiteral("her"), QStringLiteral("his"),
+        QStringLiteral("if"), QStringLiteral("in"), QStringLiteral("into"), QStringLiteral("is"),
+        QStringLiteral("it"), QStringLiteral("its"), QStringLiteral("not"), QStringLiteral("of"),
+        QStringLiteral("on"), QStringLiteral("or"), QStringLiteral("she"), QStringLiteral("so"),
+        QStringLiteral("that"), QStringLiteral("the"), QStringLiteral("their"), QStringLiteral("they"),
+        QStringLiteral("this"), QStringLiteral("to"), QStringLiteral("was"), QStringLiteral("we"),
+        QStringLiteral("were"), QStringLiteral("which"), QStringLiteral("will"), QStringLiteral("with"),
+        QStringLiteral("you")
+    };
+    return stopwords.contains(term);
+}
+
+/** 64 bit FNV-1a hash of feed url and guid, used as document id */
+t4_i64 documentId(const QString &feedUrl, const QString &guid)
+{
+    const QByteArray key = feedUrl.toUtf8() + '\n' + guid.toUtf8();
+    quint64 hash = 14695981039346656037ULL;
+    for (const char c : key) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return static_cast<t4_i64>(hash);
+}
+
+/** splits @p text into case folded words, skipping HTML tags, entities and stopwords, and adds @p weight for every occurrence */
+void addTerms(const QString &text, int weight, QHash<QString, int> &terms)
+{
+    QString term;
+    const auto flush = [&]() {
+        if (term.length() >= minTermLength && term.length() <= maxTermLength && !isStopword(term)) {
+            terms[term] += weight;
+        }
+        term.clear();
+    };
+
+    const int length = text.length();
+    for (int i = 0; i < length; ++i) {
+        const QChar c = text.at(i);
+        if (c.isLetterOrNumber()) {
+            term += c.toCaseFolded();
+            continue;
+        }
+        flush();
+        if (c == QLatin1Char('<')) {
+            const int end = text.indexOf(QLatin1Char('>'), i);
+            if (end == -1) {
+                break;
+            }
+            i = end;
+        } else if (c == QLatin1Char('&')) {
+            const int end = text.indexOf(QLatin1Char(';'), i);
+            if (end != -1 && end - i <= 10) {
+                i = end;
+            }
+        }
+    }
+    flush();
+}
+
+}
+
+namespace Akregator
+{
+namespace Backend
+{
+
+const int SearchIndexMK4::IndexedFields = FeedStorage::ArticleRecord::Title
+        | FeedStorage::ArticleRecord::Description
+        | FeedStorage::ArticleRecord::Content
+        | FeedStorage::ArticleRecord::Author;
+
+class SearchIndexMK4::SearchIndexMK4Private
+{
+public:
+    SearchIndexMK4Private() :
+        storage(0),
+        modified(false),
+        pid("id"),
+        pdoc("doc"),
+        pfeed("feed"),
+        pguid("guid"),
+        pterms("terms"),
+        pterm("term"),
+        pweight("weight"),
+        pslot("slot"),
+        pcomplete("complete"),
+        ppostings("postings")
+    {}
+
+    int findDocument(t4_i64 id) const;
+    int findTerm(const QByteArray &term) const;
+    int findSlot(t4_i64 id, const QByteArray &term) const;
+    /** removes the posting of document @p id from the postings of the term at @p termIndex */
+    void removePosting(t4_i64 id, const QByteArray &term, int termIndex);
+    /** removes the document at @p index from the postings of all its terms and from the document list */
+    void removeDocumentAt(int index);
+
+    c4_Storage *storage;
+    /** indexed documents, hashed on id */
+    c4_View docs;
+    /** terms and their postings, hashed on term */
+    c4_View terms;
+    /** the terms view without the hash, the postings subviews must be modified through it */
+    c4_View termRows;
+    /** the position of every posting in the postings of its term, hashed on document and term */
+    c4_View slots;
+    c4_View meta;
+    bool modified;
+    /** articles to index again on the next batch, by feed URL */
+    QHash<QString, QSet<QString> > queue;
+
+    c4_LongProp pid, pdoc;
+    c4_StringProp pfeed, pguid, pterms, pterm;
+    c4_IntProp pweight, pslot, pcomplete;
+    c4_ViewProp ppostings;
+};
+
+int SearchIndexMK4::SearchIndexMK4Private::findDocument(t4_i64 id) const
+{
+    c4_Row findrow;
+    pid(findrow) = id;
+    return docs.Find(findrow);
+}
+
+int SearchIndexMK4::SearchIndexMK4Private::findTerm(const QByteArray &term) const
+{
+    c4_Row findrow;
+    pterm(findrow) = term.constData();
+    return terms.Find(findrow);
+}
+
+int SearchIndexMK4::SearchIndexMK4Private::findSlot(t4_i64 id, const QByteArray &term) const
+{
+    c4_Row findrow;
+    pdoc(findrow) = id;
+    pterm(findrow) = term.constData();
+    return slots.Find(findrow);
+}
+
+void SearchIndexMK4::SearchIndexMK4Private::removePosting(t4_i64 id, const QByteArray &term, int termIndex)
+{
+    const int slotIndex = findSlot(id, term);
+    if (slotIndex == -1) {
+        return;
+    }
+    const int slot = pslot(slots.GetAt(slotIndex));
+    c4_View postings = ppostings(termRows.GetAt(termIndex));
+    const int last = postings.GetSize() - 1;
+    if (slot != last) {
+        // move the last posting into the freed slot, so no other posting changes its position
+        const c4_Row moved = postings.GetAt(last);
+        postings.SetAt(slot, moved);
+        const int movedIndex = findSlot(pdoc(moved), term);
+        if (movedIndex != -1) {
+            c4_Row row = slots.GetAt(movedIndex);
+            pslot(row) = slot;
+            slots.SetAt(movedIndex, row);
+        }
+    }
+    postings.RemoveAt(last);
+    slots.RemoveAt(slotIndex);
+    if (postings.GetSize() == 0) {
+        terms.RemoveAt(termIndex);
+    }
+}
+
+void SearchIndexMK4::SearchIndexMK4Private::removeDocumentAt(int index)
+{
+    const c4_RowRef doc = docs.GetAt(index);
+    const t4_i64 id = pid(doc);
+    const QList<QByteArray> docTerms = QByteArray(pterms(doc)).split(' ');
+    for (const QByteArray &term : docTerms) {
+        const int termIndex = findTerm(term);
+        if (termIndex != -1) {
+            removePosting(id, term, termIndex);
+        }
+    }
+    docs.RemoveAt(index);
+    modified = true;
+}
+
+SearchIndexMK4::SearchIndexMK4(const QString &archivePath) : d(new SearchIndexMK4Private)
+{
+    const QString filePath = archivePath + QLatin1String("/searchindex.mk4");
+    d->storage = new c4_Storage(filePath.toLocal8Bit(), true);
+    d->docs = d->storage->GetAs("docs[id:L,feed:S,guid:S,terms:S]");
+    c4_View hash = d->storage->GetAs("docsHash[_H:I,_R:I]");
+    d->docs = d->docs.Hash(hash, 1); // hash on id
+    d->termRows = d->storage->GetAs("terms[term:S,postings[doc:L,weight:I]]");
+    hash = d->storage->GetAs("termsHash[_H:I,_R:I]");
+    d->terms = d->termRows.Hash(hash, 1); // hash on term
+    d->slots = d->storage->GetAs("slots[doc:L,term:S,slot:I]");
+    hash = d->storage->GetAs("slotsHash[_H:I,_R:I]");
+    d->slots = d->slots.Hash(hash, 2); // hash on doc and term
+    d->meta = d->storage->GetAs("meta[complete:I]");
+}
+
+SearchIndexMK4::~SearchIndexMK4()
+{
+    commit();
+    delete d->storage;
+    delete d;
+    d = 0;
+}
+
+bool SearchIndexMK4::isComplete() const
+{
+    return d->meta.GetSize() > 0 && d->pcomplete(d->meta.GetAt(0)) != 0;
+}
+
+void SearchIndexMK4::setComplete()
+{
+    c4_Row row;
+    d->pcomplete(row) = 1;
+    if (d->meta.GetSize() == 0) {
+        d->meta.Add(row);
+    } else {
+        d->meta.SetAt(0, row);
+    }
+    d->modified = true;
+}
+
+void SearchIndexMK4::addArticle(const QString &feedUrl, const QString &guid, const FeedStorage::ArticleRecord &record)
+{
+    const t4_i64 id = documentId(feedUrl, guid);
+    const int index = d->findDocument(id);
+    if (index != -1) {
+        d->removeDocumentAt(index);
+    }
+
+    QHash<QString, int> weights;
+    addTerms(record.title, titleWeight, weights);
+    addTerms(record.authorName, authorWeight, weights);
+    addTerms(record.description, textWeight, weights);
+    addTerms(record.content, textWeight, weights);
+    if (weights.isEmpty()) {
+        return;
+    }
+
+    QList<QByteArray> docTerms;
+    docTerms.reserve(weights.count());
+    for (auto it = weights.constBegin(), end = weights.constEnd(); it != end; ++it) {
+        const QByteArray term = it.key().toUtf8();
+        docTerms.append(term);
+        int termIndex = d->findTerm(term);
+        if (termIndex == -1) {
+            c4_Row row;
+            d->pterm(row) = term.constData();
+            termIndex = d->terms.Add(row);
+        }
+        c4_View postings = d->ppostings(d->termRows.GetAt(termIndex));
+        c4_Row posting;
+        d->pdoc(posting) = id;
+        d->pweight(posting) = it.value();
+        c4_Row slot;
+        d->pdoc(slot) = id;
+        d->pterm(slot) = term.constData();
+        d->pslot(slot) = postings.Add(posting);
+        d->slots.Add(slot);
+    }
+
+    c4_Row doc;
+    d->pid(doc) = id;
+    d->pfeed(doc) = feedUrl.toUtf8().constData();
+    d->pguid(doc) = guid.toUtf8().constData();
+    d->pterms(doc) = docTerms.join(' ').constData();
+    d->docs.Add(doc);
+    d->modified = true;
+}
+
+void SearchIndexMK4::removeArticle(const QString &feedUrl, const QString &guid)
+{
+    const int index = d->findDocument(documentId(feedUrl, guid));
+    if (index != -1) {
+        d->removeDocumentAt(index);
+    }
+}
+
+void SearchIndexMK4::clear()
+{
+    d->docs.RemoveAll();
+    d->terms.RemoveAll();
+    d->slots.RemoveAll();
+    d->meta.RemoveAll();
+    d->queue.clear();
+    d->modified = true;
+}
+
+void SearchIndexMK4::queueArticle(const QString &feedUrl, const QString &guid)
+{
+    d->queue[feedUrl].insert(guid);
+}
+
+bool SearchIndexMK4::hasQueuedArticles() const
+{
+    return !d->queue.isEmpty();
+}
+
+QHash<QString, QSet<QString> > SearchIndexMK4::takeQueuedArticles()
+{
+    QHash<QString, QSet<QString> > queued;
+    queued.swap(d->queue);
+    return queued;
+}
+
+QVector<Storage::SearchHit> SearchIndexMK4::search(const QString &query, int maxHits) const
+{
+    QVector<Storage::SearchHit> hits;
+    QHash<QString, int> queryTerms;
+    addTerms(query, 1, queryTerms);
+    if (queryTerms.isEmpty() || maxHits <= 0) {
+        return hits;
+    }
+
+    // intersect the shortest posting lists first, so the candidate set shrinks as early as possible
+    QVector<QPair<int, int> > lists; // (postings count, term index)
+    for (auto it = queryTerms.constBegin(), end = queryTerms.constEnd(); it != end; ++it) {
+        const int termIndex = d->findTerm(it.key().toUtf8());
+        if (termIndex == -1) {
+            return hits;
+        }
+        const c4_View postings = d->ppostings(d->termRows.GetAt(termIndex));
+        lists.append(qMakePair(postings.GetSize(), termIndex));
+    }
+    std::sort(lists.begin(), lists.end());
+
+    const double documentCount = d->docs.GetSize();
+    QHash<t4_i64, double> scores;
+    for (int i = 0; i < lists.count(); ++i) {
+        const c4_View postings = d->ppostings(d->termRows.GetAt(lists.at(i).second));
+        const int size = postings.GetSize();
+        const double idf = std::log(1.0 + documentCount / size);
+        QHash<t4_i64, double> matches;
+        matches.reserve(i == 0 ? size : scores.count());
+        for (int j = 0; j < size; ++j) {
+            const c4_RowRef posting = postings.GetAt(j);
+            const t4_i64 id = d->pdoc(posting);
+            if (i > 0 && !scores.contains(id)) {
+                continue;
+            }
+            matches.insert(id, scores.value(id) + d->pweight(posting) * idf);
+        }
+        scores.swap(matches);
+        if (scores.isEmpty()) {
+            return hits;
+        }
+    }
+
+    QVector<QPair<double, t4_i64> > ranked;
+    ranked.reserve(scores.count());
+    for (auto it = scores.constBegin(), end = scores.constEnd(); it != end; ++it) {
+        ranked.append(qMakePair(it.value(), it.key()));
+    }
+    const int count = qMin(maxHits, ranked.count());
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(),
+    [](const QPair<double, t4_i64> &a, const QPair<double, t4_i64> &b) {
+        return a.first > b.first;
+    });
+
+    hits.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const int index = d->findDocument(ranked.at(i).second);
+        if (index == -1) {
+            continue;
+        }
+        const c4_RowRef doc = d->docs.GetAt(index);
+        Storage::SearchHit hit;
+        hit.feedUrl = QString::fromUtf8(d->pfeed(doc));
+        hit.guid = QString::fromUtf8(d->pguid(doc));
+        hit.score = ranked.at(i).first;
+        hits.append(hit);
+    }
+    return hits;
+}
+
+bool SearchIndexMK4::isModified() const
+{
+    return d->modified;
+}
+
+void SearchIndexMK4::commit()
+{
+    if (d->modified) {
+        d->storage->Commit();
+        d->modified = false;
+    }
+}
+
+void SearchIndexMK4::rollback()
+{
+    d->storage->Rollback();
+    d->queue.clear();
+    d->modified = false;
+}
+
+} // namespace Backend
+} // namespace Akregator
@@ -0,0 +1,91 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef AKREGATOR_BACKEND_SEARCHINDEXMK4_H
+#define AKREGATOR_BACKEND_SEARCHINDEXMK4_H
+
+#include "feedstorage.h"
+#include "storage.h"
+
+#include <QHash>
+#include <QSet>
+
+namespace Akregator
+{
+namespace Backend
+{
+
+/**
+ * Inverted index over title, description, content and author of the archived articles,
+ * stored in searchindex.mk4 next to the article archives.
+ *
+ * Every indexed article keeps the list of its terms, and a forward table records where each
+ * of its postings is stored, so updating or deleting an article touches only its own postings.
+ *
+ * The feed archives do not index their articles while they are written. They queue the
+ * changed articles with queueArticle() and StorageMK4Impl indexes the queue in one batch
+ * when it commits or searches.
+ */
+class SearchIndexMK4
+{
+public:
+    /** the fields that are indexed, see FeedStorage::ArticleRecord::Field */
+    static const int IndexedFields;
+
+    explicit SearchIndexMK4(const QString &archivePath);
+    ~SearchIndexMK4();
+
+    /** returns whether the articles archived before the index existed have been added to it */
+    bool isComplete() const;
+    void setComplete();
+
+    /** adds an article, replacing an already indexed version of it. Only the IndexedFields of @p record are used */
+    void addArticle(const QString &feedUrl, const QString &guid, const FeedStorage::ArticleRecord &record);
+    void removeArticle(const QString &feedUrl, const QString &guid);
+    void clear();
+
+    /** notes that an article was added, changed or deleted and has to be indexed again */
+    void queueArticle(const QString &feedUrl, const QString &guid);
+    bool hasQueuedArticles() const;
+    /** returns the queued articles by feed URL and empties the queue */
+    QHash<QString, QSet<QString> > takeQueuedArticles();
+
+    /** returns the articles containing all words of @p query, best match first */
+    QVector<Storage::SearchHit> search(const QString &query, int maxHits) const;
+
+    /** returns whether the index changed since the last commit() */
+    bool isModified() const;
+    void commit();
+    void rollback();
+
+private:
+    SearchIndexMK4(const SearchIndexMK4 &);
+    SearchIndexMK4 &operator=(const SearchIndexMK4 &);
+
+    class SearchIndexMK4Private;
+    SearchIndexMK4Private *d;
+};
+
+} // namespace Backend
+} // namespace Akregator
+
+#endif // AKREGATOR_BACKEND_SEARCHINDEXMK4_H
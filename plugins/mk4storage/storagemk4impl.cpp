@@ -24,29 +24,111 @@
 */
 #include "storagemk4impl.h"
 #include "feedstoragemk4impl.h"
+#include "searchindexmk4.h"
+#include "persistenceservice.h"
+#include "akregatorconfig.h"
 
 #include <mk4.h>
 
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
 #include <QMap>
+#include <QSaveFile>
+#include <QSet>
 #include <QString>
 #include <QStringList>
 #include <QTimer>
 
+#include <list>
+
 #include <qdebug.h>
 #include <QFileInfo>
 #include <QDir>
 #include <QStandardPaths>
 
+namespace {
+/** a metakit stream on top of a QIODevice */
+class DeviceStream : public c4_Stream
+{
+public:
+    explicit DeviceStream(QIODevice *device) : m_device(device)
+    {
+    }
+
+    int Read(void *buffer, int length) override
+    {
+        return m_device->read(static_cast<char *>(buffer), length);
+    }
+
+    bool Write(const void *buffer, int length) override
+    {
+        return m_device->write(static_cast<const char *>(buffer), length) == length;
+    }
+
+private:
+    QIODevice *const m_device;
+};
+
+/** rewrites the metakit file @p filePath, which must not be open, with only the data in use.
+    Metakit reuses the space of deleted data only partially, so files grow over time.
+    Adds the file to @p result if it was rewritten */
+bool compactFile(const QString &filePath, Akregator::Backend::Storage::CompactionResult &result)
+{
+    const QFileInfo before(filePath);
+    if (!before.exists()) {
+        return false;
+    }
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not compact" << filePath << ":" << file.errorString();
+        return false;
+    }
+    {
+        // serializing a storage writes its live data only
+        c4_Storage source(QFile::encodeName(filePath).constData(), 0);
+        DeviceStream stream(&file);
+        source.SaveTo(stream);
+    }
+    if (!file.commit()) {
+        qWarning() << "Could not compact" << filePath << ":" << file.errorString();
+        return false;
+    }
+
+    ++result.files;
+    result.sizeBefore += before.size();
+    result.sizeAfter += QFileInfo(filePath).size();
+    return true;
+}
+}
+
 class Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate
 {
 public:
-    StorageMK4ImplPrivate() : modified(false),
+    StorageMK4ImplPrivate() : storage(0),
+        modified(false),
+        feedListStorage(0),
+        searchIndex(0),
+        indexing(false),
         purl("url"),
         pFeedList("feedList"),
         pTagSet("tagSet"),
         punread("unread"),
         ptotalCount("totalCount"),
-        plastFetch("lastFetch") {}
+        plastFetch("lastFetch"),
+        peTag("etag"),
+        plastModified("lastModified"),
+        pdigest("digest") {}
+
+    /** the row of a feed in the archive index, kept in memory and written back on commit */
+    struct FeedSummary {
+        int row;
+        int unread;
+        int totalCount;
+        int lastFetch;
+        Akregator::Backend::FetchValidators validators;
+    };
 
     c4_Storage *storage;
     Akregator::Backend::StorageMK4Impl *q;
@@ -54,15 +136,61 @@ public:
     bool autoCommit;
     bool modified;
     mutable QMap<QString, Akregator::Backend::FeedStorageMK4Impl *> feeds;
+    /** feed storages with uncommitted changes */
+    QSet<Akregator::Backend::FeedStorageMK4Impl *> dirtyFeeds;
+    /** feed storages that currently have their file open */
+    QSet<Akregator::Backend::FeedStorageMK4Impl *> openFeeds;
+    /** the open feed storages without uncommitted changes, most recently used first. Only these are
+        released when too many files are open: releasing a modified one would commit it, and
+        rollback() could no longer undo its changes */
+    std::list<Akregator::Backend::FeedStorageMK4Impl *> releasable;
+    /** the position of every storage in releasable, so it is moved or removed without a search */
+    QHash<Akregator::Backend::FeedStorageMK4Impl *, std::list<Akregator::Backend::FeedStorageMK4Impl *>::iterator> releasablePositions;
+    /** the summaries of all feeds in the archive index, by URL */
+    QHash<QString, FeedSummary> summaries;
+    /** URLs of the summaries changed since the last commit */
+    QSet<QString> dirtySummaries;
+    /** URLs of all feeds in the archive index, in index order */
     QStringList feedURLs;
-    c4_StringProp purl, pFeedList, pTagSet;
+    c4_StringProp purl, pFeedList, pTagSet, peTag, plastModified, pdigest;
     c4_IntProp punread, ptotalCount, plastFetch;
     QString archivePath;
 
     c4_Storage *feedListStorage;
     c4_View feedListView;
+    SearchIndexMK4 *searchIndex;
+    /** feeds whose articles have not been added to a new search index yet */
+    QStringList unindexedFeeds;
+    /** whether slotIndexNextFeed() is scheduled */
+    bool indexing;
 
     Akregator::Backend::FeedStorageMK4Impl *createFeedStorage(const QString &url);
+
+    /** reads the whole archive index into summaries */
+    void loadSummaries();
+    /** writes the changed summaries back into the archive index */
+    void flushSummaries();
+    /** marks the summary of @p url as changed */
+    void summaryChanged(const QString &url);
+
+    /** opens the archive index, the feed list backup and the search index */
+    void openIndexFiles();
+    /** closes the files opened by openIndexFiles(), without committing the archive index */
+    void closeIndexFiles();
+
+    /** adds an open, unmodified feed storage to releasable as the most recently used one */
+    void addReleasable(Akregator::Backend::FeedStorageMK4Impl *fs);
+    void removeReleasable(Akregator::Backend::FeedStorageMK4Impl *fs);
+    /** releases the least recently used unmodified storages until at most Settings::maxOpenArchives() are open.
+        @p keep is not released */
+    void releaseExcessArchives(Akregator::Backend::FeedStorageMK4Impl *keep);
+    /** forgets a feed storage that is about to be released by the caller */
+    void forgetOpenArchive(Akregator::Backend::FeedStorageMK4Impl *fs);
+
+    /** indexes the articles the feed archives queued since the last batch */
+    void indexQueuedArticles();
+    /** adds the archived articles to the search index in the background, one feed at a time, if the index is new */
+    void startIndexing();
 };
 
 Akregator::Backend::StorageMK4Impl::StorageMK4Impl() : d(new StorageMK4ImplPrivate)
@@ -76,14 +204,19 @@ Akregator::Backend::FeedStorageMK4Impl *Akregator::Backend::StorageMK4Impl::Stor
     if (!feeds.contains(url)) {
         Akregator::Backend::FeedStorageMK4Impl *fs = new Akregator::Backend::FeedStorageMK4Impl(url, q);
         feeds[url] = fs;
-        c4_Row findrow;
-        purl(findrow) = url.toLatin1();
-        int findidx = archiveView.Find(findrow);
-        if (findidx == -1) {
-            punread(findrow) = 0;
-            ptotalCount(findrow) = 0;
-            plastFetch(findrow) = 0;
-            archiveView.Add(findrow);
+        if (!summaries.contains(url)) {
+            c4_Row row;
+            purl(row) = url.toLatin1();
+            punread(row) = 0;
+            ptotalCount(row) = 0;
+            plastFetch(row) = 0;
+            FeedSummary summary;
+            summary.row = archiveView.Add(row);
+            summary.unread = 0;
+            summary.totalCount = 0;
+            summary.lastFetch = 0;
+            summaries.insert(url, summary);
+            feedURLs.append(url);
             modified = true;
         }
         fs->convertOldArchive();
@@ -91,6 +224,56 @@ Akregator::Backend::FeedStorageMK4Impl *Akregator::Backend::StorageMK4Impl::Stor
     return feeds[url];
 }
 
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::loadSummaries()
+{
+    summaries.clear();
+    dirtySummaries.clear();
+    feedURLs.clear();
+
+    const int size = archiveView.GetSize();
+    summaries.reserve(size);
+    feedURLs.reserve(size);
+    for (int i = 0; i < size; ++i) {
+        const c4_RowRef row = archiveView.GetAt(i);
+        const QString url = QString::fromLatin1(purl(row));
+        FeedSummary summary;
+        summary.row = i;
+        summary.unread = punread(row);
+        summary.totalCount = ptotalCount(row);
+        summary.lastFetch = plastFetch(row);
+        summary.validators.eTag = QString::fromLatin1(peTag(row));
+        summary.validators.lastModified = QString::fromLatin1(plastModified(row));
+        summary.validators.digest = QString::fromLatin1(pdigest(row));
+        summaries.insert(url, summary);
+        feedURLs.append(url);
+    }
+}
+
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::flushSummaries()
+{
+    for (const QString &url : qAsConst(dirtySummaries)) {
+        const QHash<QString, FeedSummary>::ConstIterator it = summaries.constFind(url);
+        if (it == summaries.constEnd()) {
+            continue;
+        }
+        c4_Row row = archiveView.GetAt(it->row);
+        punread(row) = it->unread;
+        ptotalCount(row) = it->totalCount;
+        plastFetch(row) = it->lastFetch;
+        peTag(row) = it->validators.eTag.toLatin1().constData();
+        plastModified(row) = it->validators.lastModified.toLatin1().constData();
+        pdigest(row) = it->validators.digest.toLatin1().constData();
+        archiveView.SetAt(it->row, row);
+    }
+    dirtySummaries.clear();
+}
+
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::summaryChanged(const QString &url)
+{
+    dirtySummaries.insert(url);
+    q->markDirty();
+}
+
 Akregator::Backend::FeedStorage *Akregator::Backend::StorageMK4Impl::archiveFor(const QString &url)
 {
     return d->createFeedStorage(url);
@@ -130,18 +313,112 @@ Akregator::Backend::StorageMK4Impl::~StorageMK4Impl()
 }
 void Akregator::Backend::StorageMK4Impl::initialize(const QStringList &) {}
 
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::openIndexFiles()
+{
+    QString filePath = archivePath + QLatin1String("/archiveindex.mk4");
+    storage = new c4_Storage(filePath.toLocal8Bit(), true);
+    archiveView = storage->GetAs("archive[url:S,unread:I,totalCount:I,lastFetch:I,etag:S,lastModified:S,digest:S]");
+    c4_View hash = storage->GetAs("archiveHash[_H:I,_R:I]");
+    archiveView = archiveView.Hash(hash, 1); // hash on url
+    loadSummaries();
+
+    filePath = archivePath + QLatin1String("/feedlistbackup.mk4");
+    feedListStorage = new c4_Storage(filePath.toLocal8Bit(), true);
+    feedListView = feedListStorage->GetAs("archive[feedList:S,tagSet:S]");
+
+    searchIndex = new SearchIndexMK4(archivePath);
+}
+
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::closeIndexFiles()
+{
+    delete searchIndex; // commits pending index changes
+    searchIndex = 0;
+
+    archiveView = c4_View();
+    delete storage;
+    storage = 0;
+
+    feedListStorage->Commit();
+    feedListView = c4_View();
+    delete feedListStorage;
+    feedListStorage = 0;
+}
+
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::addReleasable(FeedStorageMK4Impl *fs)
+{
+    if (!releasablePositions.contains(fs)) {
+        releasable.push_front(fs);
+        releasablePositions.insert(fs, releasable.begin());
+    }
+}
+
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::removeReleasable(FeedStorageMK4Impl *fs)
+{
+    const QHash<FeedStorageMK4Impl *, std::list<FeedStorageMK4Impl *>::iterator>::Iterator it = releasablePositions.find(fs);
+    if (it != releasablePositions.end()) {
+        releasable.erase(it.value());
+        releasablePositions.erase(it);
+    }
+}
+
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::releaseExcessArchives(FeedStorageMK4Impl *keep)
+{
+    const int maxOpen = qMax(2, Settings::maxOpenArchives());
+    // modified storages stay open until the next commit, so there may be more than maxOpen for a while
+    while (openFeeds.count() > maxOpen && !releasable.empty() && releasable.back() != keep) {
+        FeedStorageMK4Impl *const lru = releasable.back();
+        releasable.pop_back();
+        releasablePositions.remove(lru);
+        openFeeds.remove(lru);
+        lru->release(); // nothing to commit
+    }
+}
+
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::forgetOpenArchive(FeedStorageMK4Impl *fs)
+{
+    openFeeds.remove(fs);
+    dirtyFeeds.remove(fs);
+    removeReleasable(fs);
+}
+
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::indexQueuedArticles()
+{
+    if (!searchIndex || !searchIndex->hasQueuedArticles()) {
+        return;
+    }
+    const QHash<QString, QSet<QString> > queued = searchIndex->takeQueuedArticles();
+    for (auto it = queued.constBegin(), end = queued.constEnd(); it != end; ++it) {
+        const FeedStorage *const fs = createFeedStorage(it.key());
+        for (const QString &guid : it.value()) {
+            FeedStorage::ArticleRecord record;
+            if (fs->readRecord(guid, record, SearchIndexMK4::IndexedFields | FeedStorage::ArticleRecord::Status)
+                && !(record.status & FeedStorage::DeletedFlag)) {
+                searchIndex->addArticle(it.key(), guid, record);
+            } else {
+                searchIndex->removeArticle(it.key(), guid);
+            }
+        }
+    }
+}
+
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::startIndexing()
+{
+    if (!searchIndex || searchIndex->isComplete()) {
+        unindexedFeeds.clear();
+        return;
+    }
+    unindexedFeeds = feedURLs;
+    if (!indexing) {
+        indexing = true;
+        QTimer::singleShot(0, q, &StorageMK4Impl::slotIndexNextFeed);
+    }
+}
+
 bool Akregator::Backend::StorageMK4Impl::open(bool autoCommit)
 {
-    QString filePath = d->archivePath + QLatin1String("/archiveindex.mk4");
-    d->storage = new c4_Storage(filePath.toLocal8Bit(), true);
-    d->archiveView = d->storage->GetAs("archive[url:S,unread:I,totalCount:I,lastFetch:I]");
-    c4_View hash = d->storage->GetAs("archiveHash[_H:I,_R:I]");
-    d->archiveView = d->archiveView.Hash(hash, 1); // hash on url
+    d->openIndexFiles();
     d->autoCommit = autoCommit;
-
-    filePath = d->archivePath + QLatin1String("/feedlistbackup.mk4");
-    d->feedListStorage = new c4_Storage(filePath.toLocal8Bit(), true);
-    d->feedListView = d->feedListStorage->GetAs("archive[feedList:S,tagSet:S]");
+    d->startIndexing();
     return true;
 }
 
@@ -152,52 +429,104 @@ bool Akregator::Backend::StorageMK4Impl::autoCommit() const
 
 bool Akregator::Backend::StorageMK4Impl::close()
 {
+    // the destructor closes the storage again after an explicit close()
+    if (!d->storage) {
+        return true;
+    }
+    if (d->autoCommit) {
+        d->indexQueuedArticles();
+    }
     QMap<QString, FeedStorageMK4Impl *>::Iterator it;
     QMap<QString, FeedStorageMK4Impl *>::Iterator end(d->feeds.end());
     for (it = d->feeds.begin(); it != end; ++it) {
         it.value()->close();
         delete it.value();
     }
+    d->feeds.clear();
+    d->dirtyFeeds.clear();
+    d->openFeeds.clear();
+    d->releasable.clear();
+    d->releasablePositions.clear();
+    d->unindexedFeeds.clear();
     if (d->autoCommit) {
+        d->flushSummaries();
         d->storage->Commit();
     }
 
-    delete d->storage;
-    d->storage = 0;
-
-    d->feedListStorage->Commit();
-    delete d->feedListStorage;
-    d->feedListStorage = 0;
-
+    d->closeIndexFiles();
     return true;
 }
 
 bool Akregator::Backend::StorageMK4Impl::commit()
 {
-    QMap<QString, FeedStorageMK4Impl *>::Iterator it;
-    QMap<QString, FeedStorageMK4Impl *>::Iterator end(d->feeds.end());
-    for (it = d->feeds.begin(); it != end; ++it) {
-        it.value()->commit();
+    QElapsedTimer timer;
+    timer.start();
+
+    // index the articles changed since the last commit in one batch; this may open archives again
+    d->indexQueuedArticles();
+
+    // files written by this commit, flushed to disk on the I/O thread
+    QStringList written;
+    for (FeedStorageMK4Impl *const i : qAsConst(d->dirtyFeeds)) {
+        if (i->isModified()) {
+            written += i->filePath();
+            i->commit();
+        }
+        if (i->isOpen()) {
+            d->addReleasable(i);
+        }
+    }
+    d->dirtyFeeds.clear();
+    // archives opened while others were modified may exceed the limit
+    d->releaseExcessArchives(nullptr);
+
+    // like the feed archives, the index is only written when it changed
+    if (d->searchIndex && d->searchIndex->isModified()) {
+        d->searchIndex->commit();
+        written += d->archivePath + QLatin1String("/searchindex.mk4");
     }
 
-    if (d->storage) {
-        d->storage->Commit();
-        return true;
+    if (!d->storage) {
+        return false;
     }
 
-    return false;
+    d->flushSummaries();
+    d->storage->Commit();
+    written += d->archivePath + QLatin1String("/archiveindex.mk4");
+
+    PersistenceService::self()->reportFlush(QStringLiteral("archive commit"), timer.elapsed());
+    if (Settings::archiveGroupCommit()) {
+        // one durability barrier for everything written by this commit
+        PersistenceService::self()->syncFiles(written);
+    } else {
+        for (const QString &i : qAsConst(written)) {
+            PersistenceService::self()->syncFiles(QStringList(i));
+        }
+    }
+    return true;
 }
 
 bool Akregator::Backend::StorageMK4Impl::rollback()
 {
-    QMap<QString, FeedStorageMK4Impl *>::Iterator it;
-    QMap<QString, FeedStorageMK4Impl *>::Iterator end(d->feeds.end());
-    for (it = d->feeds.begin(); it != end; ++it) {
-        it.value()->rollback();
+    // storages without uncommitted changes have nothing to roll back
+    for (FeedStorageMK4Impl *const i : qAsConst(d->dirtyFeeds)) {
+        i->rollback();
+        if (i->isOpen()) {
+            d->addReleasable(i);
+        }
+    }
+    d->dirtyFeeds.clear();
+    d->releaseExcessArchives(nullptr);
+
+    if (d->searchIndex) {
+        d->searchIndex->rollback();
     }
 
     if (d->storage) {
         d->storage->Rollback();
+        d->loadSummaries();
+        // articles added to a new index since the last commit are gone, start over
+        d->startIndexing();
         return true;
     }
     return false;
@@ -205,71 +534,66 @@ bool Akregator::Backend::StorageMK4Impl::rollback()
 
 int Akregator::Backend::StorageMK4Impl::unreadFor(const QString &url) const
 {
-    c4_Row findrow;
-    d->purl(findrow) = url.toLatin1();
-    int findidx = d->archiveView.Find(findrow);
-
-    return findidx != -1 ? d->punread(d->archiveView.GetAt(findidx)) : 0;
+    const QHash<QString, StorageMK4ImplPrivate::FeedSummary>::ConstIterator it = d->summaries.constFind(url);
+    return it != d->summaries.constEnd() ? it->unread : 0;
 }
 
 void Akregator::Backend::StorageMK4Impl::setUnreadFor(const QString &url, int unread)
 {
-    c4_Row findrow;
-    d->purl(findrow) = url.toLatin1();
-    int findidx = d->archiveView.Find(findrow);
-    if (findidx == -1) {
+    const QHash<QString, StorageMK4ImplPrivate::FeedSummary>::Iterator it = d->summaries.find(url);
+    if (it == d->summaries.end() || it->unread == unread) {
         return;
     }
-    findrow = d->archiveView.GetAt(findidx);
-    d->punread(findrow) = unread;
-    d->archiveView.SetAt(findidx, findrow);
-    markDirty();
+    it->unread = unread;
+    d->summaryChanged(url);
 }
 
 int Akregator::Backend::StorageMK4Impl::totalCountFor(const QString &url) const
 {
-    c4_Row findrow;
-    d->purl(findrow) = url.toLatin1();
-    int findidx = d->archiveView.Find(findrow);
-
-    return findidx != -1 ? d->ptotalCount(d->archiveView.GetAt(findidx)) : 0;
+    const QHash<QString, StorageMK4ImplPrivate::FeedSummary>::ConstIterator it = d->summaries.constFind(url);
+    return it != d->summaries.constEnd() ? it->totalCount : 0;
 }
 
 void Akregator::Backend::StorageMK4Impl::setTotalCountFor(const QString &url, int total)
 {
-    c4_Row findrow;
-    d->purl(findrow) = url.toLatin1();
-    int findidx = d->archiveView.Find(findrow);
-    if (findidx == -1) {
+    const QHash<QString, StorageMK4ImplPrivate::FeedSummary>::Iterator it = d->summaries.find(url);
+    if (it == d->summaries.end() || it->totalCount == total) {
         return;
     }
-    findrow = d->archiveView.GetAt(findidx);
-    d->ptotalCount(findrow) = total;
-    d->archiveView.SetAt(findidx, findrow);
-    markDirty();
+    it->totalCount = total;
+    d->summaryChanged(url);
 }
 
 int Akregator::Backend::StorageMK4Impl::lastFetchFor(const QString &url) const
 {
-    c4_Row findrow;
-    d->purl(findrow) = url.toLatin1();
-    int findidx = d->archiveView.Find(findrow);
-
-    return (findidx != -1 ? d->plastFetch(d->archiveView.GetAt(findidx)) : 0);
+    const QHash<QString, StorageMK4ImplPrivate::FeedSummary>::ConstIterator it = d->summaries.constFind(url);
+    return it != d->summaries.constEnd() ? it->lastFetch : 0;
 }
 
 void Akregator::Backend::StorageMK4Impl::setLastFetchFor(const QString &url, int lastFetch)
 {
-    c4_Row findrow;
-    d->purl(findrow) = url.toLatin1();
-    int findidx = d->archiveView.Find(findrow);
-    if (findidx == -1) {
+    const QHash<QString, StorageMK4ImplPrivate::FeedSummary>::Iterator it = d->summaries.find(url);
+    if (it == d->summaries.end() || it->lastFetch == lastFetch) {
         return;
     }
-    findrow = d->archiveView.GetAt(findidx);
-    d->plastFetch(findrow) = lastFetch;
-    d->archiveView.SetAt(findidx, findrow);
-    markDirty();
+    it->lastFetch = lastFetch;
+    d->summaryChanged(url);
+}
+
+Akregator::Backend::FetchValidators Akregator::Backend::StorageMK4Impl::fetchValidatorsFor(const QString &url) const
+{
+    const QHash<QString, StorageMK4ImplPrivate::FeedSummary>::ConstIterator it = d->summaries.constFind(url);
+    return it != d->summaries.constEnd() ? it->validators : FetchValidators();
+}
+
+void Akregator::Backend::StorageMK4Impl::setFetchValidatorsFor(const QString &url, const FetchValidators &validators)
+{
+    const QHash<QString, StorageMK4ImplPrivate::FeedSummary>::Iterator it = d->summaries.find(url);
+    if (it == d->summaries.end()) {
+        return;
+    }
+    it->validators = validators;
+    d->summaryChanged(url);
 }
 
 void Akregator::Backend::StorageMK4Impl::markDirty()
@@ -281,6 +605,34 @@ void Akregator::Backend::StorageMK4Impl::markDirty()
     }
 }
 
+void Akregator::Backend::StorageMK4Impl::markDirty(FeedStorageMK4Impl *feedStorage)
+{
+    d->dirtyFeeds.insert(feedStorage);
+    // stays open until committed or rolled back
+    d->removeReleasable(feedStorage);
+    markDirty();
+}
+
+void Akregator::Backend::StorageMK4Impl::archiveOpened(FeedStorageMK4Impl *feedStorage)
+{
+    d->openFeeds.insert(feedStorage);
+    if (!d->dirtyFeeds.contains(feedStorage)) {
+        d->addReleasable(feedStorage);
+    }
+    d->releaseExcessArchives(feedStorage);
+}
+
+void Akregator::Backend::StorageMK4Impl::archiveAccessed(FeedStorageMK4Impl *feedStorage)
+{
+    if (!d->releasable.empty() && d->releasable.front() == feedStorage) {
+        return;
+    }
+    const QHash<FeedStorageMK4Impl *, std::list<FeedStorageMK4Impl *>::iterator>::ConstIterator it = d->releasablePositions.constFind(feedStorage);
+    if (it != d->releasablePositions.constEnd()) {
+        d->releasable.splice(d->releasable.begin(), d->releasable, it.value());
+    }
+}
+
 void Akregator::Backend::StorageMK4Impl::slotCommit()
 {
     if (d->modified) {
@@ -291,15 +643,7 @@ void Akregator::Backend::StorageMK4Impl::slotCommit()
 
 QStringList Akregator::Backend::StorageMK4Impl::feeds() const
 {
-    // TODO: cache list
-    QStringList list;
-    int size = d->archiveView.GetSize();
-    for (int i = 0; i < size; ++i) {
-        list += QString::fromLatin1(d->purl(d->archiveView.GetAt(i)));
-    }
-    // fill with urls
-    return list;
-
+    return d->feedURLs;
 }
 
 void Akregator::Backend::StorageMK4Impl::add(Storage *source)
@@ -315,21 +659,104 @@ void Akregator::Backend::StorageMK4Impl::add(Storage *source)
 
 void Akregator::Backend::StorageMK4Impl::clear()
 {
-    QStringList feeds;
-    int size = d->archiveView.GetSize();
-    for (int i = 0; i < size; ++i) {
-        feeds += QString::fromLatin1(d->purl(d->archiveView.GetAt(i)));
+    if (d->searchIndex) {
+        d->searchIndex->clear();
+        // nothing is left to index
+        d->searchIndex->setComplete();
     }
+    d->unindexedFeeds.clear();
+
+    const QStringList feeds = d->feedURLs;
     QStringList::ConstIterator end(feeds.constEnd());
 
     for (QStringList::ConstIterator it = feeds.constBegin(); it != end; ++it) {
-        FeedStorage *fa = archiveFor(*it);
+        FeedStorageMK4Impl *const fa = d->createFeedStorage(*it);
         fa->clear();
-        fa->commit();
-        // FIXME: delete file (should be 0 in size now)
+        d->forgetOpenArchive(fa);
+        fa->release(); // commits
+        // an empty archive file still holds the free space of the removed articles, which only
+        // compaction would give back. The file is created again on the next write
+        QFile::remove(fa->filePath());
     }
     d->storage->RemoveAll();
+    d->loadSummaries();
+    if (d->searchIndex) {
+        // the feeds queued their articles for removal, which the cleared index does not need
+        d->searchIndex->takeQueuedArticles();
+    }
+}
+
+void Akregator::Backend::StorageMK4Impl::compactArchive(const QString &feedUrl, uint purgeBefore, CompactionResult &result)
+{
+    if (!d->summaries.contains(feedUrl) || !commit()) {
+        return;
+    }
 
+    // deleted articles stay in the archive as blanked rows, so that they are not added again
+    // while the feed still lists them
+    FeedStorageMK4Impl *const fs = d->createFeedStorage(feedUrl);
+    if (purgeBefore != 0) {
+        fs->purgeDeletedArticles(purgeBefore);
+    }
+    d->forgetOpenArchive(fs);
+    fs->release(); // commits
+    compactFile(fs->filePath(), result);
+}
+
+void Akregator::Backend::StorageMK4Impl::compactSharedFiles(CompactionResult &result)
+{
+    if (!commit()) {
+        return;
+    }
+
+    // the index files are always open, so they are closed and opened again around compaction
+    d->closeIndexFiles();
+    compactFile(d->archivePath + QLatin1String("/archiveindex.mk4"), result);
+    compactFile(d->archivePath + QLatin1String("/feedlistbackup.mk4"), result);
+    compactFile(d->archivePath + QLatin1String("/searchindex.mk4"), result);
+    d->openIndexFiles();
+}
+
+QVector<Akregator::Backend::Storage::SearchHit> Akregator::Backend::StorageMK4Impl::search(const QString &query, int maxHits) const
+{
+    if (!d->searchIndex) {
+        return QVector<SearchHit>();
+    }
+    d->indexQueuedArticles();
+    return d->searchIndex->search(query, maxHits);
+}
+
+void Akregator::Backend::StorageMK4Impl::slotIndexNextFeed()
+{
+    d->indexing = false;
+    if (!d->searchIndex || d->searchIndex->isComplete()) {
+        return;
+    }
+    if (d->unindexedFeeds.isEmpty()) {
+        d->searchIndex->setComplete();
+        markDirty();
+        return;
+    }
+
+    const QString url = d->unindexedFeeds.takeFirst();
+    if (d->summaries.contains(url)) {
+        const FeedStorage *const fs = d->createFeedStorage(url);
+        const QStringList guids = fs->articles();
+        for (const QString &guid : guids) {
+            FeedStorage::ArticleRecord record;
+            if (fs->readRecord(guid, record, SearchIndexMK4::IndexedFields | FeedStorage::ArticleRecord::Status)
+                && !(record.status & FeedStorage::DeletedFlag)) {
+                d->searchIndex->addArticle(url, guid, record);
+            }
+        }
+    }
+    d->indexing = true;
+    QTimer::singleShot(0, this, &StorageMK4Impl::slotIndexNextFeed);
+}
+
+Akregator::Backend::SearchIndexMK4 *Akregator::Backend::StorageMK4Impl::searchIndex() const
+{
+    return d->searchIndex;
 }
 
 void Akregator::Backend::StorageMK4Impl::storeFeedList(const QString &opmlStr)
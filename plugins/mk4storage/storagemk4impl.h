@@ -32,6 +32,8 @@ namespace Akregator
 {
 namespace Backend
 {
+class FeedStorageMK4Impl;
+class SearchIndexMK4;
 
 /**
  * Metakit implementation of Storage interface
@@ -96,6 +98,8 @@ public:
     void setTotalCountFor(const QString &url, int total) override;
     int lastFetchFor(const QString &url) const override;
     void setLastFetchFor(const QString &url, int lastFetch) override;
+    FetchValidators fetchValidatorsFor(const QString &url) const override;
+    void setFetchValidatorsFor(const QString &url, const FetchValidators &validators) override;
 
     QStringList feeds() const override;
 
@@ -113,10 +117,34 @@ public:
     /** deletes all feed storages in this archive */
     void clear() override;
 
+    /** searches the full-text index. A new index is filled in the background after open(),
+        until then only the articles written since are found */
+    QVector<SearchHit> search(const QString &query, int maxHits) const override;
+
+    /** rewrites the metakit file of the feed with only its live data. The file is released,
+        so it reports a new generation when it is opened again */
+    void compactArchive(const QString &feedUrl, uint purgeBefore, CompactionResult &result) override;
+    /** rewrites the archive index, the feed list backup and the search index */
+    void compactSharedFiles(CompactionResult &result) override;
+
+    /** returns the full-text index of the archive, or 0 if the storage is not open */
+    SearchIndexMK4 *searchIndex() const;
+
     void markDirty();
+    /** marks the archive of a feed as modified, so that the next commit() includes it */
+    void markDirty(FeedStorageMK4Impl *feedStorage);
+
+    /** called by a feed archive after it opened its file. Releases the least recently used archives
+        without uncommitted changes when more than Settings::maxOpenArchives() are open */
+    void archiveOpened(FeedStorageMK4Impl *feedStorage);
+
+    /** called by a feed archive on every access, makes it the most recently used one */
+    void archiveAccessed(FeedStorageMK4Impl *feedStorage);
 
 protected Q_SLOTS:
     void slotCommit();
+    /** adds the archived articles of the next feed to a new search index */
+    void slotIndexNextFeed();
 
 private:
     class StorageMK4ImplPrivate;
@@ -0,0 +1,415 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "storageparitytest.h"
+#include "feedstorage.h"
+#include "storage.h"
+#include "storagemk4impl.h"
+#include "storagesqliteimpl.h"
+
+#include <QStandardPaths>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QVector>
+
+using namespace Akregator::Backend;
+
+typedef FeedStorage::ArticleRecord Record;
+
+namespace
+{
+const QString feedUrl = QStringLiteral("http://www.example.com/feed.rss");
+
+Storage *createStorage(const QString &backend, const QString &archivePath)
+{
+    if (backend == QLatin1String("metakit")) {
+        StorageMK4Impl *const storage = new StorageMK4Impl;
+        storage->setArchivePath(archivePath);
+        return storage;
+    }
+    StorageSQLiteImpl *const storage = new StorageSQLiteImpl;
+    storage->setArchivePath(archivePath);
+    return storage;
+}
+
+Record sampleRecord()
+{
+    Record record;
+    record.title = QStringLiteral("Title");
+    record.description = QStringLiteral("Description with äöü");
+    record.content = QStringLiteral("<p>Content</p>");
+    record.link = QStringLiteral("http://www.example.com/article");
+    record.commentsLink = QStringLiteral("http://www.example.com/article#comments");
+    record.comments = 3;
+    record.guidIsHash = false;
+    record.guidIsPermaLink = true;
+    record.hash = 4711;
+    record.pubDate = 1500000000;
+    record.status = FeedStorage::ReadFlag;
+    record.authorName = QStringLiteral("Author");
+    record.authorUri = QStringLiteral("http://www.example.com/author");
+    record.authorEMail = QStringLiteral("author@example.com");
+    record.hasEnclosure = true;
+    record.enclosureUrl = QStringLiteral("http://www.example.com/podcast.ogg");
+    record.enclosureType = QStringLiteral("audio/ogg");
+    record.enclosureLength = 1024;
+    return record;
+}
+
+FeedStorage::ItemRecord sampleItem(const QString &guid, uint hash)
+{
+    FeedStorage::ItemRecord item;
+    item.guid = guid;
+    item.record = sampleRecord();
+    item.record.title = guid;
+    item.record.hash = hash;
+    item.record.pubDate = 1500000000 + hash;
+    item.record.status = 0;
+    return item;
+}
+
+void compareRecords(const Record &actual, const Record &expected)
+{
+    QCOMPARE(actual.title, expected.title);
+    QCOMPARE(actual.description, expected.description);
+    QCOMPARE(actual.content, expected.content);
+    QCOMPARE(actual.link, expected.link);
+    QCOMPARE(actual.commentsLink, expected.commentsLink);
+    QCOMPARE(actual.comments, expected.comments);
+    QCOMPARE(actual.guidIsHash, expected.guidIsHash);
+    QCOMPARE(actual.guidIsPermaLink, expected.guidIsPermaLink);
+    QCOMPARE(actual.hash, expected.hash);
+    QCOMPARE(actual.pubDate, expected.pubDate);
+    QCOMPARE(actual.status, expected.status);
+    QCOMPARE(actual.authorName, expected.authorName);
+    QCOMPARE(actual.authorUri, expected.authorUri);
+    QCOMPARE(actual.authorEMail, expected.authorEMail);
+    QCOMPARE(actual.hasEnclosure, expected.hasEnclosure);
+    QCOMPARE(actual.enclosureUrl, expected.enclosureUrl);
+    QCOMPARE(actual.enclosureType, expected.enclosureType);
+    QCOMPARE(actual.enclosureLength, expected.enclosureLength);
+}
+
+/** the guids of the hits, sorted, as the backends rank differently */
+QStringList hitGuids(const QVector<Storage::SearchHit> &hits)
+{
+    QStringList guids;
+    for (const Storage::SearchHit &hit : hits) {
+        guids.append(hit.guid);
+    }
+    guids.sort();
+    return guids;
+}
+}
+
+StorageParityTest::StorageParityTest(QObject *parent)
+    : QObject(parent)
+    , m_dir(nullptr)
+    , m_storage(nullptr)
+{
+}
+
+StorageParityTest::~StorageParityTest()
+{
+}
+
+void StorageParityTest::initTestCase_data()
+{
+    QTest::addColumn<QString>("backend");
+    QTest::newRow("metakit") << QStringLiteral("metakit");
+    QTest::newRow("sqlite") << QStringLiteral("sqlite");
+}
+
+void StorageParityTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void StorageParityTest::init()
+{
+    QFETCH_GLOBAL(QString, backend);
+    m_dir = new QTemporaryDir;
+    QVERIFY(m_dir->isValid());
+    m_storage = createStorage(backend, m_dir->path());
+    QVERIFY(m_storage->open(true));
+}
+
+void StorageParityTest::cleanup()
+{
+    delete m_storage;
+    m_storage = nullptr;
+    delete m_dir;
+    m_dir = nullptr;
+}
+
+void StorageParityTest::reopen()
+{
+    QFETCH_GLOBAL(QString, backend);
+    QVERIFY(m_storage->commit());
+    delete m_storage;
+    m_storage = createStorage(backend, m_dir->path());
+    QVERIFY(m_storage->open(true));
+}
+
+void StorageParityTest::shouldReadAndUpdateRecords()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    Record read;
+    QVERIFY(!archive->readRecord(QStringLiteral("guid1"), read));
+    QVERIFY(!archive->contains(QStringLiteral("guid1")));
+
+    const Record original = sampleRecord();
+    archive->writeRecord(QStringLiteral("guid1"), original);
+    QVERIFY(archive->readRecord(QStringLiteral("guid1"), read));
+    compareRecords(read, original);
+
+    Record changes;
+    changes.title = QStringLiteral("New Title");
+    changes.hash = 42;
+    changes.description = QStringLiteral("not written");
+    archive->updateFields(QStringLiteral("guid1"), Record::Title | Record::Hash, changes);
+    Record expected = original;
+    expected.title = changes.title;
+    expected.hash = changes.hash;
+    QVERIFY(archive->readRecord(QStringLiteral("guid1"), read));
+    compareRecords(read, expected);
+
+    // unknown articles are not added by an update
+    archive->updateFields(QStringLiteral("unknown"), Record::AllFields, original);
+    QCOMPARE(archive->articles(), QStringList() << QStringLiteral("guid1"));
+}
+
+void StorageParityTest::shouldIngestChangedItemsOnly()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    QVector<FeedStorage::IngestResult> results = archive->ingest({ sampleItem(QStringLiteral("guid1"), 1), sampleItem(QStringLiteral("guid2"), 2) });
+    QCOMPARE(results, QVector<FeedStorage::IngestResult>({ FeedStorage::Inserted, FeedStorage::Inserted }));
+    archive->setStatus(QStringLiteral("guid1"), FeedStorage::ReadFlag);
+
+    FeedStorage::ItemRecord changed = sampleItem(QStringLiteral("guid1"), 10);
+    changed.record.title = QStringLiteral("Changed");
+    changed.fields = Record::Title | Record::Hash;
+    FeedStorage::ItemRecord unchanged = sampleItem(QStringLiteral("guid2"), 2);
+    unchanged.record.title = QStringLiteral("not written");
+
+    results = archive->ingest({ changed, unchanged, sampleItem(QStringLiteral("guid3"), 3) });
+    QCOMPARE(results, QVector<FeedStorage::IngestResult>({ FeedStorage::Updated, FeedStorage::Unchanged, FeedStorage::Inserted }));
+    QCOMPARE(archive->totalCount(), 3);
+    QCOMPARE(m_storage->totalCountFor(feedUrl), 3);
+
+    Record read;
+    QVERIFY(archive->readRecord(QStringLiteral("guid1"), read));
+    QCOMPARE(read.title, QStringLiteral("Changed"));
+    QCOMPARE(read.hash, 10u);
+    QCOMPARE(read.status, int(FeedStorage::ReadFlag));
+    QVERIFY(archive->readRecord(QStringLiteral("guid2"), read));
+    QCOMPARE(read.title, QStringLiteral("guid2"));
+}
+
+void StorageParityTest::shouldIngestLargeBatches()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    QVector<FeedStorage::ItemRecord> items;
+    for (int i = 0; i < 250; ++i) {
+        items.append(sampleItem(QStringLiteral("guid%1").arg(i), i + 1));
+    }
+    // an item listed twice is stored once
+    items.append(sampleItem(QStringLiteral("guid0"), 1));
+
+    QVector<FeedStorage::IngestResult> results = archive->ingest(items);
+    QCOMPARE(results.count(FeedStorage::Inserted), 250);
+    QCOMPARE(results.last(), FeedStorage::Unchanged);
+    QCOMPARE(archive->totalCount(), 250);
+
+    items.removeLast();
+    items[120].record.hash = 1000;
+    items[249].record.hash = 1001;
+    results = archive->ingest(items);
+    QCOMPARE(results.count(FeedStorage::Unchanged), 248);
+    QCOMPARE(results.at(120), FeedStorage::Updated);
+    QCOMPARE(results.at(249), FeedStorage::Updated);
+    QCOMPARE(archive->hash(QStringLiteral("guid249")), 1001u);
+    QCOMPARE(archive->totalCount(), 250);
+}
+
+void StorageParityTest::shouldNotCountDeletedArticles()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    archive->ingest({ sampleItem(QStringLiteral("guid1"), 1), sampleItem(QStringLiteral("guid2"), 2), sampleItem(QStringLiteral("guid3"), 3) });
+    archive->setStatus(QStringLiteral("guid1"), FeedStorage::DeletedFlag);
+    archive->setDeleted(QStringLiteral("guid1"));
+
+    QCOMPARE(archive->totalCount(), 2);
+    // the tombstone keeps the guid, so the article is not fetched again
+    QVERIFY(archive->contains(QStringLiteral("guid1")));
+    QVERIFY(archive->title(QStringLiteral("guid1")).isEmpty());
+    QCOMPARE(archive->articlesPublishedBefore(1500000003), QStringList() << QStringLiteral("guid2"));
+
+    // ingesting the deleted article again does not bring it back
+    archive->ingest({ sampleItem(QStringLiteral("guid1"), 1) });
+    QCOMPARE(archive->totalCount(), 2);
+}
+
+void StorageParityTest::shouldKeepSummariesAfterReopening()
+{
+    FetchValidators validators;
+    validators.eTag = QStringLiteral("\"etag\"");
+    validators.lastModified = QStringLiteral("Sat, 01 Jul 2017 10:00:00 GMT");
+    validators.digest = QStringLiteral("0123456789abcdef0123456789abcdef01234567");
+
+    FeedStorage *archive = m_storage->archiveFor(feedUrl);
+    archive->ingest({ sampleItem(QStringLiteral("guid1"), 1), sampleItem(QStringLiteral("guid2"), 2) });
+    archive->setUnread(1);
+    archive->setLastFetch(1500000100);
+    archive->setFetchValidators(validators);
+    reopen();
+
+    QCOMPARE(m_storage->feeds(), QStringList() << feedUrl);
+    QCOMPARE(m_storage->unreadFor(feedUrl), 1);
+    QCOMPARE(m_storage->totalCountFor(feedUrl), 2);
+    QCOMPARE(m_storage->lastFetchFor(feedUrl), 1500000100);
+    const FetchValidators stored = m_storage->fetchValidatorsFor(feedUrl);
+    QCOMPARE(stored.eTag, validators.eTag);
+    QCOMPARE(stored.lastModified, validators.lastModified);
+    QCOMPARE(stored.digest, validators.digest);
+
+    archive = m_storage->archiveFor(feedUrl);
+    QStringList guids = archive->articles();
+    guids.sort();
+    QCOMPARE(guids, QStringList() << QStringLiteral("guid1") << QStringLiteral("guid2"));
+    Record read;
+    QVERIFY(archive->readRecord(QStringLiteral("guid2"), read));
+    compareRecords(read, sampleItem(QStringLiteral("guid2"), 2).record);
+}
+
+void StorageParityTest::shouldRollBackUncommittedChanges()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    archive->writeRecord(QStringLiteral("guid1"), sampleRecord());
+    QVERIFY(m_storage->commit());
+
+    const quint64 generation = archive->generation();
+    archive->setTitle(QStringLiteral("guid1"), QStringLiteral("changed"));
+    archive->writeRecord(QStringLiteral("guid2"), sampleRecord());
+    QVERIFY(m_storage->rollback());
+
+    // caches of article fields notice that they have to be reloaded
+    QVERIFY(archive->generation() != generation);
+    QCOMPARE(archive->title(QStringLiteral("guid1")), sampleRecord().title);
+    QVERIFY(!archive->contains(QStringLiteral("guid2")));
+    QCOMPARE(archive->articles(), QStringList() << QStringLiteral("guid1"));
+}
+
+void StorageParityTest::shouldStoreFeedListAndTagSet()
+{
+    const QString feedList = QStringLiteral("<?xml version=\"1.0\"?><opml version=\"1.0\"><body><outline text=\"Feed\" xmlUrl=\"%1\"/></body></opml>").arg(feedUrl);
+    const QString tagSet = QStringLiteral("<tagSet><tag id=\"tag\"/></tagSet>");
+    QVERIFY(m_storage->restoreFeedList().isEmpty());
+    m_storage->storeFeedList(feedList);
+    m_storage->storeTagSet(tagSet);
+    reopen();
+
+    QCOMPARE(m_storage->restoreFeedList(), feedList);
+    QCOMPARE(m_storage->restoreTagSet(), tagSet);
+}
+
+void StorageParityTest::shouldFindSameArticles()
+{
+    FeedStorage::ItemRecord first = sampleItem(QStringLiteral("guid1"), 1);
+    first.record.title = QStringLiteral("Metakit archive");
+    first.record.content = QStringLiteral("<p>Storage backends</p>");
+    FeedStorage::ItemRecord second = sampleItem(QStringLiteral("guid2"), 2);
+    second.record.title = QStringLiteral("SQLite archive");
+    second.record.content = QStringLiteral("<p>Storage backends</p>");
+    FeedStorage::ItemRecord third = sampleItem(QStringLiteral("guid3"), 3);
+    third.record.title = QStringLiteral("Deleted archive");
+    m_storage->archiveFor(feedUrl)->ingest({ first, second, third });
+    FeedStorage::ItemRecord other = sampleItem(QStringLiteral("guid4"), 4);
+    other.record.title = QStringLiteral("Metakit release");
+    m_storage->archiveFor(QStringLiteral("http://www.example.org/other.rss"))->ingest({ other });
+
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    archive->setStatus(QStringLiteral("guid3"), FeedStorage::DeletedFlag);
+    archive->setDeleted(QStringLiteral("guid3"));
+
+    QCOMPARE(hitGuids(m_storage->search(QStringLiteral("archive"), 10)), QStringList() << QStringLiteral("guid1") << QStringLiteral("guid2"));
+    QCOMPARE(hitGuids(m_storage->search(QStringLiteral("metakit"), 10)), QStringList() << QStringLiteral("guid1") << QStringLiteral("guid4"));
+    QCOMPARE(hitGuids(m_storage->search(QStringLiteral("Metakit archive"), 10)), QStringList() << QStringLiteral("guid1"));
+    QCOMPARE(hitGuids(m_storage->search(QStringLiteral("backends"), 10)), QStringList() << QStringLiteral("guid1") << QStringLiteral("guid2"));
+    QVERIFY(m_storage->search(QStringLiteral("deleted"), 10).isEmpty());
+    QVERIFY(m_storage->search(QStringLiteral("unknown"), 10).isEmpty());
+    QCOMPARE(m_storage->search(QStringLiteral("archive"), 1).count(), 1);
+
+    const QVector<Storage::SearchHit> hits = m_storage->search(QStringLiteral("release"), 10);
+    QCOMPARE(hits.count(), 1);
+    QCOMPARE(hits.at(0).feedUrl, QStringLiteral("http://www.example.org/other.rss"));
+}
+
+void StorageParityTest::shouldClearAllArticles()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    archive->ingest({ sampleItem(QStringLiteral("guid1"), 1), sampleItem(QStringLiteral("guid2"), 2) });
+    archive->setUnread(2);
+    QVERIFY(m_storage->commit());
+
+    const quint64 generation = archive->generation();
+    m_storage->clear();
+    QVERIFY(archive->generation() != generation);
+    QVERIFY(archive->articles().isEmpty());
+    QCOMPARE(m_storage->totalCountFor(feedUrl), 0);
+    QCOMPARE(m_storage->unreadFor(feedUrl), 0);
+    QVERIFY(m_storage->search(QStringLiteral("guid1"), 10).isEmpty());
+
+    // the cleared archive can be used again
+    archive->writeRecord(QStringLiteral("guid3"), sampleRecord());
+    reopen();
+    QCOMPARE(m_storage->archiveFor(feedUrl)->articles(), QStringList() << QStringLiteral("guid3"));
+}
+
+void StorageParityTest::shouldPurgeOldDeletedArticlesWhenCompacting()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    archive->ingest({ sampleItem(QStringLiteral("guid1"), 1), sampleItem(QStringLiteral("guid2"), 2), sampleItem(QStringLiteral("guid3"), 3) });
+    for (const QString &guid : { QStringLiteral("guid1"), QStringLiteral("guid3") }) {
+        archive->setStatus(guid, FeedStorage::DeletedFlag);
+        archive->setDeleted(guid);
+    }
+
+    Storage::CompactionResult result = { 0, 0, 0 };
+    m_storage->compactArchive(feedUrl, 0, result);
+    QCOMPARE(archive->articles().count(), 3);
+
+    // only deleted articles published before the date are dropped
+    const quint64 generation = archive->generation();
+    m_storage->compactArchive(feedUrl, 1500000002, result);
+    m_storage->compactSharedFiles(result);
+    QVERIFY(result.files >= 1);
+    QVERIFY(archive->generation() != generation);
+    QCOMPARE(archive->articles(), QStringList() << QStringLiteral("guid2") << QStringLiteral("guid3"));
+    QCOMPARE(archive->totalCount(), 1);
+
+    reopen();
+    QCOMPARE(m_storage->archiveFor(feedUrl)->articles(), QStringList() << QStringLiteral("guid2") << QStringLiteral("guid3"));
+}
+
+QTEST_GUILESS_MAIN(StorageParityTest)
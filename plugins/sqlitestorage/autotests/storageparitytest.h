@@ -0,0 +1,71 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef STORAGEPARITYTEST_H
+#define STORAGEPARITYTEST_H
+
+#include <QObject>
+
+class QTemporaryDir;
+
+namespace Akregator
+{
+namespace Backend
+{
+class Storage;
+}
+}
+
+/** runs the same checks against the Metakit and the SQLite backend, so that switching
+    the backend does not change what the application reads from the archive */
+class StorageParityTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StorageParityTest(QObject *parent = nullptr);
+    ~StorageParityTest();
+
+private Q_SLOTS:
+    void initTestCase_data();
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void shouldReadAndUpdateRecords();
+    void shouldIngestChangedItemsOnly();
+    void shouldIngestLargeBatches();
+    void shouldNotCountDeletedArticles();
+    void shouldKeepSummariesAfterReopening();
+    void shouldRollBackUncommittedChanges();
+    void shouldStoreFeedListAndTagSet();
+    void shouldFindSameArticles();
+    void shouldClearAllArticles();
+    void shouldPurgeOldDeletedArticlesWhenCompacting();
+
+private:
+    void reopen();
+
+    QTemporaryDir *m_dir;
+    Akregator::Backend::Storage *m_storage;
+};
+
+#endif // STORAGEPARITYTEST_H
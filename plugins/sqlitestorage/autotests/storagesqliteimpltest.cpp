@@ -0,0 +1,183 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "storagesqliteimpltest.h"
+#include "feedstorage.h"
+#include "storagesqliteimpl.h"
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QVariant>
+#include <QVector>
+
+using namespace Akregator::Backend;
+
+namespace
+{
+const QString feedUrl = QStringLiteral("http://www.example.com/feed.rss");
+
+/** the tables of schema version 1 that hold articles, before they had an id and a full-text index */
+const char *const schemaVersion1[] = {
+    "CREATE TABLE feeds (id INTEGER PRIMARY KEY, url TEXT NOT NULL UNIQUE,"
+    " unread INTEGER NOT NULL DEFAULT 0, totalCount INTEGER NOT NULL DEFAULT 0, lastFetch INTEGER NOT NULL DEFAULT 0,"
+    " etag TEXT NOT NULL DEFAULT '', lastModified TEXT NOT NULL DEFAULT '', digest TEXT NOT NULL DEFAULT '')",
+    "CREATE TABLE articles (feedId INTEGER NOT NULL, guid TEXT NOT NULL,"
+    " title TEXT NOT NULL DEFAULT '', hash INTEGER NOT NULL DEFAULT 0, guidIsHash INTEGER NOT NULL DEFAULT 0,"
+    " guidIsPermaLink INTEGER NOT NULL DEFAULT 0, description TEXT NOT NULL DEFAULT '', link TEXT NOT NULL DEFAULT '',"
+    " comments INTEGER NOT NULL DEFAULT 0, commentsLink TEXT NOT NULL DEFAULT '', status INTEGER NOT NULL DEFAULT 0,"
+    " pubDate INTEGER NOT NULL DEFAULT 0, hasEnclosure INTEGER NOT NULL DEFAULT 0, enclosureUrl TEXT NOT NULL DEFAULT '',"
+    " enclosureType TEXT NOT NULL DEFAULT '', enclosureLength INTEGER NOT NULL DEFAULT -1,"
+    " authorName TEXT NOT NULL DEFAULT '', authorUri TEXT NOT NULL DEFAULT '', authorEMail TEXT NOT NULL DEFAULT '',"
+    " content TEXT NOT NULL DEFAULT '', PRIMARY KEY (feedId, guid))",
+    "CREATE INDEX articlesByGuid ON articles (guid)",
+    "CREATE INDEX articlesByPubDate ON articles (feedId, pubDate)",
+    "CREATE INDEX articlesByStatus ON articles (feedId, status)",
+    "INSERT INTO feeds (id, url) VALUES (1, 'http://www.example.com/feed.rss')",
+    "INSERT INTO articles (feedId, guid, title, hash, content) VALUES (1, 'guid1', 'Metakit archive', 1, '<p>Storage backends</p>')",
+    "INSERT INTO articles (feedId, guid, title, hash) VALUES (1, 'guid2', 'SQLite archive', 2)",
+    "PRAGMA user_version = 1"
+};
+}
+
+StorageSQLiteImplTest::StorageSQLiteImplTest(QObject *parent)
+    : QObject(parent)
+    , m_dir(nullptr)
+{
+}
+
+StorageSQLiteImplTest::~StorageSQLiteImplTest()
+{
+}
+
+void StorageSQLiteImplTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void StorageSQLiteImplTest::init()
+{
+    m_dir = new QTemporaryDir;
+    QVERIFY(m_dir->isValid());
+}
+
+void StorageSQLiteImplTest::cleanup()
+{
+    delete m_dir;
+    m_dir = nullptr;
+}
+
+QVariant StorageSQLiteImplTest::queryArchive(const QString &sql)
+{
+    const QString connectionName = QStringLiteral("storagesqliteimpltest");
+    QVariant value;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(m_dir->path() + QLatin1String("/archive.sqlite"));
+        if (db.open()) {
+            QSqlQuery query(db);
+            if (query.exec(sql) && query.next()) {
+                value = query.value(0);
+            }
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return value;
+}
+
+void StorageSQLiteImplTest::shouldWriteSchemaVersionOfNewArchive()
+{
+    {
+        StorageSQLiteImpl storage;
+        storage.setArchivePath(m_dir->path());
+        QVERIFY(storage.open(true));
+    }
+    QVERIFY(queryArchive(QStringLiteral("PRAGMA user_version")).toInt() > 0);
+}
+
+void StorageSQLiteImplTest::shouldRefuseNewerSchemaVersion()
+{
+    {
+        StorageSQLiteImpl storage;
+        storage.setArchivePath(m_dir->path());
+        QVERIFY(storage.open(true));
+    }
+    queryArchive(QStringLiteral("PRAGMA user_version = 1000"));
+
+    StorageSQLiteImpl storage;
+    storage.setArchivePath(m_dir->path());
+    QVERIFY(!storage.open(true));
+    // the archive is left alone for the version that wrote it
+    QCOMPARE(queryArchive(QStringLiteral("PRAGMA user_version")).toInt(), 1000);
+}
+
+void StorageSQLiteImplTest::shouldMigrateArchiveOfVersion1()
+{
+    for (const char *const sql : schemaVersion1) {
+        queryArchive(QLatin1String(sql));
+    }
+
+    StorageSQLiteImpl storage;
+    storage.setArchivePath(m_dir->path());
+    QVERIFY(storage.open(true));
+    FeedStorage *const archive = storage.archiveFor(feedUrl);
+    QCOMPARE(archive->articles(), QStringList() << QStringLiteral("guid1") << QStringLiteral("guid2"));
+    QCOMPARE(archive->title(QStringLiteral("guid1")), QStringLiteral("Metakit archive"));
+    QCOMPARE(archive->hash(QStringLiteral("guid2")), 2U);
+
+    // the copied articles are in the full-text index
+    const QVector<Storage::SearchHit> hits = storage.search(QStringLiteral("backends"), 10);
+    QCOMPARE(hits.count(), 1);
+    QCOMPARE(hits.at(0).guid, QStringLiteral("guid1"));
+    QCOMPARE(storage.search(QStringLiteral("archive"), 10).count(), 2);
+
+    QVERIFY(storage.close());
+    QVERIFY(queryArchive(QStringLiteral("PRAGMA user_version")).toInt() > 1);
+}
+
+void StorageSQLiteImplTest::shouldSearchUpdatedArticles()
+{
+    StorageSQLiteImpl storage;
+    storage.setArchivePath(m_dir->path());
+    QVERIFY(storage.open(true));
+    FeedStorage *const archive = storage.archiveFor(feedUrl);
+    archive->addEntry(QStringLiteral("guid1"));
+    archive->setTitle(QStringLiteral("guid1"), QStringLiteral("Metakit archive"));
+    QCOMPARE(storage.search(QStringLiteral("metakit"), 10).count(), 1);
+
+    // the index follows updates and deletions of the articles
+    archive->setTitle(QStringLiteral("guid1"), QStringLiteral("SQLite archive"));
+    QVERIFY(storage.search(QStringLiteral("metakit"), 10).isEmpty());
+    QCOMPARE(storage.search(QStringLiteral("sqlite"), 10).count(), 1);
+    archive->deleteArticle(QStringLiteral("guid1"));
+    QVERIFY(storage.search(QStringLiteral("sqlite"), 10).isEmpty());
+
+    // words that are FTS5 operators are searched for as words
+    archive->addEntry(QStringLiteral("guid2"));
+    archive->setTitle(QStringLiteral("guid2"), QStringLiteral("Near and far"));
+    QCOMPARE(storage.search(QStringLiteral("NEAR AND"), 10).count(), 1);
+}
+
+QTEST_GUILESS_MAIN(StorageSQLiteImplTest)
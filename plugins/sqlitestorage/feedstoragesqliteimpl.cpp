@@ -0,0 +1,895 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "feedstoragesqliteimpl.h"
+#include "storagesqliteimpl.h"
+
+#include <QHash>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QVariant>
+
+namespace
+{
+typedef Akregator::Backend::FeedStorage::ArticleRecord ArticleRecord;
+
+/** the number of guids looked up by one statement in FeedStorageSQLiteImpl::ingest() */
+const int lookupBatchSize = 100;
+
+static QString orEmpty(const QString &str)
+{
+    return str.isNull() ? QStringLiteral("") : str;
+}
+
+/** returns the columns of the articles table holding the fields selected by @p fields */
+static QStringList columnsFor(int fields)
+{
+    QStringList columns;
+    if (fields & ArticleRecord::Title) {
+        columns += QStringLiteral("title");
+    }
+    if (fields & ArticleRecord::Description) {
+        columns += QStringLiteral("description");
+    }
+    if (fields & ArticleRecord::Content) {
+        columns += QStringLiteral("content");
+    }
+    if (fields & ArticleRecord::Link) {
+        columns += QStringLiteral("link");
+    }
+    if (fields & ArticleRecord::CommentsLink) {
+        columns += QStringLiteral("commentsLink");
+    }
+    if (fields & ArticleRecord::Comments) {
+        columns += QStringLiteral("comments");
+    }
+    if (fields & ArticleRecord::GuidIsHash) {
+        columns += QStringLiteral("guidIsHash");
+    }
+    if (fields & ArticleRecord::GuidIsPermaLink) {
+        columns += QStringLiteral("guidIsPermaLink");
+    }
+    if (fields & ArticleRecord::Hash) {
+        columns += QStringLiteral("hash");
+    }
+    if (fields & ArticleRecord::PubDate) {
+        columns += QStringLiteral("pubDate");
+    }
+    if (fields & ArticleRecord::Status) {
+        columns += QStringLiteral("status");
+    }
+    if (fields & ArticleRecord::Author) {
+        columns << QStringLiteral("authorName") << QStringLiteral("authorUri") << QStringLiteral("authorEMail");
+    }
+    if (fields & ArticleRecord::Enclosure) {
+        columns << QStringLiteral("hasEnclosure") << QStringLiteral("enclosureUrl") << QStringLiteral("enclosureType") << QStringLiteral("enclosureLength");
+    }
+    return columns;
+}
+
+/** binds the fields selected by @p fields to the placeholders named after their columns */
+static void bindRecord(QSqlQuery &query, int fields, const ArticleRecord &record)
+{
+    if (fields & ArticleRecord::Title) {
+        query.bindValue(QStringLiteral(":title"), orEmpty(record.title));
+    }
+    if (fields & ArticleRecord::Description) {
+        query.bindValue(QStringLiteral(":description"), orEmpty(record.description));
+    }
+    if (fields & ArticleRecord::Content) {
+        query.bindValue(QStringLiteral(":content"), orEmpty(record.content));
+    }
+    if (fields & ArticleRecord::Link) {
+        query.bindValue(QStringLiteral(":link"), orEmpty(record.link));
+    }
+    if (fields & ArticleRecord::CommentsLink) {
+        query.bindValue(QStringLiteral(":commentsLink"), orEmpty(record.commentsLink));
+    }
+    if (fields & ArticleRecord::Comments) {
+        query.bindValue(QStringLiteral(":comments"), record.comments);
+    }
+    if (fields & ArticleRecord::GuidIsHash) {
+        query.bindValue(QStringLiteral(":guidIsHash"), record.guidIsHash);
+    }
+    if (fields & ArticleRecord::GuidIsPermaLink) {
+        query.bindValue(QStringLiteral(":guidIsPermaLink"), record.guidIsPermaLink);
+    }
+    if (fields & ArticleRecord::Hash) {
+        query.bindValue(QStringLiteral(":hash"), static_cast<qint64>(record.hash));
+    }
+    if (fields & ArticleRecord::PubDate) {
+        query.bindValue(QStringLiteral(":pubDate"), static_cast<qint64>(record.pubDate));
+    }
+    if (fields & ArticleRecord::Status) {
+        query.bindValue(QStringLiteral(":status"), record.status);
+    }
+    if (fields & ArticleRecord::Author) {
+        query.bindValue(QStringLiteral(":authorName"), orEmpty(record.authorName));
+        query.bindValue(QStringLiteral(":authorUri"), orEmpty(record.authorUri));
+        query.bindValue(QStringLiteral(":authorEMail"), orEmpty(record.authorEMail));
+    }
+    if (fields & ArticleRecord::Enclosure) {
+        query.bindValue(QStringLiteral(":hasEnclosure"), record.hasEnclosure);
+        query.bindValue(QStringLiteral(":enclosureUrl"), record.hasEnclosure ? orEmpty(record.enclosureUrl) : QStringLiteral(""));
+        query.bindValue(QStringLiteral(":enclosureType"), record.hasEnclosure ? orEmpty(record.enclosureType) : QStringLiteral(""));
+        query.bindValue(QStringLiteral(":enclosureLength"), record.hasEnclosure ? record.enclosureLength : -1);
+    }
+}
+
+/** reads the fields selected by @p fields from the current row of a query selecting columnsFor(fields) */
+static void readRecordFrom(const QSqlQuery &query, int fields, ArticleRecord &record)
+{
+    int i = 0;
+    if (fields & ArticleRecord::Title) {
+        record.title = query.value(i++).toString();
+    }
+    if (fields & ArticleRecord::Description) {
+        record.description = query.value(i++).toString();
+    }
+    if (fields & ArticleRecord::Content) {
+        record.content = query.value(i++).toString();
+    }
+    if (fields & ArticleRecord::Link) {
+        record.link = query.value(i++).toString();
+    }
+    if (fields & ArticleRecord::CommentsLink) {
+        record.commentsLink = query.value(i++).toString();
+    }
+    if (fields & ArticleRecord::Comments) {
+        record.comments = query.value(i++).toInt();
+    }
+    if (fields & ArticleRecord::GuidIsHash) {
+        record.guidIsHash = query.value(i++).toBool();
+    }
+    if (fields & ArticleRecord::GuidIsPermaLink) {
+        record.guidIsPermaLink = query.value(i++).toBool();
+    }
+    if (fields & ArticleRecord::Hash) {
+        record.hash = query.value(i++).toUInt();
+    }
+    if (fields & ArticleRecord::PubDate) {
+        record.pubDate = query.value(i++).toUInt();
+    }
+    if (fields & ArticleRecord::Status) {
+        record.status = query.value(i++).toInt();
+    }
+    if (fields & ArticleRecord::Author) {
+        record.authorName = query.value(i++).toString();
+        record.authorUri = query.value(i++).toString();
+        record.authorEMail = query.value(i++).toString();
+    }
+    if (fields & ArticleRecord::Enclosure) {
+        record.hasEnclosure = query.value(i++).toBool();
+        record.enclosureUrl = query.value(i++).toString();
+        record.enclosureType = query.value(i++).toString();
+        record.enclosureLength = query.value(i++).toInt();
+    }
+}
+}
+
+namespace Akregator
+{
+namespace Backend
+{
+
+class FeedStorageSQLiteImpl::FeedStorageSQLiteImplPrivate
+{
+public:
+    qint64 feedId() const
+    {
+        return mainStorage->feedId(url);
+    }
+
+    /** runs a prepared statement that takes the feed id and the guid */
+    QSqlQuery &exec(const QString &sql, const QString &guid) const;
+    /** returns the value of @p column of an article, a null variant if the article is not in the archive */
+    QVariant value(const QString &guid, const QString &column) const;
+    /** sets @p column of an article. Does nothing if the article is not in the archive */
+    void setValue(const QString &guid, const QString &column, const QVariant &value);
+    void insert(const QString &guid, const ArticleRecord &record);
+    /** @return whether the article was in the archive */
+    bool update(const QString &guid, int fields, const ArticleRecord &record);
+    /** returns the guids selected by the first column of @p query */
+    QStringList guids(QSqlQuery &query) const;
+
+    /** the hash and the status of an article in the archive */
+    struct StoredArticle {
+        uint hash;
+        int status;
+    };
+    /** looks up the articles of @p items, by guid. Articles not in the archive are left out */
+    QHash<QString, StoredArticle> storedArticles(const QVector<ItemRecord> &items) const;
+
+    QString url;
+    StorageSQLiteImpl *mainStorage;
+    /** counts clear() calls, added to the generation of the main storage */
+    quint64 generation;
+};
+
+QSqlQuery &FeedStorageSQLiteImpl::FeedStorageSQLiteImplPrivate::exec(const QString &sql, const QString &guid) const
+{
+    QSqlQuery &query = mainStorage->statement(sql);
+    query.bindValue(QStringLiteral(":feedId"), feedId());
+    query.bindValue(QStringLiteral(":guid"), guid);
+    mainStorage->exec(query);
+    return query;
+}
+
+QVariant FeedStorageSQLiteImpl::FeedStorageSQLiteImplPrivate::value(const QString &guid, const QString &column) const
+{
+    QSqlQuery &query = exec(QStringLiteral("SELECT %1 FROM articles WHERE feedId = :feedId AND guid = :guid").arg(column), guid);
+    QVariant value;
+    if (query.next()) {
+        value = query.value(0);
+    }
+    query.finish();
+    return value;
+}
+
+void FeedStorageSQLiteImpl::FeedStorageSQLiteImplPrivate::setValue(const QString &guid, const QString &column, const QVariant &value)
+{
+    mainStorage->markDirty();
+    QSqlQuery &query = mainStorage->statement(QStringLiteral("UPDATE articles SET %1 = :value WHERE feedId = :feedId AND guid = :guid").arg(column));
+    query.bindValue(QStringLiteral(":value"), value);
+    query.bindValue(QStringLiteral(":feedId"), feedId());
+    query.bindValue(QStringLiteral(":guid"), guid);
+    mainStorage->exec(query);
+}
+
+void FeedStorageSQLiteImpl::FeedStorageSQLiteImplPrivate::insert(const QString &guid, const ArticleRecord &record)
+{
+    static const QStringList columns = columnsFor(ArticleRecord::AllFields);
+    static const QString sql = QStringLiteral("INSERT INTO articles (feedId, guid, %1) VALUES (:feedId, :guid, :%2)")
+                               .arg(columns.join(QLatin1String(", ")), columns.join(QLatin1String(", :")));
+    mainStorage->markDirty();
+    QSqlQuery &query = mainStorage->statement(sql);
+    query.bindValue(QStringLiteral(":feedId"), feedId());
+    query.bindValue(QStringLiteral(":guid"), guid);
+    bindRecord(query, ArticleRecord::AllFields, record);
+    mainStorage->exec(query);
+}
+
+bool FeedStorageSQLiteImpl::FeedStorageSQLiteImplPrivate::update(const QString &guid, int fields, const ArticleRecord &record)
+{
+    QStringList assignments;
+    const QStringList columns = columnsFor(fields);
+    for (const QString &column : columns) {
+        assignments += column + QLatin1String(" = :") + column;
+    }
+    mainStorage->markDirty();
+    QSqlQuery &query = mainStorage->statement(QStringLiteral("UPDATE articles SET %1 WHERE feedId = :feedId AND guid = :guid").arg(assignments.join(QLatin1String(", "))));
+    query.bindValue(QStringLiteral(":feedId"), feedId());
+    query.bindValue(QStringLiteral(":guid"), guid);
+    bindRecord(query, fields, record);
+    return mainStorage->exec(query) && query.numRowsAffected() > 0;
+}
+
+QStringList FeedStorageSQLiteImpl::FeedStorageSQLiteImplPrivate::guids(QSqlQuery &query) const
+{
+    QStringList list;
+    if (mainStorage->exec(query)) {
+        while (query.next()) {
+            list += query.value(0).toString();
+        }
+    }
+    query.finish();
+    return list;
+}
+
+QHash<QString, FeedStorageSQLiteImpl::FeedStorageSQLiteImplPrivate::StoredArticle> FeedStorageSQLiteImpl::FeedStorageSQLiteImplPrivate::storedArticles(const QVector<ItemRecord> &items) const
+{
+    static const QString sql = [] {
+        QStringList placeholders;
+        for (int i = 0; i < lookupBatchSize; ++i) {
+            placeholders += QStringLiteral(":guid%1").arg(i);
+        }
+        return QStringLiteral("SELECT guid, hash, status FROM articles WHERE feedId = :feedId AND guid IN (%1)").arg(placeholders.join(QLatin1String(", ")));
+    }();
+
+    QHash<QString, StoredArticle> stored;
+    if (items.isEmpty()) {
+        return stored;
+    }
+    stored.reserve(items.count());
+    QSqlQuery &query = mainStorage->statement(sql);
+    const qint64 id = feedId();
+    for (int first = 0; first < items.count(); first += lookupBatchSize) {
+        query.bindValue(QStringLiteral(":feedId"), id);
+        // the last batch repeats its last guid, so that all batches share one prepared statement
+        for (int i = 0; i < lookupBatchSize; ++i) {
+            query.bindValue(QStringLiteral(":guid%1").arg(i), items.at(qMin(first + i, items.count() - 1)).guid);
+        }
+        if (!mainStorage->exec(query)) {
+            break;
+        }
+        while (query.next()) {
+            StoredArticle article;
+            article.hash = query.value(1).toUInt();
+            article.status = query.value(2).toInt();
+            stored.insert(query.value(0).toString(), article);
+        }
+        query.finish();
+    }
+    return stored;
+}
+
+FeedStorageSQLiteImpl::FeedStorageSQLiteImpl(const QString &url, StorageSQLiteImpl *main)
+{
+    d = new FeedStorageSQLiteImplPrivate;
+    d->url = url;
+    d->mainStorage = main;
+    d->generation = 0;
+}
+
+FeedStorageSQLiteImpl::~FeedStorageSQLiteImpl()
+{
+    delete d; d = 0;
+}
+
+void FeedStorageSQLiteImpl::convertOldArchive()
+{
+    // archives of earlier versions are brought in with akregatorstorageexporter --migrate
+}
+
+void FeedStorageSQLiteImpl::commit()
+{
+    d->mainStorage->commit();
+}
+
+void FeedStorageSQLiteImpl::rollback()
+{
+    d->mainStorage->rollback();
+}
+
+void FeedStorageSQLiteImpl::close()
+{
+}
+
+QString FeedStorageSQLiteImpl::url() const
+{
+    return d->url;
+}
+
+quint64 FeedStorageSQLiteImpl::generation() const
+{
+    // both only grow, so the sum changes whenever one of them does
+    return d->generation + d->mainStorage->generation();
+}
+
+int FeedStorageSQLiteImpl::unread() const
+{
+    return d->mainStorage->unreadFor(d->url);
+}
+
+void FeedStorageSQLiteImpl::setUnread(int unread)
+{
+    d->mainStorage->setUnreadFor(d->url, unread);
+}
+
+int FeedStorageSQLiteImpl::totalCount() const
+{
+    return d->mainStorage->totalCountFor(d->url);
+}
+
+void FeedStorageSQLiteImpl::setTotalCount(int total)
+{
+    d->mainStorage->setTotalCountFor(d->url, total);
+}
+
+int FeedStorageSQLiteImpl::lastFetch() const
+{
+    return d->mainStorage->lastFetchFor(d->url);
+}
+
+void FeedStorageSQLiteImpl::setLastFetch(int lastFetch)
+{
+    d->mainStorage->setLastFetchFor(d->url, lastFetch);
+}
+
+FetchValidators FeedStorageSQLiteImpl::fetchValidators() const
+{
+    return d->mainStorage->fetchValidatorsFor(d->url);
+}
+
+void FeedStorageSQLiteImpl::setFetchValidators(const FetchValidators &validators)
+{
+    d->mainStorage->setFetchValidatorsFor(d->url, validators);
+}
+
+QStringList FeedStorageSQLiteImpl::articles(const QString &tag) const
+{
+    if (tag.isNull()) { // return all articles
+        QSqlQuery &query = d->mainStorage->statement(QStringLiteral("SELECT guid FROM articles WHERE feedId = :feedId ORDER BY rowid"));
+        query.bindValue(QStringLiteral(":feedId"), d->feedId());
+        return d->guids(query);
+    }
+    QSqlQuery &query = d->mainStorage->statement(QStringLiteral("SELECT guid FROM tags WHERE feedId = :feedId AND tag = :tag"));
+    query.bindValue(QStringLiteral(":feedId"), d->feedId());
+    query.bindValue(QStringLiteral(":tag"), tag);
+    return d->guids(query);
+}
+
+QStringList FeedStorageSQLiteImpl::articles(const Category &cat) const
+{
+    QSqlQuery &query = d->mainStorage->statement(QStringLiteral("SELECT guid FROM categories WHERE feedId = :feedId AND term = :term AND scheme = :scheme"));
+    query.bindValue(QStringLiteral(":feedId"), d->feedId());
+    query.bindValue(QStringLiteral(":term"), orEmpty(cat.term));
+    query.bindValue(QStringLiteral(":scheme"), orEmpty(cat.scheme));
+    return d->guids(query);
+}
+
+QStringList FeedStorageSQLiteImpl::articlesPublishedBefore(uint pubDate) const
+{
+    QSqlQuery &query = d->mainStorage->statement(QStringLiteral("SELECT guid FROM articles WHERE feedId = :feedId AND pubDate < :pubDate AND (status & 1) = 0"));
+    query.bindValue(QStringLiteral(":feedId"), d->feedId());
+    query.bindValue(QStringLiteral(":pubDate"), static_cast<qint64>(pubDate));
+    return d->guids(query);
+}
+
+void FeedStorageSQLiteImpl::addEntry(const QString &guid)
+{
+    if (!contains(guid)) {
+        d->mainStorage->markDirty();
+        d->exec(QStringLiteral("INSERT INTO articles (feedId, guid) VALUES (:feedId, :guid)"), guid);
+        setTotalCount(totalCount() + 1);
+    }
+}
+
+bool FeedStorageSQLiteImpl::contains(const QString &guid) const
+{
+    return !d->value(guid, QStringLiteral("1")).isNull();
+}
+
+void FeedStorageSQLiteImpl::deleteArticle(const QString &guid)
+{
+    const QVariant status = d->value(guid, QStringLiteral("status"));
+    if (status.isNull()) {
+        return;
+    }
+    d->mainStorage->markDirty();
+    d->exec(QStringLiteral("DELETE FROM tags WHERE feedId = :feedId AND guid = :guid"), guid);
+    d->exec(QStringLiteral("DELETE FROM categories WHERE feedId = :feedId AND guid = :guid"), guid);
+    d->exec(QStringLiteral("DELETE FROM articles WHERE feedId = :feedId AND guid = :guid"), guid);
+    if (!(status.toInt() & DeletedFlag)) {
+        setTotalCount(totalCount() - 1);
+    }
+}
+
+int FeedStorageSQLiteImpl::comments(const QString &guid) const
+{
+    return d->value(guid, QStringLiteral("comments")).toInt();
+}
+
+QString FeedStorageSQLiteImpl::commentsLink(const QString &guid) const
+{
+    return orEmpty(d->value(guid, QStringLiteral("commentsLink")).toString());
+}
+
+bool FeedStorageSQLiteImpl::guidIsHash(const QString &guid) const
+{
+    return d->value(guid, QStringLiteral("guidIsHash")).toBool();
+}
+
+bool FeedStorageSQLiteImpl::guidIsPermaLink(const QString &guid) const
+{
+    return d->value(guid, QStringLiteral("guidIsPermaLink")).toBool();
+}
+
+uint FeedStorageSQLiteImpl::hash(const QString &guid) const
+{
+    return d->value(guid, QStringLiteral("hash")).toUInt();
+}
+
+void FeedStorageSQLiteImpl::setDeleted(const QString &guid)
+{
+    if (!contains(guid)) {
+        return;
+    }
+    d->mainStorage->markDirty();
+    d->exec(QStringLiteral("DELETE FROM tags WHERE feedId = :feedId AND guid = :guid"), guid);
+    d->exec(QStringLiteral("UPDATE articles SET description = '', content = '', title = '', link = '', authorName = '',"
+                           " authorUri = '', authorEMail = '', commentsLink = '' WHERE feedId = :feedId AND guid = :guid"), guid);
+}
+
+QString FeedStorageSQLiteImpl::link(const QString &guid) const
+{
+    return orEmpty(d->value(guid, QStringLiteral("link")).toString());
+}
+
+uint FeedStorageSQLiteImpl::pubDate(const QString &guid) const
+{
+    return d->value(guid, QStringLiteral("pubDate")).toUInt();
+}
+
+int FeedStorageSQLiteImpl::status(const QString &guid) const
+{
+    return d->value(guid, QStringLiteral("status")).toInt();
+}
+
+void FeedStorageSQLiteImpl::setStatus(const QString &guid, int status)
+{
+    const QVariant oldStatus = d->value(guid, QStringLiteral("status"));
+    if (oldStatus.isNull()) {
+        return;
+    }
+    d->setValue(guid, QStringLiteral("status"), status);
+    const int delta = totalCountDelta(oldStatus.toInt(), status);
+    if (delta != 0) {
+        setTotalCount(totalCount() + delta);
+    }
+}
+
+QString FeedStorageSQLiteImpl::title(const QString &guid) const
+{
+    return orEmpty(d->value(guid, QStringLiteral("title")).toString());
+}
+
+QString FeedStorageSQLiteImpl::description(const QString &guid) const
+{
+    return orEmpty(d->value(guid, QStringLiteral("description")).toString());
+}
+
+QString FeedStorageSQLiteImpl::content(const QString &guid) const
+{
+    return orEmpty(d->value(guid, QStringLiteral("content")).toString());
+}
+
+void FeedStorageSQLiteImpl::setPubDate(const QString &guid, uint pubdate)
+{
+    d->setValue(guid, QStringLiteral("pubDate"), static_cast<qint64>(pubdate));
+}
+
+void FeedStorageSQLiteImpl::setGuidIsHash(const QString &guid, bool isHash)
+{
+    d->setValue(guid, QStringLiteral("guidIsHash"), isHash);
+}
+
+void FeedStorageSQLiteImpl::setLink(const QString &guid, const QString &link)
+{
+    d->setValue(guid, QStringLiteral("link"), orEmpty(link));
+}
+
+void FeedStorageSQLiteImpl::setHash(const QString &guid, uint hash)
+{
+    d->setValue(guid, QStringLiteral("hash"), static_cast<qint64>(hash));
+}
+
+void FeedStorageSQLiteImpl::setTitle(const QString &guid, const QString &title)
+{
+    d->setValue(guid, QStringLiteral("title"), orEmpty(title));
+}
+
+void FeedStorageSQLiteImpl::setDescription(const QString &guid, const QString &description)
+{
+    d->setValue(guid, QStringLiteral("description"), orEmpty(description));
+}
+
+void FeedStorageSQLiteImpl::setContent(const QString &guid, const QString &content)
+{
+    d->setValue(guid, QStringLiteral("content"), orEmpty(content));
+}
+
+void FeedStorageSQLiteImpl::setAuthorName(const QString &guid, const QString &author)
+{
+    d->setValue(guid, QStringLiteral("authorName"), orEmpty(author));
+}
+
+void FeedStorageSQLiteImpl::setAuthorUri(const QString &guid, const QString &author)
+{
+    d->setValue(guid, QStringLiteral("authorUri"), orEmpty(author));
+}
+
+void FeedStorageSQLiteImpl::setAuthorEMail(const QString &guid, const QString &author)
+{
+    d->setValue(guid, QStringLiteral("authorEMail"), orEmpty(author));
+}
+
+QString FeedStorageSQLiteImpl::authorName(const QString &guid) const
+{
+    return d->value(guid, QStringLiteral("authorName")).toString();
+}
+
+QString FeedStorageSQLiteImpl::authorUri(const QString &guid) const
+{
+    return d->value(guid, QStringLiteral("authorUri")).toString();
+}
+
+QString FeedStorageSQLiteImpl::authorEMail(const QString &guid) const
+{
+    return d->value(guid, QStringLiteral("authorEMail")).toString();
+}
+
+void FeedStorageSQLiteImpl::setCommentsLink(const QString &guid, const QString &commentsLink)
+{
+    d->setValue(guid, QStringLiteral("commentsLink"), orEmpty(commentsLink));
+}
+
+void FeedStorageSQLiteImpl::setComments(const QString &guid, int comments)
+{
+    d->setValue(guid, QStringLiteral("comments"), comments);
+}
+
+void FeedStorageSQLiteImpl::setGuidIsPermaLink(const QString &guid, bool isPermaLink)
+{
+    d->setValue(guid, QStringLiteral("guidIsPermaLink"), isPermaLink);
+}
+
+void FeedStorageSQLiteImpl::addCategory(const QString &guid, const Category &cat)
+{
+    if (!contains(guid)) {
+        return;
+    }
+    d->mainStorage->markDirty();
+    QSqlQuery &query = d->mainStorage->statement(QStringLiteral("INSERT OR IGNORE INTO categories (feedId, guid, term, scheme, name)"
+                                                                " VALUES (:feedId, :guid, :term, :scheme, :name)"));
+    query.bindValue(QStringLiteral(":feedId"), d->feedId());
+    query.bindValue(QStringLiteral(":guid"), guid);
+    query.bindValue(QStringLiteral(":term"), orEmpty(cat.term));
+    query.bindValue(QStringLiteral(":scheme"), orEmpty(cat.scheme));
+    query.bindValue(QStringLiteral(":name"), orEmpty(cat.name));
+    d->mainStorage->exec(query);
+}
+
+QList<Category> FeedStorageSQLiteImpl::categories(const QString &guid) const
+{
+    QList<Category> list;
+
+    QSqlQuery *query;
+    if (guid.isNull()) { // return all categories in the feed
+        query = &d->mainStorage->statement(QStringLiteral("SELECT term, scheme, MIN(name) FROM categories WHERE feedId = :feedId GROUP BY term, scheme"));
+    } else { // return categories for an article
+        query = &d->mainStorage->statement(QStringLiteral("SELECT term, scheme, name FROM categories WHERE feedId = :feedId AND guid = :guid"));
+        query->bindValue(QStringLiteral(":guid"), guid);
+    }
+    query->bindValue(QStringLiteral(":feedId"), d->feedId());
+    if (d->mainStorage->exec(*query)) {
+        while (query->next()) {
+            Category cat;
+            cat.term = query->value(0).toString();
+            cat.scheme = query->value(1).toString();
+            cat.name = query->value(2).toString();
+            list += cat;
+        }
+    }
+    query->finish();
+    return list;
+}
+
+void FeedStorageSQLiteImpl::addTag(const QString &guid, const QString &tag)
+{
+    if (!contains(guid)) {
+        return;
+    }
+    d->mainStorage->markDirty();
+    QSqlQuery &query = d->mainStorage->statement(QStringLiteral("INSERT OR IGNORE INTO tags (feedId, guid, tag) VALUES (:feedId, :guid, :tag)"));
+    query.bindValue(QStringLiteral(":feedId"), d->feedId());
+    query.bindValue(QStringLiteral(":guid"), guid);
+    query.bindValue(QStringLiteral(":tag"), tag);
+    d->mainStorage->exec(query);
+}
+
+void FeedStorageSQLiteImpl::removeTag(const QString &guid, const QString &tag)
+{
+    d->mainStorage->markDirty();
+    QSqlQuery &query = d->mainStorage->statement(QStringLiteral("DELETE FROM tags WHERE feedId = :feedId AND guid = :guid AND tag = :tag"));
+    query.bindValue(QStringLiteral(":feedId"), d->feedId());
+    query.bindValue(QStringLiteral(":guid"), guid);
+    query.bindValue(QStringLiteral(":tag"), tag);
+    d->mainStorage->exec(query);
+}
+
+QStringList FeedStorageSQLiteImpl::tags(const QString &guid) const
+{
+    if (guid.isNull()) { // return all tags in the feed
+        QSqlQuery &query = d->mainStorage->statement(QStringLiteral("SELECT DISTINCT tag FROM tags WHERE feedId = :feedId"));
+        query.bindValue(QStringLiteral(":feedId"), d->feedId());
+        return d->guids(query);
+    }
+    QSqlQuery &query = d->mainStorage->statement(QStringLiteral("SELECT tag FROM tags WHERE feedId = :feedId AND guid = :guid"));
+    query.bindValue(QStringLiteral(":feedId"), d->feedId());
+    query.bindValue(QStringLiteral(":guid"), guid);
+    return d->guids(query);
+}
+
+void FeedStorageSQLiteImpl::add(FeedStorage *source)
+{
+    const QStringList articles = source->articles();
+    for (const QString &guid : articles) {
+        copyArticle(guid, source);
+    }
+    setUnread(source->unread());
+    setLastFetch(source->lastFetch());
+    setFetchValidators(source->fetchValidators());
+    setTotalCount(source->totalCount());
+}
+
+void FeedStorageSQLiteImpl::copyArticle(const QString &guid, FeedStorage *source)
+{
+    ArticleRecord record;
+    source->readRecord(guid, record);
+    writeRecord(guid, record);
+
+    const QStringList tags = source->tags(guid);
+    for (const QString &tag : tags) {
+        addTag(guid, tag);
+    }
+    const QList<Category> categories = source->categories(guid);
+    for (const Category &category : categories) {
+        addCategory(guid, category);
+    }
+}
+
+void FeedStorageSQLiteImpl::setEnclosure(const QString &guid, const QString &url, const QString &type, int length)
+{
+    ArticleRecord record;
+    record.hasEnclosure = true;
+    record.enclosureUrl = url;
+    record.enclosureType = type;
+    record.enclosureLength = length;
+    d->update(guid, ArticleRecord::Enclosure, record);
+}
+
+void FeedStorageSQLiteImpl::removeEnclosure(const QString &guid)
+{
+    d->update(guid, ArticleRecord::Enclosure, ArticleRecord());
+}
+
+void FeedStorageSQLiteImpl::enclosure(const QString &guid, bool &hasEnclosure, QString &url, QString &type, int &length) const
+{
+    ArticleRecord record;
+    readRecord(guid, record, ArticleRecord::Enclosure);
+    hasEnclosure = record.hasEnclosure;
+    url = record.enclosureUrl;
+    type = record.enclosureType;
+    length = record.enclosureLength;
+}
+
+bool FeedStorageSQLiteImpl::readRecord(const QString &guid, ArticleRecord &record, int fields) const
+{
+    if ((fields & ArticleRecord::AllFields) == 0) {
+        return contains(guid);
+    }
+    QSqlQuery &query = d->exec(QStringLiteral("SELECT %1 FROM articles WHERE feedId = :feedId AND guid = :guid")
+                               .arg(columnsFor(fields).join(QLatin1String(", "))), guid);
+    const bool found = query.next();
+    if (found) {
+        readRecordFrom(query, fields, record);
+    }
+    query.finish();
+    return found;
+}
+
+void FeedStorageSQLiteImpl::writeRecord(const QString &guid, const ArticleRecord &record)
+{
+    const QVariant oldStatus = d->value(guid, QStringLiteral("status"));
+    if (oldStatus.isNull()) {
+        d->insert(guid, record);
+    } else {
+        d->update(guid, ArticleRecord::AllFields, record);
+    }
+    const int delta = totalCountDelta(oldStatus.isNull() ? int(DeletedFlag) : oldStatus.toInt(), record.status);
+    if (delta != 0) {
+        setTotalCount(totalCount() + delta);
+    }
+}
+
+void FeedStorageSQLiteImpl::updateFields(const QString &guid, int fields, const ArticleRecord &record)
+{
+    if ((fields & ArticleRecord::AllFields) == 0) {
+        return;
+    }
+    if (!(fields & ArticleRecord::Status)) {
+        d->update(guid, fields, record);
+        return;
+    }
+    const QVariant oldStatus = d->value(guid, QStringLiteral("status"));
+    if (d->update(guid, fields, record)) {
+        const int delta = totalCountDelta(oldStatus.toInt(), record.status);
+        if (delta != 0) {
+            setTotalCount(totalCount() + delta);
+        }
+    }
+}
+
+QVector<FeedStorage::IngestResult> FeedStorageSQLiteImpl::ingest(const QVector<ItemRecord> &items)
+{
+    QVector<IngestResult> results;
+    results.reserve(items.count());
+    int added = 0;
+
+    // kept up to date below, as a feed may list an item twice
+    QHash<QString, FeedStorageSQLiteImplPrivate::StoredArticle> stored = d->storedArticles(items);
+    for (const ItemRecord &item : items) {
+        const QHash<QString, FeedStorageSQLiteImplPrivate::StoredArticle>::Iterator it = stored.find(item.guid);
+        if (it == stored.end()) {
+            d->insert(item.guid, item.record);
+            added += totalCountDelta(DeletedFlag, item.record.status);
+            FeedStorageSQLiteImplPrivate::StoredArticle article;
+            article.hash = item.record.hash;
+            article.status = item.record.status;
+            stored.insert(item.guid, article);
+            results.append(Inserted);
+        } else if (it->hash == item.record.hash) {
+            results.append(Unchanged);
+        } else {
+            if (item.fields & ArticleRecord::Status) {
+                added += totalCountDelta(it->status, item.record.status);
+                it->status = item.record.status;
+            }
+            if (item.fields & ArticleRecord::Hash) {
+                it->hash = item.record.hash;
+            }
+            if (item.fields & ArticleRecord::AllFields) {
+                d->update(item.guid, item.fields, item.record);
+            }
+            results.append(Updated);
+        }
+    }
+
+    if (added != 0) {
+        setTotalCount(totalCount() + added);
+    }
+    return results;
+}
+
+int FeedStorageSQLiteImpl::purgeDeletedArticles(uint pubDate)
+{
+    // tags are removed when an article is deleted already
+    d->mainStorage->markDirty();
+    QSqlQuery &categories = d->mainStorage->statement(QStringLiteral("DELETE FROM categories WHERE feedId = :feedId AND guid IN"
+                                                                     " (SELECT guid FROM articles WHERE feedId = :articleFeedId"
+                                                                     " AND (status & 1) != 0 AND pubDate < :pubDate)"));
+    categories.bindValue(QStringLiteral(":feedId"), d->feedId());
+    categories.bindValue(QStringLiteral(":articleFeedId"), d->feedId());
+    categories.bindValue(QStringLiteral(":pubDate"), static_cast<qint64>(pubDate));
+    d->mainStorage->exec(categories);
+
+    QSqlQuery &articles = d->mainStorage->statement(QStringLiteral("DELETE FROM articles WHERE feedId = :feedId AND (status & 1) != 0 AND pubDate < :pubDate"));
+    articles.bindValue(QStringLiteral(":feedId"), d->feedId());
+    articles.bindValue(QStringLiteral(":pubDate"), static_cast<qint64>(pubDate));
+    if (!d->mainStorage->exec(articles)) {
+        return 0;
+    }
+    const int purged = articles.numRowsAffected();
+    if (purged > 0) {
+        ++d->generation;
+    }
+    return purged;
+}
+
+void FeedStorageSQLiteImpl::clear()
+{
+    d->mainStorage->markDirty();
+    const qint64 feedId = d->feedId();
+    for (const QString &table : { QStringLiteral("tags"), QStringLiteral("categories"), QStringLiteral("articles") }) {
+        QSqlQuery &query = d->mainStorage->statement(QStringLiteral("DELETE FROM %1 WHERE feedId = :feedId").arg(table));
+        query.bindValue(QStringLiteral(":feedId"), feedId);
+        d->mainStorage->exec(query);
+    }
+
+    ++d->generation;
+    setUnread(0);
+    setTotalCount(0);
+}
+
+} // namespace Backend
+} // namespace Akregator
@@ -0,0 +1,730 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "storagesqliteimpl.h"
+#include "feedstoragesqliteimpl.h"
+#include "persistenceservice.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHash>
+#include <QMap>
+#include <QRegularExpression>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+#include <qdebug.h>
+
+namespace
+{
+/** the version stored in PRAGMA user_version, bump it when the schema changes */
+const int schemaVersion = 2;
+
+const char *const schema[] = {
+    "CREATE TABLE IF NOT EXISTS feeds (id INTEGER PRIMARY KEY, url TEXT NOT NULL UNIQUE,"
+    " unread INTEGER NOT NULL DEFAULT 0, totalCount INTEGER NOT NULL DEFAULT 0, lastFetch INTEGER NOT NULL DEFAULT 0,"
+    " etag TEXT NOT NULL DEFAULT '', lastModified TEXT NOT NULL DEFAULT '', digest TEXT NOT NULL DEFAULT '')",
+    // the explicit id keeps the rowids referenced by the full-text index stable across VACUUM
+    "CREATE TABLE IF NOT EXISTS articles (id INTEGER PRIMARY KEY, feedId INTEGER NOT NULL, guid TEXT NOT NULL,"
+    " title TEXT NOT NULL DEFAULT '', hash INTEGER NOT NULL DEFAULT 0, guidIsHash INTEGER NOT NULL DEFAULT 0,"
+    " guidIsPermaLink INTEGER NOT NULL DEFAULT 0, description TEXT NOT NULL DEFAULT '', link TEXT NOT NULL DEFAULT '',"
+    " comments INTEGER NOT NULL DEFAULT 0, commentsLink TEXT NOT NULL DEFAULT '', status INTEGER NOT NULL DEFAULT 0,"
+    " pubDate INTEGER NOT NULL DEFAULT 0, hasEnclosure INTEGER NOT NULL DEFAULT 0, enclosureUrl TEXT NOT NULL DEFAULT '',"
+    " enclosureType TEXT NOT NULL DEFAULT '', enclosureLength INTEGER NOT NULL DEFAULT -1,"
+    " authorName TEXT NOT NULL DEFAULT '', authorUri TEXT NOT NULL DEFAULT '', authorEMail TEXT NOT NULL DEFAULT '',"
+    " content TEXT NOT NULL DEFAULT '', UNIQUE (feedId, guid))",
+    "CREATE INDEX IF NOT EXISTS articlesByGuid ON articles (guid)",
+    "CREATE INDEX IF NOT EXISTS articlesByPubDate ON articles (feedId, pubDate)",
+    "CREATE INDEX IF NOT EXISTS articlesByStatus ON articles (feedId, status)",
+    // the full-text index of the searched columns, it stores no text itself and is kept in sync by the triggers below
+    "CREATE VIRTUAL TABLE IF NOT EXISTS articlesText USING fts5(title, authorName, description, content,"
+    " content = 'articles', content_rowid = 'id')",
+    "CREATE TRIGGER IF NOT EXISTS articlesTextInsert AFTER INSERT ON articles BEGIN"
+    " INSERT INTO articlesText (rowid, title, authorName, description, content)"
+    " VALUES (new.id, new.title, new.authorName, new.description, new.content); END",
+    "CREATE TRIGGER IF NOT EXISTS articlesTextDelete AFTER DELETE ON articles BEGIN"
+    " INSERT INTO articlesText (articlesText, rowid, title, authorName, description, content)"
+    " VALUES ('delete', old.id, old.title, old.authorName, old.description, old.content); END",
+    "CREATE TRIGGER IF NOT EXISTS articlesTextUpdate AFTER UPDATE OF title, authorName, description, content ON articles BEGIN"
+    " INSERT INTO articlesText (articlesText, rowid, title, authorName, description, content)"
+    " VALUES ('delete', old.id, old.title, old.authorName, old.description, old.content);"
+    " INSERT INTO articlesText (rowid, title, authorName, description, content)"
+    " VALUES (new.id, new.title, new.authorName, new.description, new.content); END",
+    "CREATE TABLE IF NOT EXISTS categories (feedId INTEGER NOT NULL, guid TEXT NOT NULL, term TEXT NOT NULL,"
+    " scheme TEXT NOT NULL, name TEXT NOT NULL DEFAULT '', PRIMARY KEY (feedId, guid, term, scheme))",
+    "CREATE TABLE IF NOT EXISTS tags (feedId INTEGER NOT NULL, guid TEXT NOT NULL, tag TEXT NOT NULL,"
+    " PRIMARY KEY (feedId, guid, tag))",
+    "CREATE TABLE IF NOT EXISTS feedList (id INTEGER PRIMARY KEY CHECK (id = 0),"
+    " feedList TEXT NOT NULL DEFAULT '', tagSet TEXT NOT NULL DEFAULT '')"
+};
+
+/** version 1 had no article ids, so the articles table is moved aside and copied into the new schema */
+const char *const moveArticlesOfVersion1[] = {
+    "DROP INDEX articlesByGuid",
+    "DROP INDEX articlesByPubDate",
+    "DROP INDEX articlesByStatus",
+    "ALTER TABLE articles RENAME TO articlesVersion1"
+};
+
+const char *const copyArticlesOfVersion1[] = {
+    "INSERT INTO articles (feedId, guid, title, hash, guidIsHash, guidIsPermaLink, description, link, comments, commentsLink,"
+    " status, pubDate, hasEnclosure, enclosureUrl, enclosureType, enclosureLength, authorName, authorUri, authorEMail, content)"
+    " SELECT feedId, guid, title, hash, guidIsHash, guidIsPermaLink, description, link, comments, commentsLink,"
+    " status, pubDate, hasEnclosure, enclosureUrl, enclosureType, enclosureLength, authorName, authorUri, authorEMail, content"
+    " FROM articlesVersion1 ORDER BY rowid",
+    "DROP TABLE articlesVersion1"
+};
+
+/** quotes @p word as an FTS5 string, so that words like AND or NEAR are not read as operators */
+static QString ftsString(QString word)
+{
+    word.replace(QLatin1Char('"'), QLatin1String("\"\""));
+    return QLatin1Char('"') + word + QLatin1Char('"');
+}
+
+static QString orEmpty(const QString &str)
+{
+    return str.isNull() ? QStringLiteral("") : str;
+}
+}
+
+class Akregator::Backend::StorageSQLiteImpl::StorageSQLiteImplPrivate
+{
+public:
+    StorageSQLiteImplPrivate() : isOpen(false)
+        , autoCommit(false)
+        , inTransaction(false)
+        , synchronous(-1)
+        , generation(0)
+    {
+    }
+
+    /** the feed row of the database, kept in memory */
+    struct FeedSummary {
+        qint64 id;
+        int unread;
+        int totalCount;
+        int lastFetch;
+        Akregator::Backend::FetchValidators validators;
+    };
+
+    QSqlDatabase database() const
+    {
+        return QSqlDatabase::database(connectionName, false);
+    }
+
+    /** executes a statement that is run only once, like a pragma or a schema change */
+    bool execute(const QString &sql);
+    /** closes the database connection opened by StorageSQLiteImpl::open() */
+    void removeConnection();
+    /** returns the schema version of the database, 0 for a new database */
+    int userVersion();
+    /** executes @p statements in order, stopping at the first one that fails */
+    template<size_t N>
+    bool execute(const char *const (&statements)[N])
+    {
+        for (const char *const sql : statements) {
+            if (!execute(QLatin1String(sql))) {
+                return false;
+            }
+        }
+        return true;
+    }
+    /** updates the schema of a database written with version @p version to the current schema version */
+    bool migrateSchema(int version);
+    /** reads the feeds table into summaries */
+    void loadSummaries();
+    /** sets the synchronous pragma matching the sync policy of the PersistenceService */
+    void applySyncPolicy();
+    /** writes @p value into column @p column of the feed row @p id */
+    void updateFeedColumn(qint64 id, const QString &column, const QVariant &value);
+    void storeFeedListColumn(const QString &column, const QString &value);
+    QString restoreFeedListColumn(const QString &column) const;
+
+    Akregator::Backend::FeedStorageSQLiteImpl *createFeedStorage(const QString &url);
+
+    Akregator::Backend::StorageSQLiteImpl *q;
+    QString archivePath;
+    QString connectionName;
+    bool isOpen;
+    bool autoCommit;
+    bool inTransaction;
+    /** the value of PRAGMA synchronous, -1 before it was set */
+    int synchronous;
+    /** see StorageSQLiteImpl::generation() */
+    quint64 generation;
+    QHash<QString, QSqlQuery *> statements;
+    /** the rows of the feeds table, by URL */
+    QHash<QString, FeedSummary> summaries;
+    /** URLs of all feeds in the database, in insertion order */
+    QStringList feedURLs;
+    QMap<QString, Akregator::Backend::FeedStorageSQLiteImpl *> feeds;
+};
+
+bool Akregator::Backend::StorageSQLiteImpl::StorageSQLiteImplPrivate::execute(const QString &sql)
+{
+    QSqlQuery query(database());
+    if (!query.exec(sql)) {
+        qWarning() << "SQLite archive:" << query.lastError().text() << sql;
+        return false;
+    }
+    return true;
+}
+
+void Akregator::Backend::StorageSQLiteImpl::StorageSQLiteImplPrivate::removeConnection()
+{
+    database().close();
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+int Akregator::Backend::StorageSQLiteImpl::StorageSQLiteImplPrivate::userVersion()
+{
+    QSqlQuery query(database());
+    if (!query.exec(QStringLiteral("PRAGMA user_version")) || !query.next()) {
+        qWarning() << "SQLite archive:" << query.lastError().text();
+        return -1;
+    }
+    return query.value(0).toInt();
+}
+
+bool Akregator::Backend::StorageSQLiteImpl::StorageSQLiteImplPrivate::migrateSchema(int version)
+{
+    // add a case for every schema change, falling through to the next one
+    switch (version) {
+    case 1:
+        // the triggers fill the full-text index while the articles are copied
+        if (!execute(moveArticlesOfVersion1) || !execute(schema) || !execute(copyArticlesOfVersion1)) {
+            return false;
+        }
+    // fall through
+    case schemaVersion:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void Akregator::Backend::StorageSQLiteImpl::StorageSQLiteImplPrivate::loadSummaries()
+{
+    summaries.clear();
+    feedURLs.clear();
+
+    QSqlQuery &query = q->statement(QStringLiteral("SELECT id, url, unread, totalCount, lastFetch, etag, lastModified, digest FROM feeds ORDER BY id"));
+    if (!q->exec(query)) {
+        return;
+    }
+    while (query.next()) {
+        const QString url = query.value(1).toString();
+        FeedSummary summary;
+        summary.id = query.value(0).toLongLong();
+        summary.unread = query.value(2).toInt();
+        summary.totalCount = query.value(3).toInt();
+        summary.lastFetch = query.value(4).toInt();
+        summary.validators.eTag = query.value(5).toString();
+        summary.validators.lastModified = query.value(6).toString();
+        summary.validators.digest = query.value(7).toString();
+        summaries.insert(url, summary);
+        feedURLs.append(url);
+    }
+    query.finish();
+}
+
+void Akregator::Backend::StorageSQLiteImpl::StorageSQLiteImplPrivate::applySyncPolicy()
+{
+    // WAL with NORMAL stays consistent after a crash but may lose the last commits on power loss,
+    // FULL syncs the log on every commit
+    const int value = PersistenceService::self()->syncPolicy() == PersistenceService::SyncAlways ? 2 : 1;
+    if (value != synchronous && execute(QStringLiteral("PRAGMA synchronous = %1").arg(value))) {
+        synchronous = value;
+    }
+}
+
+void Akregator::Backend::StorageSQLiteImpl::StorageSQLiteImplPrivate::updateFeedColumn(qint64 id, const QString &column, const QVariant &value)
+{
+    q->markDirty();
+    QSqlQuery &query = q->statement(QStringLiteral("UPDATE feeds SET %1 = :value WHERE id = :id").arg(column));
+    query.bindValue(QStringLiteral(":value"), value);
+    query.bindValue(QStringLiteral(":id"), id);
+    q->exec(query);
+}
+
+void Akregator::Backend::StorageSQLiteImpl::StorageSQLiteImplPrivate::storeFeedListColumn(const QString &column, const QString &value)
+{
+    q->markDirty();
+    QSqlQuery &insert = q->statement(QStringLiteral("INSERT OR IGNORE INTO feedList (id) VALUES (0)"));
+    q->exec(insert);
+    QSqlQuery &update = q->statement(QStringLiteral("UPDATE feedList SET %1 = :value WHERE id = 0").arg(column));
+    update.bindValue(QStringLiteral(":value"), orEmpty(value));
+    q->exec(update);
+}
+
+QString Akregator::Backend::StorageSQLiteImpl::StorageSQLiteImplPrivate::restoreFeedListColumn(const QString &column) const
+{
+    QSqlQuery &query = q->statement(QStringLiteral("SELECT %1 FROM feedList WHERE id = 0").arg(column));
+    QString value;
+    if (q->exec(query) && query.next()) {
+        value = query.value(0).toString();
+    }
+    query.finish();
+    return value;
+}
+
+Akregator::Backend::FeedStorageSQLiteImpl *Akregator::Backend::StorageSQLiteImpl::StorageSQLiteImplPrivate::createFeedStorage(const QString &url)
+{
+    FeedStorageSQLiteImpl *fs = feeds.value(url);
+    if (!fs) {
+        q->feedId(url);
+        fs = new FeedStorageSQLiteImpl(url, q);
+        feeds[url] = fs;
+    }
+    return fs;
+}
+
+Akregator::Backend::StorageSQLiteImpl::StorageSQLiteImpl() : d(new StorageSQLiteImplPrivate)
+{
+    d->q = this;
+    setArchivePath(QString());
+}
+
+Akregator::Backend::StorageSQLiteImpl::~StorageSQLiteImpl()
+{
+    close();
+    delete d;
+    d = 0;
+}
+
+QString Akregator::Backend::StorageSQLiteImpl::defaultArchivePath()
+{
+    const QString ret = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QLatin1Char('/') + QStringLiteral("akregator/Archive");
+    QDir().mkpath(ret);
+    return ret;
+}
+
+void Akregator::Backend::StorageSQLiteImpl::setArchivePath(const QString &archivePath)
+{
+    if (archivePath.isNull()) { // if isNull, reset to default
+        d->archivePath = defaultArchivePath();
+    } else {
+        d->archivePath = archivePath;
+    }
+}
+
+QString Akregator::Backend::StorageSQLiteImpl::archivePath() const
+{
+    return d->archivePath;
+}
+
+void Akregator::Backend::StorageSQLiteImpl::initialize(const QStringList &) {}
+
+bool Akregator::Backend::StorageSQLiteImpl::open(bool autoCommit)
+{
+    if (d->isOpen) {
+        return true;
+    }
+
+    QDir().mkpath(d->archivePath);
+    d->connectionName = QStringLiteral("akregator-archive-%1").arg(reinterpret_cast<quintptr>(this));
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), d->connectionName);
+        db.setDatabaseName(d->archivePath + QLatin1String("/archive.sqlite"));
+        if (!db.open()) {
+            qWarning() << "Could not open the SQLite archive:" << db.lastError().text();
+            db = QSqlDatabase();
+            QSqlDatabase::removeDatabase(d->connectionName);
+            return false;
+        }
+    }
+
+    // readers do not block the writer and vice versa, and a commit appends to the log instead of
+    // rewriting pages in place
+    d->execute(QStringLiteral("PRAGMA journal_mode = WAL"));
+    d->applySyncPolicy();
+
+    const int version = d->userVersion();
+    if (version < 0 || version > schemaVersion) {
+        // written by a newer Akregator, which may use columns we would not keep up to date
+        qWarning() << "Unsupported schema version of the SQLite archive:" << version;
+        d->removeConnection();
+        return false;
+    }
+    if (version != schemaVersion) {
+        d->execute(QStringLiteral("BEGIN"));
+        const bool ok = (version == 0 ? d->execute(schema) : d->migrateSchema(version))
+                        && d->execute(QStringLiteral("PRAGMA user_version = %1").arg(schemaVersion));
+        d->execute(ok ? QStringLiteral("COMMIT") : QStringLiteral("ROLLBACK"));
+        if (!ok) {
+            qWarning() << "Could not update the SQLite archive from schema version" << version;
+            d->removeConnection();
+            return false;
+        }
+    }
+
+    d->isOpen = true;
+    d->autoCommit = autoCommit;
+    d->loadSummaries();
+    return true;
+}
+
+bool Akregator::Backend::StorageSQLiteImpl::autoCommit() const
+{
+    return d->autoCommit;
+}
+
+bool Akregator::Backend::StorageSQLiteImpl::commit()
+{
+    if (!d->inTransaction) {
+        return d->isOpen;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!d->database().commit()) {
+        qWarning() << "Could not commit the SQLite archive:" << d->database().lastError().text();
+        // the transaction stays open, e.g. while another process holds the lock; try again later
+        QTimer::singleShot(3000, this, &StorageSQLiteImpl::slotCommit);
+        return false;
+    }
+    d->inTransaction = false;
+    PersistenceService::self()->reportFlush(QStringLiteral("archive commit"), timer.elapsed());
+    return true;
+}
+
+bool Akregator::Backend::StorageSQLiteImpl::rollback()
+{
+    if (!d->inTransaction) {
+        return d->isOpen;
+    }
+
+    d->inTransaction = false;
+    const bool ok = d->database().rollback();
+    d->loadSummaries();
+    ++d->generation;
+    return ok;
+}
+
+bool Akregator::Backend::StorageSQLiteImpl::close()
+{
+    if (!d->isOpen) {
+        return true;
+    }
+
+    QMap<QString, FeedStorageSQLiteImpl *>::Iterator it;
+    QMap<QString, FeedStorageSQLiteImpl *>::Iterator end(d->feeds.end());
+    for (it = d->feeds.begin(); it != end; ++it) {
+        it.value()->close();
+        delete it.value();
+    }
+    d->feeds.clear();
+
+    if (d->autoCommit) {
+        commit();
+    } else {
+        rollback();
+    }
+
+    qDeleteAll(d->statements);
+    d->statements.clear();
+    d->summaries.clear();
+    d->feedURLs.clear();
+
+    d->removeConnection();
+    d->isOpen = false;
+    d->synchronous = -1;
+    return true;
+}
+
+QSqlQuery &Akregator::Backend::StorageSQLiteImpl::statement(const QString &sql) const
+{
+    QSqlQuery *&query = d->statements[sql];
+    if (!query) {
+        query = new QSqlQuery(d->database());
+        query->setForwardOnly(true);
+        if (!query->prepare(sql)) {
+            qWarning() << "SQLite archive:" << query->lastError().text() << sql;
+        }
+    }
+    return *query;
+}
+
+bool Akregator::Backend::StorageSQLiteImpl::exec(QSqlQuery &query) const
+{
+    if (!query.exec()) {
+        qWarning() << "SQLite archive:" << query.lastError().text() << query.lastQuery();
+        return false;
+    }
+    return true;
+}
+
+qint64 Akregator::Backend::StorageSQLiteImpl::feedId(const QString &url)
+{
+    const QHash<QString, StorageSQLiteImplPrivate::FeedSummary>::ConstIterator it = d->summaries.constFind(url);
+    if (it != d->summaries.constEnd()) {
+        return it->id;
+    }
+
+    markDirty();
+    QSqlQuery &query = statement(QStringLiteral("INSERT INTO feeds (url) VALUES (:url)"));
+    query.bindValue(QStringLiteral(":url"), url);
+    if (!exec(query)) {
+        return -1;
+    }
+
+    StorageSQLiteImplPrivate::FeedSummary summary;
+    summary.id = query.lastInsertId().toLongLong();
+    summary.unread = 0;
+    summary.totalCount = 0;
+    summary.lastFetch = 0;
+    d->summaries.insert(url, summary);
+    d->feedURLs.append(url);
+    return summary.id;
+}
+
+void Akregator::Backend::StorageSQLiteImpl::markDirty()
+{
+    if (d->inTransaction || !d->isOpen) {
+        return;
+    }
+    d->applySyncPolicy();
+    if (!d->database().transaction()) {
+        qWarning() << "Could not start a transaction on the SQLite archive:" << d->database().lastError().text();
+        return;
+    }
+    d->inTransaction = true;
+    // commit changes after 3 seconds
+    QTimer::singleShot(3000, this, &StorageSQLiteImpl::slotCommit);
+}
+
+void Akregator::Backend::StorageSQLiteImpl::slotCommit()
+{
+    commit();
+}
+
+Akregator::Backend::FeedStorage *Akregator::Backend::StorageSQLiteImpl::archiveFor(const QString &url)
+{
+    return d->createFeedStorage(url);
+}
+
+const Akregator::Backend::FeedStorage *Akregator::Backend::StorageSQLiteImpl::archiveFor(const QString &url) const
+{
+    return d->createFeedStorage(url);
+}
+
+int Akregator::Backend::StorageSQLiteImpl::unreadFor(const QString &url) const
+{
+    const QHash<QString, StorageSQLiteImplPrivate::FeedSummary>::ConstIterator it = d->summaries.constFind(url);
+    return it != d->summaries.constEnd() ? it->unread : 0;
+}
+
+void Akregator::Backend::StorageSQLiteImpl::setUnreadFor(const QString &url, int unread)
+{
+    const QHash<QString, StorageSQLiteImplPrivate::FeedSummary>::Iterator it = d->summaries.find(url);
+    if (it == d->summaries.end() || it->unread == unread) {
+        return;
+    }
+    it->unread = unread;
+    d->updateFeedColumn(it->id, QStringLiteral("unread"), unread);
+}
+
+int Akregator::Backend::StorageSQLiteImpl::totalCountFor(const QString &url) const
+{
+    const QHash<QString, StorageSQLiteImplPrivate::FeedSummary>::ConstIterator it = d->summaries.constFind(url);
+    return it != d->summaries.constEnd() ? it->totalCount : 0;
+}
+
+void Akregator::Backend::StorageSQLiteImpl::setTotalCountFor(const QString &url, int total)
+{
+    const QHash<QString, StorageSQLiteImplPrivate::FeedSummary>::Iterator it = d->summaries.find(url);
+    if (it == d->summaries.end() || it->totalCount == total) {
+        return;
+    }
+    it->totalCount = total;
+    d->updateFeedColumn(it->id, QStringLiteral("totalCount"), total);
+}
+
+int Akregator::Backend::StorageSQLiteImpl::lastFetchFor(const QString &url) const
+{
+    const QHash<QString, StorageSQLiteImplPrivate::FeedSummary>::ConstIterator it = d->summaries.constFind(url);
+    return it != d->summaries.constEnd() ? it->lastFetch : 0;
+}
+
+void Akregator::Backend::StorageSQLiteImpl::setLastFetchFor(const QString &url, int lastFetch)
+{
+    const QHash<QString, StorageSQLiteImplPrivate::FeedSummary>::Iterator it = d->summaries.find(url);
+    if (it == d->summaries.end() || it->lastFetch == lastFetch) {
+        return;
+    }
+    it->lastFetch = lastFetch;
+    d->updateFeedColumn(it->id, QStringLiteral("lastFetch"), lastFetch);
+}
+
+Akregator::Backend::FetchValidators Akregator::Backend::StorageSQLiteImpl::fetchValidatorsFor(const QString &url) const
+{
+    const QHash<QString, StorageSQLiteImplPrivate::FeedSummary>::ConstIterator it = d->summaries.constFind(url);
+    return it != d->summaries.constEnd() ? it->validators : FetchValidators();
+}
+
+void Akregator::Backend::StorageSQLiteImpl::setFetchValidatorsFor(const QString &url, const FetchValidators &validators)
+{
+    const QHash<QString, StorageSQLiteImplPrivate::FeedSummary>::Iterator it = d->summaries.find(url);
+    if (it == d->summaries.end()) {
+        return;
+    }
+    it->validators = validators;
+
+    markDirty();
+    QSqlQuery &query = statement(QStringLiteral("UPDATE feeds SET etag = :etag, lastModified = :lastModified, digest = :digest WHERE id = :id"));
+    query.bindValue(QStringLiteral(":etag"), orEmpty(validators.eTag));
+    query.bindValue(QStringLiteral(":lastModified"), orEmpty(validators.lastModified));
+    query.bindValue(QStringLiteral(":digest"), orEmpty(validators.digest));
+    query.bindValue(QStringLiteral(":id"), it->id);
+    exec(query);
+}
+
+QStringList Akregator::Backend::StorageSQLiteImpl::feeds() const
+{
+    return d->feedURLs;
+}
+
+void Akregator::Backend::StorageSQLiteImpl::storeFeedList(const QString &opmlStr)
+{
+    d->storeFeedListColumn(QStringLiteral("feedList"), opmlStr);
+}
+
+QString Akregator::Backend::StorageSQLiteImpl::restoreFeedList() const
+{
+    return d->restoreFeedListColumn(QStringLiteral("feedList"));
+}
+
+void Akregator::Backend::StorageSQLiteImpl::storeTagSet(const QString &xmlStr)
+{
+    d->storeFeedListColumn(QStringLiteral("tagSet"), xmlStr);
+}
+
+QString Akregator::Backend::StorageSQLiteImpl::restoreTagSet() const
+{
+    return d->restoreFeedListColumn(QStringLiteral("tagSet"));
+}
+
+void Akregator::Backend::StorageSQLiteImpl::add(Storage *source)
+{
+    const QStringList feeds = source->feeds();
+    for (const QString &url : feeds) {
+        archiveFor(url)->add(source->archiveFor(url));
+    }
+}
+
+void Akregator::Backend::StorageSQLiteImpl::clear()
+{
+    markDirty();
+    d->execute(QStringLiteral("DELETE FROM articles"));
+    d->execute(QStringLiteral("DELETE FROM categories"));
+    d->execute(QStringLiteral("DELETE FROM tags"));
+    d->execute(QStringLiteral("DELETE FROM feeds"));
+    // feed storages still in use add their feed row again on the next write
+    d->summaries.clear();
+    d->feedURLs.clear();
+    ++d->generation;
+}
+
+quint64 Akregator::Backend::StorageSQLiteImpl::generation() const
+{
+    return d->generation;
+}
+
+QVector<Akregator::Backend::Storage::SearchHit> Akregator::Backend::StorageSQLiteImpl::search(const QString &query, int maxHits) const
+{
+    QVector<SearchHit> hits;
+    const QStringList words = query.split(QRegularExpression(QStringLiteral("\\W+")), QString::SkipEmptyParts);
+    if (words.isEmpty() || maxHits <= 0 || !d->isOpen) {
+        return hits;
+    }
+
+    QStringList terms;
+    for (const QString &word : words) {
+        terms += ftsString(word);
+    }
+
+    // every word must occur in one of the columns, bm25() weighs matches in the title and the author higher.
+    // It ranks better matches lower, so the score is negated
+    QSqlQuery &select = statement(QStringLiteral("SELECT feeds.url, articles.guid, -bm25(articlesText, 3.0, 2.0, 1.0, 1.0) AS score"
+                                                 " FROM articlesText JOIN articles ON articles.id = articlesText.rowid"
+                                                 " JOIN feeds ON feeds.id = articles.feedId"
+                                                 " WHERE articlesText MATCH :terms AND (articles.status & 1) = 0"
+                                                 " ORDER BY score DESC, articles.pubDate DESC LIMIT :maxHits"));
+    select.bindValue(QStringLiteral(":terms"), terms.join(QLatin1Char(' ')));
+    select.bindValue(QStringLiteral(":maxHits"), maxHits);
+    if (!exec(select)) {
+        return hits;
+    }
+
+    while (select.next()) {
+        SearchHit hit;
+        hit.feedUrl = select.value(0).toString();
+        hit.guid = select.value(1).toString();
+        hit.score = select.value(2).toDouble();
+        hits.append(hit);
+    }
+    select.finish();
+    return hits;
+}
+
+void Akregator::Backend::StorageSQLiteImpl::compactArchive(const QString &feedUrl, uint purgeBefore, CompactionResult &)
+{
+    if (!d->isOpen || purgeBefore == 0 || !d->summaries.contains(feedUrl)) {
+        return;
+    }
+    d->createFeedStorage(feedUrl)->purgeDeletedArticles(purgeBefore);
+    commit();
+}
+
+void Akregator::Backend::StorageSQLiteImpl::compactSharedFiles(CompactionResult &result)
+{
+    if (!d->isOpen || !commit()) {
+        return;
+    }
+
+    const QString filePath = d->archivePath + QLatin1String("/archive.sqlite");
+    const QString walPath = filePath + QLatin1String("-wal");
+    d->execute(QStringLiteral("PRAGMA wal_checkpoint(TRUNCATE)"));
+    const qint64 sizeBefore = QFileInfo(filePath).size() + QFileInfo(walPath).size();
+
+    // VACUUM fails while statements are still active
+    for (QSqlQuery *const i : qAsConst(d->statements)) {
+        i->finish();
+    }
+    if (!d->execute(QStringLiteral("VACUUM"))) {
+        return;
+    }
+    d->execute(QStringLiteral("PRAGMA wal_checkpoint(TRUNCATE)"));
+
+    ++d->generation;
+    ++result.files;
+    result.sizeBefore += sizeBefore;
+    result.sizeAfter += QFileInfo(filePath).size() + QFileInfo(walPath).size();
+    PersistenceService::self()->syncFiles(QStringList(filePath));
+}
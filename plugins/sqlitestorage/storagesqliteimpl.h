@@ -0,0 +1,137 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef STORAGESQLITEIMPL_H
+#define STORAGESQLITEIMPL_H
+
+#include "storage.h"
+
+class QSqlQuery;
+
+namespace Akregator
+{
+namespace Backend
+{
+class FeedStorageSQLiteImpl;
+
+/**
+ * SQLite implementation of Storage interface.
+ *
+ * All feeds are stored in a single database in WAL mode. Changes are collected in one
+ * transaction, which is committed a few seconds after the first change or on commit().
+ */
+class StorageSQLiteImpl : public Storage
+{
+    Q_OBJECT
+public:
+
+    StorageSQLiteImpl();
+    ~StorageSQLiteImpl();
+
+    /** QStandardPaths::GenericDataLocation + "/akregator/Archive" */
+    static QString defaultArchivePath();
+
+    /** sets the directory where the database will be stored.
+
+        @param archivePath the path to the archive, or QString() to reset it to the default.
+     */
+    void setArchivePath(const QString &archivePath);
+
+    /** returns the directory containing the database */
+    QString archivePath() const;
+
+    void initialize(const QStringList &params) override;
+    bool open(bool autoCommit = false) override;
+    bool commit() override;
+    bool rollback() override;
+    bool close() override;
+
+    FeedStorage *archiveFor(const QString &url) override;
+    const FeedStorage *archiveFor(const QString &url) const override;
+
+    bool autoCommit() const override;
+    int unreadFor(const QString &url) const override;
+    void setUnreadFor(const QString &url, int unread) override;
+    int totalCountFor(const QString &url) const override;
+    void setTotalCountFor(const QString &url, int total) override;
+    int lastFetchFor(const QString &url) const override;
+    void setLastFetchFor(const QString &url, int lastFetch) override;
+    FetchValidators fetchValidatorsFor(const QString &url) const override;
+    void setFetchValidatorsFor(const QString &url, const FetchValidators &validators) override;
+
+    QStringList feeds() const override;
+
+    void storeFeedList(const QString &opmlStr) override;
+    QString restoreFeedList() const override;
+
+    void storeTagSet(const QString &xmlStr) override;
+    QString restoreTagSet() const override;
+
+    /** adds all feed storages from a source to this storage
+        existing articles are replaced
+    */
+    void add(Storage *source) override;
+
+    /** deletes all feed storages in this archive */
+    void clear() override;
+
+    /** returns the articles containing all words of @p query in their title, description,
+        content or author name, best match first */
+    QVector<SearchHit> search(const QString &query, int maxHits) const override;
+
+    /** drops the old deleted articles of the feed, the database file is rewritten by compactSharedFiles() */
+    void compactArchive(const QString &feedUrl, uint purgeBefore, CompactionResult &result) override;
+    /** commits and runs VACUUM, which rebuilds the database file without its free pages */
+    void compactSharedFiles(CompactionResult &result) override;
+
+    /** returns the prepared statement for @p sql, preparing it on first use.
+        Statements are kept until the storage is closed */
+    QSqlQuery &statement(const QString &sql) const;
+
+    /** executes a prepared statement, logging the error if it fails */
+    bool exec(QSqlQuery &query) const;
+
+    /** returns the id of the feed row of @p url, adding the row if there is none yet */
+    qint64 feedId(const QString &url);
+
+    /** starts the write transaction unless one is open already. Must be called before every write,
+        the transaction is committed by the next commit() */
+    void markDirty();
+
+    /** changes on every rollback, clear and compaction, see FeedStorage::generation() */
+    quint64 generation() const;
+
+protected Q_SLOTS:
+    void slotCommit();
+
+private:
+    StorageSQLiteImpl(const StorageSQLiteImpl &);
+    StorageSQLiteImpl &operator =(const StorageSQLiteImpl &);
+
+    class StorageSQLiteImplPrivate;
+    StorageSQLiteImplPrivate *d;
+};
+
+} // namespace Backend
+} // namespace Akregator
+
+#endif // STORAGESQLITEIMPL_H
@@ -117,6 +117,10 @@ public:
 
     virtual QVector<Akregator::Article> selectedArticles() const = 0;
 
+    /** returns the articles the user is likely to select after the current one:
+        the next and previous article in the list, and the next unread one */
+    virtual QVector<Akregator::Article> neighbourArticles() const = 0;
+
     virtual Akregator::TreeNode *selectedSubscription() const = 0;
 
 public Q_SLOTS:
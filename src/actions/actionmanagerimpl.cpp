@@ -231,6 +231,16 @@ void ActionManagerImpl::initMainWidget(MainWidget *mainWidget)
     connect(action, &QAction::triggered, d->mainWidget, &MainWidget::slotFeedAddGroup);
     coll->setDefaultShortcut(action, QKeySequence(Qt::SHIFT + Qt::Key_Insert));
 
+    action = coll->addAction(QStringLiteral("feed_search_archive"));
+    action->setIcon(QIcon::fromTheme(QStringLiteral("edit-find")));
+    action->setText(i18n("&Search Archive..."));
+    connect(action, &QAction::triggered, d->mainWidget, &MainWidget::slotSearchArchive);
+
+    action = coll->addAction(QStringLiteral("feed_compact_archive"));
+    action->setIcon(QIcon::fromTheme(QStringLiteral("archive-remove")));
+    action->setText(i18n("&Compact Archive"));
+    connect(action, &QAction::triggered, d->mainWidget, &MainWidget::slotCompactArchive);
+
     action = coll->addAction(QStringLiteral("feed_remove"));
     action->setIcon(QIcon::fromTheme(QStringLiteral("edit-delete")));
     action->setText(i18n("&Delete Feed"));
@@ -31,7 +31,9 @@
 #include "akregatorconfig.h"
 #include "aboutdata.h"
 #include "actionmanagerimpl.h"
+#include "conditionalretriever.h"
 #include "article.h"
+#include "articlemetadatacache.h"
 #include "fetchqueue.h"
 #include "feedlist.h"
 #include "framemanager.h"
@@ -39,6 +41,7 @@
 #include "loadfeedlistcommand.h"
 #include "mainwidget.h"
 #include "notificationmanager.h"
+#include "persistenceservice.h"
 #include "plugin.h"
 #include "pluginmanager.h"
 #include "storage.h"
@@ -72,13 +75,13 @@
 #include <kstandardaction.h>
 
 #include <QApplication>
+#include <QBuffer>
 #include <QFile>
 #include <QObject>
 #include <QStringList>
-#include <QTextStream>
 #include <QTimer>
 #include <QWidget>
-#include <QDomDocument>
+#include <QXmlStreamWriter>
 #include "akregratormigrateapplication.h"
 #include "partadaptor.h"
 
@@ -87,97 +90,71 @@
 #include <QStandardPaths>
 
 namespace {
-static QDomDocument createDefaultFeedList()
+static void writeDefaultFeed(QXmlStreamWriter &writer, const QString &title, const QString &xmlUrl)
 {
-    QDomDocument doc;
-    QDomProcessingInstruction z = doc.createProcessingInstruction(QStringLiteral("xml"), QStringLiteral("version=\"1.0\" encoding=\"UTF-8\""));
-    doc.appendChild(z);
-
-    QDomElement root = doc.createElement(QStringLiteral("opml"));
-    root.setAttribute(QStringLiteral("version"), QStringLiteral("1.0"));
-    doc.appendChild(root);
-
-    QDomElement head = doc.createElement(QStringLiteral("head"));
-    root.appendChild(head);
-
-    QDomElement text = doc.createElement(QStringLiteral("text"));
-    text.appendChild(doc.createTextNode(i18n("Feeds")));
-    head.appendChild(text);
+    writer.writeEmptyElement(QStringLiteral("outline"));
+    writer.writeAttribute(QStringLiteral("text"), title);
+    writer.writeAttribute(QStringLiteral("xmlUrl"), xmlUrl);
+}
 
-    QDomElement body = doc.createElement(QStringLiteral("body"));
-    root.appendChild(body);
+static QByteArray createDefaultFeedList()
+{
+    QByteArray opml;
+    QBuffer buffer(&opml);
+    buffer.open(QIODevice::WriteOnly);
 
-    QDomElement mainFolder = doc.createElement(QStringLiteral("outline"));
-    mainFolder.setAttribute(QStringLiteral("text"), QStringLiteral("KDE"));
-    body.appendChild(mainFolder);
+    QXmlStreamWriter writer(&buffer);
+    writer.writeStartDocument();
 
-    QDomElement dot = doc.createElement(QStringLiteral("outline"));
-    dot.setAttribute(QStringLiteral("text"), i18n("KDE Dot News"));
-    dot.setAttribute(QStringLiteral("xmlUrl"), QStringLiteral("http://www.kde.org/dotkdeorg.rdf"));
-    mainFolder.appendChild(dot);
+    writer.writeStartElement(QStringLiteral("opml"));
+    writer.writeAttribute(QStringLiteral("version"), QStringLiteral("1.0"));
 
-    QDomElement linuxFeeds = doc.createElement(QStringLiteral("outline"));
-    linuxFeeds.setAttribute(QStringLiteral("text"), i18n("Linux.com"));
-    linuxFeeds.setAttribute(QStringLiteral("xmlUrl"), QStringLiteral("https://www.linux.com/rss/feeds.php"));
-    mainFolder.appendChild(linuxFeeds);
+    writer.writeStartElement(QStringLiteral("head"));
+    writer.writeTextElement(QStringLiteral("text"), i18n("Feeds"));
+    writer.writeEndElement();
 
-    QDomElement planetkde = doc.createElement(QStringLiteral("outline"));
-    planetkde.setAttribute(QStringLiteral("text"), i18n("Planet KDE"));
-    planetkde.setAttribute(QStringLiteral("xmlUrl"), QStringLiteral("http://planetkde.org/rss20.xml"));
-    mainFolder.appendChild(planetkde);
+    writer.writeStartElement(QStringLiteral("body"));
 
-    QDomElement planetkdepim = doc.createElement(QStringLiteral("outline"));
-    planetkdepim.setAttribute(QStringLiteral("text"), i18n("Planet KDE PIM"));
-    planetkdepim.setAttribute(QStringLiteral("xmlUrl"), QStringLiteral("http://pim.planetkde.org/rss20.xml"));
-    mainFolder.appendChild(planetkdepim);
+    writer.writeStartElement(QStringLiteral("outline"));
+    writer.writeAttribute(QStringLiteral("text"), QStringLiteral("KDE"));
 
-    QDomElement apps = doc.createElement(QStringLiteral("outline"));
-    apps.setAttribute(QStringLiteral("text"), i18n("KDE Apps"));
-    apps.setAttribute(QStringLiteral("xmlUrl"), QStringLiteral("https://store.kde.org/content.rdf"));
-    mainFolder.appendChild(apps);
+    writeDefaultFeed(writer, i18n("KDE Dot News"), QStringLiteral("http://www.kde.org/dotkdeorg.rdf"));
+    writeDefaultFeed(writer, i18n("Linux.com"), QStringLiteral("https://www.linux.com/rss/feeds.php"));
+    writeDefaultFeed(writer, i18n("Planet KDE"), QStringLiteral("http://planetkde.org/rss20.xml"));
+    writeDefaultFeed(writer, i18n("Planet KDE PIM"), QStringLiteral("http://pim.planetkde.org/rss20.xml"));
+    writeDefaultFeed(writer, i18n("KDE Apps"), QStringLiteral("https://store.kde.org/content.rdf"));
 
 #if 0
     // hungarian feed(s)
-    QDomElement hungarianFolder = doc.createElement(QStringLiteral("outline"));
-    hungarianFolder.setAttribute(QStringLiteral("text"), i18n("Hungarian feeds"));
-    mainFolder.appendChild(hungarianFolder);
-
-    QDomElement hungarianKde = doc.createElement(QStringLiteral("outline"));
-    hungarianKde.setAttribute(QStringLiteral("text"), i18n("KDE.HU"));
-    hungarianKde.setAttribute(QStringLiteral("xmlUrl"), QStringLiteral("http://kde.hu/rss.xml"));
-    hungarianFolder.appendChild(hungarianKde);
+    writer.writeStartElement(QStringLiteral("outline"));
+    writer.writeAttribute(QStringLiteral("text"), i18n("Hungarian feeds"));
+    writeDefaultFeed(writer, i18n("KDE.HU"), QStringLiteral("http://kde.hu/rss.xml"));
+    writer.writeEndElement();
 #endif
     // Brazilian Portuguese feeds
-    QDomElement portugueuseFolder = doc.createElement(QStringLiteral("outline"));
-    portugueuseFolder.setAttribute(QStringLiteral("text"), i18n("Brazilian Portuguese feeds"));
-    mainFolder.appendChild(portugueuseFolder);
-
-    QDomElement portugueuseKde = doc.createElement(QStringLiteral("outline"));
-    portugueuseKde.setAttribute(QStringLiteral("text"), i18n("Planet KDE Brazilian Portuguese"));
-    portugueuseKde.setAttribute(QStringLiteral("xmlUrl"), QStringLiteral("http://planetkde.org/pt-br/rss20.xml"));
-    portugueuseFolder.appendChild(portugueuseKde);
+    writer.writeStartElement(QStringLiteral("outline"));
+    writer.writeAttribute(QStringLiteral("text"), i18n("Brazilian Portuguese feeds"));
+    writeDefaultFeed(writer, i18n("Planet KDE Brazilian Portuguese"), QStringLiteral("http://planetkde.org/pt-br/rss20.xml"));
+    writer.writeEndElement();
 
     // spanish feed(s)
-    QDomElement spanishFolder = doc.createElement(QStringLiteral("outline"));
-    spanishFolder.setAttribute(QStringLiteral("text"), i18n("Spanish feeds"));
-    mainFolder.appendChild(spanishFolder);
-
-    QDomElement spanishKde = doc.createElement(QStringLiteral("outline"));
-    spanishKde.setAttribute(QStringLiteral("text"), i18n("Planet KDE España"));
-    spanishKde.setAttribute(QStringLiteral("xmlUrl"), QStringLiteral("http://planet.kde-espana.org/atom.xml"));
-    spanishFolder.appendChild(spanishKde);
+    writer.writeStartElement(QStringLiteral("outline"));
+    writer.writeAttribute(QStringLiteral("text"), i18n("Spanish feeds"));
+    writeDefaultFeed(writer, i18n("Planet KDE España"), QStringLiteral("http://planet.kde-espana.org/atom.xml"));
+    writer.writeEndElement();
 
     // french feed(s)
-    QDomElement frenchFolder = doc.createElement(QStringLiteral("outline"));
-    frenchFolder.setAttribute(QStringLiteral("text"), i18n("French feeds"));
-    mainFolder.appendChild(frenchFolder);
+    writer.writeStartElement(QStringLiteral("outline"));
+    writer.writeAttribute(QStringLiteral("text"), i18n("French feeds"));
+    writeDefaultFeed(writer, i18n("Planet KDE France"), QStringLiteral("https://fr.planetkde.org/rss20.xml"));
+    writer.writeEndElement();
 
-    QDomElement frenchKde = doc.createElement(QStringLiteral("outline"));
-    frenchKde.setAttribute(QStringLiteral("text"), i18n("Planet KDE France"));
-    frenchKde.setAttribute(QStringLiteral("xmlUrl"), QStringLiteral("https://fr.planetkde.org/rss20.xml"));
-    frenchFolder.appendChild(frenchKde);
+    writer.writeEndElement(); // KDE
+    writer.writeEndElement(); // body
+    writer.writeEndElement(); // opml
+    writer.writeEndDocument();
 
-    return doc;
+    return opml;
 }
 }
 
@@ -293,6 +270,9 @@ Part::Part(QWidget *parentWidget, QObject *parent, const QVariantList &)
     connect(m_autosaveTimer, &QTimer::timeout, this, &Part::slotSaveFeedList);
     m_autosaveTimer->start(5 * 60 * 1000); // 5 minutes
 
+    connect(Backend::PersistenceService::self(), &Backend::PersistenceService::writeFailed, this, &Part::slotFeedListWriteFailed);
+    connect(Backend::PersistenceService::self(), &Backend::PersistenceService::flushed, this, &Part::slotFlushed);
+
     QString useragent = QStringLiteral("Akregator/%1; syndication").arg(QStringLiteral(AKREGATOR_VERSION));
 
     if (!Settings::customUserAgent().isEmpty()) {
@@ -300,6 +280,7 @@ Part::Part(QWidget *parentWidget, QObject *parent, const QVariantList &)
     }
 
     Syndication::FileRetriever::setUserAgent(useragent);
+    ConditionalRetriever::setUserAgent(useragent);
 
     loadPlugins(QStringLiteral("extension"));   // FIXME: also unload them!
     if (mCentralWidget->previousSessionCrashed()) {
@@ -360,8 +341,11 @@ void Part::slotOnShutdown()
     //delete m_mainWidget;
     delete TrayIcon::getInstance();
     TrayIcon::setInstance(nullptr);
+    ArticleMetadataCache::self()->clear();
     delete m_storage;
     m_storage = 0;
+    // the feed list and the archive must be on disk before we quit
+    Backend::PersistenceService::self()->waitForDone();
     //delete m_actionManager;
 }
 
@@ -392,6 +376,9 @@ void Part::slotSettingsChanged()
     }
 
     Syndication::FileRetriever::setUseCache(Settings::useHTMLCache());
+    ConditionalRetriever::setUseCache(Settings::useHTMLCache());
+    ArticleMetadataCache::self()->setMaximumSize(Settings::articleMetadataCacheSize() * 1024);
+    Backend::PersistenceService::self()->setSyncPolicy(static_cast<Backend::PersistenceService::SyncPolicy>(Settings::writeSyncPolicy()));
 
     QStringList fonts;
     fonts.append(Settings::standardFont());
@@ -488,15 +475,15 @@ bool Part::openFile()
     return true;
 }
 
-bool Part::writeToTextFile(const QString &data, const QString &filename) const
+bool Part::writeToFile(const QByteArray &data, const QString &filename) const
 {
     QSaveFile file(filename);
     if (!file.open(QIODevice::WriteOnly)) {
         return false;
     }
-    QTextStream stream(&file);
-    stream.setCodec("UTF-8");
-    stream << data << endl;
+    if (file.write(data) != data.size()) {
+        file.cancelWriting();
+    }
     return file.commit();
 }
 
@@ -545,6 +532,11 @@ void Part::slotSaveFeedList()
         return;
     }
 
+    // nothing to write when no feed or folder changed since the last save
+    if (!m_mainWidget->isFeedListModified()) {
+        return;
+    }
+
     // the first time we overwrite the feed list, we create a backup
     if (!m_backedUpList) {
         const QString backup = localFilePath() + QLatin1Char('~');
@@ -553,17 +545,35 @@ void Part::slotSaveFeedList()
         }
     }
 
-    const QString xml = m_mainWidget->feedListToOPML().toString();
-    m_storage->storeFeedList(xml);
-    if (writeToTextFile(xml, localFilePath())) {
+    const QByteArray opml = m_mainWidget->feedListToOPML();
+    m_storage->storeFeedList(QString::fromUtf8(opml));
+
+    // written on the I/O thread, slotFeedListWriteFailed() marks the list modified again if that fails
+    Backend::PersistenceService::self()->writeFile(localFilePath(), opml);
+    m_mainWidget->setFeedListModified(false);
+}
+
+void Part::slotFeedListWriteFailed(const QString &path)
+{
+    if (path != localFilePath() || !m_mainWidget) {
+        return;
+    }
+
+    m_mainWidget->setFeedListModified(true);
+    if (m_shuttingDown) {
         return;
     }
 
     KMessageBox::error(m_mainWidget,
-                       i18n("Access denied: Cannot save feed list to <b>%1</b>. Please check your permissions.", localFilePath()),
+                       i18n("Access denied: Cannot save feed list to <b>%1</b>. Please check your permissions.", path),
                        i18n("Write Error"));
 }
 
+void Part::slotFlushed(const QString &name, qint64 msecs)
+{
+    qCDebug(AKREGATOR_LOG) << "flushed" << name << "in" << msecs << "ms";
+}
+
 bool Part::isTrayIconEnabled() const
 {
     return Settings::showTrayIcon();
@@ -592,13 +602,8 @@ void Part::importFile(const QUrl &url)
 
     QFile file(filename);
     if (file.open(QIODevice::ReadOnly)) {
-        // Read OPML feeds list and build QDom tree.
-        QDomDocument doc;
-        if (doc.setContent(file.readAll())) {
-            m_mainWidget->importFeedList(doc);
-        } else {
-            KMessageBox::error(m_mainWidget, i18n("Could not import the file %1 (no valid OPML)", filename), i18n("OPML Parsing Error"));
-        }
+        // the import command parses the OPML and reports invalid documents
+        m_mainWidget->importFeedList(file.readAll());
     } else {
         KMessageBox::error(m_mainWidget, i18n("The file %1 could not be read, check if it exists or if it is readable for the current user.", filename), i18n("Read Error"));
     }
@@ -618,13 +623,13 @@ void Part::exportFile(const QUrl &url)
             return;
         }
 
-        if (!writeToTextFile(m_mainWidget->feedListToOPML().toString(), fname)) {
+        if (!writeToFile(m_mainWidget->feedListToOPML(), fname)) {
             KMessageBox::error(m_mainWidget, i18n("Access denied: cannot write to file %1. Please check your permissions.", fname), i18n("Write Error"));
         }
 
         return;
     } else {
-        auto job = KIO::storedPut(m_mainWidget->feedListToOPML().toString().toUtf8(), url, -1);
+        auto job = KIO::storedPut(m_mainWidget->feedListToOPML(), url, -1);
         KJobWidgets::setWindow(job, m_mainWidget);
         if (!job->exec()) {
             KMessageBox::error(m_mainWidget, job->errorString());
@@ -175,13 +175,16 @@ private Q_SLOTS:
 
     void flushAddFeedRequests();
 
+    void slotFeedListWriteFailed(const QString &path);
+    void slotFlushed(const QString &name, qint64 msecs);
+
     void slotRestoreSession(Akregator::CrashWidget::CrashAction type);
 private: // methods
 
     /** fills the font settings with system fonts, if fonts are not set */
     void initFonts();
 
-    bool writeToTextFile(const QString &data, const QString &fname) const;
+    bool writeToFile(const QByteArray &data, const QString &fname) const;
 
     /**
      * This function ist called by the MainWindow upon restore
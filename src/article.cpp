@@ -23,6 +23,7 @@
 */
 
 #include "article.h"
+#include "articlemetadatacache.h"
 #include "feed.h"
 #include "feedstorage.h"
 #include "shared.h"
@@ -79,6 +80,7 @@ namespace Akregator {
 struct Article::Private : public Shared {
     Private();
     Private(const QString &guid, Feed *feed, Backend::FeedStorage *archive);
+    Private(const QString &guid, Feed *feed, Backend::FeedStorage *archive, const Backend::FeedStorage::ArticleRecord &record);
     Private(const ItemPtr &article, Feed *feed, Backend::FeedStorage *archive);
 
     /** The status of the article is stored in an int, the bits having the
@@ -168,9 +170,24 @@ Article::Private::Private(const QString &guid_, Feed *feed_, Backend::FeedStorag
     : feed(feed_)
     , guid(guid_)
     , archive(archive_)
-    , status(archive->status(guid))
-    , hash(archive->hash(guid))
-    , pubDate(QDateTime::fromTime_t(archive->pubDate(guid)))
+    , status(0)
+    , hash(0)
+{
+    typedef Backend::FeedStorage::ArticleRecord Record;
+    Record record;
+    archive->readRecord(guid, record, Record::Status | Record::Hash | Record::PubDate);
+    status = record.status;
+    hash = record.hash;
+    pubDate = QDateTime::fromTime_t(record.pubDate);
+}
+
+Article::Private::Private(const QString &guid_, Feed *feed_, Backend::FeedStorage *archive_, const Backend::FeedStorage::ArticleRecord &record)
+    : feed(feed_)
+    , guid(guid_)
+    , archive(archive_)
+    , status((record.status & Read) != 0 ? Read : New)
+    , hash(record.hash)
+    , pubDate(QDateTime::fromTime_t(record.pubDate))
 {
 }
 
@@ -181,76 +198,81 @@ Article::Private::Private(const ItemPtr &article, Feed *feed_, Backend::FeedStor
     , hash(0)
 {
     Q_ASSERT(archive);
-    const QList<PersonPtr> authorList = article->authors();
+    typedef Backend::FeedStorage::ArticleRecord Record;
 
-    QString author;
+    const Backend::FeedStorage::ItemRecord item = Article::recordForItem(article);
+    guid = item.guid;
+    hash = item.record.hash;
 
-    const PersonPtr firstAuthor = !authorList.isEmpty() ? authorList.first() : PersonPtr();
+    Record stored;
+    if (!archive->readRecord(guid, stored, Record::Hash | Record::PubDate)) {
+        pubDate = QDateTime::fromTime_t(item.record.pubDate);
+        archive->writeRecord(guid, item.record);
+        ArticleMetadataCache::self()->invalidate(archive, guid);
+    } else {
+        pubDate = QDateTime::fromTime_t(stored.pubDate);
+        if (hash != stored.hash) { //article is in archive, was it modified?
+            // if yes, update
+            archive->updateFields(guid, item.fields, item.record);
+            ArticleMetadataCache::self()->invalidate(archive, guid);
+        } else if (item.record.hasEnclosure) {
+            // always update the enclosure, as it's not used for hash calculation
+            archive->updateFields(guid, Record::Enclosure, item.record);
+        }
+    }
+}
 
-    hash = Utils::calcHash(article->title() + article->description() + article->content() + article->link() + author);
+uint Article::hashForItem(const ItemPtr &item)
+{
+    return Utils::calcHash(item->title() + item->description() + item->content() + item->link());
+}
 
-    guid = article->id();
+Backend::FeedStorage::ItemRecord Article::recordForItem(const ItemPtr &article, bool markAsRead)
+{
+    typedef Backend::FeedStorage::ArticleRecord Record;
+    Backend::FeedStorage::ItemRecord item;
+    Record &record = item.record;
 
-    if (!archive->contains(guid)) {
-        archive->addEntry(guid);
+    item.guid = article->id();
+    item.fields = Record::Hash | Record::Title | Record::Description | Record::Content | Record::Link;
 
-        archive->setHash(guid, hash);
-        QString title = article->title();
-        if (title.isEmpty()) {
-            title = buildTitle(article->description());
-        }
-        archive->setTitle(guid, title);
-        archive->setContent(guid, article->content());
-        archive->setDescription(guid, article->description());
-        archive->setLink(guid, article->link());
-        //archive->setComments(guid, article.comments());
-        //archive->setCommentsLink(guid, article.commentsLink().url());
-        archive->setGuidIsPermaLink(guid, false);
-        archive->setGuidIsHash(guid, guid.startsWith(QStringLiteral("hash:")));
-        const time_t datePublished = article->datePublished();
-        if (datePublished > 0) {
-            pubDate.setTime_t(datePublished);
-        } else {
-            pubDate = QDateTime::currentDateTime();
-        }
-        archive->setPubDate(guid, pubDate.toTime_t());
-        if (firstAuthor) {
-            archive->setAuthorName(guid, firstAuthor->name());
-            archive->setAuthorUri(guid, firstAuthor->uri());
-            archive->setAuthorEMail(guid, firstAuthor->email());
-        }
-        const QList<EnclosurePtr> encs = article->enclosures();
-        if (!encs.isEmpty()) {
-            archive->setEnclosure(guid, encs[0]->url(), encs[0]->type(), encs[0]->length());
-        }
-    } else {
-        // always update comments count, as it's not used for hash calculation
-        //archive->setComments(guid, article.comments());
-        if (hash != archive->hash(guid)) { //article is in archive, was it modified?
-            // if yes, update
-            pubDate.setTime_t(archive->pubDate(guid));
-            archive->setHash(guid, hash);
-            QString title = article->title();
-            if (title.isEmpty()) {
-                title = buildTitle(article->description());
-            }
-            archive->setTitle(guid, title);
-            archive->setDescription(guid, article->description());
-            archive->setContent(guid, article->content());
-            archive->setLink(guid, article->link());
-            if (firstAuthor) {
-                archive->setAuthorName(guid, firstAuthor->name());
-                archive->setAuthorUri(guid, firstAuthor->uri());
-                archive->setAuthorEMail(guid, firstAuthor->email());
-            }
-            //archive->setCommentsLink(guid, article.commentsLink());
-        }
+    record.hash = hashForItem(article);
+    record.title = article->title();
+    if (record.title.isEmpty()) {
+        record.title = buildTitle(article->description());
+    }
+    record.description = article->description();
+    record.content = article->content();
+    record.link = article->link();
+    //record.comments = article.comments();
+    //record.commentsLink = article.commentsLink().url();
+    record.guidIsPermaLink = false;
+    record.guidIsHash = item.guid.startsWith(QStringLiteral("hash:"));
+
+    const time_t datePublished = article->datePublished();
+    record.pubDate = datePublished > 0 ? datePublished : QDateTime::currentDateTime().toTime_t();
+
+    // new articles are stored as unread, the New flag is only kept in memory
+    record.status = markAsRead ? Private::Read : 0;
+
+    const QList<PersonPtr> authorList = article->authors();
+    if (!authorList.isEmpty()) {
+        const PersonPtr firstAuthor = authorList.first();
+        item.fields |= Record::Author;
+        record.authorName = firstAuthor->name();
+        record.authorUri = firstAuthor->uri();
+        record.authorEMail = firstAuthor->email();
     }
 
     const QList<EnclosurePtr> encs = article->enclosures();
     if (!encs.isEmpty()) {
-        archive->setEnclosure(guid, encs[0]->url(), encs[0]->type(), encs[0]->length());
+        item.fields |= Record::Enclosure;
+        record.hasEnclosure = true;
+        record.enclosureUrl = encs[0]->url();
+        record.enclosureType = encs[0]->type();
+        record.enclosureLength = encs[0]->length();
     }
+    return item;
 }
 
 Article::Article() : d(new Private)
@@ -269,6 +291,10 @@ Article::Article(const ItemPtr &article, Backend::FeedStorage *archive) : d(new
 {
 }
 
+Article::Article(const QString &guid, Feed *feed, const Backend::FeedStorage::ArticleRecord &record) : d(new Private(guid, feed, feed->storage()->archiveFor(feed->xmlUrl()), record))
+{
+}
+
 bool Article::isNull() const
 {
     return d->archive == 0; // TODO: use proper null state
@@ -290,6 +316,7 @@ void Article::setDeleted()
     d->status = Private::Deleted | Private::Read;
     d->archive->setStatus(d->guid, d->status);
     d->archive->setDeleted(d->guid);
+    ArticleMetadataCache::self()->invalidate(d->archive, d->guid);
 
     if (d->feed) {
         d->feed->setArticleDeleted(*this);
@@ -395,7 +422,7 @@ QString Article::title() const
 {
     QString str;
     if (d->archive) {
-        str = d->archive->title(d->guid);
+        str = ArticleMetadataCache::self()->value(d->archive, d->guid, ArticleMetadataCache::Title);
     }
     return str;
 }
@@ -404,7 +431,7 @@ QString Article::authorName() const
 {
     QString str;
     if (d->archive) {
-        str = d->archive->authorName(d->guid);
+        str = ArticleMetadataCache::self()->value(d->archive, d->guid, ArticleMetadataCache::AuthorName);
     }
     return str;
 }
@@ -413,7 +440,7 @@ QString Article::authorEMail() const
 {
     QString str;
     if (d->archive) {
-        str = d->archive->authorEMail(d->guid);
+        str = ArticleMetadataCache::self()->value(d->archive, d->guid, ArticleMetadataCache::AuthorEMail);
     }
     return str;
 }
@@ -422,7 +449,7 @@ QString Article::authorUri() const
 {
     QString str;
     if (d->archive) {
-        str = d->archive->authorUri(d->guid);
+        str = ArticleMetadataCache::self()->value(d->archive, d->guid, ArticleMetadataCache::AuthorUri);
     }
     return str;
 }
@@ -474,7 +501,7 @@ QString Article::authorAsHtml() const
 
 QUrl Article::link() const
 {
-    return QUrl(d->archive->link(d->guid));
+    return QUrl(ArticleMetadataCache::self()->value(d->archive, d->guid, ArticleMetadataCache::Link));
 }
 
 QString Article::description() const
@@ -482,6 +509,15 @@ QString Article::description() const
     return d->archive->description(d->guid);
 }
 
+QString Article::cachedDescription() const
+{
+    QString str;
+    if (d->archive) {
+        str = ArticleMetadataCache::self()->value(d->archive, d->guid, ArticleMetadataCache::Description);
+    }
+    return str;
+}
+
 QString Article::content(ContentOption opt) const
 {
     const QString cnt = d->archive->content(d->guid);
@@ -518,6 +554,11 @@ uint Article::hash() const
     return d->hash;
 }
 
+void Article::setHash(uint hash)
+{
+    d->hash = hash;
+}
+
 bool Article::keep() const
 {
     return (d->status & Private::Keep) != 0;
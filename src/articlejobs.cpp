@@ -31,10 +31,9 @@
 #include "akregator_debug.h"
 #include <KLocalizedString>
 
+#include <QSet>
 #include <QTimer>
 
-#include <vector>
-
 #include <cassert>
 
 using namespace Akregator;
@@ -48,12 +47,14 @@ ArticleDeleteJob::ArticleDeleteJob(QObject *parent)
 
 void ArticleDeleteJob::appendArticleIds(const QList<ArticleId> &ids)
 {
-    m_ids += ids;
+    for (const ArticleId &id : ids) {
+        appendArticleId(id);
+    }
 }
 
 void ArticleDeleteJob::appendArticleId(const ArticleId &id)
 {
-    m_ids += id;
+    m_ids[id.feedUrl].append(id.guid);
 }
 
 void ArticleDeleteJob::start()
@@ -68,23 +69,21 @@ void ArticleDeleteJob::doStart()
         emitResult();
         return;
     }
-    std::vector<Feed *> feeds;
 
-    for (const ArticleId &id : qAsConst(m_ids)) {
-        Article article = m_feedList->findArticle(id.feedUrl, id.guid);
-        if (article.isNull()) {
+    // one feed at a time, so that every feed notifies its observers once
+    for (auto it = m_ids.cbegin(), end = m_ids.cend(); it != end; ++it) {
+        Feed *const feed = m_feedList->findByURL(it.key());
+        if (!feed) {
             continue;
         }
-
-        if (Feed *const feed = m_feedList->findByURL(id.feedUrl)) {
-            feeds.push_back(feed);
-            feed->setNotificationMode(false);
+        feed->setNotificationMode(false);
+        for (const QString &guid : it.value()) {
+            Article article = feed->findArticle(guid);
+            if (!article.isNull() && !article.isDeleted()) {
+                article.setDeleted();
+            }
         }
-        article.setDeleted();
-    }
-
-    for (Feed *const i : qAsConst(feeds)) {
-        i->setNotificationMode(true);
+        feed->setNotificationMode(true);
     }
 
     emitResult();
@@ -98,12 +97,12 @@ ArticleModifyJob::ArticleModifyJob(QObject *parent) : KJob(parent)
 
 void ArticleModifyJob::setStatus(const ArticleId &id, int status)
 {
-    m_status[id] = status;
+    m_status[id.feedUrl][id.guid] = status;
 }
 
 void ArticleModifyJob::setKeep(const ArticleId &id, bool keep)
 {
-    m_keepFlags[id] = keep;
+    m_keepFlags[id.feedUrl][id.guid] = keep;
 }
 
 void ArticleModifyJob::start()
@@ -118,38 +117,37 @@ void ArticleModifyJob::doStart()
         emitResult();
         return;
     }
-    std::vector<Feed *> feeds;
 
-    for (auto it = m_keepFlags.cbegin(), end = m_keepFlags.cend(); it != end; ++it) {
-        const ArticleId &id = it.key();
-        Feed *feed = m_feedList->findByURL(id.feedUrl);
+    QSet<QString> feedUrls = m_keepFlags.keys().toSet();
+    feedUrls.unite(m_status.keys().toSet());
+
+    // one feed at a time, so that every feed notifies its observers once. Articles
+    // that already have the new value are skipped, so they are neither written nor
+    // reported as changed
+    for (const QString &feedUrl : qAsConst(feedUrls)) {
+        Feed *const feed = m_feedList->findByURL(feedUrl);
         if (!feed) {
             continue;
         }
         feed->setNotificationMode(false);
-        feeds.push_back(feed);
-        Article article = feed->findArticle(id.guid);
-        if (!article.isNull()) {
-            article.setKeep(it.value());
-        }
-    }
 
-    for (auto it = m_status.cbegin(), end = m_status.cend(); it != end; ++it) {
-        const ArticleId &id = it.key();
-        Feed *feed = m_feedList->findByURL(id.feedUrl);
-        if (!feed) {
-            continue;
+        const QHash<QString, bool> keepFlags = m_keepFlags.value(feedUrl);
+        for (auto it = keepFlags.cbegin(), end = keepFlags.cend(); it != end; ++it) {
+            Article article = feed->findArticle(it.key());
+            if (!article.isNull() && article.keep() != it.value()) {
+                article.setKeep(it.value());
+            }
         }
-        feed->setNotificationMode(false);
-        feeds.push_back(feed);
-        Article article = feed->findArticle(id.guid);
-        if (!article.isNull()) {
-            article.setStatus(it.value());
+
+        const QHash<QString, int> statuses = m_status.value(feedUrl);
+        for (auto it = statuses.cbegin(), end = statuses.cend(); it != end; ++it) {
+            Article article = feed->findArticle(it.key());
+            if (!article.isNull() && article.status() != it.value()) {
+                article.setStatus(it.value());
+            }
         }
-    }
 
-    for (Feed *const i : qAsConst(feeds)) {
-        i->setNotificationMode(true);
+        feed->setNotificationMode(true);
     }
     emitResult();
 }
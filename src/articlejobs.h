@@ -28,9 +28,10 @@
 #include <KCompositeJob>
 
 #include <QVector>
-#include <QMap>
+#include <QHash>
 #include <QPointer>
 #include <QString>
+#include <QStringList>
 
 #include "akregator_export.h"
 
@@ -76,7 +77,8 @@ private Q_SLOTS:
 
 private:
     QSharedPointer<FeedList> m_feedList;
-    ArticleIdList m_ids;
+    /** guids of the articles to delete, by feed URL */
+    QHash<QString, QStringList> m_ids;
 };
 
 class AKREGATOR_EXPORT ArticleModifyJob : public KJob
@@ -96,8 +98,9 @@ private Q_SLOTS:
 
 private:
     QSharedPointer<FeedList> m_feedList;
-    QMap<ArticleId, bool> m_keepFlags;
-    QMap<ArticleId, int> m_status;
+    /** new keep flags and statuses, by feed URL and guid */
+    QHash<QString, QHash<QString, bool> > m_keepFlags;
+    QHash<QString, QHash<QString, int> > m_status;
 };
 
 class AKREGATOR_EXPORT ArticleListJob : public KJob
@@ -51,21 +51,17 @@
 
 using namespace Akregator;
 
-FilterDeletedProxyModel::FilterDeletedProxyModel(QObject *parent) : QSortFilterProxyModel(parent)
-{
-    setDynamicSortFilter(true);
-}
-
-bool FilterDeletedProxyModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
-{
-    return !sourceModel()->index(source_row, 0, source_parent).data(ArticleModel::IsDeletedRole).toBool();
-}
-
 SortColorizeProxyModel::SortColorizeProxyModel(QObject *parent) : QSortFilterProxyModel(parent)
     , m_keepFlagIcon(QIcon::fromTheme(QStringLiteral("mail-mark-important")))
 {
     m_unreadColor = KColorScheme(QPalette::Normal, KColorScheme::View).foreground(KColorScheme::PositiveText).color();
     m_newColor = KColorScheme(QPalette::Normal, KColorScheme::View).foreground(KColorScheme::NegativeText).color();
+    setDynamicSortFilter(true);
+}
+
+const ArticleModel *SortColorizeProxyModel::articleModel() const
+{
+    return static_cast<const ArticleModel *>(sourceModel());
 }
 
 bool SortColorizeProxyModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
@@ -74,8 +70,13 @@ bool SortColorizeProxyModel::filterAcceptsRow(int source_row, const QModelIndex
         return false;
     }
 
+    const ArticleModel *const model = articleModel();
+    if (model->rowKey(source_row).isDeleted) {
+        return false;
+    }
+
     for (uint i = 0; i < m_matchers.size(); ++i) {
-        if (!static_cast<ArticleModel *>(sourceModel())->rowMatches(source_row, m_matchers[i])) {
+        if (!model->rowMatches(source_row, m_matchers[i])) {
             return false;
         }
     }
@@ -83,6 +84,11 @@ bool SortColorizeProxyModel::filterAcceptsRow(int source_row, const QModelIndex
     return true;
 }
 
+bool SortColorizeProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+{
+    return articleModel()->rowLessThan(left.row(), right.row(), left.column());
+}
+
 void SortColorizeProxyModel::setFilters(const std::vector<QSharedPointer<const Filters::AbstractMatcher> > &matchers)
 {
     if (m_matchers == matchers) {
@@ -102,7 +108,7 @@ QVariant SortColorizeProxyModel::data(const QModelIndex &idx, int role) const
 
     switch (role) {
     case Qt::ForegroundRole:
-        switch (static_cast<ArticleStatus>(sourceIdx.data(ArticleModel::StatusRole).toInt())) {
+        switch (static_cast<ArticleStatus>(articleModel()->rowKey(sourceIdx.row()).status)) {
         case Unread:
             return Settings::useCustomColors()
                    ? Settings::colorUnreadArticles() : m_unreadColor;
@@ -115,7 +121,7 @@ QVariant SortColorizeProxyModel::data(const QModelIndex &idx, int role) const
         break;
     case Qt::DecorationRole:
         if (sourceIdx.column() == ArticleModel::ItemTitleColumn) {
-            return sourceIdx.data(ArticleModel::IsImportantRole).toBool() ? m_keepFlagIcon : QVariant();
+            return articleModel()->rowKey(sourceIdx.row()).isImportant ? m_keepFlagIcon : QVariant();
         }
         break;
     }
@@ -144,16 +150,13 @@ void ArticleListView::setArticleModel(ArticleModel *model)
     m_proxy->setSourceModel(model);
     m_proxy->setSortRole(ArticleModel::SortRole);
     m_proxy->setFilters(m_matchers);
-    FilterDeletedProxyModel *const proxy2 = new FilterDeletedProxyModel(model);
-    proxy2->setSortRole(ArticleModel::SortRole);
-    proxy2->setSourceModel(m_proxy);
 
     connect(model, &QAbstractItemModel::rowsInserted,
             m_proxy.data(), &QSortFilterProxyModel::invalidate);
 
     FilterColumnsProxyModel *const columnsProxy = new FilterColumnsProxyModel(model);
     columnsProxy->setSortRole(ArticleModel::SortRole);
-    columnsProxy->setSourceModel(proxy2);
+    columnsProxy->setSourceModel(m_proxy);
     columnsProxy->setColumnEnabled(ArticleModel::ItemTitleColumn);
     columnsProxy->setColumnEnabled(ArticleModel::FeedTitleColumn);
     columnsProxy->setColumnEnabled(ArticleModel::DateColumn);
@@ -44,17 +44,13 @@ class Article;
 namespace Filters {
 }
 
-class AKREGATORPART_EXPORT FilterDeletedProxyModel : public QSortFilterProxyModel
-{
-    Q_OBJECT
-public:
-
-    explicit FilterDeletedProxyModel(QObject *parent = nullptr);
-
-private:
-    bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const override;
-};
+class ArticleModel;
 
+/**
+ * Hides deleted articles and articles not matching the filters, sorts and colorizes the rest.
+ * Must be used directly on top of an ArticleModel: filtering and sorting read the model's packed
+ * row keys instead of calling data().
+ */
 class AKREGATORPART_EXPORT SortColorizeProxyModel : public QSortFilterProxyModel
 {
     Q_OBJECT
@@ -66,8 +62,12 @@ public:
 
     void setFilters(const std::vector<QSharedPointer<const Akregator::Filters::AbstractMatcher> > &);
 
-private:
+protected:
     bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const override;
+    bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
+
+private:
+    const ArticleModel *articleModel() const;
 
     QIcon m_keepFlagIcon;
     std::vector<QSharedPointer<const Akregator::Filters::AbstractMatcher> > m_matchers;
@@ -36,8 +36,43 @@
 #include <QList>
 #include <QRegExp>
 
+#include <algorithm>
+
 namespace Akregator {
 namespace Filters {
+namespace {
+/** relative cost of evaluating a criterion: reading the subject, then comparing */
+int criterionCost(Criterion::Subject subject, Criterion::Predicate predicate)
+{
+    int cost = 0;
+    switch (subject) {
+    case Criterion::Status:
+    case Criterion::KeepFlag:
+        break;
+    case Criterion::Link:
+        cost = 1;
+        break;
+    case Criterion::Title:
+    case Criterion::Author:
+        cost = 2;
+        break;
+    case Criterion::Description:
+        cost = 3;
+        break;
+    }
+    cost *= 3;
+
+    switch (predicate) {
+    case Criterion::Contains:
+        return cost + 1;
+    case Criterion::Matches:
+        return cost + 2;
+    default:
+        return cost;
+    }
+}
+}
+
 AbstractMatcher::AbstractMatcher()
 {
 }
@@ -164,7 +199,7 @@ bool Criterion::satisfiedBy(const Article &article) const
         concreteSubject = QVariant(article.title());
         break;
     case Description:
-        concreteSubject = QVariant(article.description());
+        concreteSubject = QVariant(article.cachedDescription());
         break;
     case Link:
         // ### Maybe use prettyUrl here?
@@ -213,6 +248,56 @@ bool Criterion::satisfiedBy(const Article &article) const
     return satisfied;
 }
 
+bool ArticleMatcher::CompiledCriterion::satisfiedBy(const Article &article) const
+{
+    bool satisfied = false;
+
+    if (predicate == Criterion::Equals && subject == Criterion::Status) {
+        satisfied = article.status() == object.toInt();
+    } else if (predicate == Criterion::Equals && subject == Criterion::KeepFlag) {
+        satisfied = article.keep() == object.toBool();
+    } else {
+        QString text;
+        switch (subject) {
+        case Criterion::Title:
+            text = article.title();
+            break;
+        case Criterion::Description:
+            text = article.cachedDescription();
+            break;
+        case Criterion::Link:
+            text = article.link().url();
+            break;
+        case Criterion::Author:
+            text = article.authorName();
+            break;
+        case Criterion::Status:
+            text = QString::number(article.status());
+            break;
+        case Criterion::KeepFlag:
+            text = article.keep() ? QStringLiteral("true") : QStringLiteral("false");
+            break;
+        }
+
+        switch (predicate) {
+        case Criterion::Contains:
+            satisfied = needle.indexIn(text) != -1;
+            break;
+        case Criterion::Equals:
+            satisfied = text == object.toString();
+            break;
+        case Criterion::Matches:
+            satisfied = regExp.match(text).hasMatch();
+            break;
+        default:
+            qCDebug(AKREGATOR_LOG) << "Internal inconsistency; predicateType should never be Negation";
+            break;
+        }
+    }
+
+    return negated ? !satisfied : satisfied;
+}
+
 Criterion::Subject Criterion::subject() const
 {
     return m_subject;
@@ -241,6 +326,34 @@ ArticleMatcher::ArticleMatcher(const QVector<Criterion> &criteria, Association a
     : m_criteria(criteria)
     , m_association(assoc)
 {
+    compile();
+}
+
+void ArticleMatcher::compile()
+{
+    m_plan.clear();
+    m_plan.reserve(m_criteria.count());
+
+    for (const Criterion &criterion : qAsConst(m_criteria)) {
+        CompiledCriterion compiled;
+        compiled.subject = criterion.subject();
+        compiled.predicate = static_cast<Criterion::Predicate>(criterion.predicate() & ~Criterion::Negation);
+        compiled.negated = criterion.predicate() & Criterion::Negation;
+        compiled.cost = criterionCost(compiled.subject, compiled.predicate);
+        compiled.object = criterion.object();
+        if (compiled.predicate == Criterion::Contains) {
+            compiled.needle = QStringMatcher(compiled.object.toString(), Qt::CaseInsensitive);
+        } else if (compiled.predicate == Criterion::Matches) {
+            compiled.regExp = QRegularExpression(compiled.object.toString());
+            compiled.regExp.optimize();
+        }
+        m_plan.append(compiled);
+    }
+
+    // the criteria have no side effects, so evaluating the cheap ones first does not change the result
+    std::stable_sort(m_plan.begin(), m_plan.end(), [](const CompiledCriterion &lhs, const CompiledCriterion &rhs) {
+        return lhs.cost < rhs.cost;
+    });
 }
 
 bool ArticleMatcher::matches(const Article &a) const
@@ -286,6 +399,7 @@ void ArticleMatcher::readConfig(KConfigGroup *config)
         c.readConfig(config);
         m_criteria.append(c);
     }
+    compile();
 }
 
 bool ArticleMatcher::operator==(const AbstractMatcher &other) const
@@ -306,12 +420,14 @@ bool ArticleMatcher::operator!=(const AbstractMatcher &other) const
 
 bool ArticleMatcher::anyCriterionMatches(const Article &a) const
 {
-    if (m_criteria.isEmpty()) {
+    if (m_plan.isEmpty()) {
         return true;
     }
-    const int criteriaSize(m_criteria.size());
-    for (int index = 0; index < criteriaSize; ++index) {
-        if (m_criteria.at(index).satisfiedBy(a)) {
+    if (a.isNull()) {
+        return false;
+    }
+    for (const CompiledCriterion &criterion : m_plan) {
+        if (criterion.satisfiedBy(a)) {
             return true;
         }
     }
@@ -320,12 +436,14 @@ bool ArticleMatcher::anyCriterionMatches(const Article &a) const
 
 bool ArticleMatcher::allCriteriaMatch(const Article &a) const
 {
-    if (m_criteria.isEmpty()) {
+    if (m_plan.isEmpty()) {
         return true;
     }
-    const int criteriaSize(m_criteria.size());
-    for (int index = 0; index < criteriaSize; ++index) {
-        if (!m_criteria.at(index).satisfiedBy(a)) {
+    if (a.isNull()) {
+        return false;
+    }
+    for (const CompiledCriterion &criterion : m_plan) {
+        if (!criterion.satisfiedBy(a)) {
             return false;
         }
     }
@@ -29,6 +29,9 @@
 #define AKREGATOR_ARTICLEMATCHER_H
 
 #include "akregatorpart_export.h"
+
+#include <QRegularExpression>
+#include <QStringMatcher>
 #include <QVector>
 #include <QString>
 #include <QVariant>
@@ -66,6 +69,10 @@ private:
 };
 
 /** a powerful matcher supporting multiple criterions, which can be combined      via logical OR or AND
+
+    The criteria are compiled once into a plan ordered by cost: status and keep flag checks run
+    before checks needing article text, which is only read when a cheap check did not decide the
+    result already. All text is read from the ArticleMetadataCache, not the archive.
  *  @author Frerich Raabe
  */
 class AKREGATORPART_EXPORT ArticleMatcher : public AbstractMatcher
@@ -93,11 +100,18 @@ private:
     static Association stringToAssociation(const QString &assocStr);
     static QString associationToString(Association association);
 
+    /** a criterion prepared for repeated evaluation */
+    struct CompiledCriterion;
+
+    /** builds m_plan from m_criteria */
+    void compile();
+
     bool anyCriterionMatches(const Article &a) const;
     bool allCriteriaMatch(const Article &a) const;
 
     QVector<Criterion> m_criteria;
     Association m_association;
+    QVector<CompiledCriterion> m_plan;
 };
 
 /** Criterion for ArticleMatcher
@@ -148,6 +162,21 @@ private:
     Predicate m_predicate;
     QVariant m_object;
 };
+
+struct ArticleMatcher::CompiledCriterion {
+    bool satisfiedBy(const Article &article) const;
+
+    Criterion::Subject subject;
+    /** the predicate without the Negation flag */
+    Criterion::Predicate predicate;
+    bool negated;
+    int cost;
+    QVariant object;
+    /** case insensitive, for Contains */
+    QStringMatcher needle;
+    /** for Matches */
+    QRegularExpression regExp;
+};
 } // namespace Filters
 } // namespace Akregator
 
@@ -0,0 +1,291 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "articlemetadatacache.h"
+#include "akregatorconfig.h"
+#include "feedstorage.h"
+
+#include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+using namespace Akregator;
+
+namespace {
+typedef Backend::FeedStorage::ArticleRecord ArticleRecord;
+
+const int cachedFields = ArticleRecord::Title | ArticleRecord::Link | ArticleRecord::Author;
+
+QString fieldOf(const ArticleRecord &record, ArticleMetadataCache::Field field)
+{
+    switch (field) {
+    case ArticleMetadataCache::Title:
+        return record.title;
+    case ArticleMetadataCache::Link:
+        return record.link;
+    case ArticleMetadataCache::AuthorName:
+        return record.authorName;
+    case ArticleMetadataCache::AuthorEMail:
+        return record.authorEMail;
+    case ArticleMetadataCache::AuthorUri:
+        return record.authorUri;
+    case ArticleMetadataCache::Description:
+        return record.description;
+    case ArticleMetadataCache::FieldCount:
+        break;
+    }
+    return QString();
+}
+
+/** estimated overhead of a row besides the string data: offsets, lengths and the guid hash entry */
+const int rowOverhead = ArticleMetadataCache::FieldCount * 2 * sizeof(int) + 64;
+
+/** the cached fields of one feed, one column per field, all strings packed into one UTF-8 buffer */
+class FeedColumns
+{
+public:
+    explicit FeedColumns(quint64 generation_) : generation(generation_)
+        , wasted(0)
+        , descriptionsLoaded(false)
+    {
+    }
+
+    /** appends the fields of @p record as a new row. Equal strings are stored once if @p interned is given */
+    int appendRow(const ArticleRecord &record, QHash<QByteArray, int> *interned);
+
+    /** the number of columns filled in for every row */
+    int fieldCount() const
+    {
+        return descriptionsLoaded ? ArticleMetadataCache::FieldCount : ArticleMetadataCache::Description;
+    }
+
+    QString value(int row, ArticleMetadataCache::Field field) const
+    {
+        return QString::fromUtf8(pool.constData() + offsets[field][row], lengths[field][row]);
+    }
+
+    /** cost for QCache, in kilobytes */
+    int cost() const
+    {
+        return (pool.size() + rows.count() * rowOverhead) / 1024 + 1;
+    }
+
+    QByteArray pool;
+    QVector<int> offsets[ArticleMetadataCache::FieldCount];
+    QVector<int> lengths[ArticleMetadataCache::FieldCount];
+    QHash<QString, int> rows;
+    /** Backend::FeedStorage::generation() of the archive when the columns were loaded */
+    quint64 generation;
+    /** bytes of the pool used by invalidated rows */
+    int wasted;
+    /** whether the Description column is filled in */
+    bool descriptionsLoaded;
+};
+
+int FeedColumns::appendRow(const ArticleRecord &record, QHash<QByteArray, int> *interned)
+{
+    const int row = offsets[0].count();
+    for (int field = 0; field < fieldCount(); ++field) {
+        const QByteArray utf8 = fieldOf(record, static_cast<ArticleMetadataCache::Field>(field)).toUtf8();
+        int offset = interned ? interned->value(utf8, -1) : -1;
+        if (offset == -1) {
+            offset = pool.size();
+            pool += utf8;
+            if (interned) {
+                interned->insert(utf8, offset);
+            }
+        }
+        offsets[field].append(offset);
+        lengths[field].append(utf8.size());
+    }
+    return row;
+}
+}
+
+class ArticleMetadataCache::Private
+{
+public:
+    /** returns the columns of @p archive, loading them if necessary. Returns 0 if the feed does not fit into the cache */
+    FeedColumns *columnsFor(Backend::FeedStorage *archive);
+    /** returns the columns of @p archive if they are cached and still current */
+    FeedColumns *cachedColumns(Backend::FeedStorage *archive);
+    /** reads the descriptions of all rows of @p columns. Returns 0 if the feed no longer fits into the cache */
+    FeedColumns *loadDescriptions(Backend::FeedStorage *archive, FeedColumns *columns);
+    /** re-inserts the columns of @p feedUrl after they grew, so QCache accounts for the new cost */
+    void updateCost(const QString &feedUrl);
+
+    /** by feed URL */
+    QCache<QString, FeedColumns> feeds;
+};
+
+FeedColumns *ArticleMetadataCache::Private::cachedColumns(Backend::FeedStorage *archive)
+{
+    const QString url = archive->url();
+    FeedColumns *columns = feeds.object(url);
+    if (columns && columns->generation != archive->generation()) {
+        feeds.remove(url);
+        return 0;
+    }
+    return columns;
+}
+
+FeedColumns *ArticleMetadataCache::Private::columnsFor(Backend::FeedStorage *archive)
+{
+    if (FeedColumns *columns = cachedColumns(archive)) {
+        return columns;
+    }
+
+    FeedColumns *columns = new FeedColumns(archive->generation());
+    // author names and links repeat a lot within a feed, so equal strings share their bytes
+    QHash<QByteArray, int> interned;
+    const QStringList guids = archive->articles();
+    columns->rows.reserve(guids.count());
+    for (int field = 0; field < columns->fieldCount(); ++field) {
+        columns->offsets[field].reserve(guids.count());
+        columns->lengths[field].reserve(guids.count());
+    }
+    for (const QString &guid : guids) {
+        ArticleRecord record;
+        if (archive->readRecord(guid, record, cachedFields)) {
+            columns->rows.insert(guid, columns->appendRow(record, &interned));
+        }
+    }
+    columns->pool.squeeze();
+
+    // QCache deletes the object right away if it is larger than the whole cache
+    return feeds.insert(archive->url(), columns, columns->cost()) ? columns : 0;
+}
+
+FeedColumns *ArticleMetadataCache::Private::loadDescriptions(Backend::FeedStorage *archive, FeedColumns *columns)
+{
+    const int rowCount = columns->offsets[0].count();
+    columns->offsets[Description].fill(0, rowCount);
+    columns->lengths[Description].fill(0, rowCount);
+    ArticleRecord record;
+    for (QHash<QString, int>::ConstIterator it = columns->rows.constBegin(); it != columns->rows.constEnd(); ++it) {
+        if (archive->readRecord(it.key(), record, ArticleRecord::Description)) {
+            const QByteArray utf8 = record.description.toUtf8();
+            columns->offsets[Description][it.value()] = columns->pool.size();
+            columns->lengths[Description][it.value()] = utf8.size();
+            columns->pool += utf8;
+        }
+    }
+    columns->descriptionsLoaded = true;
+
+    const QString url = archive->url();
+    updateCost(url);
+    return feeds.object(url);
+}
+
+void ArticleMetadataCache::Private::updateCost(const QString &feedUrl)
+{
+    FeedColumns *columns = feeds.take(feedUrl);
+    if (columns) {
+        feeds.insert(feedUrl, columns, columns->cost());
+    }
+}
+
+ArticleMetadataCache *ArticleMetadataCache::self()
+{
+    static ArticleMetadataCache self;
+    return &self;
+}
+
+ArticleMetadataCache::ArticleMetadataCache() : d(new Private)
+{
+    setMaximumSize(Settings::articleMetadataCacheSize() * 1024);
+}
+
+ArticleMetadataCache::~ArticleMetadataCache()
+{
+    delete d;
+}
+
+QString ArticleMetadataCache::value(Backend::FeedStorage *archive, const QString &guid, Field field)
+{
+    FeedColumns *columns = d->columnsFor(archive);
+    if (columns && field == Description && !columns->descriptionsLoaded) {
+        columns = d->loadDescriptions(archive, columns);
+    }
+    if (columns) {
+        const int row = columns->rows.value(guid, -1);
+        if (row != -1) {
+            return columns->value(row, field);
+        }
+    }
+
+    // not cached yet (added or invalidated since the feed was loaded), or the feed does not fit
+    int fields = field == Description ? int(ArticleRecord::Description) : cachedFields;
+    if (columns && columns->descriptionsLoaded) {
+        fields = cachedFields | ArticleRecord::Description;
+    }
+    ArticleRecord record;
+    if (!archive->readRecord(guid, record, fields)) {
+        return QString();
+    }
+    if (!columns) {
+        return fieldOf(record, field);
+    }
+    const int row = columns->appendRow(record, 0);
+    columns->rows.insert(guid, row);
+    const QString str = columns->value(row, field);
+    d->updateCost(archive->url());
+    return str;
+}
+
+void ArticleMetadataCache::invalidate(Backend::FeedStorage *archive, const QString &guid)
+{
+    FeedColumns *columns = d->cachedColumns(archive);
+    if (!columns) {
+        return;
+    }
+    const QHash<QString, int>::Iterator it = columns->rows.find(guid);
+    if (it == columns->rows.end()) {
+        return;
+    }
+    for (int field = 0; field < columns->fieldCount(); ++field) {
+        columns->wasted += columns->lengths[field][it.value()];
+    }
+    columns->rows.erase(it);
+
+    // rows are only ever appended, so reload the feed once most of its buffer belongs to replaced rows
+    if (columns->wasted > columns->pool.size() / 2) {
+        d->feeds.remove(archive->url());
+    }
+}
+
+void ArticleMetadataCache::invalidateFeed(const QString &feedUrl)
+{
+    d->feeds.remove(feedUrl);
+}
+
+void ArticleMetadataCache::setMaximumSize(int kiloBytes)
+{
+    d->feeds.setMaxCost(kiloBytes);
+}
+
+void ArticleMetadataCache::clear()
+{
+    d->feeds.clear();
+}
@@ -0,0 +1,91 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef AKREGATOR_ARTICLEMETADATACACHE_H
+#define AKREGATOR_ARTICLEMETADATACACHE_H
+
+#include "akregator_export.h"
+
+#include <QString>
+
+namespace Akregator {
+namespace Backend {
+class FeedStorage;
+}
+
+/**
+ * Keeps the short, frequently displayed fields of the archived articles in memory, so that article
+ * lists, filters and notifications do not query the archive for every call of Article::title() etc.
+ *
+ * The fields of a feed are loaded in one pass on first access and stored column by column in one
+ * UTF-8 buffer per feed. Feeds are evicted least recently used first when the configured size
+ * (Settings::articleMetadataCacheSize()) is exceeded. Whoever writes these fields to the archive
+ * must call invalidate() afterwards.
+ *
+ * Descriptions are only loaded for a feed once one of them is asked for, which filters on the
+ * description do for every article of the feed. They count against the same size limit.
+ *
+ * Feeds are cached by URL. Changes the archive makes on its own (rollback, clear, closing or
+ * compacting the file) change Backend::FeedStorage::generation(), and the feed is loaded again.
+ */
+class AKREGATOR_EXPORT ArticleMetadataCache
+{
+public:
+    enum Field {
+        Title = 0,
+        Link,
+        AuthorName,
+        AuthorEMail,
+        AuthorUri,
+        Description,
+        FieldCount
+    };
+
+    static ArticleMetadataCache *self();
+
+    /** returns @p field of the article @p guid stored in @p archive */
+    QString value(Backend::FeedStorage *archive, const QString &guid, Field field);
+
+    /** forgets the cached fields of one article, to be called after they were changed in the archive */
+    void invalidate(Backend::FeedStorage *archive, const QString &guid);
+
+    /** forgets all cached fields of a feed */
+    void invalidateFeed(const QString &feedUrl);
+
+    /** sets the memory limit in kilobytes */
+    void setMaximumSize(int kiloBytes);
+
+    /** forgets everything, e.g. before the archive is closed */
+    void clear();
+
+private:
+    ArticleMetadataCache();
+    ~ArticleMetadataCache();
+    ArticleMetadataCache(const ArticleMetadataCache &);
+    ArticleMetadataCache &operator=(const ArticleMetadataCache &);
+
+    class Private;
+    Private *const d;
+};
+} // namespace Akregator
+
+#endif // AKREGATOR_ARTICLEMETADATACACHE_H
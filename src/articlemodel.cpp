@@ -31,7 +31,10 @@
 
 #include <Syndication/Tools>
 
+#include <QHash>
+#include <QMap>
 #include <QMimeData>
+#include <QPair>
 #include <QString>
 #include <QVector>
 
@@ -41,6 +44,7 @@
 #include <memory>
 
 #include <QLocale>
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 
@@ -54,6 +58,29 @@ public:
     Private(const QVector<Article> &articles, ArticleModel *qq);
     QVector<Article> articles;
     QVector<QString> titleCache;
+    QVector<RowKey> keys;
+
+    /** feed titles in sort order, mapped to their ordinal */
+    QMap<QString, int> feedOrdinals;
+
+    /** guids are only unique within a feed, and the model may show several feeds */
+    typedef QPair<const Feed *, QString> ArticleKey;
+    /** maps each article to its row in @c articles */
+    QHash<ArticleKey, int> rowIndex;
+
+    static ArticleKey keyFor(const Article &article)
+    {
+        return ArticleKey(article.feed(), article.guid());
+    }
+
+    /** adds the feed titles of @p list to feedOrdinals, renumbering the keys of all rows if a title is new */
+    void addFeedOrdinals(const QVector<Article> &list);
+    RowKey keyOf(const Article &article) const;
+
+    /** re-numbers the rows from @p first to the end, after rows were removed */
+    void reindexFrom(int first);
+    /** returns the sorted rows of the given articles, skipping articles not in the model */
+    QVector<int> rowsOf(const QVector<Article> &list) const;
 
     void articlesAdded(const QVector<Article> &);
     void articlesRemoved(const QVector<Article> &);
@@ -71,15 +98,82 @@ static QString stripHtml(const QString &html)
     return str.simplified();
 }
 
+static QString feedTitle(const Article &article)
+{
+    return article.feed() ? article.feed()->title() : QString();
+}
+
 ArticleModel::Private::Private(const QVector<Article> &articles_, ArticleModel *qq)
     : q(qq)
     , articles(articles_)
 {
+    addFeedOrdinals(articles);
     const int articlesCount(articles.count());
     titleCache.resize(articlesCount);
+    keys.resize(articlesCount);
+    rowIndex.reserve(articlesCount);
     for (int i = 0; i < articlesCount; ++i) {
         titleCache[i] = stripHtml(articles[i].title());
+        keys[i] = keyOf(articles[i]);
+        rowIndex.insert(keyFor(articles[i]), i);
+    }
+}
+
+void ArticleModel::Private::addFeedOrdinals(const QVector<Article> &list)
+{
+    bool added = false;
+    for (const Article &i : list) {
+        const QString title = feedTitle(i);
+        if (!feedOrdinals.contains(title)) {
+            feedOrdinals.insert(title, 0);
+            added = true;
+        }
+    }
+    if (!added) {
+        return;
+    }
+    int ordinal = 0;
+    for (QMap<QString, int>::Iterator it = feedOrdinals.begin(), end = feedOrdinals.end(); it != end; ++it) {
+        it.value() = ordinal++;
+    }
+    const int keysCount(keys.count());
+    for (int i = 0; i < keysCount; ++i) {
+        keys[i].feedOrdinal = feedOrdinals.value(feedTitle(articles[i]));
+    }
+}
+
+ArticleModel::RowKey ArticleModel::Private::keyOf(const Article &article) const
+{
+    RowKey key;
+    key.pubDate = article.pubDate().toTime_t();
+    key.feedOrdinal = feedOrdinals.value(feedTitle(article));
+    key.status = static_cast<quint8>(article.status());
+    key.isDeleted = article.isDeleted();
+    key.isImportant = article.keep();
+    return key;
+}
+
+void ArticleModel::Private::reindexFrom(int first)
+{
+    const int articlesCount(articles.count());
+    for (int i = first; i < articlesCount; ++i) {
+        rowIndex[keyFor(articles[i])] = i;
+    }
+}
+
+QVector<int> ArticleModel::Private::rowsOf(const QVector<Article> &list) const
+{
+    QVector<int> rows;
+    rows.reserve(list.count());
+    for (const Article &i : list) {
+        const int row = rowIndex.value(keyFor(i), -1);
+        if (row >= 0) {
+            rows.append(row);
+        }
     }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    return rows;
 }
 
 ArticleModel::ArticleModel(const QVector<Article> &articles, QObject *parent) : QAbstractTableModel(parent)
@@ -181,6 +275,9 @@ void ArticleModel::clear()
     beginResetModel();
     d->articles.clear();
     d->titleCache.clear();
+    d->keys.clear();
+    d->feedOrdinals.clear();
+    d->rowIndex.clear();
     endResetModel();
 }
 
@@ -204,6 +301,7 @@ void ArticleModel::Private::articlesAdded(const QVector<Article> &list)
     if (list.isEmpty()) { //assert?
         return;
     }
+    addFeedOrdinals(list);
     const int first = articles.count();
     q->beginInsertRows(QModelIndex(), first, first + list.size() - 1);
 
@@ -212,43 +310,61 @@ void ArticleModel::Private::articlesAdded(const QVector<Article> &list)
 
     const int newArticlesCount(articles.count());
     titleCache.resize(newArticlesCount);
+    keys.resize(newArticlesCount);
     for (int i = oldSize; i < newArticlesCount; ++i) {
         titleCache[i] = stripHtml(articles[i].title());
+        keys[i] = keyOf(articles[i]);
+        rowIndex.insert(keyFor(articles[i]), i);
     }
     q->endInsertRows();
 }
 
 void ArticleModel::Private::articlesRemoved(const QVector<Article> &list)
 {
-    //might want to avoid indexOf() in case of performance problems
+    const QVector<int> rows = rowsOf(list);
+    if (rows.isEmpty()) {
+        return;
+    }
     for (const Article &i : list) {
-        const int row = articles.indexOf(i);
-        Q_ASSERT(row != -1);
-        q->removeRow(row, QModelIndex());
+        rowIndex.remove(keyFor(i));
+    }
+
+    // remove contiguous ranges back to front, so the rows of the ranges not yet removed stay valid
+    int last = rows.count() - 1;
+    while (last >= 0) {
+        int first = last;
+        while (first > 0 && rows[first - 1] == rows[first] - 1) {
+            --first;
+        }
+        const int firstRow = rows[first];
+        const int count = last - first + 1;
+        q->beginRemoveRows(QModelIndex(), firstRow, firstRow + count - 1);
+        articles.remove(firstRow, count);
+        titleCache.remove(firstRow, count);
+        keys.remove(firstRow, count);
+        q->endRemoveRows();
+        last = first - 1;
     }
+    reindexFrom(rows.first());
 }
 
 void ArticleModel::Private::articlesUpdated(const QVector<Article> &list)
 {
-    int rmin = 0;
-    int rmax = 0;
-
-    const int numberOfArticles(articles.count());
-    if (numberOfArticles > 0) {
-        rmin = numberOfArticles - 1;
-        //might want to avoid indexOf() in case of performance problems
-        for (const Article &i : list) {
-            const int row = articles.indexOf(i);
-            //TODO: figure out how why the Article might not be found in
-            //TODO: the articles list because we should need this conditional.
-            if (row >= 0) {
-                titleCache[row] = stripHtml(articles[row].title());
-                rmin = std::min(row, rmin);
-                rmax = std::max(row, rmax);
-            }
+    const QVector<int> rows = rowsOf(list);
+    const int rowCount = rows.count();
+    int first = 0;
+    while (first < rowCount) {
+        int last = first;
+        titleCache[rows[first]] = stripHtml(articles[rows[first]].title());
+        keys[rows[first]] = keyOf(articles[rows[first]]);
+        while (last + 1 < rowCount && rows[last + 1] == rows[last] + 1) {
+            ++last;
+            titleCache[rows[last]] = stripHtml(articles[rows[last]].title());
+            keys[rows[last]] = keyOf(articles[rows[last]]);
         }
+        Q_EMIT q->dataChanged(q->index(rows[first], 0), q->index(rows[last], ColumnCount - 1));
+        first = last + 1;
     }
-    Q_EMIT q->dataChanged(q->index(rmin, 0), q->index(rmax, ColumnCount - 1));
 }
 
 bool ArticleModel::rowMatches(int row, const QSharedPointer<const Filters::AbstractMatcher> &matcher) const
@@ -265,6 +381,29 @@ Article ArticleModel::article(int row) const
     return d->articles[row];
 }
 
+const ArticleModel::RowKey &ArticleModel::rowKey(int row) const
+{
+    return d->keys[row];
+}
+
+bool ArticleModel::rowLessThan(int left, int right, int column) const
+{
+    switch (column) {
+    case DateColumn:
+        return d->keys[left].pubDate < d->keys[right].pubDate;
+    case FeedTitleColumn:
+        return d->keys[left].feedOrdinal < d->keys[right].feedOrdinal;
+    case ItemTitleColumn:
+        return d->titleCache[left] < d->titleCache[right];
+    case AuthorColumn:
+        return d->articles[left].authorShort() < d->articles[right].authorShort();
+    case DescriptionColumn:
+    case ContentColumn:
+        return d->articles[left].description() < d->articles[right].description();
+    }
+    return left < right;
+}
+
 QStringList ArticleModel::mimeTypes() const
 {
     return QStringList() << QStringLiteral("text/uri-list");
@@ -67,6 +67,21 @@ public:
         IsDeletedRole
     };
 
+    /**
+     * The per-row values the article list filters and sorts on, kept in a plain array so proxies
+     * can read them without going through data() and QVariant.
+     */
+    struct RowKey {
+        /** publication date as time_t */
+        uint pubDate;
+        /** position of the feed title among the titles of all feeds in the model */
+        int feedOrdinal;
+        /** an ArticleStatus */
+        quint8 status;
+        bool isDeleted;
+        bool isImportant;
+    };
+
     explicit ArticleModel(const QVector<Article> &articles, QObject *parent = nullptr);
     ~ArticleModel();
 
@@ -82,6 +97,12 @@ public:
 
     Article article(int row) const;
 
+    /** returns the packed sort and filter key of @p row, which must be a valid row */
+    const RowKey &rowKey(int row) const;
+
+    /** compares two rows by the values shown in @p column, without building QVariants */
+    bool rowLessThan(int left, int right, int column) const;
+
     QStringList mimeTypes() const override;
 
     QMimeData *mimeData(const QModelIndexList &indexes) const override;
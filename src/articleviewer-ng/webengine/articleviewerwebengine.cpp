@@ -341,6 +341,11 @@ void ArticleViewerWebEngine::setArticleAction(ArticleViewerWebEngine::ArticleAct
     Q_EMIT articleAction(type, articleId, feed);
 }
 
+void ArticleViewerWebEngine::showMoreArticles()
+{
+    Q_EMIT showMoreArticlesRequested();
+}
+
 void ArticleViewerWebEngine::restoreCurrentPosition()
 {
     mPageEngine->runJavaScript(WebEngineViewer::WebEngineScript::scrollToRelativePosition(relativePosition()));
@@ -67,6 +67,8 @@ public:
     void disableIntroduction();
     void setArticleAction(ArticleViewerWebEngine::ArticleAction type, const QString &articleId, const QString &feed);
     void restoreCurrentPosition();
+    /** asks the combined view to show the next page of articles */
+    void showMoreArticles();
 
     void createViewerPluginToolManager(KActionCollection *ac, QWidget *parent);
 
@@ -98,6 +100,7 @@ Q_SIGNALS:
     void showStatusBarMessage(const QString &link);
     void showContextMenu(const QPoint &pos);
     void articleAction(Akregator::ArticleViewerWebEngine::ArticleAction type, const QString &articleId, const QString &feed);
+    void showMoreArticlesRequested();
     void findTextInHtml();
     void textToSpeech();
     void webPageMutedOrAudibleChanged(bool isAudioMuted, bool wasRecentlyAudible);
@@ -62,6 +62,11 @@
 #include <QGridLayout>
 #include <QKeyEvent>
 #include <QApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSet>
+#include <QTimer>
+#include <QWebEnginePage>
 #include <defaultnormalviewformatter.h>
 
 #include <QStandardPaths>
@@ -70,6 +75,45 @@
 using namespace Akregator;
 using namespace Akregator::Filters;
 
+namespace {
+// number of articles the combined view shows at once, and adds when asked for more
+const int CombinedViewPageSize = 50;
+
+// delay before prefetching starts, so that the shown article is loaded first
+const int PrefetchDelay = 100;
+
+// Applies a patch computed by ArticleViewerWidget::updateCombinedView() to a combined view page.
+// Returns false if the page is not the expected one or does not match the patch.
+const char combinedViewPatchScript[] =
+    "(function(generation, removed, replaced, inserted, moreArticles) {\n"
+    "    var articles = document.getElementById('articles');\n"
+    "    if (!articles || articles.getAttribute('data-generation') != generation) {\n"
+    "        return false;\n"
+    "    }\n"
+    "    var ok = true;\n"
+    "    var fragment = function(html) {\n"
+    "        var t = document.createElement('template');\n"
+    "        t.innerHTML = html;\n"
+    "        return t.content;\n"
+    "    };\n"
+    "    removed.forEach(function(id) {\n"
+    "        var e = document.getElementById(id);\n"
+    "        if (e) { e.parentNode.removeChild(e); } else { ok = false; }\n"
+    "    });\n"
+    "    replaced.forEach(function(r) {\n"
+    "        var e = document.getElementById(r[0]);\n"
+    "        if (e) { e.parentNode.replaceChild(fragment(r[1]), e); } else { ok = false; }\n"
+    "    });\n"
+    "    inserted.forEach(function(r) {\n"
+    "        var before = r[0] ? document.getElementById(r[0]) : null;\n"
+    "        if (r[0] && !before) { ok = false; return; }\n"
+    "        articles.insertBefore(fragment(r[1]), before);\n"
+    "    });\n"
+    "    document.getElementById('moreArticles').innerHTML = moreArticles;\n"
+    "    return ok;\n"
+    "})";
+}
+
 ArticleViewerWidget::ArticleViewerWidget(const QString &grantleeDirectory, KActionCollection *ac, QWidget *parent)
     : QWidget(parent)
     , m_imageDir(QUrl::fromLocalFile(QString(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/akregator/Media/"))))
@@ -77,6 +121,12 @@ ArticleViewerWidget::ArticleViewerWidget(const QString &grantleeDirectory, KActi
     , m_viewMode(NormalView)
     , m_articleViewerWidgetNg(new Akregator::ArticleViewerWebEngineWidgetNg(ac, this))
     , m_grantleeDirectory(grantleeDirectory)
+    , m_shownLimit(CombinedViewPageSize)
+    , m_shownRemaining(0)
+    , m_pageGeneration(0)
+    , m_pageLoading(false)
+    , m_pageUpdatePending(false)
+    , m_prefetchTimer(new QTimer(this))
 {
     QGridLayout *layout = new QGridLayout(this);
     layout->setMargin(0);
@@ -84,24 +134,29 @@ ArticleViewerWidget::ArticleViewerWidget(const QString &grantleeDirectory, KActi
     m_articleHtmlWriter = new Akregator::ArticleHtmlWebEngineWriter(m_articleViewerWidgetNg->articleViewerNg(), this);
     connect(m_articleViewerWidgetNg->articleViewerNg(), &ArticleViewerWebEngine::signalOpenUrlRequest, this, &ArticleViewerWidget::signalOpenUrlRequest);
     connect(m_articleViewerWidgetNg->articleViewerNg(), &ArticleViewerWebEngine::showStatusBarMessage, this, &ArticleViewerWidget::showStatusBarMessage);
+    connect(m_articleViewerWidgetNg->articleViewerNg(), &ArticleViewerWebEngine::showMoreArticlesRequested, this, &ArticleViewerWidget::slotShowMoreArticles);
+    connect(m_articleViewerWidgetNg->articleViewerNg(), &ArticleViewerWebEngine::loadFinished, this, &ArticleViewerWidget::slotLoadFinished);
+
+    m_prefetchTimer->setSingleShot(true);
+    connect(m_prefetchTimer, &QTimer::timeout, this, &ArticleViewerWidget::slotPrefetchArticle);
 }
 
 ArticleViewerWidget::~ArticleViewerWidget()
 {
 }
 
-QSharedPointer<ArticleFormatter> ArticleViewerWidget::normalViewFormatter()
+QSharedPointer<DefaultNormalViewFormatter> ArticleViewerWidget::normalViewFormatter()
 {
     if (!m_normalViewFormatter.data()) {
-        m_normalViewFormatter = QSharedPointer<ArticleFormatter>(new DefaultNormalViewFormatter(m_grantleeDirectory, m_imageDir, m_articleViewerWidgetNg->articleViewerNg()));
+        m_normalViewFormatter = QSharedPointer<DefaultNormalViewFormatter>(new DefaultNormalViewFormatter(m_grantleeDirectory, m_imageDir, m_articleViewerWidgetNg->articleViewerNg()));
     }
     return m_normalViewFormatter;
 }
 
-QSharedPointer<ArticleFormatter> ArticleViewerWidget::combinedViewFormatter()
+QSharedPointer<DefaultCombinedViewFormatter> ArticleViewerWidget::combinedViewFormatter()
 {
     if (!m_combinedViewFormatter.data()) {
-        m_combinedViewFormatter = QSharedPointer<ArticleFormatter>(new DefaultCombinedViewFormatter(m_grantleeDirectory, m_imageDir, m_articleViewerWidgetNg->articleViewerNg()));
+        m_combinedViewFormatter = QSharedPointer<DefaultCombinedViewFormatter>(new DefaultCombinedViewFormatter(m_grantleeDirectory, m_imageDir, m_articleViewerWidgetNg->articleViewerNg()));
     }
     return m_combinedViewFormatter;
 }
@@ -213,6 +268,33 @@ void ArticleViewerWidget::showArticle(const Akregator::Article &article)
     setArticleActionsEnabled(true);
 }
 
+void ArticleViewerWidget::prefetchArticles(const QVector<Article> &articles)
+{
+    m_prefetchArticles = articles;
+    if (!m_prefetchArticles.isEmpty()) {
+        m_prefetchTimer->start(PrefetchDelay);
+    } else {
+        m_prefetchTimer->stop();
+    }
+}
+
+void ArticleViewerWidget::slotPrefetchArticle()
+{
+    if (m_prefetchArticles.isEmpty()) {
+        return;
+    }
+
+    // one article at a time, to keep the event loop responsive
+    const Article article = m_prefetchArticles.takeFirst();
+    if (!article.isNull() && !article.isDeleted() && !article.feed()->loadLinkedWebsite()) {
+        normalViewFormatter()->formatArticles(QVector<Akregator::Article>() << article, ArticleFormatter::ShowIcon);
+    }
+
+    if (!m_prefetchArticles.isEmpty()) {
+        m_prefetchTimer->start(0);
+    }
+}
+
 bool ArticleViewerWidget::openUrl(const QUrl &url)
 {
     if (!m_article.isNull() && m_article.feed()->loadLinkedWebsite()) {
@@ -244,16 +326,15 @@ void ArticleViewerWidget::slotUpdateCombinedView()
         return slotClear();
     }
 
-    m_articleViewerWidgetNg->saveCurrentPosition();
-    QString text;
-
-    int num = 0;
-    QTime spent;
-    spent.start();
+    updateCombinedView();
+}
 
+QVector<Article> ArticleViewerWidget::combinedViewArticles(QStringList &shownIds) const
+{
     const std::vector< QSharedPointer<const AbstractMatcher> >::const_iterator filterEnd = m_filters.cend();
 
     QVector<Article> articles;
+    QSet<QString> seen;
     for (const Article &i : qAsConst(m_articles)) {
         if (i.isDeleted()) {
             continue;
@@ -265,20 +346,183 @@ void ArticleViewerWidget::slotUpdateCombinedView()
         if (std::find_if(m_filters.cbegin(), filterEnd, func) != filterEnd) {
             continue;
         }
+        if (articles.count() < m_shownLimit) {
+            const QString id = DefaultCombinedViewFormatter::fragmentId(i);
+            if (seen.contains(id)) {
+                continue;
+            }
+            seen.insert(id);
+            shownIds.append(id);
+        }
         articles << i;
-        ++num;
     }
-    text = combinedViewFormatter()->formatArticles(articles, ArticleFormatter::NoIcon);
+    return articles;
+}
+
+QString ArticleViewerWidget::combinedViewFragment(const Article &article, const QString &id, bool *rendered)
+{
+    QHash<QString, CombinedViewFragment>::iterator it = m_fragments.find(id);
+    if (it != m_fragments.end() && it->hash == article.hash() && it->status == article.status() && it->keep == article.keep()) {
+        return it->html;
+    }
+    if (rendered) {
+        *rendered = true;
+    }
+    CombinedViewFragment fragment;
+    fragment.hash = article.hash();
+    fragment.status = article.status();
+    fragment.keep = article.keep();
+    fragment.html = combinedViewFormatter()->formatArticleFragment(article, ArticleFormatter::NoIcon);
+    return m_fragments.insert(id, fragment)->html;
+}
+
+void ArticleViewerWidget::renderCombinedView()
+{
+    m_articleViewerWidgetNg->saveCurrentPosition();
 
-    qCDebug(AKREGATOR_LOG) << "Combined view rendering: (" << num << " articles):" << "generating HTML:" << spent.elapsed() << "ms";
+    QTime spent;
+    spent.start();
+
+    m_shownIds.clear();
+    const QVector<Article> articles = combinedViewArticles(m_shownIds);
+    m_shownRemaining = articles.count() - m_shownIds.count();
+
+    QStringList fragments;
+    fragments.reserve(m_shownIds.count());
+    for (int i = 0; i < m_shownIds.count(); ++i) {
+        fragments.append(combinedViewFragment(articles.at(i), m_shownIds.at(i)));
+    }
+
+    ++m_pageGeneration;
+    m_pageLoading = true;
+    m_pageUpdatePending = false;
+    const QString text = combinedViewFormatter()->formatPage(fragments, m_pageGeneration, m_shownRemaining);
+
+    qCDebug(AKREGATOR_LOG) << "Combined view rendering: (" << m_shownIds.count() << " articles):" << "generating HTML:" << spent.elapsed() << "ms";
     renderContent(text);
     qCDebug(AKREGATOR_LOG) << "HTML rendering:" << spent.elapsed() << "ms";
 }
 
+void ArticleViewerWidget::updateCombinedView()
+{
+    if (m_pageLoading) {
+        // patching a page that is still loading is not possible, do it once it is there
+        m_pageUpdatePending = true;
+        return;
+    }
+
+    QTime spent;
+    spent.start();
+
+    QStringList ids;
+    const QVector<Article> articles = combinedViewArticles(ids);
+    const int remaining = articles.count() - ids.count();
+
+    const QSet<QString> oldIds = m_shownIds.toSet();
+    const QSet<QString> newIds = ids.toSet();
+
+    // articles are only ever inserted into or removed from the page, so the articles
+    // staying on it have to keep their order
+    QStringList kept;
+    for (const QString &id : qAsConst(m_shownIds)) {
+        if (newIds.contains(id)) {
+            kept.append(id);
+        }
+    }
+    int keptIndex = 0;
+    for (const QString &id : qAsConst(ids)) {
+        if (oldIds.contains(id) && (keptIndex >= kept.count() || kept.at(keptIndex++) != id)) {
+            renderCombinedView();
+            return;
+        }
+    }
+
+    QJsonArray removed;
+    for (const QString &id : qAsConst(m_shownIds)) {
+        if (!newIds.contains(id)) {
+            removed.append(id);
+        }
+    }
+
+    QJsonArray replaced;
+    QJsonArray inserted;
+    for (int i = ids.count() - 1; i >= 0; --i) {
+        const QString &id = ids.at(i);
+        bool rendered = false;
+        const QString html = combinedViewFragment(articles.at(i), id, &rendered);
+        if (!oldIds.contains(id)) {
+            // inserted from the end, so the following article is already on the page
+            const QString before = (i + 1 < ids.count()) ? ids.at(i + 1) : QString();
+            inserted.append(QJsonArray() << before << html);
+        } else if (rendered) {
+            replaced.append(QJsonArray() << id << html);
+        }
+    }
+
+    if (removed.isEmpty() && replaced.isEmpty() && inserted.isEmpty() && remaining == m_shownRemaining) {
+        return;
+    }
+
+    m_shownIds = ids;
+    m_shownRemaining = remaining;
+
+    const QJsonArray arguments = QJsonArray() << m_pageGeneration << removed << replaced << inserted
+                                              << combinedViewFormatter()->formatMoreArticlesLink(remaining);
+    const QString script = QLatin1String(combinedViewPatchScript) + QStringLiteral(".apply(null, ")
+                           + QString::fromUtf8(QJsonDocument(arguments).toJson(QJsonDocument::Compact)) + QLatin1Char(')');
+
+    const int generation = m_pageGeneration;
+    QPointer<ArticleViewerWidget> that(this);
+    m_articleViewerWidgetNg->articleViewerNg()->page()->runJavaScript(script, [that, generation](const QVariant &result) {
+        if (that && !result.toBool() && that->m_viewMode == CombinedView && generation == that->m_pageGeneration) {
+            qCDebug(AKREGATOR_LOG) << "Combined view could not be patched, rendering it again";
+            that->renderCombinedView();
+        }
+    });
+
+    qCDebug(AKREGATOR_LOG) << "Combined view update: (" << removed.count() << "removed," << replaced.count() << "changed,"
+                           << inserted.count() << "added):" << spent.elapsed() << "ms";
+}
+
+void ArticleViewerWidget::slotLoadFinished()
+{
+    if (m_viewMode != CombinedView || !m_pageLoading) {
+        return;
+    }
+
+    const int generation = m_pageGeneration;
+    QPointer<ArticleViewerWidget> that(this);
+    m_articleViewerWidgetNg->articleViewerNg()->page()->runJavaScript(
+        QStringLiteral("(function() { var articles = document.getElementById('articles'); return articles ? articles.getAttribute('data-generation') : ''; })()"),
+        [that, generation](const QVariant &result) {
+        // the page is cleared before new content is set, which finishes loading too
+        if (!that || !that->m_pageLoading || generation != that->m_pageGeneration || result.toString() != QString::number(generation)) {
+            return;
+        }
+        that->m_pageLoading = false;
+        if (that->m_pageUpdatePending && that->m_viewMode == CombinedView) {
+            that->m_pageUpdatePending = false;
+            that->updateCombinedView();
+        }
+    });
+}
+
+void ArticleViewerWidget::slotShowMoreArticles()
+{
+    if (m_viewMode != CombinedView) {
+        return;
+    }
+    m_shownLimit += CombinedViewPageSize;
+    updateCombinedView();
+}
+
 void ArticleViewerWidget::slotArticlesUpdated(TreeNode * /*node*/, const QVector<Article> & /*list*/)
 {
     if (m_viewMode == CombinedView) {
-        //TODO
+        // articles are shared with the node, only their order may have to be restored
+        if (!std::is_sorted(m_articles.constBegin(), m_articles.constEnd())) {
+            std::sort(m_articles.begin(), m_articles.end());
+        }
         slotUpdateCombinedView();
     }
 }
@@ -286,19 +530,22 @@ void ArticleViewerWidget::slotArticlesUpdated(TreeNode * /*node*/, const QVector
 void ArticleViewerWidget::slotArticlesAdded(TreeNode * /*node*/, const QVector<Article> &list)
 {
     if (m_viewMode == CombinedView) {
-        //TODO sort list, then merge
-        m_articles << list;
-        std::sort(m_articles.begin(), m_articles.end());
+        QVector<Article> added = list;
+        std::sort(added.begin(), added.end());
+        const int count = m_articles.count();
+        m_articles << added;
+        std::inplace_merge(m_articles.begin(), m_articles.begin() + count, m_articles.end());
         slotUpdateCombinedView();
     }
 }
 
 void ArticleViewerWidget::slotArticlesRemoved(TreeNode * /*node*/, const QVector<Article> &list)
 {
-    Q_UNUSED(list)
-
     if (m_viewMode == CombinedView) {
-        //TODO
+        for (const Article &article : list) {
+            m_articles.removeAll(article);
+            m_fragments.remove(DefaultCombinedViewFormatter::fragmentId(article));
+        }
         slotUpdateCombinedView();
     }
 }
@@ -309,6 +556,10 @@ void ArticleViewerWidget::slotClear()
     m_node = 0;
     m_article = Article();
     m_articles.clear();
+    m_fragments.clear();
+    m_shownIds.clear();
+    m_pageLoading = false;
+    m_pageUpdatePending = false;
 
     renderContent(QString());
 }
@@ -319,6 +570,7 @@ void ArticleViewerWidget::showNode(TreeNode *node)
 
     if (node != m_node) {
         disconnectFromNode(m_node);
+        m_fragments.clear();
     }
 
     connectToNode(node);
@@ -326,6 +578,7 @@ void ArticleViewerWidget::showNode(TreeNode *node)
     m_articles.clear();
     m_article = Article();
     m_node = node;
+    m_shownLimit = CombinedViewPageSize;
 
     delete m_listJob;
 
@@ -333,7 +586,7 @@ void ArticleViewerWidget::showNode(TreeNode *node)
     connect(m_listJob.data(), &ArticleListJob::finished, this, &ArticleViewerWidget::slotArticlesListed);
     m_listJob->start();
 
-    slotUpdateCombinedView();
+    renderCombinedView();
 }
 
 qreal ArticleViewerWidget::zoomFactor() const
@@ -367,7 +620,7 @@ void ArticleViewerWidget::slotArticlesListed(KJob *job)
         m_link = QUrl();
     }
 
-    slotUpdateCombinedView();
+    renderCombinedView();
 }
 
 void ArticleViewerWidget::keyPressEvent(QKeyEvent *e)
@@ -377,6 +630,10 @@ void ArticleViewerWidget::keyPressEvent(QKeyEvent *e)
 
 void ArticleViewerWidget::updateAfterConfigChanged()
 {
+    if (m_normalViewFormatter) {
+        m_normalViewFormatter->clearCache();
+    }
+
     switch (m_viewMode) {
     case NormalView:
         if (!m_article.isNull()) {
@@ -384,7 +641,8 @@ void ArticleViewerWidget::updateAfterConfigChanged()
         }
         break;
     case CombinedView:
-        slotUpdateCombinedView();
+        m_fragments.clear();
+        renderCombinedView();
         break;
     case SummaryView:
         slotShowSummary(m_node);
@@ -32,11 +32,14 @@
 
 #include <QPointer>
 
+#include <QHash>
 #include <QSharedPointer>
+#include <QStringList>
 #include <vector>
 #include <QUrl>
 
 class KJob;
+class QTimer;
 class KActionCollection;
 
 namespace Akregator {
@@ -46,6 +49,8 @@ class AbstractMatcher;
 
 class ArticleFormatter;
 class ArticleListJob;
+class DefaultCombinedViewFormatter;
+class DefaultNormalViewFormatter;
 class OpenUrlRequest;
 class TreeNode;
 class ArticleHtmlWebEngineWriter;
@@ -65,6 +70,10 @@ public:
 
     void showArticle(const Article &article);
 
+    /** renders @p articles in the background, so that showing them later is fast.
+        Use this for the articles the user is likely to select next */
+    void prefetchArticles(const QVector<Article> &articles);
+
     /** Shows the articles of the tree node @c node (combined view).
      * Changes in the node will update the view automatically.
      *
@@ -123,10 +132,14 @@ protected Q_SLOTS:
     void slotArticlesAdded(Akregator::TreeNode *node, const QVector<Akregator::Article> &list);
     void slotArticlesRemoved(Akregator::TreeNode *node, const QVector<Akregator::Article> &list);
 
+    void slotShowMoreArticles();
+    void slotLoadFinished();
+    void slotPrefetchArticle();
+
     // from ArticleViewer
 private:
-    QSharedPointer<ArticleFormatter> combinedViewFormatter();
-    QSharedPointer<ArticleFormatter> normalViewFormatter();
+    QSharedPointer<DefaultCombinedViewFormatter> combinedViewFormatter();
+    QSharedPointer<DefaultNormalViewFormatter> normalViewFormatter();
     void keyPressEvent(QKeyEvent *e) override;
 
     /** renders @c body. Use this method whereever possible.
@@ -145,6 +158,22 @@ private:
 
     void setArticleActionsEnabled(bool enabled);
 
+    /** returns the filtered articles of the combined view, and the fragment ids of the first
+        @c m_shownLimit of them in @p shownIds */
+    QVector<Article> combinedViewArticles(QStringList &shownIds) const;
+
+    /** returns the html fragment of @p article, rendering it only if the article changed
+        since it was last rendered. @p rendered is set to true in that case */
+    QString combinedViewFragment(const Article &article, const QString &id, bool *rendered = nullptr);
+
+    /** renders the whole combined view page from the fragment cache */
+    void renderCombinedView();
+
+    /** brings the loaded combined view page up to date by patching its DOM with the fragments
+        that were added, changed or removed. Falls back to renderCombinedView() if the page
+        cannot be patched */
+    void updateCombinedView();
+
 private:
     QString m_currentText;
     QUrl m_imageDir;
@@ -160,9 +189,30 @@ private:
     ViewMode m_viewMode;
     Akregator::ArticleHtmlWebEngineWriter *m_articleHtmlWriter;
     Akregator::ArticleViewerWebEngineWidgetNg *m_articleViewerWidgetNg;
-    QSharedPointer<ArticleFormatter> m_normalViewFormatter;
-    QSharedPointer<ArticleFormatter> m_combinedViewFormatter;
+    QSharedPointer<DefaultNormalViewFormatter> m_normalViewFormatter;
+    QSharedPointer<DefaultCombinedViewFormatter> m_combinedViewFormatter;
     QString m_grantleeDirectory;
+
+    struct CombinedViewFragment {
+        uint hash;
+        int status;
+        bool keep;
+        QString html;
+    };
+    /** rendered combined view articles, by fragment id */
+    QHash<QString, CombinedViewFragment> m_fragments;
+    /** fragment ids of the articles in the combined view page, in page order */
+    QStringList m_shownIds;
+    int m_shownLimit;
+    int m_shownRemaining;
+    /** identifies the last rendered combined view page, so that patches are not applied to another one */
+    int m_pageGeneration;
+    bool m_pageLoading;
+    bool m_pageUpdatePending;
+
+    /** articles still to be rendered by slotPrefetchArticle() */
+    QVector<Article> m_prefetchArticles;
+    QTimer *m_prefetchTimer;
 };
 } // namespace Akregator
 
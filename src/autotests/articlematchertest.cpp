@@ -0,0 +1,235 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "articlematchertest.h"
+#include "akregatorconfig.h"
+#include "article.h"
+#include "articlematcher.h"
+#include "articlemetadatacache.h"
+#include "dummystorage/storagedummyimpl.h"
+#include "feed.h"
+#include "feedstorage.h"
+#include "types.h"
+
+#include <QScopedPointer>
+#include <QStandardPaths>
+#include <QTest>
+
+#include <algorithm>
+
+using namespace Akregator;
+using namespace Akregator::Filters;
+using Akregator::Backend::FeedStorage;
+
+namespace
+{
+const QString feedUrl = QStringLiteral("http://a.example.com/feed");
+
+struct Fixture {
+    Fixture()
+        : storage(new Backend::StorageDummyImpl)
+    {
+        storage->open(true);
+        FeedStorage *const archive = storage->archiveFor(feedUrl);
+        const struct {
+            const char *guid;
+            const char *title;
+            const char *description;
+            const char *author;
+            int status;
+        } rows[] = {
+            { "a", "Foo released", "<p>The foo project released version 2</p>", "Alice", FeedStorage::NewFlag },
+            { "b", "Bar news", "Nothing about foo here", "Bob", FeedStorage::ReadFlag },
+            { "c", "FOO and bar", "", "", FeedStorage::ReadFlag | FeedStorage::KeepFlag },
+            { "d", "Title 42", "bar bar bar", "alice", 0 },
+            { "e", "", "Only a description", "Carol", FeedStorage::NewFlag | FeedStorage::KeepFlag }
+        };
+        for (const auto &row : rows) {
+            FeedStorage::ArticleRecord record;
+            record.title = QString::fromLatin1(row.title);
+            record.description = QString::fromLatin1(row.description);
+            record.link = QStringLiteral("http://a.example.com/") + QLatin1String(row.guid);
+            record.authorName = QString::fromLatin1(row.author);
+            record.status = row.status;
+            archive->writeRecord(QString::fromLatin1(row.guid), record);
+        }
+        feed.reset(new Feed(storage.data()));
+        feed->setXmlUrl(feedUrl);
+        articles = feed->articles();
+    }
+
+    ~Fixture()
+    {
+        articles.clear();
+        feed.reset();
+        ArticleMetadataCache::self()->clear();
+    }
+
+    QScopedPointer<Backend::Storage> storage;
+    QScopedPointer<Feed> feed;
+    QVector<Article> articles;
+};
+
+/** criteria for every subject and predicate, with and without negation */
+QVector<Criterion> allCriteria()
+{
+    const struct {
+        Criterion::Subject subject;
+        QVariant object;
+    } objects[] = {
+        { Criterion::Title, QStringLiteral("foo") },
+        { Criterion::Title, QStringLiteral("Bar news") },
+        { Criterion::Title, QStringLiteral("^[A-Z]+ and") },
+        { Criterion::Description, QStringLiteral("bar") },
+        { Criterion::Description, QStringLiteral("version [0-9]") },
+        { Criterion::Link, QStringLiteral("example.com/c") },
+        { Criterion::Link, QStringLiteral("http://a.example.com/d") },
+        { Criterion::Author, QStringLiteral("alice") },
+        { Criterion::Author, QStringLiteral("^B") },
+        { Criterion::Status, QVariant(int(Read)) },
+        { Criterion::Status, QVariant(int(New)) },
+        { Criterion::Status, QVariant(int(Unread)) },
+        { Criterion::KeepFlag, QVariant(true) },
+        { Criterion::KeepFlag, QVariant(false) }
+    };
+    const Criterion::Predicate predicates[] = { Criterion::Contains, Criterion::Equals, Criterion::Matches };
+
+    QVector<Criterion> criteria;
+    for (const auto &object : objects) {
+        for (const Criterion::Predicate predicate : predicates) {
+            criteria.append(Criterion(object.subject, predicate, object.object));
+            criteria.append(Criterion(object.subject, static_cast<Criterion::Predicate>(predicate | Criterion::Negation), object.object));
+        }
+    }
+    return criteria;
+}
+
+/** evaluates the criteria one by one, the way the matcher did before they were compiled */
+bool referenceMatches(const QVector<Criterion> &criteria, ArticleMatcher::Association association, const Article &article)
+{
+    const auto satisfied = [&article](const Criterion &criterion) {
+        return criterion.satisfiedBy(article);
+    };
+    switch (association) {
+    case ArticleMatcher::LogicalAnd:
+        return std::all_of(criteria.constBegin(), criteria.constEnd(), satisfied);
+    case ArticleMatcher::LogicalOr:
+        return criteria.isEmpty() || std::any_of(criteria.constBegin(), criteria.constEnd(), satisfied);
+    default:
+        return true;
+    }
+}
+
+QString describe(const QVector<Criterion> &criteria, const Article &article)
+{
+    QStringList parts;
+    for (const Criterion &criterion : criteria) {
+        parts += Criterion::subjectToString(criterion.subject()) + QLatin1Char(' ')
+                 + Criterion::predicateToString(static_cast<Criterion::Predicate>(criterion.predicate() & ~Criterion::Negation))
+                 + ((criterion.predicate() & Criterion::Negation) ? QStringLiteral(" (negated) ") : QStringLiteral(" "))
+                 + criterion.object().toString();
+    }
+    return QStringLiteral("article %1: %2").arg(article.guid(), parts.join(QLatin1String(", ")));
+}
+}
+
+ArticleMatcherTest::ArticleMatcherTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ArticleMatcherTest::~ArticleMatcherTest()
+{
+}
+
+void ArticleMatcherTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    // setting the URL of a feed would load its favicon otherwise
+    Settings::setFetchOnStartup(true);
+}
+
+void ArticleMatcherTest::shouldMatchEverythingWithoutCriteria()
+{
+    Fixture fixture;
+    QCOMPARE(fixture.articles.count(), 5);
+    const ArticleMatcher none;
+    const ArticleMatcher all(QVector<Criterion>(), ArticleMatcher::LogicalAnd);
+    const ArticleMatcher any(QVector<Criterion>(), ArticleMatcher::LogicalOr);
+    for (const Article &article : qAsConst(fixture.articles)) {
+        QVERIFY(none.matches(article));
+        QVERIFY(all.matches(article));
+        QVERIFY(any.matches(article));
+    }
+}
+
+void ArticleMatcherTest::shouldMatchLikeCriteria()
+{
+    Fixture fixture;
+    const QVector<Criterion> criteria = allCriteria();
+
+    // single criteria, then every pair in both associations
+    for (const Criterion &criterion : criteria) {
+        const QVector<Criterion> single = { criterion };
+        const ArticleMatcher matcher(single, ArticleMatcher::LogicalAnd);
+        for (const Article &article : qAsConst(fixture.articles)) {
+            QVERIFY2(matcher.matches(article) == referenceMatches(single, ArticleMatcher::LogicalAnd, article),
+                     qPrintable(describe(single, article)));
+        }
+    }
+    for (const ArticleMatcher::Association association : { ArticleMatcher::LogicalAnd, ArticleMatcher::LogicalOr }) {
+        for (const Criterion &first : criteria) {
+            for (const Criterion &second : criteria) {
+                const QVector<Criterion> pair = { first, second };
+                const ArticleMatcher matcher(pair, association);
+                for (const Article &article : qAsConst(fixture.articles)) {
+                    QVERIFY2(matcher.matches(article) == referenceMatches(pair, association, article),
+                             qPrintable(describe(pair, article)));
+                }
+            }
+        }
+    }
+}
+
+void ArticleMatcherTest::shouldNotDependOnCriteriaOrder()
+{
+    Fixture fixture;
+    // expensive text criteria first, the matcher evaluates the status check first
+    const QVector<Criterion> criteria = {
+        Criterion(Criterion::Description, Criterion::Matches, QStringLiteral("foo|bar")),
+        Criterion(Criterion::Title, Criterion::Contains, QStringLiteral("o")),
+        Criterion(Criterion::Status, Criterion::Equals, QVariant(int(Read)))
+    };
+    QVector<Criterion> reversed = criteria;
+    std::reverse(reversed.begin(), reversed.end());
+
+    for (const ArticleMatcher::Association association : { ArticleMatcher::LogicalAnd, ArticleMatcher::LogicalOr }) {
+        const ArticleMatcher matcher(criteria, association);
+        const ArticleMatcher reversedMatcher(reversed, association);
+        for (const Article &article : qAsConst(fixture.articles)) {
+            QCOMPARE(matcher.matches(article), referenceMatches(criteria, association, article));
+            QCOMPARE(reversedMatcher.matches(article), matcher.matches(article));
+        }
+    }
+}
+
+QTEST_MAIN(ArticleMatcherTest)
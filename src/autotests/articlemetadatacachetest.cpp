@@ -0,0 +1,139 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "articlemetadatacachetest.h"
+#include "articlemetadatacache.h"
+#include "dummystorage/storagedummyimpl.h"
+#include "feedstorage.h"
+
+#include <QStandardPaths>
+#include <QTest>
+
+using namespace Akregator;
+using Akregator::Backend::FeedStorage;
+
+namespace
+{
+const QString feedUrl = QStringLiteral("http://a.example.com/feed");
+
+void writeArticle(FeedStorage *archive, const QString &guid, const QString &title)
+{
+    FeedStorage::ArticleRecord record;
+    record.title = title;
+    record.link = QStringLiteral("http://a.example.com/") + guid;
+    record.authorName = QStringLiteral("Author of ") + guid;
+    archive->writeRecord(guid, record);
+}
+}
+
+ArticleMetadataCacheTest::ArticleMetadataCacheTest(QObject *parent)
+    : QObject(parent)
+    , m_storage(nullptr)
+{
+}
+
+ArticleMetadataCacheTest::~ArticleMetadataCacheTest()
+{
+}
+
+void ArticleMetadataCacheTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void ArticleMetadataCacheTest::init()
+{
+    m_storage = new Backend::StorageDummyImpl;
+    m_storage->open(true);
+}
+
+void ArticleMetadataCacheTest::cleanup()
+{
+    ArticleMetadataCache::self()->clear();
+    delete m_storage;
+    m_storage = nullptr;
+}
+
+void ArticleMetadataCacheTest::shouldReadFieldsFromArchive()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    writeArticle(archive, QStringLiteral("a"), QStringLiteral("Title A"));
+    writeArticle(archive, QStringLiteral("b"), QStringLiteral("Title B"));
+
+    ArticleMetadataCache *const cache = ArticleMetadataCache::self();
+    QCOMPARE(cache->value(archive, QStringLiteral("a"), ArticleMetadataCache::Title), QStringLiteral("Title A"));
+    QCOMPARE(cache->value(archive, QStringLiteral("b"), ArticleMetadataCache::Link), QStringLiteral("http://a.example.com/b"));
+    QCOMPARE(cache->value(archive, QStringLiteral("b"), ArticleMetadataCache::AuthorName), QStringLiteral("Author of b"));
+    QCOMPARE(cache->value(archive, QStringLiteral("unknown"), ArticleMetadataCache::Title), QString());
+
+    // articles added after the feed was loaded are read on first use
+    writeArticle(archive, QStringLiteral("c"), QStringLiteral("Title C"));
+    QCOMPARE(cache->value(archive, QStringLiteral("c"), ArticleMetadataCache::Title), QStringLiteral("Title C"));
+}
+
+void ArticleMetadataCacheTest::shouldReadChangedFieldsAfterInvalidate()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    writeArticle(archive, QStringLiteral("a"), QStringLiteral("Old"));
+    ArticleMetadataCache *const cache = ArticleMetadataCache::self();
+    QCOMPARE(cache->value(archive, QStringLiteral("a"), ArticleMetadataCache::Title), QStringLiteral("Old"));
+
+    writeArticle(archive, QStringLiteral("a"), QStringLiteral("New"));
+    cache->invalidate(archive, QStringLiteral("a"));
+    QCOMPARE(cache->value(archive, QStringLiteral("a"), ArticleMetadataCache::Title), QStringLiteral("New"));
+
+    writeArticle(archive, QStringLiteral("a"), QStringLiteral("Newer"));
+    cache->invalidateFeed(feedUrl);
+    QCOMPARE(cache->value(archive, QStringLiteral("a"), ArticleMetadataCache::Title), QStringLiteral("Newer"));
+}
+
+void ArticleMetadataCacheTest::shouldReloadClearedArchive()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    writeArticle(archive, QStringLiteral("a"), QStringLiteral("Before"));
+    ArticleMetadataCache *const cache = ArticleMetadataCache::self();
+    QCOMPARE(cache->value(archive, QStringLiteral("a"), ArticleMetadataCache::Title), QStringLiteral("Before"));
+
+    // nobody invalidates the article, the archive generation tells the cache
+    const quint64 generation = archive->generation();
+    archive->clear();
+    QVERIFY(archive->generation() != generation);
+    writeArticle(archive, QStringLiteral("a"), QStringLiteral("After"));
+    QCOMPARE(cache->value(archive, QStringLiteral("a"), ArticleMetadataCache::Title), QStringLiteral("After"));
+}
+
+void ArticleMetadataCacheTest::shouldKeepFeedsApart()
+{
+    FeedStorage *const first = m_storage->archiveFor(feedUrl);
+    FeedStorage *const second = m_storage->archiveFor(QStringLiteral("http://b.example.com/feed"));
+    writeArticle(first, QStringLiteral("a"), QStringLiteral("First"));
+    writeArticle(second, QStringLiteral("a"), QStringLiteral("Second"));
+
+    ArticleMetadataCache *const cache = ArticleMetadataCache::self();
+    QCOMPARE(cache->value(first, QStringLiteral("a"), ArticleMetadataCache::Title), QStringLiteral("First"));
+    QCOMPARE(cache->value(second, QStringLiteral("a"), ArticleMetadataCache::Title), QStringLiteral("Second"));
+
+    cache->invalidateFeed(feedUrl);
+    QCOMPARE(cache->value(second, QStringLiteral("a"), ArticleMetadataCache::Title), QStringLiteral("Second"));
+}
+
+QTEST_GUILESS_MAIN(ArticleMetadataCacheTest)
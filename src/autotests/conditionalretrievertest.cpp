@@ -0,0 +1,247 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "conditionalretrievertest.h"
+#include "conditionalretriever.h"
+
+#include <QCryptographicHash>
+#include <QHash>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTest>
+#include <QUrl>
+
+using namespace Akregator;
+
+Q_DECLARE_METATYPE(Akregator::Backend::FetchValidators)
+
+namespace
+{
+const QByteArray document = "<?xml version=\"1.0\"?><rss version=\"2.0\"><channel><title>Test</title></channel></rss>";
+const QByteArray eTag = "\"v1\"";
+
+QString digest(const QByteArray &data)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex());
+}
+}
+
+/** A minimal HTTP server for one request per connection. It answers 304 when the request
+    carries the current ETag in If-None-Match and honourValidators is set, 200 with the
+    document otherwise. The headers of the last request are kept for inspection. */
+class HttpStandIn : public QTcpServer
+{
+public:
+    HttpStandIn() : honourValidators(true)
+    {
+        connect(this, &QTcpServer::newConnection, this, &HttpStandIn::slotNewConnection);
+    }
+
+    QUrl url() const
+    {
+        return QUrl(QStringLiteral("http://127.0.0.1:%1/feed.rss").arg(serverPort()));
+    }
+
+    QByteArray body;
+    QByteArray currentETag;
+    bool honourValidators;
+    QByteArray lastRequest;
+
+private:
+    void slotNewConnection()
+    {
+        while (QTcpSocket *const socket = nextPendingConnection()) {
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+                slotReadyRead(socket);
+            });
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        }
+    }
+
+    void slotReadyRead(QTcpSocket *socket)
+    {
+        QByteArray &request = m_pending[socket];
+        request += socket->readAll();
+        if (!request.contains("\r\n\r\n")) {
+            return;
+        }
+        lastRequest = m_pending.take(socket);
+
+        QByteArray response;
+        if (honourValidators && !currentETag.isEmpty() && lastRequest.contains("If-None-Match: " + currentETag)) {
+            response = "HTTP/1.1 304 Not Modified\r\nETag: " + currentETag + "\r\nContent-Length: 0\r\n";
+        } else {
+            response = "HTTP/1.1 200 OK\r\nContent-Type: application/rss+xml\r\nContent-Length: " + QByteArray::number(body.size()) + "\r\n";
+            if (!currentETag.isEmpty()) {
+                response += "ETag: " + currentETag + "\r\n";
+            }
+            response += "Last-Modified: Mon, 02 Oct 2017 10:00:00 GMT\r\n";
+        }
+        response += "Connection: close\r\n\r\n";
+        if (response.startsWith("HTTP/1.1 200")) {
+            response += body;
+        }
+        socket->write(response);
+        socket->disconnectFromHost();
+    }
+
+    QHash<QTcpSocket *, QByteArray> m_pending;
+};
+
+namespace
+{
+/** runs one retrieval and returns the spies of its signals */
+struct Retrieval {
+    explicit Retrieval(const Backend::FetchValidators &validators)
+        : retriever(new ConditionalRetriever(validators))
+        , unchanged(retriever, &ConditionalRetriever::documentUnchanged)
+        , validators(retriever, &ConditionalRetriever::validatorsReceived)
+        , retrieved(retriever, &Syndication::DataRetriever::dataRetrieved)
+    {
+    }
+
+    ~Retrieval()
+    {
+        delete retriever;
+    }
+
+    bool run(const QUrl &url)
+    {
+        retriever->retrieveData(url);
+        return retrieved.count() == 1 || retrieved.wait(10000);
+    }
+
+    ConditionalRetriever *retriever;
+    QSignalSpy unchanged;
+    QSignalSpy validators;
+    QSignalSpy retrieved;
+};
+}
+
+ConditionalRetrieverTest::ConditionalRetrieverTest(QObject *parent)
+    : QObject(parent)
+    , m_server(nullptr)
+{
+}
+
+ConditionalRetrieverTest::~ConditionalRetrieverTest()
+{
+}
+
+void ConditionalRetrieverTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    qRegisterMetaType<Akregator::Backend::FetchValidators>();
+    // the answers of the stand-in change between requests, so they must not come from the cache
+    ConditionalRetriever::setUseCache(false);
+}
+
+void ConditionalRetrieverTest::init()
+{
+    m_server = new HttpStandIn;
+    m_server->body = document;
+    m_server->currentETag = eTag;
+    QVERIFY(m_server->listen(QHostAddress::LocalHost));
+}
+
+void ConditionalRetrieverTest::cleanup()
+{
+    delete m_server;
+    m_server = nullptr;
+}
+
+void ConditionalRetrieverTest::shouldReturnDocumentAndValidators()
+{
+    Retrieval retrieval{Backend::FetchValidators()};
+    QVERIFY(retrieval.run(m_server->url()));
+
+    QCOMPARE(retrieval.retrieved.at(0).at(0).toByteArray(), document);
+    QVERIFY(retrieval.retrieved.at(0).at(1).toBool());
+    QCOMPARE(retrieval.unchanged.count(), 0);
+    QCOMPARE(retrieval.validators.count(), 1);
+
+    const Backend::FetchValidators received = retrieval.validators.at(0).at(0).value<Backend::FetchValidators>();
+    QCOMPARE(received.eTag, QString::fromLatin1(eTag));
+    QCOMPARE(received.lastModified, QStringLiteral("Mon, 02 Oct 2017 10:00:00 GMT"));
+    QCOMPARE(received.digest, digest(document));
+    QVERIFY(!m_server->lastRequest.contains("If-None-Match"));
+}
+
+void ConditionalRetrieverTest::shouldSendValidatorsAndSkipNotModified()
+{
+    Backend::FetchValidators stored;
+    stored.eTag = QString::fromLatin1(eTag);
+    stored.lastModified = QStringLiteral("Mon, 02 Oct 2017 10:00:00 GMT");
+    stored.digest = digest(document);
+
+    Retrieval retrieval(stored);
+    QVERIFY(retrieval.run(m_server->url()));
+
+    QVERIFY(m_server->lastRequest.contains("If-None-Match: " + eTag));
+    QVERIFY(m_server->lastRequest.contains("If-Modified-Since: Mon, 02 Oct 2017 10:00:00 GMT"));
+    QCOMPARE(retrieval.unchanged.count(), 1);
+    QCOMPARE(retrieval.validators.count(), 0);
+    QVERIFY(!retrieval.retrieved.at(0).at(1).toBool());
+}
+
+void ConditionalRetrieverTest::shouldSkipDocumentWithSameDigest()
+{
+    // a server ignoring the validators sends the same document again
+    m_server->honourValidators = false;
+    Backend::FetchValidators stored;
+    stored.eTag = QString::fromLatin1(eTag);
+    stored.digest = digest(document);
+
+    Retrieval retrieval(stored);
+    QVERIFY(retrieval.run(m_server->url()));
+
+    QCOMPARE(retrieval.unchanged.count(), 1);
+    QCOMPARE(retrieval.validators.count(), 0);
+    QVERIFY(!retrieval.retrieved.at(0).at(1).toBool());
+    QVERIFY(retrieval.retrieved.at(0).at(0).toByteArray().isEmpty());
+}
+
+void ConditionalRetrieverTest::shouldReturnChangedDocument()
+{
+    Backend::FetchValidators stored;
+    stored.eTag = QString::fromLatin1(eTag);
+    stored.digest = digest(document);
+
+    const QByteArray changed = document + "\n";
+    m_server->body = changed;
+    m_server->currentETag = "\"v2\"";
+
+    Retrieval retrieval(stored);
+    QVERIFY(retrieval.run(m_server->url()));
+
+    QCOMPARE(retrieval.unchanged.count(), 0);
+    QVERIFY(retrieval.retrieved.at(0).at(1).toBool());
+    QCOMPARE(retrieval.retrieved.at(0).at(0).toByteArray(), changed);
+    QCOMPARE(retrieval.validators.count(), 1);
+    const Backend::FetchValidators received = retrieval.validators.at(0).at(0).value<Backend::FetchValidators>();
+    QCOMPARE(received.eTag, QStringLiteral("\"v2\""));
+    QCOMPARE(received.digest, digest(changed));
+}
+
+QTEST_MAIN(ConditionalRetrieverTest)
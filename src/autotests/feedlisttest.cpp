@@ -0,0 +1,232 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "feedlisttest.h"
+#include "akregatorconfig.h"
+#include "dummystorage/storagedummyimpl.h"
+#include "feed.h"
+#include "feedlist.h"
+#include "folder.h"
+
+#include <QScopedPointer>
+#include <QStandardPaths>
+#include <QTest>
+#include <QXmlStreamReader>
+
+using namespace Akregator;
+
+namespace
+{
+const char sampleOpml[] =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<opml version=\"1.0\">\n"
+    " <head><title>Feeds</title></head>\n"
+    " <body>\n"
+    "  <outline text=\"News &amp; Politics\" isOpen=\"true\" id=\"1\">\n"
+    "   <outline text=\"Caf\xc3\xa9 &lt;daily&gt;\" title=\"Caf\xc3\xa9 &lt;daily&gt;\" xmlUrl=\"http://a.example.com/feed?x=1&amp;y=2\""
+    " htmlUrl=\"http://a.example.com/\" id=\"2\" description=\"Quotes &quot;here&quot;\" useCustomFetchInterval=\"true\""
+    " fetchInterval=\"45\" archiveMode=\"limitArticleAge\" maxArticleAge=\"7\" maxArticleNumber=\"100\""
+    " markImmediatelyAsRead=\"true\" useNotification=\"true\" type=\"rss\" version=\"RSS\"/>\n"
+    "   <outline text=\"Empty\" isOpen=\"false\" id=\"3\"/>\n"
+    "  </outline>\n"
+    "  <outline text=\"Planet\" xmlUrl=\"http://b.example.com/rss\" id=\"4\" loadLinkedWebsite=\"true\" type=\"rss\" version=\"RSS\"/>\n"
+    " </body>\n"
+    "</opml>\n";
+
+bool readOpml(FeedList *list, const QByteArray &data)
+{
+    QXmlStreamReader reader(data);
+    return list->readFromOpml(reader);
+}
+
+/** compares the saved properties of two feed trees */
+void compareNodes(const TreeNode *actual, const TreeNode *expected)
+{
+    QCOMPARE(actual->title(), expected->title());
+    QCOMPARE(actual->id(), expected->id());
+    QCOMPARE(actual->isGroup(), expected->isGroup());
+    if (actual->isGroup()) {
+        const Folder *const actualFolder = static_cast<const Folder *>(actual);
+        const Folder *const expectedFolder = static_cast<const Folder *>(expected);
+        QCOMPARE(actualFolder->isOpen(), expectedFolder->isOpen());
+        const QList<const TreeNode *> actualChildren = actualFolder->children();
+        const QList<const TreeNode *> expectedChildren = expectedFolder->children();
+        QCOMPARE(actualChildren.count(), expectedChildren.count());
+        for (int i = 0; i < actualChildren.count(); ++i) {
+            compareNodes(actualChildren.at(i), expectedChildren.at(i));
+        }
+        return;
+    }
+    const Feed *const actualFeed = static_cast<const Feed *>(actual);
+    const Feed *const expectedFeed = static_cast<const Feed *>(expected);
+    QCOMPARE(actualFeed->xmlUrl(), expectedFeed->xmlUrl());
+    QCOMPARE(actualFeed->htmlUrl(), expectedFeed->htmlUrl());
+    QCOMPARE(actualFeed->description(), expectedFeed->description());
+    QCOMPARE(actualFeed->useCustomFetchInterval(), expectedFeed->useCustomFetchInterval());
+    QCOMPARE(actualFeed->fetchInterval(), expectedFeed->fetchInterval());
+    QCOMPARE(actualFeed->archiveMode(), expectedFeed->archiveMode());
+    QCOMPARE(actualFeed->maxArticleAge(), expectedFeed->maxArticleAge());
+    QCOMPARE(actualFeed->maxArticleNumber(), expectedFeed->maxArticleNumber());
+    QCOMPARE(actualFeed->markImmediatelyAsRead(), expectedFeed->markImmediatelyAsRead());
+    QCOMPARE(actualFeed->useNotification(), expectedFeed->useNotification());
+    QCOMPARE(actualFeed->loadLinkedWebsite(), expectedFeed->loadLinkedWebsite());
+}
+}
+
+FeedListTest::FeedListTest(QObject *parent)
+    : QObject(parent)
+    , m_storage(nullptr)
+{
+}
+
+FeedListTest::~FeedListTest()
+{
+}
+
+void FeedListTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    // setting the URL of a feed would load its favicon otherwise
+    Settings::setFetchOnStartup(true);
+}
+
+void FeedListTest::init()
+{
+    m_storage = new Backend::StorageDummyImpl;
+    m_storage->open(true);
+}
+
+void FeedListTest::cleanup()
+{
+    delete m_storage;
+    m_storage = nullptr;
+}
+
+void FeedListTest::shouldReadFoldersAndFeeds()
+{
+    FeedList list(m_storage);
+    QVERIFY(readOpml(&list, sampleOpml));
+    QVERIFY(!list.isModified());
+    QCOMPARE(list.feeds().count(), 2);
+    QCOMPARE(list.folders().count(), 3); // including the root folder
+
+    const QList<TreeNode *> topLevel = list.allFeedsFolder()->children();
+    QCOMPARE(topLevel.count(), 2);
+    QVERIFY(topLevel.at(0)->isGroup());
+    const Folder *const news = static_cast<const Folder *>(topLevel.at(0));
+    QCOMPARE(news->title(), QStringLiteral("News & Politics"));
+    QVERIFY(news->isOpen());
+    QCOMPARE(news->children().count(), 2);
+
+    const Feed *const cafe = list.findByURL(QStringLiteral("http://a.example.com/feed?x=1&y=2"));
+    QVERIFY(cafe);
+    QCOMPARE(cafe->parent(), news);
+    QCOMPARE(cafe->title(), QString::fromUtf8("Caf\xc3\xa9 <daily>"));
+    QCOMPARE(cafe->id(), uint(2));
+    QCOMPARE(cafe->description(), QStringLiteral("Quotes \"here\""));
+    QVERIFY(cafe->useCustomFetchInterval());
+    QCOMPARE(cafe->fetchInterval(), 45);
+    QCOMPARE(cafe->archiveMode(), Feed::limitArticleAge);
+    QCOMPARE(cafe->maxArticleAge(), 7);
+    QCOMPARE(cafe->maxArticleNumber(), 100);
+    QVERIFY(cafe->markImmediatelyAsRead());
+    QVERIFY(cafe->useNotification());
+    QVERIFY(!cafe->loadLinkedWebsite());
+
+    const Feed *const planet = list.findByURL(QStringLiteral("http://b.example.com/rss"));
+    QVERIFY(planet);
+    QVERIFY(planet->parent() == list.allFeedsFolder());
+    QVERIFY(planet->loadLinkedWebsite());
+    QVERIFY(!planet->useCustomFetchInterval());
+}
+
+void FeedListTest::shouldRoundTripOpml()
+{
+    FeedList list(m_storage);
+    QVERIFY(readOpml(&list, sampleOpml));
+    const QByteArray written = list.toOpml();
+
+    FeedList copy(m_storage);
+    QVERIFY(readOpml(&copy, written));
+    QVERIFY(!copy.isModified());
+    compareNodes(copy.allFeedsFolder(), list.allFeedsFolder());
+
+    // writing is stable, a second round trip gives the same bytes
+    QCOMPARE(copy.toOpml(), written);
+}
+
+void FeedListTest::shouldReadLegacyAttributes()
+{
+    const QByteArray opml =
+        "<opml><body>"
+        "<outline title=\"Lower\" xmlurl=\"http://a.example.com/lower\" id=\"1\"/>"
+        "<outline text=\"Upper\" xmlURL=\"http://a.example.com/upper\" id=\"2\"/>"
+        "</body></opml>";
+    FeedList list(m_storage);
+    QVERIFY(readOpml(&list, opml));
+    QCOMPARE(list.feeds().count(), 2);
+    QVERIFY(list.findByURL(QStringLiteral("http://a.example.com/lower")));
+    QCOMPARE(list.findByURL(QStringLiteral("http://a.example.com/lower"))->title(), QStringLiteral("Lower"));
+    QVERIFY(list.findByURL(QStringLiteral("http://a.example.com/upper")));
+}
+
+void FeedListTest::shouldAssignMissingIds()
+{
+    const QByteArray opml =
+        "<opml><body>"
+        "<outline text=\"Folder\"><outline text=\"Feed\" xmlUrl=\"http://a.example.com/feed\"/></outline>"
+        "</body></opml>";
+    FeedList list(m_storage);
+    QVERIFY(readOpml(&list, opml));
+    // the new ids have to be saved
+    QVERIFY(list.isModified());
+    const Feed *const feed = list.findByURL(QStringLiteral("http://a.example.com/feed"));
+    QVERIFY(feed);
+    QVERIFY(feed->id() != 0);
+    QVERIFY(feed->parent()->id() != 0);
+    QVERIFY(feed->id() != feed->parent()->id());
+    QVERIFY(list.findByID(feed->id()) == feed);
+}
+
+void FeedListTest::shouldRejectMalformedXml()
+{
+    FeedList list(m_storage);
+    QXmlStreamReader reader(QByteArray("<opml><body><outline text=\"Feed\" xmlUrl=\"http://a.example.com\"></body></opml>"));
+    QVERIFY(!list.readFromOpml(reader));
+    QVERIFY(reader.hasError());
+    QVERIFY(reader.lineNumber() > 0);
+}
+
+void FeedListTest::shouldRejectOtherDocuments()
+{
+    FeedList list(m_storage);
+    QXmlStreamReader reader(QByteArray("<rss version=\"2.0\"><channel/></rss>"));
+    QVERIFY(!list.readFromOpml(reader));
+    QVERIFY(!reader.hasError());
+
+    // an OPML document needs a body
+    FeedList headOnly(m_storage);
+    QVERIFY(!readOpml(&headOnly, "<opml><head/></opml>"));
+    QVERIFY(headOnly.isEmpty());
+}
+
+QTEST_MAIN(FeedListTest)
@@ -0,0 +1,59 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef FEEDLISTTEST_H
+#define FEEDLISTTEST_H
+
+#include <QObject>
+
+namespace Akregator
+{
+namespace Backend
+{
+class Storage;
+}
+}
+
+class FeedListTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FeedListTest(QObject *parent = nullptr);
+    ~FeedListTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void shouldReadFoldersAndFeeds();
+    void shouldRoundTripOpml();
+    void shouldReadLegacyAttributes();
+    void shouldAssignMissingIds();
+    void shouldRejectMalformedXml();
+    void shouldRejectOtherDocuments();
+
+private:
+    Akregator::Backend::Storage *m_storage;
+};
+
+#endif // FEEDLISTTEST_H
@@ -0,0 +1,212 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "feedtest.h"
+#include "akregatorconfig.h"
+#include "articlejobs.h"
+#include "dummystorage/storagedummyimpl.h"
+#include "feed.h"
+#include "feedlist.h"
+#include "feedstorage.h"
+#include "kernel.h"
+
+#include <QDateTime>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+
+using namespace Akregator;
+using Akregator::Backend::FeedStorage;
+
+namespace
+{
+const QString feedUrl = QStringLiteral("http://a.example.com/feed");
+const int day = 24 * 3600;
+}
+
+FeedTest::FeedTest(QObject *parent)
+    : QObject(parent)
+    , m_storage(nullptr)
+{
+}
+
+FeedTest::~FeedTest()
+{
+}
+
+void FeedTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    // setting the URL of a feed would load its favicon otherwise
+    Settings::setFetchOnStartup(true);
+}
+
+void FeedTest::init()
+{
+    m_storage = new Backend::StorageDummyImpl;
+    m_storage->open(true);
+    Kernel::self()->setFeedList(QSharedPointer<FeedList>(new FeedList(m_storage)));
+}
+
+void FeedTest::cleanup()
+{
+    Kernel::self()->setFeedList(QSharedPointer<FeedList>());
+    delete m_storage;
+    m_storage = nullptr;
+}
+
+Feed *FeedTest::createFeed()
+{
+    Feed *const feed = new Feed(m_storage);
+    feed->setXmlUrl(feedUrl);
+    return feed;
+}
+
+void FeedTest::addArticle(const QString &guid, int status, uint pubDate)
+{
+    FeedStorage::ArticleRecord record;
+    record.title = guid;
+    record.status = status;
+    record.pubDate = pubDate;
+    m_storage->archiveFor(feedUrl)->writeRecord(guid, record);
+}
+
+void FeedTest::shouldNotCountDeletedArticlesInArchive()
+{
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    addArticle(QStringLiteral("a"), FeedStorage::NewFlag, 1);
+    addArticle(QStringLiteral("b"), FeedStorage::NewFlag, 2);
+    addArticle(QStringLiteral("c"), FeedStorage::DeletedFlag | FeedStorage::ReadFlag, 3);
+    QCOMPARE(archive->totalCount(), 2);
+
+    archive->setStatus(QStringLiteral("a"), FeedStorage::DeletedFlag | FeedStorage::ReadFlag);
+    QCOMPARE(archive->totalCount(), 1);
+
+    // removing a tombstone does not change the count, removing a live article does
+    archive->deleteArticle(QStringLiteral("a"));
+    QCOMPARE(archive->totalCount(), 1);
+    archive->deleteArticle(QStringLiteral("b"));
+    QCOMPARE(archive->totalCount(), 0);
+    QCOMPARE(m_storage->totalCountFor(feedUrl), 0);
+}
+
+void FeedTest::shouldCorrectStoredTotalWhenLoaded()
+{
+    addArticle(QStringLiteral("a"), FeedStorage::NewFlag, 1);
+    addArticle(QStringLiteral("b"), FeedStorage::DeletedFlag | FeedStorage::ReadFlag, 2);
+    // as left by an archive that counted deleted articles
+    m_storage->setTotalCountFor(feedUrl, 2);
+
+    QScopedPointer<Feed> feed(createFeed());
+    QCOMPARE(feed->totalCount(), 2);
+
+    QSignalSpy changed(feed.data(), &TreeNode::signalChanged);
+    QCOMPARE(feed->articles().count(), 2);
+    QCOMPARE(feed->totalCount(), 1);
+    QCOMPARE(m_storage->totalCountFor(feedUrl), 1);
+    QVERIFY(!changed.isEmpty());
+}
+
+void FeedTest::shouldExpireArticlesOfUnloadedFeed()
+{
+    const uint now = QDateTime::currentDateTime().toTime_t();
+    addArticle(QStringLiteral("old"), FeedStorage::NewFlag, now - 3 * day);
+    addArticle(QStringLiteral("oldRead"), FeedStorage::ReadFlag, now - 3 * day);
+    addArticle(QStringLiteral("recent"), FeedStorage::NewFlag, now);
+    m_storage->setUnreadFor(feedUrl, 2);
+
+    QScopedPointer<Feed> feed(createFeed());
+    feed->setArchiveMode(Feed::limitArticleAge);
+    feed->setMaxArticleAge(1);
+    QSignalSpy changed(feed.data(), &TreeNode::signalChanged);
+
+    ArticleDeleteJob job;
+    feed->deleteExpiredArticles(&job);
+
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    QCOMPARE(archive->status(QStringLiteral("old")), FeedStorage::DeletedFlag | FeedStorage::ReadFlag);
+    QCOMPARE(archive->status(QStringLiteral("oldRead")), FeedStorage::DeletedFlag | FeedStorage::ReadFlag);
+    QCOMPARE(archive->title(QStringLiteral("old")), QString());
+    QCOMPARE(archive->status(QStringLiteral("recent")), int(FeedStorage::NewFlag));
+    QCOMPARE(feed->unread(), 1);
+    QCOMPARE(feed->totalCount(), 1);
+    QVERIFY(!changed.isEmpty());
+
+    // the feed reads the tombstones when it is loaded
+    const QVector<Article> articles = feed->articles();
+    QCOMPARE(articles.count(), 3);
+    QCOMPARE(feed->totalCount(), 1);
+    QCOMPARE(feed->unread(), 1);
+    QVERIFY(feed->findArticle(QStringLiteral("old")).isDeleted());
+    QVERIFY(!feed->findArticle(QStringLiteral("recent")).isDeleted());
+}
+
+void FeedTest::shouldKeepImportantArticlesOfUnloadedFeed()
+{
+    const uint now = QDateTime::currentDateTime().toTime_t();
+    addArticle(QStringLiteral("old"), FeedStorage::NewFlag, now - 3 * day);
+    addArticle(QStringLiteral("kept"), FeedStorage::NewFlag | FeedStorage::KeepFlag, now - 3 * day);
+    m_storage->setUnreadFor(feedUrl, 2);
+    Settings::setDoNotExpireImportantArticles(true);
+
+    QScopedPointer<Feed> feed(createFeed());
+    feed->setArchiveMode(Feed::limitArticleAge);
+    feed->setMaxArticleAge(1);
+
+    ArticleDeleteJob job;
+    feed->deleteExpiredArticles(&job);
+
+    FeedStorage *const archive = m_storage->archiveFor(feedUrl);
+    QVERIFY(archive->status(QStringLiteral("old")) & FeedStorage::DeletedFlag);
+    QCOMPARE(archive->status(QStringLiteral("kept")), FeedStorage::NewFlag | FeedStorage::KeepFlag);
+    QCOMPARE(feed->unread(), 1);
+    QCOMPARE(feed->totalCount(), 1);
+}
+
+void FeedTest::shouldPurgeDeletedArticlesOnlyWhenExpiringByAge()
+{
+    const uint now = QDateTime::currentDateTime().toTime_t();
+    addArticle(QStringLiteral("live"), FeedStorage::NewFlag, now);
+    addArticle(QStringLiteral("deleted"), FeedStorage::DeletedFlag | FeedStorage::ReadFlag, now - 3 * day);
+
+    QScopedPointer<Feed> feed(createFeed());
+    feed->setArchiveMode(Feed::keepAllArticles);
+    QCOMPARE(feed->purgeDeletedArticlesBefore(), 0u);
+    feed->setArchiveMode(Feed::limitArticleNumber);
+    QCOMPARE(feed->purgeDeletedArticlesBefore(), 0u);
+    feed->setArchiveMode(Feed::limitArticleAge);
+    feed->setMaxArticleAge(1);
+    const uint purgeBefore = feed->purgeDeletedArticlesBefore();
+    QVERIFY(purgeBefore >= now - day && purgeBefore <= QDateTime::currentDateTime().toTime_t() - day);
+
+    // the loaded tombstone goes once compaction dropped it from the archive
+    QCOMPARE(feed->articles().count(), 2);
+    feed->forgetPurgedArticles();
+    QCOMPARE(feed->articles().count(), 2);
+    m_storage->archiveFor(feedUrl)->deleteArticle(QStringLiteral("deleted"));
+    feed->forgetPurgedArticles();
+    QCOMPARE(feed->articles().count(), 1);
+    QVERIFY(feed->findArticle(QStringLiteral("deleted")).isNull());
+    QCOMPARE(feed->totalCount(), 1);
+}
+
+QTEST_MAIN(FeedTest)
@@ -0,0 +1,244 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "fetchqueuetest.h"
+#include "akregatorconfig.h"
+#include "dummystorage/storagedummyimpl.h"
+#include "feed.h"
+#include "fetchqueue.h"
+
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+
+using namespace Akregator;
+
+namespace
+{
+/** a queue that records the fetches it starts instead of fetching */
+class TestFetchQueue : public FetchQueue
+{
+public:
+    QList<Feed *> started;
+
+    void finish(Feed *feed)
+    {
+        slotFeedFetched(feed);
+    }
+
+    void fail(Feed *feed)
+    {
+        slotFetchError(feed);
+    }
+
+protected:
+    void startFetch(Feed *feed) override
+    {
+        started.append(feed);
+    }
+};
+}
+
+FetchQueueTest::FetchQueueTest(QObject *parent)
+    : QObject(parent)
+    , m_storage(nullptr)
+{
+}
+
+FetchQueueTest::~FetchQueueTest()
+{
+}
+
+void FetchQueueTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    // setting the URL of a feed would load its favicon otherwise
+    Settings::setFetchOnStartup(true);
+}
+
+void FetchQueueTest::init()
+{
+    Settings::setConcurrentFetches(6);
+    Settings::setMaxFetchesPerHost(2);
+    m_storage = new Backend::StorageDummyImpl;
+    m_storage->open(true);
+}
+
+void FetchQueueTest::cleanup()
+{
+    delete m_storage;
+    m_storage = nullptr;
+}
+
+Feed *FetchQueueTest::createFeed(const QString &url)
+{
+    Feed *const feed = new Feed(m_storage);
+    feed->setXmlUrl(url);
+    return feed;
+}
+
+void FetchQueueTest::shouldStartAndStop()
+{
+    TestFetchQueue queue;
+    QSignalSpy started(&queue, &FetchQueue::signalStarted);
+    QSignalSpy stopped(&queue, &FetchQueue::signalStopped);
+    QSignalSpy fetched(&queue, &FetchQueue::fetched);
+    QVERIFY(queue.isEmpty());
+
+    QScopedPointer<Feed> feed(createFeed(QStringLiteral("http://a.example.com/feed")));
+    queue.addFeed(feed.data());
+    QCOMPARE(started.count(), 1);
+    QCOMPARE(queue.started, QList<Feed *>() << feed.data());
+    QVERIFY(!queue.isEmpty());
+
+    queue.finish(feed.data());
+    QCOMPARE(fetched.count(), 1);
+    QCOMPARE(stopped.count(), 1);
+    QVERIFY(queue.isEmpty());
+}
+
+void FetchQueueTest::shouldNotQueueFeedTwice()
+{
+    TestFetchQueue queue;
+    QScopedPointer<Feed> feed(createFeed(QStringLiteral("http://a.example.com/feed")));
+    queue.addFeed(feed.data());
+    queue.addFeed(feed.data());
+    QCOMPARE(queue.started.count(), 1);
+
+    queue.finish(feed.data());
+    QVERIFY(queue.isEmpty());
+    QCOMPARE(queue.started.count(), 1);
+}
+
+void FetchQueueTest::shouldLimitFetchesPerHost()
+{
+    Settings::setMaxFetchesPerHost(1);
+    TestFetchQueue queue;
+    QScopedPointer<Feed> a1(createFeed(QStringLiteral("http://a.example.com/1")));
+    QScopedPointer<Feed> a2(createFeed(QStringLiteral("http://A.example.com/2")));
+    QScopedPointer<Feed> b1(createFeed(QStringLiteral("http://b.example.com/1")));
+
+    queue.addFeed(a1.data());
+    queue.addFeed(a2.data());
+    queue.addFeed(b1.data());
+    // host names are case insensitive, a2 waits for a1
+    QCOMPARE(queue.started, QList<Feed *>() << a1.data() << b1.data());
+
+    queue.finish(b1.data());
+    QCOMPARE(queue.started.count(), 2);
+
+    queue.finish(a1.data());
+    QCOMPARE(queue.started, QList<Feed *>() << a1.data() << b1.data() << a2.data());
+}
+
+void FetchQueueTest::shouldLimitConcurrentFetches()
+{
+    Settings::setConcurrentFetches(2);
+    TestFetchQueue queue;
+    QScopedPointer<Feed> a(createFeed(QStringLiteral("http://a.example.com/feed")));
+    QScopedPointer<Feed> b(createFeed(QStringLiteral("http://b.example.com/feed")));
+    QScopedPointer<Feed> c(createFeed(QStringLiteral("http://c.example.com/feed")));
+
+    queue.addFeed(a.data());
+    queue.addFeed(b.data());
+    queue.addFeed(c.data());
+    QCOMPARE(queue.started, QList<Feed *>() << a.data() << b.data());
+
+    queue.finish(b.data());
+    QCOMPARE(queue.started, QList<Feed *>() << a.data() << b.data() << c.data());
+}
+
+void FetchQueueTest::shouldDeferIntervalFetchAfterError()
+{
+    TestFetchQueue queue;
+    QSignalSpy errors(&queue, &FetchQueue::fetchError);
+    QScopedPointer<Feed> feed(createFeed(QStringLiteral("http://a.example.com/feed")));
+
+    queue.addFeed(feed.data(), true);
+    queue.fail(feed.data());
+    QCOMPARE(errors.count(), 1);
+    QVERIFY(queue.isEmpty());
+
+    // the interval fetch waits for the backoff to expire, deferred feeds do not count as queued
+    queue.addFeed(feed.data(), true);
+    QCOMPARE(queue.started.count(), 1);
+    QVERIFY(queue.isEmpty());
+}
+
+void FetchQueueTest::shouldNotDeferExplicitFetchAfterError()
+{
+    TestFetchQueue queue;
+    QScopedPointer<Feed> feed(createFeed(QStringLiteral("http://a.example.com/feed")));
+
+    queue.addFeed(feed.data(), true);
+    queue.fail(feed.data());
+    queue.addFeed(feed.data(), true);
+    QCOMPARE(queue.started.count(), 1);
+
+    // the explicit fetch replaces the deferred interval fetch and starts right away
+    queue.addFeed(feed.data());
+    QCOMPARE(queue.started.count(), 2);
+    QCOMPARE(queue.started.last(), feed.data());
+
+    queue.finish(feed.data());
+    QVERIFY(queue.isEmpty());
+}
+
+void FetchQueueTest::shouldFetchBlockedFeedWhenRunningFeedIsDestroyed()
+{
+    Settings::setMaxFetchesPerHost(1);
+    TestFetchQueue queue;
+    QSignalSpy stopped(&queue, &FetchQueue::signalStopped);
+    Feed *const a1 = createFeed(QStringLiteral("http://a.example.com/1"));
+    QScopedPointer<Feed> a2(createFeed(QStringLiteral("http://a.example.com/2")));
+
+    queue.addFeed(a1);
+    queue.addFeed(a2.data());
+    QCOMPARE(queue.started, QList<Feed *>() << a1);
+
+    delete a1;
+    QCOMPARE(queue.started.count(), 2);
+    QCOMPARE(queue.started.last(), a2.data());
+    QCOMPARE(stopped.count(), 0);
+
+    queue.finish(a2.data());
+    QCOMPARE(stopped.count(), 1);
+}
+
+void FetchQueueTest::shouldDropQueuedFeedWhenDestroyed()
+{
+    Settings::setConcurrentFetches(1);
+    TestFetchQueue queue;
+    QScopedPointer<Feed> a(createFeed(QStringLiteral("http://a.example.com/feed")));
+    Feed *const b = createFeed(QStringLiteral("http://b.example.com/feed"));
+    QScopedPointer<Feed> c(createFeed(QStringLiteral("http://c.example.com/feed")));
+
+    queue.addFeed(a.data());
+    queue.addFeed(b);
+    queue.addFeed(c.data());
+    delete b;
+
+    queue.finish(a.data());
+    QCOMPARE(queue.started, QList<Feed *>() << a.data() << c.data());
+}
+
+QTEST_MAIN(FetchQueueTest)
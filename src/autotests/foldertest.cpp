@@ -0,0 +1,221 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "foldertest.h"
+#include "akregatorconfig.h"
+#include "article.h"
+#include "dummystorage/storagedummyimpl.h"
+#include "feed.h"
+#include "feedstorage.h"
+#include "folder.h"
+#include "types.h"
+
+#include <QScopedPointer>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+
+using namespace Akregator;
+using Akregator::Backend::FeedStorage;
+
+FolderTest::FolderTest(QObject *parent)
+    : QObject(parent)
+    , m_storage(nullptr)
+{
+}
+
+FolderTest::~FolderTest()
+{
+}
+
+void FolderTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    // setting the URL of a feed would load its favicon otherwise
+    Settings::setFetchOnStartup(true);
+}
+
+void FolderTest::init()
+{
+    m_storage = new Backend::StorageDummyImpl;
+    m_storage->open(true);
+}
+
+void FolderTest::cleanup()
+{
+    delete m_storage;
+    m_storage = nullptr;
+}
+
+Feed *FolderTest::createFeed(const QString &url, int unread, int read)
+{
+    FeedStorage *const archive = m_storage->archiveFor(url);
+    for (int i = 0; i < unread + read; ++i) {
+        FeedStorage::ArticleRecord record;
+        record.title = QString::number(i);
+        record.status = i < unread ? FeedStorage::NewFlag : FeedStorage::ReadFlag;
+        archive->writeRecord(QString::number(i), record);
+    }
+    m_storage->setUnreadFor(url, unread);
+
+    Feed *const feed = new Feed(m_storage);
+    feed->setXmlUrl(url);
+    return feed;
+}
+
+void FolderTest::shouldSumCountsOfAllDescendants()
+{
+    QScopedPointer<Folder> root(new Folder(QStringLiteral("root")));
+    Folder *const sub = new Folder(QStringLiteral("sub"));
+    root->appendChild(sub);
+    sub->appendChild(createFeed(QStringLiteral("http://a.example.com"), 2, 1));
+    sub->appendChild(createFeed(QStringLiteral("http://b.example.com"), 0, 4));
+    root->appendChild(createFeed(QStringLiteral("http://c.example.com"), 3, 0));
+    root->prependChild(new Folder(QStringLiteral("empty")));
+
+    QCOMPARE(sub->unread(), 2);
+    QCOMPARE(sub->totalCount(), 7);
+    QCOMPARE(root->unread(), 5);
+    QCOMPARE(root->totalCount(), 10);
+}
+
+void FolderTest::shouldFollowArticleStatusChanges()
+{
+    QScopedPointer<Folder> root(new Folder(QStringLiteral("root")));
+    Folder *const sub = new Folder(QStringLiteral("sub"));
+    root->appendChild(sub);
+    Feed *const feed = createFeed(QStringLiteral("http://a.example.com"), 3, 1);
+    sub->appendChild(feed);
+
+    QVector<Article> articles = feed->articles();
+    QCOMPARE(articles.count(), 4);
+    for (Article &article : articles) {
+        article.setStatus(Read);
+    }
+    QCOMPARE(feed->unread(), 0);
+    QCOMPARE(sub->unread(), 0);
+    QCOMPARE(root->unread(), 0);
+
+    articles[0].setStatus(New);
+    QCOMPARE(sub->unread(), 1);
+    QCOMPARE(root->unread(), 1);
+    QCOMPARE(root->totalCount(), 4);
+}
+
+void FolderTest::shouldFollowDeletedArticles()
+{
+    QScopedPointer<Folder> root(new Folder(QStringLiteral("root")));
+    Folder *const sub = new Folder(QStringLiteral("sub"));
+    root->appendChild(sub);
+    Feed *const feed = createFeed(QStringLiteral("http://a.example.com"), 2, 2);
+    sub->appendChild(feed);
+
+    QVector<Article> articles = feed->articles();
+    articles[0].setDeleted();
+    articles[3].setDeleted();
+    QCOMPARE(feed->totalCount(), 2);
+    QCOMPARE(sub->totalCount(), 2);
+    QCOMPARE(root->totalCount(), 2);
+    QCOMPARE(root->unread(), 1);
+}
+
+void FolderTest::shouldFollowAddedAndRemovedChildren()
+{
+    QScopedPointer<Folder> root(new Folder(QStringLiteral("root")));
+    Folder *const first = new Folder(QStringLiteral("first"));
+    Folder *const second = new Folder(QStringLiteral("second"));
+    root->appendChild(first);
+    root->appendChild(second);
+    Feed *const read = createFeed(QStringLiteral("http://c.example.com"), 0, 1);
+    second->appendChild(read);
+    Folder *const sub = new Folder(QStringLiteral("sub"));
+    first->appendChild(sub);
+    sub->appendChild(createFeed(QStringLiteral("http://a.example.com"), 2, 1));
+    QCOMPARE(first->unread(), 2);
+    QCOMPARE(root->unread(), 2);
+
+    // move the subfolder, as dragging it does
+    first->removeChild(sub);
+    QCOMPARE(first->unread(), 0);
+    QCOMPARE(first->totalCount(), 0);
+    QCOMPARE(root->unread(), 0);
+    QCOMPARE(root->totalCount(), 1);
+    second->insertChild(sub, read);
+    QCOMPARE(second->unread(), 2);
+    QCOMPARE(second->totalCount(), 4);
+    QCOMPARE(root->unread(), 2);
+    QCOMPARE(root->totalCount(), 4);
+
+    // a feed added to the moved folder is counted by its new ancestors only
+    sub->appendChild(createFeed(QStringLiteral("http://b.example.com"), 1, 0));
+    QCOMPARE(first->unread(), 0);
+    QCOMPARE(second->unread(), 3);
+    QCOMPARE(root->unread(), 3);
+    QCOMPARE(root->totalCount(), 5);
+}
+
+void FolderTest::shouldFollowDestroyedChildren()
+{
+    QScopedPointer<Folder> root(new Folder(QStringLiteral("root")));
+    Folder *const sub = new Folder(QStringLiteral("sub"));
+    root->appendChild(sub);
+    Feed *const feed = createFeed(QStringLiteral("http://a.example.com"), 2, 1);
+    sub->appendChild(feed);
+    sub->appendChild(createFeed(QStringLiteral("http://b.example.com"), 1, 1));
+    QCOMPARE(root->unread(), 3);
+
+    delete feed;
+    QCOMPARE(sub->unread(), 1);
+    QCOMPARE(sub->totalCount(), 2);
+    QCOMPARE(root->unread(), 1);
+    QCOMPARE(root->totalCount(), 2);
+
+    delete sub;
+    QCOMPARE(root->unread(), 0);
+    QCOMPARE(root->totalCount(), 0);
+}
+
+void FolderTest::shouldNotifyOncePerEventLoopTurn()
+{
+    QScopedPointer<Folder> root(new Folder(QStringLiteral("root")));
+    Folder *const sub = new Folder(QStringLiteral("sub"));
+    root->appendChild(sub);
+    Feed *const feed = createFeed(QStringLiteral("http://a.example.com"), 5, 0);
+    sub->appendChild(feed);
+    QVector<Article> articles = feed->articles();
+    QCoreApplication::processEvents();
+
+    QSignalSpy rootChanged(root.data(), &TreeNode::signalChanged);
+    QSignalSpy subChanged(sub, &TreeNode::signalChanged);
+    for (Article &article : articles) {
+        article.setStatus(Read);
+    }
+    QCOMPARE(root->unread(), 0);
+    QVERIFY(rootChanged.isEmpty());
+
+    QTRY_COMPARE(rootChanged.count(), 1);
+    QCOMPARE(subChanged.count(), 1);
+    QCoreApplication::processEvents();
+    QCOMPARE(rootChanged.count(), 1);
+}
+
+QTEST_MAIN(FolderTest)
@@ -0,0 +1,228 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "startupbenchmark.h"
+#include "akregatorconfig.h"
+#include "feed.h"
+#include "feedlist.h"
+#include "feedstorage.h"
+#include "startupprofile.h"
+#include "storagemk4impl.h"
+#include "subscriptionlistmodel.h"
+
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QVector>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+using namespace Akregator;
+using Akregator::Backend::FeedStorage;
+
+namespace
+{
+const int feedsPerFolder = 50;
+const int articlesPerFeed = 20;
+
+QString opmlFileName(const QString &dir)
+{
+    return dir + QLatin1String("/feeds.opml");
+}
+
+QString archivePath(const QString &dir)
+{
+    return dir + QLatin1String("/archive");
+}
+
+void writeArchive(FeedStorage *archive, const QString &feedUrl)
+{
+    QVector<FeedStorage::ItemRecord> items;
+    items.reserve(articlesPerFeed);
+    for (int i = 0; i < articlesPerFeed; ++i) {
+        FeedStorage::ItemRecord item;
+        item.guid = feedUrl + QLatin1Char('#') + QString::number(i);
+        item.record.title = QStringLiteral("Article %1").arg(i);
+        item.record.description = QStringLiteral("<p>Description of article %1 of %2</p>").arg(i).arg(feedUrl);
+        item.record.link = item.guid;
+        item.record.hash = i + 1;
+        item.record.pubDate = 1500000000 + i * 3600;
+        item.record.status = i % 2 ? FeedStorage::ReadFlag : FeedStorage::NewFlag;
+        items.append(item);
+    }
+    archive->ingest(items);
+    archive->setUnread(articlesPerFeed / 2);
+}
+}
+
+StartupBenchmark::StartupBenchmark(QObject *parent)
+    : QObject(parent)
+{
+}
+
+StartupBenchmark::~StartupBenchmark()
+{
+}
+
+void StartupBenchmark::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    // setting the URL of a feed would load its favicon otherwise
+    Settings::setFetchOnStartup(true);
+}
+
+void StartupBenchmark::addFeedCounts()
+{
+    QTest::addColumn<int>("feeds");
+    QTest::newRow("100") << 100;
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("10000") << 10000;
+}
+
+QString StartupBenchmark::dataDir(int feeds)
+{
+    QSharedPointer<QTemporaryDir> &dir = m_dirs[feeds];
+    if (dir) {
+        return dir->path();
+    }
+    dir.reset(new QTemporaryDir);
+
+    QFile file(opmlFileName(dir->path()));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return QString();
+    }
+
+    Backend::StorageMK4Impl storage;
+    storage.setArchivePath(archivePath(dir->path()));
+    storage.open(true);
+
+    QXmlStreamWriter writer(&file);
+    writer.setAutoFormatting(true);
+    writer.writeStartDocument();
+    writer.writeStartElement(QStringLiteral("opml"));
+    writer.writeAttribute(QStringLiteral("version"), QStringLiteral("1.0"));
+    writer.writeStartElement(QStringLiteral("head"));
+    writer.writeTextElement(QStringLiteral("title"), QStringLiteral("Akregator Feeds"));
+    writer.writeEndElement();
+    writer.writeStartElement(QStringLiteral("body"));
+    for (int i = 0; i < feeds; ++i) {
+        if (i % feedsPerFolder == 0) {
+            if (i > 0) {
+                writer.writeEndElement();
+            }
+            writer.writeStartElement(QStringLiteral("outline"));
+            writer.writeAttribute(QStringLiteral("text"), QStringLiteral("Folder %1").arg(i / feedsPerFolder));
+            writer.writeAttribute(QStringLiteral("isOpen"), QStringLiteral("true"));
+        }
+        const QString feedUrl = QStringLiteral("http://feed%1.example.com/rss.xml").arg(i);
+        writer.writeEmptyElement(QStringLiteral("outline"));
+        writer.writeAttribute(QStringLiteral("type"), QStringLiteral("rss"));
+        writer.writeAttribute(QStringLiteral("text"), QStringLiteral("Feed %1").arg(i));
+        writer.writeAttribute(QStringLiteral("xmlUrl"), feedUrl);
+        writer.writeAttribute(QStringLiteral("htmlUrl"), QStringLiteral("http://feed%1.example.com/").arg(i));
+        writer.writeAttribute(QStringLiteral("id"), QString::number(i + 1));
+        writeArchive(storage.archiveFor(feedUrl), feedUrl);
+    }
+    if (feeds > 0) {
+        writer.writeEndElement();
+    }
+    writer.writeEndElement();
+    writer.writeEndElement();
+    writer.writeEndDocument();
+
+    storage.commit();
+    return dir->path();
+}
+
+void StartupBenchmark::benchmarkStartup_data()
+{
+    addFeedCounts();
+}
+
+void StartupBenchmark::benchmarkStartup()
+{
+    QFETCH(int, feeds);
+    const QString dir = dataDir(feeds);
+    QVERIFY(!dir.isEmpty());
+
+    QBENCHMARK {
+        StartupProfile::start();
+        Backend::StorageMK4Impl storage;
+        storage.setArchivePath(archivePath(dir));
+        storage.open(true);
+
+        QSharedPointer<FeedList> feedList(new FeedList(&storage));
+        QFile file(opmlFileName(dir));
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QXmlStreamReader reader(&file);
+        {
+            StartupProfile::Scope scope(StartupProfile::OpmlParse);
+            QVERIFY(feedList->readFromOpml(reader));
+            scope.setItems(feedList->feeds().count() + feedList->folders().count());
+        }
+        {
+            StartupProfile::Scope scope(StartupProfile::ModelBuild);
+            SubscriptionListModel model(feedList);
+        }
+        StartupProfile::finish();
+
+        QCOMPARE(feedList->feeds().count(), feeds);
+        feedList.reset();
+    }
+    StartupProfile::finishPostStartup();
+}
+
+void StartupBenchmark::benchmarkArticleLoad_data()
+{
+    addFeedCounts();
+}
+
+void StartupBenchmark::benchmarkArticleLoad()
+{
+    QFETCH(int, feeds);
+    const QString dir = dataDir(feeds);
+    QVERIFY(!dir.isEmpty());
+
+    Backend::StorageMK4Impl storage;
+    storage.setArchivePath(archivePath(dir));
+    storage.open(true);
+    QSharedPointer<FeedList> feedList(new FeedList(&storage));
+    QFile file(opmlFileName(dir));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QXmlStreamReader reader(&file);
+    QVERIFY(feedList->readFromOpml(reader));
+
+    // articles are loaded on first use, so this is measured once: after that they are in memory
+    int articles = 0;
+    QBENCHMARK_ONCE {
+        const QVector<Feed *> feedVector = feedList->feeds();
+        for (Feed *const feed : feedVector) {
+            articles += feed->articles().count();
+        }
+    }
+    QCOMPARE(articles, feeds * articlesPerFeed);
+
+    feedList.reset();
+}
+
+QTEST_MAIN(StartupBenchmark)
@@ -0,0 +1,56 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef STARTUPBENCHMARK_H
+#define STARTUPBENCHMARK_H
+
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+
+class QTemporaryDir;
+
+/** measures loading generated feed lists of 100, 1000 and 10000 feeds with their Metakit archives */
+class StartupBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StartupBenchmark(QObject *parent = nullptr);
+    ~StartupBenchmark();
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void benchmarkStartup_data();
+    void benchmarkStartup();
+    void benchmarkArticleLoad_data();
+    void benchmarkArticleLoad();
+
+private:
+    void addFeedCounts();
+    /** returns the directory holding feeds.opml and the archives of @p feeds feeds, generating it on first use */
+    QString dataDir(int feeds);
+
+    QHash<int, QSharedPointer<QTemporaryDir> > m_dirs;
+};
+
+#endif // STARTUPBENCHMARK_H
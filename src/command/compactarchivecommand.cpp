@@ -0,0 +1,144 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "compactarchivecommand.h"
+
+#include "feed.h"
+#include "feedlist.h"
+
+#include "akregator_debug.h"
+
+#include <QSharedPointer>
+#include <QStringList>
+#include <QTimer>
+
+using namespace Akregator;
+
+class CompactArchiveCommand::Private
+{
+    CompactArchiveCommand *const q;
+public:
+    explicit Private(CompactArchiveCommand *qq);
+
+    void compactNextArchive();
+
+    Backend::Storage *m_storage;
+    QWeakPointer<FeedList> m_feedList;
+    /** URLs of the archived feeds */
+    QStringList m_feeds;
+    /** index in m_feeds of the next feed to compact */
+    int m_nextFeed;
+    bool m_aborted;
+    Backend::Storage::CompactionResult m_result;
+};
+
+CompactArchiveCommand::Private::Private(CompactArchiveCommand *qq) : q(qq)
+    , m_storage(nullptr)
+    , m_feedList()
+    , m_nextFeed(0)
+    , m_aborted(false)
+{
+    m_result.files = 0;
+    m_result.sizeBefore = 0;
+    m_result.sizeAfter = 0;
+}
+
+void CompactArchiveCommand::Private::compactNextArchive()
+{
+    if (!m_storage) {
+        qCWarning(AKREGATOR_LOG) << "No storage set, could not compact the archive";
+    }
+    if (m_aborted || !m_storage) {
+        q->done();
+        return;
+    }
+
+    // the files shared by all feeds count as one more step
+    const int steps = m_feeds.count() + 1;
+    if (m_nextFeed < m_feeds.count()) {
+        const QString url = m_feeds.at(m_nextFeed++);
+        const QSharedPointer<FeedList> feedList = m_feedList.lock();
+        // feeds missing from the feed list keep their deleted articles
+        Feed *const feed = feedList ? feedList->findByURL(url) : nullptr;
+        m_storage->compactArchive(url, feed ? feed->purgeDeletedArticlesBefore() : 0, m_result);
+        if (feed) {
+            feed->forgetPurgedArticles();
+        }
+        Q_EMIT q->progress((m_nextFeed * 100) / steps, QString());
+        // one archive per event loop iteration, so that compacting large archives does not block the UI
+        QTimer::singleShot(0, q, SLOT(compactNextArchive()));
+        return;
+    }
+
+    m_storage->compactSharedFiles(m_result);
+    Q_EMIT q->progress(100, QString());
+    q->done();
+}
+
+CompactArchiveCommand::CompactArchiveCommand(QObject *parent) : Command(parent)
+    , d(new Private(this))
+{
+}
+
+CompactArchiveCommand::~CompactArchiveCommand()
+{
+    delete d;
+}
+
+void CompactArchiveCommand::setStorage(Backend::Storage *storage)
+{
+    d->m_storage = storage;
+}
+
+Backend::Storage *CompactArchiveCommand::storage() const
+{
+    return d->m_storage;
+}
+
+void CompactArchiveCommand::setFeedList(const QWeakPointer<FeedList> &feedList)
+{
+    d->m_feedList = feedList;
+}
+
+QWeakPointer<FeedList> CompactArchiveCommand::feedList() const
+{
+    return d->m_feedList;
+}
+
+Backend::Storage::CompactionResult CompactArchiveCommand::result() const
+{
+    return d->m_result;
+}
+
+void CompactArchiveCommand::doAbort()
+{
+    d->m_aborted = true;
+}
+
+void CompactArchiveCommand::doStart()
+{
+    d->m_feeds = d->m_storage ? d->m_storage->feeds() : QStringList();
+    d->m_nextFeed = 0;
+    QTimer::singleShot(0, this, SLOT(compactNextArchive()));
+}
+
+#include "moc_compactarchivecommand.cpp"
@@ -0,0 +1,63 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef AKREGATOR_COMPACTARCHIVECOMMAND_H
+#define AKREGATOR_COMPACTARCHIVECOMMAND_H
+
+#include "command.h"
+#include "storage.h"
+
+#include <QWeakPointer>
+
+namespace Akregator {
+class FeedList;
+
+/** compacts the archive of one feed per event loop iteration, then the files shared by all feeds.
+    Deleted articles are dropped as the archive settings of their feeds allow, see Feed::purgeDeletedArticlesBefore() */
+class CompactArchiveCommand : public Command
+{
+    Q_OBJECT
+public:
+    explicit CompactArchiveCommand(QObject *parent = nullptr);
+    ~CompactArchiveCommand();
+
+    void setStorage(Backend::Storage *storage);
+    Backend::Storage *storage() const;
+
+    void setFeedList(const QWeakPointer<FeedList> &feedList);
+    QWeakPointer<FeedList> feedList() const;
+
+    /** the files compacted so far, all of them once the command finished */
+    Backend::Storage::CompactionResult result() const;
+
+private:
+    void doStart() override;
+    void doAbort() override;
+
+private:
+    class Private;
+    Private *const d;
+    Q_PRIVATE_SLOT(d, void compactNextArchive())
+};
+}
+
+#endif // AKREGATOR_COMPACTARCHIVECOMMAND_H
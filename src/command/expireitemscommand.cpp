@@ -46,16 +46,23 @@ public:
     explicit Private(ExpireItemsCommand *qq);
 
     void createDeleteJobs();
+    void expireNextFeed();
     void addDeleteJobForFeed(Feed *feed);
     void jobFinished(KJob *);
+    void feedDone();
 
     QWeakPointer<FeedList> m_feedList;
     QVector<int> m_feeds;
     QSet<KJob *> m_jobs;
+    /** index in m_feeds of the next feed to expire */
+    int m_nextFeed;
+    int m_finishedFeeds;
 };
 
 ExpireItemsCommand::Private::Private(ExpireItemsCommand *qq) : q(qq)
     , m_feedList()
+    , m_nextFeed(0)
+    , m_finishedFeeds(0)
 {
 }
 
@@ -73,8 +80,14 @@ void ExpireItemsCommand::Private::jobFinished(KJob *job)
 {
     Q_ASSERT(!m_jobs.isEmpty());
     m_jobs.remove(job);
-    Q_EMIT q->progress(((m_feeds.count() - m_jobs.count()) * 100) / m_feeds.count(), QString());
-    if (m_jobs.isEmpty()) {
+    feedDone();
+}
+
+void ExpireItemsCommand::Private::feedDone()
+{
+    ++m_finishedFeeds;
+    Q_EMIT q->progress((m_finishedFeeds * 100) / m_feeds.count(), QString());
+    if (m_jobs.isEmpty() && m_nextFeed >= m_feeds.count()) {
         q->done();
     }
 }
@@ -92,11 +105,29 @@ void ExpireItemsCommand::Private::createDeleteJobs()
         return;
     }
 
-    for (const int i : qAsConst(m_feeds)) {
-        Feed *const feed = qobject_cast<Feed *>(feedList->findByID(i));
-        if (feed) {
-            addDeleteJobForFeed(feed);
-        }
+    m_nextFeed = 0;
+    m_finishedFeeds = 0;
+    expireNextFeed();
+}
+
+void ExpireItemsCommand::Private::expireNextFeed()
+{
+    if (m_nextFeed >= m_feeds.count()) {
+        return;
+    }
+
+    // one feed per event loop iteration, so that expiring large archives does not block the UI
+    const int id = m_feeds.at(m_nextFeed++);
+    if (m_nextFeed < m_feeds.count()) {
+        QTimer::singleShot(0, q, SLOT(expireNextFeed()));
+    }
+
+    const QSharedPointer<FeedList> feedList = m_feedList.lock();
+    Feed *const feed = feedList ? qobject_cast<Feed *>(feedList->findByID(id)) : nullptr;
+    if (feed) {
+        addDeleteJobForFeed(feed);
+    } else {
+        feedDone();
     }
 }
 
@@ -132,6 +163,7 @@ QVector<int> ExpireItemsCommand::feeds() const
 
 void ExpireItemsCommand::doAbort()
 {
+    d->m_nextFeed = d->m_feeds.count();
     for (KJob *const i : qAsConst(d->m_jobs)) {
         i->kill();
     }
@@ -55,6 +55,7 @@ private:
     class Private;
     Private *const d;
     Q_PRIVATE_SLOT(d, void createDeleteJobs())
+    Q_PRIVATE_SLOT(d, void expireNextFeed())
     Q_PRIVATE_SLOT(d, void jobFinished(KJob *))
 };
 }
@@ -31,10 +31,11 @@
 #include "akregator_debug.h"
 #include <QInputDialog>
 #include <KLocalizedString>
+#include <KMessageBox>
 
-#include <QDomDocument>
 #include <QPointer>
 #include <QTimer>
+#include <QXmlStreamReader>
 
 #include <QSharedPointer>
 
@@ -51,7 +52,7 @@ public:
     void doImport();
 
     QWeakPointer<FeedList> targetList;
-    QDomDocument document;
+    QByteArray document;
     ImportFeedListCommand::RootFolderOption rootFolderOption;
     QString importedRootFolderName;
 };
@@ -77,11 +78,15 @@ void ImportFeedListCommand::Private::doImport()
     }
 
     QScopedPointer<FeedList> importedList(new FeedList(Kernel::self()->storage()));
-    const bool parsed = importedList->readFromOpml(document);
+    QXmlStreamReader reader(document);
+    const bool parsed = importedList->readFromOpml(reader);
 
-    // FIXME: parsing error, print some message
     if (!parsed) {
-        q->done();
+        QPointer<QObject> that(q);
+        KMessageBox::error(q->parentWidget(), i18n("Could not import the feed list (no valid OPML)"), i18n("OPML Parsing Error"));
+        if (that) {
+            q->done();
+        }
         return;
     }
 
@@ -140,9 +145,9 @@ void ImportFeedListCommand::setImportedRootFolderName(const QString &defaultName
     d->importedRootFolderName = defaultName;
 }
 
-void ImportFeedListCommand::setFeedListDocument(const QDomDocument &doc)
+void ImportFeedListCommand::setFeedListData(const QByteArray &opml)
 {
-    d->document = doc;
+    d->document = opml;
 }
 
 void ImportFeedListCommand::doAbort()
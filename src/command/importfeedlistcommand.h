@@ -29,7 +29,7 @@
 
 #include <QWeakPointer>
 
-class QDomDocument;
+class QByteArray;
 
 namespace Akregator {
 class FeedList;
@@ -52,7 +52,8 @@ public:
     void setImportedRootFolderOption(RootFolderOption opt);
     void setImportedRootFolderName(const QString &defaultName);
 
-    void setFeedListDocument(const QDomDocument &doc);
+    /** sets the OPML document to import */
+    void setFeedListData(const QByteArray &opml);
 
 private:
     void doStart() override;
@@ -25,6 +25,7 @@
 #include "loadfeedlistcommand.h"
 
 #include "feedlist.h"
+#include "startupprofile.h"
 #include "storage.h"
 
 #include <KLocalizedString>
@@ -32,12 +33,12 @@
 #include <KRandom>
 
 #include <QDateTime>
-#include <QDomDocument>
 #include <QFile>
 #include <QPointer>
 #include <QString>
 #include <QTimer>
 #include <QFileInfo>
+#include <QXmlStreamReader>
 
 #include <cassert>
 
@@ -53,13 +54,15 @@ public:
     {
     }
 
-    void handleDocument(const QDomDocument &doc);
+    void handleInvalidOpml();
+    void handleInvalidXml(const QXmlStreamReader &reader);
+    void loadDefaultFeedList();
     QString createBackup(const QString &path, bool *ok);
     void emitResult(const QSharedPointer<FeedList> &list);
     void doLoad();
 
     QString fileName;
-    QDomDocument defaultFeedList;
+    QByteArray defaultFeedList;
     Storage *storage;
 };
 
@@ -69,26 +72,63 @@ void LoadFeedListCommand::Private::emitResult(const QSharedPointer<FeedList> &li
     q->done();
 }
 
-void LoadFeedListCommand::Private::handleDocument(const QDomDocument &doc)
+void LoadFeedListCommand::Private::handleInvalidOpml()
 {
-    QSharedPointer<FeedList> feedList(new FeedList(storage));
-    if (!feedList->readFromOpml(doc)) {
-        bool backupCreated;
-        const QString backupFile = createBackup(fileName, &backupCreated);
-        const QString msg
-            = backupCreated
-              ? i18n("<qt>The standard feed list is corrupted (invalid OPML). "
-                     "A backup was created:<p><b>%1</b></p></qt>", backupFile)
-              : i18n("<qt>The standard feed list is corrupted (invalid OPML). "
-                     "Could not create a backup.</qt>");
+    bool backupCreated;
+    const QString backupFile = createBackup(fileName, &backupCreated);
+    const QString msg
+        = backupCreated
+          ? i18n("<qt>The standard feed list is corrupted (invalid OPML). "
+                 "A backup was created:<p><b>%1</b></p></qt>", backupFile)
+          : i18n("<qt>The standard feed list is corrupted (invalid OPML). "
+                 "Could not create a backup.</qt>");
+
+    QPointer<QObject> that(q);
+    KMessageBox::error(q->parentWidget(), msg, i18n("OPML Parsing Error"));
+    if (!that) {
+        return;
+    }
+    emitResult(QSharedPointer<FeedList>());
+}
 
-        QPointer<QObject> that(q);
-        KMessageBox::error(q->parentWidget(), msg, i18n("OPML Parsing Error"));
-        if (!that) {
-            return;
-        }
-        feedList.reset();
+void LoadFeedListCommand::Private::handleInvalidXml(const QXmlStreamReader &reader)
+{
+    bool backupCreated = false;
+    const QString backupFile = createBackup(fileName, &backupCreated);
+    const QString title = i18nc("error message window caption", "XML Parsing Error");
+    const QString details
+        = xi18n("<qt><p>XML parsing error in line %1, "
+                "column %2 of %3:</p><p>%4</p></qt>",
+                QString::number(reader.lineNumber()),
+                QString::number(reader.columnNumber()),
+                fileName,
+                reader.errorString());
+    const QString msg
+        = backupCreated
+          ? i18n("<qt>The standard feed list is corrupted (invalid XML). "
+                 "A backup was created:<p><b>%1</b></p></qt>", backupFile)
+          : i18n("<qt>The standard feed list is corrupted (invalid XML). "
+                 "Could not create a backup.</qt>");
+
+    QPointer<QObject> that(q);
+
+    KMessageBox::detailedError(q->parentWidget(), msg, details, title);
+
+    if (that) {
+        loadDefaultFeedList();
+    }
+}
+
+void LoadFeedListCommand::Private::loadDefaultFeedList()
+{
+    QSharedPointer<FeedList> feedList(new FeedList(storage));
+    QXmlStreamReader reader(defaultFeedList);
+    if (!feedList->readFromOpml(reader)) {
+        handleInvalidOpml();
+        return;
     }
+    // the default list was never saved
+    feedList->setModified(true);
     emitResult(feedList);
 }
 
@@ -120,9 +160,9 @@ void LoadFeedListCommand::setFileName(const QString &fileName)
     d->fileName = fileName;
 }
 
-void LoadFeedListCommand::setDefaultFeedList(const QDomDocument &doc)
+void LoadFeedListCommand::setDefaultFeedList(const QByteArray &opml)
 {
-    d->defaultFeedList = doc;
+    d->defaultFeedList = opml;
 }
 
 void LoadFeedListCommand::setStorage(Backend::Storage *s)
@@ -145,14 +185,10 @@ void LoadFeedListCommand::Private::doLoad()
     Q_ASSERT(!fileName.isNull());
     Q_EMIT q->progress(0, i18n("Opening Feed List..."));
 
-    QString str;
-
-    const QString listBackup = storage->restoreFeedList();
-
-    QDomDocument doc;
+    StartupProfile::start();
 
     if (!QFileInfo::exists(fileName)) {
-        handleDocument(defaultFeedList);
+        loadDefaultFeedList();
         return;
     }
 
@@ -165,43 +201,33 @@ void LoadFeedListCommand::Private::doLoad()
             i18n("<qt>Could not open feed list (%1) for reading.</qt>", file.fileName()),
             i18n("Read Error"));
         if (that) {
-            handleDocument(defaultFeedList);
+            loadDefaultFeedList();
         }
         return;
     }
 
-    QString errMsg;
-    int errLine = 0;
-    int errCol = 0;
-    if (!doc.setContent(&file, true, &errMsg, &errLine, &errCol)) {
-        bool backupCreated = false;
-        const QString backupFile = createBackup(fileName, &backupCreated);
-        const QString title = i18nc("error message window caption", "XML Parsing Error");
-        const QString details
-            = xi18n("<qt><p>XML parsing error in line %1, "
-                    "column %2 of %3:</p><p>%4</p></qt>",
-                    QString::number(errLine),
-                    QString::number(errCol),
-                    fileName,
-                    errMsg);
-        const QString msg
-            = backupCreated
-              ? i18n("<qt>The standard feed list is corrupted (invalid XML). "
-                     "A backup was created:<p><b>%1</b></p></qt>", backupFile)
-              : i18n("<qt>The standard feed list is corrupted (invalid XML). "
-                     "Could not create a backup.</qt>");
-
-        QPointer<QObject> that(q);
+    QSharedPointer<FeedList> feedList(new FeedList(storage));
+    QXmlStreamReader reader(&file);
+    bool parsed;
+    {
+        StartupProfile::Scope scope(StartupProfile::OpmlParse);
+        parsed = feedList->readFromOpml(reader);
+        scope.setItems(feedList->feeds().count() + feedList->folders().count());
+    }
 
-        KMessageBox::detailedError(q->parentWidget(), msg, details, title);
+    if (reader.hasError()) {
+        feedList.reset();
+        handleInvalidXml(reader);
+        return;
+    }
 
-        if (that) {
-            handleDocument(defaultFeedList);
-        }
+    if (!parsed) {
+        feedList.reset();
+        handleInvalidOpml();
         return;
     }
 
-    handleDocument(doc);
+    emitResult(feedList);
 }
 
 #include "moc_loadfeedlistcommand.cpp"
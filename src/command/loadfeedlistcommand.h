@@ -29,7 +29,7 @@
 
 #include <QSharedPointer>
 
-class QDomDocument;
+class QByteArray;
 
 namespace Akregator {
 namespace Backend {
@@ -46,7 +46,7 @@ public:
     ~LoadFeedListCommand();
 
     void setFileName(const QString &fileName);
-    void setDefaultFeedList(const QDomDocument &doc);
+    void setDefaultFeedList(const QByteArray &opml);
     void setStorage(Backend::Storage *storage);
 
 Q_SIGNALS:
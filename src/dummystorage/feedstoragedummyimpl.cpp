@@ -72,6 +72,9 @@ public:
         int enclosureLength;
     };
 
+    /** copies the fields selected by @c fields from @c record into @c entry */
+    static void recordToEntry(Entry &entry, int fields, const ArticleRecord &record);
+
     QHash<QString, Entry> entries;
 
     // all tags occurring in the feed
@@ -85,8 +88,57 @@ public:
 
     Storage *mainStorage;
     QString url;
+    quint64 generation;
 };
 
+void FeedStorageDummyImpl::FeedStorageDummyImplPrivate::recordToEntry(Entry &entry, int fields, const ArticleRecord &record)
+{
+    if (fields & ArticleRecord::Title) {
+        entry.title = record.title;
+    }
+    if (fields & ArticleRecord::Description) {
+        entry.description = record.description;
+    }
+    if (fields & ArticleRecord::Content) {
+        entry.content = record.content;
+    }
+    if (fields & ArticleRecord::Link) {
+        entry.link = record.link;
+    }
+    if (fields & ArticleRecord::CommentsLink) {
+        entry.commentsLink = record.commentsLink;
+    }
+    if (fields & ArticleRecord::Comments) {
+        entry.comments = record.comments;
+    }
+    if (fields & ArticleRecord::GuidIsHash) {
+        entry.guidIsHash = record.guidIsHash;
+    }
+    if (fields & ArticleRecord::GuidIsPermaLink) {
+        entry.guidIsPermaLink = record.guidIsPermaLink;
+    }
+    if (fields & ArticleRecord::Hash) {
+        entry.hash = record.hash;
+    }
+    if (fields & ArticleRecord::PubDate) {
+        entry.pubDate = record.pubDate;
+    }
+    if (fields & ArticleRecord::Status) {
+        entry.status = record.status;
+    }
+    if (fields & ArticleRecord::Author) {
+        entry.authorName = record.authorName;
+        entry.authorUri = record.authorUri;
+        entry.authorEMail = record.authorEMail;
+    }
+    if (fields & ArticleRecord::Enclosure) {
+        entry.hasEnclosure = record.hasEnclosure;
+        entry.enclosureUrl = record.hasEnclosure ? record.enclosureUrl : QString();
+        entry.enclosureType = record.hasEnclosure ? record.enclosureType : QString();
+        entry.enclosureLength = record.hasEnclosure ? record.enclosureLength : -1;
+    }
+}
+
 void FeedStorageDummyImpl::convertOldArchive()
 {
 }
@@ -95,6 +147,7 @@ FeedStorageDummyImpl::FeedStorageDummyImpl(const QString &url, StorageDummyImpl
 {
     d->url = url;
     d->mainStorage = main;
+    d->generation = 0;
 }
 
 FeedStorageDummyImpl::~FeedStorageDummyImpl()
@@ -115,6 +168,16 @@ void FeedStorageDummyImpl::close()
 {
 }
 
+QString FeedStorageDummyImpl::url() const
+{
+    return d->url;
+}
+
+quint64 FeedStorageDummyImpl::generation() const
+{
+    return d->generation;
+}
+
 int FeedStorageDummyImpl::unread() const
 {
     return d->mainStorage->unreadFor(d->url);
@@ -145,6 +208,16 @@ void FeedStorageDummyImpl::setLastFetch(int lastFetch)
     d->mainStorage->setLastFetchFor(d->url, lastFetch);
 }
 
+FetchValidators FeedStorageDummyImpl::fetchValidators() const
+{
+    return d->mainStorage->fetchValidatorsFor(d->url);
+}
+
+void FeedStorageDummyImpl::setFetchValidators(const FetchValidators &validators)
+{
+    d->mainStorage->setFetchValidatorsFor(d->url, validators);
+}
+
 QStringList FeedStorageDummyImpl::articles(const QString &tag) const
 {
     return tag.isNull() ? QStringList(d->entries.keys()) : d->taggedArticles.value(tag);
@@ -155,6 +228,17 @@ QStringList FeedStorageDummyImpl::articles(const Category &cat) const
     return d->categorizedArticles.value(cat);
 }
 
+QStringList FeedStorageDummyImpl::articlesPublishedBefore(uint pubDate) const
+{
+    QStringList list;
+    for (auto it = d->entries.constBegin(), end = d->entries.constEnd(); it != end; ++it) {
+        if (it.value().pubDate < pubDate && !(it.value().status & DeletedFlag)) {
+            list += it.key();
+        }
+    }
+    return list;
+}
+
 void FeedStorageDummyImpl::addEntry(const QString &guid)
 {
     if (!d->entries.contains(guid)) {
@@ -176,6 +260,9 @@ void FeedStorageDummyImpl::deleteArticle(const QString &guid)
 
     setDeleted(guid);
 
+    if (!(d->entries[guid].status & DeletedFlag)) {
+        setTotalCount(totalCount() - 1);
+    }
     d->entries.remove(guid);
 }
 
@@ -210,7 +297,7 @@ void FeedStorageDummyImpl::setDeleted(const QString &guid)
         return;
     }
 
-    FeedStorageDummyImplPrivate::Entry entry = d->entries[guid];
+    FeedStorageDummyImplPrivate::Entry &entry = d->entries[guid];
 
     // remove article from tag->article index
     QStringList::ConstIterator it = entry.tags.constBegin();
@@ -259,7 +346,11 @@ int FeedStorageDummyImpl::status(const QString &guid) const
 void FeedStorageDummyImpl::setStatus(const QString &guid, int status)
 {
     if (contains(guid)) {
+        const int delta = totalCountDelta(d->entries[guid].status, status);
         d->entries[guid].status = status;
+        if (delta != 0) {
+            setTotalCount(totalCount() + delta);
+        }
     }
 }
 
@@ -448,26 +539,16 @@ void FeedStorageDummyImpl::add(FeedStorage *source)
     }
     setUnread(source->unread());
     setLastFetch(source->lastFetch());
+    setFetchValidators(source->fetchValidators());
     setTotalCount(source->totalCount());
 }
 
 void FeedStorageDummyImpl::copyArticle(const QString &guid, FeedStorage *source)
 {
-    if (!contains(guid)) {
-        addEntry(guid);
-    }
-
-    setComments(guid, source->comments(guid));
-    setCommentsLink(guid, source->commentsLink(guid));
-    setDescription(guid, source->description(guid));
-    setContent(guid, source->content(guid));
-    setGuidIsHash(guid, source->guidIsHash(guid));
-    setGuidIsPermaLink(guid, source->guidIsPermaLink(guid));
-    setHash(guid, source->hash(guid));
-    setLink(guid, source->link(guid));
-    setPubDate(guid, source->pubDate(guid));
-    setStatus(guid, source->status(guid));
-    setTitle(guid, source->title(guid));
+    ArticleRecord record;
+    source->readRecord(guid, record);
+    writeRecord(guid, record);
+
     QStringList tags = source->tags(guid);
 
     for (QStringList::ConstIterator it = tags.constBegin(); it != tags.constEnd(); ++it) {
@@ -478,6 +559,7 @@ void FeedStorageDummyImpl::copyArticle(const QString &guid, FeedStorage *source)
 void FeedStorageDummyImpl::clear()
 {
     d->entries.clear();
+    ++d->generation;
     setUnread(0);
     setTotalCount(0);
 }
@@ -519,5 +601,110 @@ void FeedStorageDummyImpl::enclosure(const QString &guid, bool &hasEnclosure, QS
         length = -1;
     }
 }
+
+bool FeedStorageDummyImpl::readRecord(const QString &guid, ArticleRecord &record, int fields) const
+{
+    const auto it = d->entries.constFind(guid);
+    if (it == d->entries.constEnd()) {
+        return false;
+    }
+    const FeedStorageDummyImplPrivate::Entry &entry = it.value();
+    if (fields & ArticleRecord::Title) {
+        record.title = entry.title;
+    }
+    if (fields & ArticleRecord::Description) {
+        record.description = entry.description;
+    }
+    if (fields & ArticleRecord::Content) {
+        record.content = entry.content;
+    }
+    if (fields & ArticleRecord::Link) {
+        record.link = entry.link;
+    }
+    if (fields & ArticleRecord::CommentsLink) {
+        record.commentsLink = entry.commentsLink;
+    }
+    if (fields & ArticleRecord::Comments) {
+        record.comments = entry.comments;
+    }
+    if (fields & ArticleRecord::GuidIsHash) {
+        record.guidIsHash = entry.guidIsHash;
+    }
+    if (fields & ArticleRecord::GuidIsPermaLink) {
+        record.guidIsPermaLink = entry.guidIsPermaLink;
+    }
+    if (fields & ArticleRecord::Hash) {
+        record.hash = entry.hash;
+    }
+    if (fields & ArticleRecord::PubDate) {
+        record.pubDate = entry.pubDate;
+    }
+    if (fields & ArticleRecord::Status) {
+        record.status = entry.status;
+    }
+    if (fields & ArticleRecord::Author) {
+        record.authorName = entry.authorName;
+        record.authorUri = entry.authorUri;
+        record.authorEMail = entry.authorEMail;
+    }
+    if (fields & ArticleRecord::Enclosure) {
+        record.hasEnclosure = entry.hasEnclosure;
+        record.enclosureUrl = entry.enclosureUrl;
+        record.enclosureType = entry.enclosureType;
+        record.enclosureLength = entry.enclosureLength;
+    }
+    return true;
+}
+
+void FeedStorageDummyImpl::writeRecord(const QString &guid, const ArticleRecord &record)
+{
+    const int oldStatus = d->entries.contains(guid) ? d->entries[guid].status : int(DeletedFlag);
+    FeedStorageDummyImplPrivate::recordToEntry(d->entries[guid], ArticleRecord::AllFields, record);
+    const int delta = totalCountDelta(oldStatus, record.status);
+    if (delta != 0) {
+        setTotalCount(totalCount() + delta);
+    }
+}
+
+void FeedStorageDummyImpl::updateFields(const QString &guid, int fields, const ArticleRecord &record)
+{
+    const auto it = d->entries.find(guid);
+    if (it != d->entries.end()) {
+        const int delta = (fields & ArticleRecord::Status) ? totalCountDelta(it.value().status, record.status) : 0;
+        FeedStorageDummyImplPrivate::recordToEntry(it.value(), fields, record);
+        if (delta != 0) {
+            setTotalCount(totalCount() + delta);
+        }
+    }
+}
+
+QVector<FeedStorage::IngestResult> FeedStorageDummyImpl::ingest(const QVector<ItemRecord> &items)
+{
+    QVector<IngestResult> results;
+    results.reserve(items.count());
+    int added = 0;
+
+    for (const ItemRecord &item : items) {
+        const auto it = d->entries.find(item.guid);
+        if (it == d->entries.end()) {
+            FeedStorageDummyImplPrivate::recordToEntry(d->entries[item.guid], ArticleRecord::AllFields, item.record);
+            added += totalCountDelta(DeletedFlag, item.record.status);
+            results.append(Inserted);
+        } else if (it.value().hash == item.record.hash) {
+            results.append(Unchanged);
+        } else {
+            if (item.fields & ArticleRecord::Status) {
+                added += totalCountDelta(it.value().status, item.record.status);
+            }
+            FeedStorageDummyImplPrivate::recordToEntry(it.value(), item.fields, item.record);
+            results.append(Updated);
+        }
+    }
+
+    if (added != 0) {
+        setTotalCount(totalCount() + added);
+    }
+    return results;
+}
 } // namespace Backend
 } // namespace Akregator
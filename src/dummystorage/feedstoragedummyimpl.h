@@ -44,10 +44,13 @@ public:
     int totalCount() const override;
     int lastFetch() const override;
     void setLastFetch(int lastFetch) override;
+    FetchValidators fetchValidators() const override;
+    void setFetchValidators(const FetchValidators &validators) override;
 
     QStringList articles(const QString &tag = QString()) const override;
 
     QStringList articles(const Category &cat) const override;
+    QStringList articlesPublishedBefore(uint pubDate) const override;
 
     bool contains(const QString &guid) const override;
     void addEntry(const QString &guid) override;
@@ -83,6 +86,11 @@ public:
     void removeEnclosure(const QString &guid) override;
     void enclosure(const QString &guid, bool &hasEnclosure, QString &url, QString &type, int &length) const override;
 
+    bool readRecord(const QString &guid, ArticleRecord &record, int fields = ArticleRecord::AllFields) const override;
+    void writeRecord(const QString &guid, const ArticleRecord &record) override;
+    void updateFields(const QString &guid, int fields, const ArticleRecord &record) override;
+    QVector<IngestResult> ingest(const QVector<ItemRecord> &items) override;
+
     void addCategory(const QString &guid, const Category &category) override;
     QList<Category> categories(const QString &guid = QString()) const override;
 
@@ -94,6 +102,8 @@ public:
     QString authorUri(const QString &guid) const override;
     QString authorEMail(const QString &guid) const override;
 
+    QString url() const override;
+    quint64 generation() const override;
     void close() override;
     void commit() override;
     void rollback() override;
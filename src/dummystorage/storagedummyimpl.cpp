@@ -39,6 +39,7 @@ public:
         int unread;
         int totalCount;
         int lastFetch;
+        FetchValidators validators;
         FeedStorage *feedStorage;
     };
 
@@ -142,6 +143,19 @@ void StorageDummyImpl::setLastFetchFor(const QString &url, int lastFetch)
     }
 }
 
+FetchValidators StorageDummyImpl::fetchValidatorsFor(const QString &url) const
+{
+    return d->feeds.contains(url) ? d->feeds[url].validators : FetchValidators();
+}
+
+void StorageDummyImpl::setFetchValidatorsFor(const QString &url, const FetchValidators &validators)
+{
+    if (!d->feeds.contains(url)) {
+        d->addEntry(url, 0, 0, 0);
+    }
+    d->feeds[url].validators = validators;
+}
+
 void StorageDummyImpl::slotCommit()
 {
 }
@@ -186,6 +200,19 @@ void StorageDummyImpl::clear()
     d->feeds.clear();
 }
 
+QVector<Storage::SearchHit> StorageDummyImpl::search(const QString &, int) const
+{
+    return QVector<SearchHit>();
+}
+
+void StorageDummyImpl::compactArchive(const QString &, uint, CompactionResult &)
+{
+}
+
+void StorageDummyImpl::compactSharedFiles(CompactionResult &)
+{
+}
+
 void StorageDummyImpl::storeFeedList(const QString &opmlStr)
 {
     d->feedList = opmlStr;
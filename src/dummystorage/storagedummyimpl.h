@@ -79,6 +79,8 @@ public:
     void setTotalCountFor(const QString &url, int total) override;
     int lastFetchFor(const QString &url) const override;
     void setLastFetchFor(const QString &url, int lastFetch) override;
+    FetchValidators fetchValidatorsFor(const QString &url) const override;
+    void setFetchValidatorsFor(const QString &url, const FetchValidators &validators) override;
     QStringList feeds() const override;
 
     void storeFeedList(const QString &opmlStr) override;
@@ -95,6 +97,11 @@ public:
     /** deletes all feed storages in this archive */
     void clear() override;
 
+    QVector<SearchHit> search(const QString &query, int maxHits) const override;
+
+    void compactArchive(const QString &feedUrl, uint purgeBefore, CompactionResult &result) override;
+    void compactSharedFiles(CompactionResult &result) override;
+
 protected Q_SLOTS:
     void slotCommit();
 
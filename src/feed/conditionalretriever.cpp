@@ -0,0 +1,167 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "conditionalretriever.h"
+
+#include <KIO/TransferJob>
+
+#include <QCryptographicHash>
+#include <QStringList>
+#include <QUrl>
+
+using namespace Akregator;
+
+namespace {
+QString userAgentString;
+bool useCache = true;
+}
+
+class Q_DECL_HIDDEN ConditionalRetriever::Private
+{
+public:
+    explicit Private(const Backend::FetchValidators &validators) : validators(validators)
+        , job(nullptr)
+        , lastError(0)
+    {
+    }
+
+    /** extracts the validators from the response headers, one "Name: value" pair per line */
+    static Backend::FetchValidators parseValidators(const QString &headers);
+
+    const Backend::FetchValidators validators;
+    KIO::TransferJob *job;
+    QByteArray buffer;
+    int lastError;
+};
+
+Backend::FetchValidators ConditionalRetriever::Private::parseValidators(const QString &headers)
+{
+    Backend::FetchValidators result;
+    const QStringList lines = headers.split(QLatin1Char('\n'), QString::SkipEmptyParts);
+    for (const QString &line : lines) {
+        const int colon = line.indexOf(QLatin1Char(':'));
+        if (colon <= 0) {
+            continue;
+        }
+        const QString name = line.left(colon).trimmed();
+        const QString value = line.mid(colon + 1).trimmed();
+        if (name.compare(QLatin1String("ETag"), Qt::CaseInsensitive) == 0) {
+            result.eTag = value;
+        } else if (name.compare(QLatin1String("Last-Modified"), Qt::CaseInsensitive) == 0) {
+            result.lastModified = value;
+        }
+    }
+    return result;
+}
+
+ConditionalRetriever::ConditionalRetriever(const Backend::FetchValidators &validators) : d(new Private(validators))
+{
+}
+
+ConditionalRetriever::~ConditionalRetriever()
+{
+    delete d;
+}
+
+void ConditionalRetriever::setUserAgent(const QString &userAgent)
+{
+    userAgentString = userAgent;
+}
+
+void ConditionalRetriever::setUseCache(bool enabled)
+{
+    useCache = enabled;
+}
+
+void ConditionalRetriever::retrieveData(const QUrl &url)
+{
+    d->job = KIO::get(url, useCache ? KIO::NoReload : KIO::Reload, KIO::HideProgressInfo);
+    if (!userAgentString.isEmpty()) {
+        d->job->addMetaData(QStringLiteral("UserAgent"), userAgentString);
+    }
+    d->job->addMetaData(QStringLiteral("PropagateHttpHeader"), QStringLiteral("true"));
+
+    QStringList conditions;
+    if (!d->validators.eTag.isEmpty()) {
+        conditions << QStringLiteral("If-None-Match: ") + d->validators.eTag;
+    }
+    if (!d->validators.lastModified.isEmpty()) {
+        conditions << QStringLiteral("If-Modified-Since: ") + d->validators.lastModified;
+    }
+    if (!conditions.isEmpty()) {
+        d->job->addMetaData(QStringLiteral("customHTTPHeader"), conditions.join(QStringLiteral("\r\n")));
+    }
+
+    connect(d->job, &KIO::TransferJob::data, this, &ConditionalRetriever::slotData);
+    connect(d->job, &KJob::result, this, &ConditionalRetriever::slotResult);
+}
+
+int ConditionalRetriever::errorCode() const
+{
+    return d->lastError;
+}
+
+void ConditionalRetriever::abort()
+{
+    if (d->job) {
+        d->job->kill();
+        d->job = nullptr;
+    }
+}
+
+void ConditionalRetriever::slotData(KIO::Job *, const QByteArray &data)
+{
+    d->buffer.append(data);
+}
+
+void ConditionalRetriever::slotResult(KJob *job)
+{
+    KIO::TransferJob *const transferJob = static_cast<KIO::TransferJob *>(job);
+    d->job = nullptr;
+    d->lastError = job->error();
+
+    // the loader deletes us in the slot connected to dataRetrieved(), so emit it last
+    if (transferJob->queryMetaData(QStringLiteral("responsecode")).toInt() == 304) {
+        Q_EMIT documentUnchanged();
+        Q_EMIT dataRetrieved(QByteArray(), false);
+        return;
+    }
+
+    if (d->lastError) {
+        Q_EMIT dataRetrieved(d->buffer, false);
+        return;
+    }
+
+    Backend::FetchValidators received = Private::parseValidators(transferJob->queryMetaData(QStringLiteral("HTTP-Headers")));
+    received.digest = QString::fromLatin1(QCryptographicHash::hash(d->buffer, QCryptographicHash::Sha1).toHex());
+
+    // servers without validators, or with validators that change on every request,
+    // often send the same document again
+    if (!d->validators.digest.isEmpty() && received.digest == d->validators.digest) {
+        Q_EMIT documentUnchanged();
+        Q_EMIT dataRetrieved(QByteArray(), false);
+        return;
+    }
+
+    Q_EMIT validatorsReceived(received);
+    Q_EMIT dataRetrieved(d->buffer, true);
+}
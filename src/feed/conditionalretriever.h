@@ -0,0 +1,86 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef AKREGATOR_CONDITIONALRETRIEVER_H
+#define AKREGATOR_CONDITIONALRETRIEVER_H
+
+#include "akregator_export.h"
+#include "feedstorage.h"
+
+#include <Syndication/DataRetriever>
+
+class KJob;
+
+namespace KIO {
+class Job;
+}
+
+namespace Akregator {
+/** Downloads a feed document with a conditional request, sending the ETag and Last-Modified
+    validators of the last merged document. When the server answers 304 Not Modified, or sends a
+    document with the same digest as before, documentUnchanged() is emitted and the retrieval is
+    reported as failed, so Syndication::Loader does not parse the document at all.
+
+    Like Syndication::FileRetriever, it goes through the KIO HTTP cache unless setUseCache(false) was called.
+    A document served from the cache has the digest of the last fetch and is reported as unchanged, too. */
+class AKREGATOR_EXPORT ConditionalRetriever : public Syndication::DataRetriever
+{
+    Q_OBJECT
+public:
+
+    explicit ConditionalRetriever(const Backend::FetchValidators &validators);
+    ~ConditionalRetriever();
+
+    void retrieveData(const QUrl &url) override;
+
+    /** returns the KIO error code of the last retrieval */
+    int errorCode() const override;
+
+    void abort() override;
+
+    static void setUserAgent(const QString &userAgent);
+
+    /** sets whether the KIO HTTP cache is used, see the "Use HTML Cache" setting. Enabled by default */
+    static void setUseCache(bool useCache);
+
+Q_SIGNALS:
+
+    /** emitted before dataRetrieved() when the document did not change since the last fetch */
+    void documentUnchanged();
+
+    /** emitted before dataRetrieved() with the validators of a changed document. Store them
+        once the document was merged, so the next fetch can be skipped if it is unchanged */
+    void validatorsReceived(const Akregator::Backend::FetchValidators &validators);
+
+private Q_SLOTS:
+
+    void slotData(KIO::Job *job, const QByteArray &data);
+    void slotResult(KJob *job);
+
+private:
+
+    class Private;
+    Private *const d;
+};
+} // namespace Akregator
+
+#endif // AKREGATOR_CONDITIONALRETRIEVER_H
@@ -28,10 +28,14 @@
 #include "akregatorconfig.h"
 #include "article.h"
 #include "articlejobs.h"
+#include "articlemetadatacache.h"
+#include "conditionalretriever.h"
+#include "feeddiffjob.h"
 #include "feedstorage.h"
 #include "fetchqueue.h"
 #include "folder.h"
 #include "notificationmanager.h"
+#include "startupprofile.h"
 #include "storage.h"
 #include "treenodevisitor.h"
 #include "types.h"
@@ -48,12 +52,14 @@
 #include <KRandom>
 
 #include <QDateTime>
-#include <QDomDocument>
-#include <QDomElement>
 #include <QHash>
 #include <QList>
+#include <QMultiMap>
 #include <QPixmap>
+#include <QThreadPool>
 #include <QTimer>
+#include <QXmlStreamAttributes>
+#include <QXmlStreamWriter>
 
 #include <memory>
 #include <QStandardPaths>
@@ -94,6 +100,12 @@ public:
     int fetchTries;
     bool followDiscovery;
     Syndication::Loader *loader;
+    /** computes the article changes of the last fetch, 0 if none is pending */
+    FeedDiffJob *diffJob;
+    /** set when the running fetch found the document unchanged since the last merge */
+    bool documentUnchanged;
+    /** validators of the fetched document, stored once it was merged */
+    Backend::FetchValidators fetchedValidators;
     bool articlesLoaded;
     Backend::FeedStorage *archive;
 
@@ -104,6 +116,10 @@ public:
     /** list of feed articles */
     QHash<QString, Article> articles;
 
+    /** the articles, by publication date (time_t), oldest first. Kept in sync with
+        articles, so that expiry and the article limit need neither scan nor sort them */
+    QMultiMap<uint, Article> articlesByPubDate;
+
     /** list of deleted articles. This contains **/
     QVector<Article> deletedArticles;
 
@@ -121,8 +137,93 @@ public:
     {
         totalCount = -1;
     }
+
+    /** articles are read from the archive on first use, not when the feed list is loaded */
+    void ensureArticlesLoaded() const
+    {
+        if (!articlesLoaded) {
+            q->loadArticles();
+        }
+    }
+
+    /** adds @p article to the article list and the pubDate index */
+    void insertArticle(const Article &article);
+    /** removes @p article from the article list and the pubDate index */
+    void removeArticle(const Article &article);
+
+    /** returns the age in seconds after which articles expire, -1 if they do not */
+    int expiryAge() const;
+
+    /** marks the articles published before @p cutoff deleted in the archive, without loading
+        the articles. Used while the feed is not loaded.
+        @return whether an article was expired */
+    bool expireArchivedArticles(uint cutoff, bool useKeep);
 };
 
+void Akregator::Feed::Private::insertArticle(const Article &article)
+{
+    const Article old = articles.value(article.guid());
+    if (!old.isNull()) {
+        articlesByPubDate.remove(old.pubDate().toTime_t(), old);
+    }
+    articles.insert(article.guid(), article);
+    articlesByPubDate.insert(article.pubDate().toTime_t(), article);
+}
+
+void Akregator::Feed::Private::removeArticle(const Article &article)
+{
+    articles.remove(article.guid());
+    articlesByPubDate.remove(article.pubDate().toTime_t(), article);
+}
+
+int Akregator::Feed::Private::expiryAge() const
+{
+    // check whether the feed uses the global default and the default is limitArticleAge
+    if (archiveMode == globalDefault && Settings::archiveMode() == Settings::EnumArchiveMode::limitArticleAge) {
+        return Settings::maxArticleAge() * 24 * 3600;
+    }
+    // otherwise check if this feed has limitArticleAge set
+    if (archiveMode == limitArticleAge) {
+        return maxArticleAge * 24 * 3600;
+    }
+    return -1;
+}
+
+bool Akregator::Feed::Private::expireArchivedArticles(uint cutoff, bool useKeep)
+{
+    typedef Backend::FeedStorage::ArticleRecord ArticleRecord;
+    Backend::FeedStorage *const feedArchive = storage->archiveFor(xmlUrl);
+    const QStringList expired = feedArchive->articlesPublishedBefore(cutoff);
+    if (expired.isEmpty()) {
+        return false;
+    }
+
+    int unread = feedArchive->unread();
+    bool expiredAny = false;
+    ArticleRecord record;
+    for (const QString &guid : expired) {
+        if (!feedArchive->readRecord(guid, record, ArticleRecord::Status)) {
+            continue;
+        }
+        if (useKeep && (record.status & Backend::FeedStorage::KeepFlag)) {
+            continue;
+        }
+        if (!(record.status & Backend::FeedStorage::ReadFlag)) {
+            --unread;
+        }
+        // the same tombstone Article::setDeleted() leaves
+        feedArchive->setStatus(guid, Backend::FeedStorage::DeletedFlag | Backend::FeedStorage::ReadFlag);
+        feedArchive->setDeleted(guid);
+        ArticleMetadataCache::self()->invalidate(feedArchive, guid);
+        expiredAny = true;
+    }
+
+    if (expiredAny) {
+        feedArchive->setUnread(unread);
+    }
+    return expiredAny;
+}
+
 QString Akregator::Feed::archiveModeToString(ArchiveMode mode)
 {
     switch (mode) {
@@ -140,31 +241,31 @@ QString Akregator::Feed::archiveModeToString(ArchiveMode mode)
     return QStringLiteral("globalDefault");
 }
 
-Akregator::Feed *Akregator::Feed::fromOPML(QDomElement e, Backend::Storage *storage)
+Akregator::Feed *Akregator::Feed::fromOPML(const QXmlStreamAttributes &attributes, Backend::Storage *storage)
 {
-    if (!e.hasAttribute(QStringLiteral("xmlUrl")) && !e.hasAttribute(QStringLiteral("xmlurl")) && !e.hasAttribute(QStringLiteral("xmlURL"))) {
+    if (!attributes.hasAttribute(QLatin1String("xmlUrl")) && !attributes.hasAttribute(QLatin1String("xmlurl")) && !attributes.hasAttribute(QLatin1String("xmlURL"))) {
         return nullptr;
     }
 
-    QString title = e.hasAttribute(QStringLiteral("text")) ? e.attribute(QStringLiteral("text")) : e.attribute(QStringLiteral("title"));
+    QString title = (attributes.hasAttribute(QLatin1String("text")) ? attributes.value(QLatin1String("text")) : attributes.value(QLatin1String("title"))).toString();
 
-    QString xmlUrl = e.hasAttribute(QStringLiteral("xmlUrl")) ? e.attribute(QStringLiteral("xmlUrl")) : e.attribute(QStringLiteral("xmlurl"));
+    QString xmlUrl = (attributes.hasAttribute(QLatin1String("xmlUrl")) ? attributes.value(QLatin1String("xmlUrl")) : attributes.value(QLatin1String("xmlurl"))).toString();
     if (xmlUrl.isEmpty()) {
-        xmlUrl = e.attribute(QStringLiteral("xmlURL"));
+        xmlUrl = attributes.value(QLatin1String("xmlURL")).toString();
     }
 
-    bool useCustomFetchInterval = e.attribute(QStringLiteral("useCustomFetchInterval")) == QLatin1String("true");
+    bool useCustomFetchInterval = attributes.value(QLatin1String("useCustomFetchInterval")) == QLatin1String("true");
 
-    QString htmlUrl = e.attribute(QStringLiteral("htmlUrl"));
-    QString description = e.attribute(QStringLiteral("description"));
-    int fetchInterval = e.attribute(QStringLiteral("fetchInterval")).toInt();
-    ArchiveMode archiveMode = stringToArchiveMode(e.attribute(QStringLiteral("archiveMode")));
-    int maxArticleAge = e.attribute(QStringLiteral("maxArticleAge")).toUInt();
-    int maxArticleNumber = e.attribute(QStringLiteral("maxArticleNumber")).toUInt();
-    bool markImmediatelyAsRead = e.attribute(QStringLiteral("markImmediatelyAsRead")) == QLatin1String("true");
-    bool useNotification = e.attribute(QStringLiteral("useNotification")) == QLatin1String("true");
-    bool loadLinkedWebsite = e.attribute(QStringLiteral("loadLinkedWebsite")) == QLatin1String("true");
-    uint id = e.attribute(QStringLiteral("id")).toUInt();
+    QString htmlUrl = attributes.value(QLatin1String("htmlUrl")).toString();
+    QString description = attributes.value(QLatin1String("description")).toString();
+    int fetchInterval = attributes.value(QLatin1String("fetchInterval")).toInt();
+    ArchiveMode archiveMode = stringToArchiveMode(attributes.value(QLatin1String("archiveMode")).toString());
+    int maxArticleAge = attributes.value(QLatin1String("maxArticleAge")).toUInt();
+    int maxArticleNumber = attributes.value(QLatin1String("maxArticleNumber")).toUInt();
+    bool markImmediatelyAsRead = attributes.value(QLatin1String("markImmediatelyAsRead")) == QLatin1String("true");
+    bool useNotification = attributes.value(QLatin1String("useNotification")) == QLatin1String("true");
+    bool loadLinkedWebsite = attributes.value(QLatin1String("loadLinkedWebsite")) == QLatin1String("true");
+    uint id = attributes.value(QLatin1String("id")).toUInt();
 
     Feed *const feed = new Feed(storage);
     feed->setTitle(title);
@@ -180,7 +281,6 @@ Akregator::Feed *Akregator::Feed::fromOPML(QDomElement e, Backend::Storage *stor
     feed->setMaxArticleNumber(maxArticleNumber);
     feed->setMarkImmediatelyAsRead(markImmediatelyAsRead);
     feed->setLoadLinkedWebsite(loadLinkedWebsite);
-    feed->loadArticles(); // TODO: make me fly: make this delayed
 
     return feed;
 }
@@ -220,14 +320,13 @@ QVector<Akregator::Feed *> Akregator::Feed::feeds()
 
 Article Akregator::Feed::findArticle(const QString &guid) const
 {
+    d->ensureArticlesLoaded();
     return d->articles.value(guid);
 }
 
 QVector<Article> Akregator::Feed::articles()
 {
-    if (!d->articlesLoaded) {
-        loadArticles();
-    }
+    d->ensureArticlesLoaded();
     return valuesToVector(d->articles);
 }
 
@@ -242,22 +341,41 @@ void Akregator::Feed::loadArticles()
         return;
     }
 
+    // the count kept in the archive index, shown until now
+    const int storedTotal = totalCount();
+
     if (!d->archive && d->storage) {
+        StartupProfile::Scope scope(StartupProfile::ArchiveOpen);
         d->archive = d->storage->archiveFor(xmlUrl());
     }
 
-    QStringList list = d->archive->articles();
-    for (QStringList::ConstIterator it = list.constBegin(); it != list.constEnd(); ++it) {
-        Article mya(*it, this);
-        d->articles[mya.guid()] = mya;
-        if (mya.isDeleted()) {
-            d->deletedArticles.append(mya);
+    {
+        StartupProfile::Scope scope(StartupProfile::ArticleLoad);
+        QStringList list = d->archive->articles();
+        for (QStringList::ConstIterator it = list.constBegin(); it != list.constEnd(); ++it) {
+            Article mya(*it, this);
+            d->insertArticle(mya);
+            if (mya.isDeleted()) {
+                d->deletedArticles.append(mya);
+            }
         }
+        scope.setItems(list.count());
     }
 
     d->articlesLoaded = true;
     enforceLimitArticleNumber();
+
+    StartupProfile::Scope scope(StartupProfile::UnreadRecount);
     recalcUnreadCount();
+
+    // archives written before deleted articles were left out of the index count need a correction
+    const int total = totalCount();
+    if (total != storedTotal) {
+        if (d->storage) {
+            d->storage->setTotalCountFor(d->xmlUrl, total);
+        }
+        nodeModified();
+    }
 }
 
 void Akregator::Feed::recalcUnreadCount()
@@ -315,6 +433,8 @@ Akregator::Feed::Private::Private(Backend::Storage *storage_, Akregator::Feed *q
     , fetchTries(0)
     , followDiscovery(false)
     , loader(0)
+    , diffJob(0)
+    , documentUnchanged(false)
     , articlesLoaded(false)
     , archive(0)
     , totalCount(-1)
@@ -353,7 +473,10 @@ bool Akregator::Feed::useCustomFetchInterval() const
 
 void Akregator::Feed::setCustomFetchIntervalEnabled(bool enabled)
 {
-    d->autoFetch = enabled;
+    if (d->autoFetch != enabled) {
+        d->autoFetch = enabled;
+        propertiesModified();
+    }
 }
 
 int Akregator::Feed::fetchInterval() const
@@ -363,7 +486,10 @@ int Akregator::Feed::fetchInterval() const
 
 void Akregator::Feed::setFetchInterval(int interval)
 {
-    d->fetchInterval = interval;
+    if (d->fetchInterval != interval) {
+        d->fetchInterval = interval;
+        propertiesModified();
+    }
 }
 
 int Akregator::Feed::maxArticleAge() const
@@ -373,7 +499,10 @@ int Akregator::Feed::maxArticleAge() const
 
 void Akregator::Feed::setMaxArticleAge(int maxArticleAge)
 {
-    d->maxArticleAge = maxArticleAge;
+    if (d->maxArticleAge != maxArticleAge) {
+        d->maxArticleAge = maxArticleAge;
+        propertiesModified();
+    }
 }
 
 int Akregator::Feed::maxArticleNumber() const
@@ -383,7 +512,10 @@ int Akregator::Feed::maxArticleNumber() const
 
 void Akregator::Feed::setMaxArticleNumber(int maxArticleNumber)
 {
-    d->maxArticleNumber = maxArticleNumber;
+    if (d->maxArticleNumber != maxArticleNumber) {
+        d->maxArticleNumber = maxArticleNumber;
+        propertiesModified();
+    }
 }
 
 bool Akregator::Feed::markImmediatelyAsRead() const
@@ -393,12 +525,15 @@ bool Akregator::Feed::markImmediatelyAsRead() const
 
 bool Akregator::Feed::isFetching() const
 {
-    return d->loader != 0;
+    return d->loader != 0 || d->diffJob != 0;
 }
 
 void Akregator::Feed::setMarkImmediatelyAsRead(bool enabled)
 {
-    d->markImmediatelyAsRead = enabled;
+    if (d->markImmediatelyAsRead != enabled) {
+        d->markImmediatelyAsRead = enabled;
+        propertiesModified();
+    }
     if (enabled) {
         createMarkAsReadJob()->start();
     }
@@ -406,7 +541,10 @@ void Akregator::Feed::setMarkImmediatelyAsRead(bool enabled)
 
 void Akregator::Feed::setUseNotification(bool enabled)
 {
-    d->useNotification = enabled;
+    if (d->useNotification != enabled) {
+        d->useNotification = enabled;
+        propertiesModified();
+    }
 }
 
 bool Akregator::Feed::useNotification() const
@@ -416,7 +554,10 @@ bool Akregator::Feed::useNotification() const
 
 void Akregator::Feed::setLoadLinkedWebsite(bool enabled)
 {
-    d->loadLinkedWebsite = enabled;
+    if (d->loadLinkedWebsite != enabled) {
+        d->loadLinkedWebsite = enabled;
+        propertiesModified();
+    }
 }
 
 bool Akregator::Feed::loadLinkedWebsite() const
@@ -436,7 +577,10 @@ QString Akregator::Feed::xmlUrl() const
 
 void Akregator::Feed::setXmlUrl(const QString &s)
 {
-    d->xmlUrl = s;
+    if (d->xmlUrl != s) {
+        d->xmlUrl = s;
+        propertiesModified();
+    }
     if (!Settings::fetchOnStartup()) {
         QTimer::singleShot(KRandom::random() % 4000, this, &Feed::slotAddFeedIconListener);    // TODO: let's give a gui some time to show up before starting the fetch when no fetch on startup is used. replace this with something proper later...
     }
@@ -449,7 +593,10 @@ QString Akregator::Feed::htmlUrl() const
 
 void Akregator::Feed::setHtmlUrl(const QString &s)
 {
-    d->htmlUrl = s;
+    if (d->htmlUrl != s) {
+        d->htmlUrl = s;
+        propertiesModified();
+    }
 }
 
 QString Akregator::Feed::description() const
@@ -459,7 +606,10 @@ QString Akregator::Feed::description() const
 
 void Akregator::Feed::setDescription(const QString &s)
 {
-    d->description = s;
+    if (d->description != s) {
+        d->description = s;
+        propertiesModified();
+    }
 }
 
 bool Akregator::Feed::fetchErrorOccurred() const
@@ -477,41 +627,44 @@ bool Akregator::Feed::isArticlesLoaded() const
     return d->articlesLoaded;
 }
 
-QDomElement Akregator::Feed::toOPML(QDomElement parent, QDomDocument document) const
-{
-    QDomElement el = document.createElement(QStringLiteral("outline"));
-    el.setAttribute(QStringLiteral("text"), title());
-    el.setAttribute(QStringLiteral("title"), title());
-    el.setAttribute(QStringLiteral("xmlUrl"), d->xmlUrl);
-    el.setAttribute(QStringLiteral("htmlUrl"), d->htmlUrl);
-    el.setAttribute(QStringLiteral("id"), QString::number(id()));
-    el.setAttribute(QStringLiteral("description"), d->description);
-    el.setAttribute(QStringLiteral("useCustomFetchInterval"), (useCustomFetchInterval() ? QStringLiteral("true") : QStringLiteral("false")));
-    el.setAttribute(QStringLiteral("fetchInterval"), QString::number(fetchInterval()));
-    el.setAttribute(QStringLiteral("archiveMode"), archiveModeToString(d->archiveMode));
-    el.setAttribute(QStringLiteral("maxArticleAge"), d->maxArticleAge);
-    el.setAttribute(QStringLiteral("maxArticleNumber"), d->maxArticleNumber);
+void Akregator::Feed::toOPML(QXmlStreamWriter &writer) const
+{
+    writer.writeStartElement(QStringLiteral("outline"));
+    writer.writeAttribute(QStringLiteral("text"), title());
+    writer.writeAttribute(QStringLiteral("title"), title());
+    writer.writeAttribute(QStringLiteral("xmlUrl"), d->xmlUrl);
+    writer.writeAttribute(QStringLiteral("htmlUrl"), d->htmlUrl);
+    writer.writeAttribute(QStringLiteral("id"), QString::number(id()));
+    writer.writeAttribute(QStringLiteral("description"), d->description);
+    writer.writeAttribute(QStringLiteral("useCustomFetchInterval"), (useCustomFetchInterval() ? QStringLiteral("true") : QStringLiteral("false")));
+    writer.writeAttribute(QStringLiteral("fetchInterval"), QString::number(fetchInterval()));
+    writer.writeAttribute(QStringLiteral("archiveMode"), archiveModeToString(d->archiveMode));
+    writer.writeAttribute(QStringLiteral("maxArticleAge"), QString::number(d->maxArticleAge));
+    writer.writeAttribute(QStringLiteral("maxArticleNumber"), QString::number(d->maxArticleNumber));
     if (d->markImmediatelyAsRead) {
-        el.setAttribute(QStringLiteral("markImmediatelyAsRead"), QStringLiteral("true"));
+        writer.writeAttribute(QStringLiteral("markImmediatelyAsRead"), QStringLiteral("true"));
     }
     if (d->useNotification) {
-        el.setAttribute(QStringLiteral("useNotification"), QStringLiteral("true"));
+        writer.writeAttribute(QStringLiteral("useNotification"), QStringLiteral("true"));
     }
     if (d->loadLinkedWebsite) {
-        el.setAttribute(QStringLiteral("loadLinkedWebsite"), QStringLiteral("true"));
+        writer.writeAttribute(QStringLiteral("loadLinkedWebsite"), QStringLiteral("true"));
     }
-    el.setAttribute(QStringLiteral("maxArticleNumber"), d->maxArticleNumber);
-    el.setAttribute(QStringLiteral("type"), QStringLiteral("rss"));   // despite some additional fields, it is still "rss" OPML
-    el.setAttribute(QStringLiteral("version"), QStringLiteral("RSS"));
-    parent.appendChild(el);
-    return el;
+    writer.writeAttribute(QStringLiteral("type"), QStringLiteral("rss"));   // despite some additional fields, it is still "rss" OPML
+    writer.writeAttribute(QStringLiteral("version"), QStringLiteral("RSS"));
+    writer.writeEndElement();
 }
 
 KJob *Akregator::Feed::createMarkAsReadJob()
 {
     ArticleModifyJob *job = new ArticleModifyJob;
+    const QString url = xmlUrl();
     Q_FOREACH (const Article &i, articles()) {
-        const ArticleId aid = { xmlUrl(), i.guid() };
+        // deleted articles are read as well
+        if (i.status() == Read) {
+            continue;
+        }
+        const ArticleId aid = { url, i.guid() };
         job->setStatus(aid, Read);
     }
     return job;
@@ -530,12 +683,13 @@ void Akregator::Feed::slotAddToFetchQueue(FetchQueue *queue, bool intervalFetchO
             interval = Settings::autoFetchInterval() * 60;
         }
 
-        uint lastFetch = d->archive->lastFetch();
+        // read from the archive index, so checking the interval does not load the articles
+        uint lastFetch = d->archive ? d->archive->lastFetch() : d->storage ? d->storage->lastFetchFor(d->xmlUrl) : 0;
 
         uint now = QDateTime::currentDateTimeUtc().toTime_t();
 
         if (interval > 0 && now - lastFetch >= (uint)interval) {
-            queue->addFeed(this);
+            queue->addFeed(this, true);
         }
     }
 }
@@ -545,77 +699,89 @@ void Akregator::Feed::slotAddFeedIconListener()
     loadFavicon(QUrl(d->xmlUrl));
 }
 
-void Akregator::Feed::appendArticles(const Syndication::FeedPtr &feed)
+void Akregator::Feed::appendArticles(const FeedDiff &diff)
 {
     d->setTotalCountDirty();
     bool changed = false;
     const bool notify = useNotification() || Settings::useNotifications();
 
-    QList<ItemPtr> items = feed->items();
-    QList<ItemPtr>::ConstIterator it = items.constBegin();
-    QList<ItemPtr>::ConstIterator en = items.constEnd();
+    // collect the signals of the whole batch and emit them once at the end
+    setNotificationMode(false);
 
-    int nudge = 0;
+    // the diff was computed from a snapshot, so check it against the current list.
+    // For modified items, the article object is kept at the same index in updatedArticles,
+    // for new ones it is null
+    QVector<Backend::FeedStorage::ItemRecord> records;
+    QVector<Article> updatedArticles;
+    records.reserve(diff.added.count() + diff.updated.count());
+    updatedArticles.reserve(diff.added.count() + diff.updated.count());
+
+    for (const Backend::FeedStorage::ItemRecord &record : diff.added) {
+        if (!d->articles.contains(record.guid)) {
+            records.append(record);
+            updatedArticles.append(Article());
+        }
+    }
 
-    QVector<Article> deletedArticles = d->deletedArticles;
+    for (const Backend::FeedStorage::ItemRecord &record : diff.updated) {
+        const Article old = d->articles.value(record.guid);
+        // the article's guid is no hash but an ID, so it was updated if the hash values differ
+        if (!old.isNull() && !old.isDeleted() && old.hash() != record.record.hash && !old.guidIsHash()) {
+            records.append(record);
+            updatedArticles.append(old);
+        }
+    }
 
-    for (; it != en; ++it) {
-        if (!d->articles.contains((*it)->id())) { // article not in list
-            Article mya(*it, this);
-            mya.offsetPubDate(nudge);
-            nudge--;
+    const QVector<Backend::FeedStorage::IngestResult> results = d->archive->ingest(records);
+
+    for (int i = 0; i < records.count(); ++i) {
+        const Backend::FeedStorage::ItemRecord &record = records.at(i);
+        Article mya = updatedArticles.at(i);
+        if (mya.isNull()) {
+            if (results.at(i) == Backend::FeedStorage::Inserted) {
+                mya = Article(record.guid, this, record.record);
+            } else { // archived, but not in the list (e.g. expired)
+                if (results.at(i) == Backend::FeedStorage::Updated) {
+                    ArticleMetadataCache::self()->invalidate(d->archive, record.guid);
+                }
+                mya = Article(record.guid, this);
+            }
             appendArticle(mya);
-            d->addedArticlesNotify.append(mya);
-
-            if (!mya.isDeleted() && !markImmediatelyAsRead()) {
-                mya.setStatus(New);
-            } else {
-                mya.setStatus(Read);
+            if (!d->articles.contains(record.guid)) {
+                continue;
             }
+            d->addedArticlesNotify.append(mya);
             if (notify) {
                 NotificationManager::self()->slotNotifyArticle(mya);
             }
             changed = true;
-        } else { // article is in list
-            // if the article's guid is no hash but an ID, we have to check if the article was updated. That's done by comparing the hash values.
-            Article old = d->articles[(*it)->id()];
-            Article mya(*it, this);
-            if (!mya.guidIsHash() && mya.hash() != old.hash() && !old.isDeleted()) {
-                mya.setKeep(old.keep());
-                int oldstatus = old.status();
-                old.setStatus(Read);
-
-                d->articles.remove(old.guid());
-                appendArticle(mya);
-
-                mya.setStatus(oldstatus);
-
-                d->updatedArticlesNotify.append(mya);
-                changed = true;
-            } else if (old.isDeleted()) {
-                deletedArticles.removeAll(mya);
-            }
+        } else if (results.at(i) == Backend::FeedStorage::Updated) {
+            mya.setHash(record.record.hash);
+            ArticleMetadataCache::self()->invalidate(d->archive, record.guid);
+            d->updatedArticlesNotify.append(mya);
+            changed = true;
         }
     }
 
-    QVector<Article>::ConstIterator dit = deletedArticles.constBegin();
-    QVector<Article>::ConstIterator dtmp;
-    QVector<Article>::ConstIterator den = deletedArticles.constEnd();
-
     // delete articles with delete flag set completely from archive, which aren't in the current feed source anymore
-    while (dit != den) {
-        dtmp = dit;
-        ++dit;
-        d->articles.remove((*dtmp).guid());
-        d->archive->deleteArticle((*dtmp).guid());
-        d->removedArticlesNotify.append(*dtmp);
+    for (const QString &guid : diff.purged) {
+        const Article old = d->articles.value(guid);
+        if (old.isNull() || !old.isDeleted()) {
+            continue;
+        }
+        d->removeArticle(old);
+        d->archive->deleteArticle(guid);
+        ArticleMetadataCache::self()->invalidate(d->archive, guid);
+        d->removedArticlesNotify.append(old);
         changed = true;
-        d->deletedArticles.removeAll(*dtmp);
+        d->deletedArticles.removeAll(old);
     }
 
     if (changed) {
         articlesModified();
+        nodeModified(); // total count changed
     }
+    setNotificationMode(true);
 }
 
 bool Akregator::Feed::usesExpiryByAge() const
@@ -625,24 +791,15 @@ bool Akregator::Feed::usesExpiryByAge() const
 
 bool Akregator::Feed::isExpired(const Article &a) const
 {
-    QDateTime now = QDateTime::currentDateTime();
-    int expiryAge = -1;
-// check whether the feed uses the global default and the default is limitArticleAge
-    if (d->archiveMode == globalDefault && Settings::archiveMode() == Settings::EnumArchiveMode::limitArticleAge) {
-        expiryAge = Settings::maxArticleAge() * 24 * 3600;
-    } else // otherwise check if this feed has limitArticleAge set
-    if (d->archiveMode == limitArticleAge) {
-        expiryAge = d->maxArticleAge * 24 * 3600;
-    }
-
-    return expiryAge != -1 && a.pubDate().secsTo(now) > expiryAge;
+    const int expiryAge = d->expiryAge();
+    return expiryAge != -1 && a.pubDate().secsTo(QDateTime::currentDateTime()) > expiryAge;
 }
 
 void Akregator::Feed::appendArticle(const Article &a)
 {
     if ((a.keep() && Settings::doNotExpireImportantArticles()) || (!usesExpiryByAge() || !isExpired(a))) {   // if not expired
         if (!d->articles.contains(a.guid())) {
-            d->articles[a.guid()] = a;
+            d->insertArticle(a);
             if (!a.isDeleted() && a.status() != Read) {
                 setUnread(unread() + 1);
             }
@@ -671,17 +828,37 @@ void Akregator::Feed::slotAbortFetch()
 {
     if (d->loader) {
         d->loader->abort();
+    } else if (d->diffJob) {
+        // the job cannot be stopped, just ignore its result
+        d->diffJob = 0;
+        Q_EMIT fetchAborted(this);
     }
 }
 
 void Akregator::Feed::tryFetch()
 {
     d->fetchErrorCode = Syndication::Success;
+    d->documentUnchanged = false;
+    d->fetchedValidators = Backend::FetchValidators();
 
     d->loader = Syndication::Loader::create(this, SLOT(fetchCompleted(Syndication::Loader *,
                                                                       Syndication::FeedPtr,
                                                                       Syndication::ErrorCode)));
-    d->loader->loadFrom(QUrl(d->xmlUrl));
+    if (!Settings::useConditionalFetching()) {
+        d->loader->loadFrom(QUrl(d->xmlUrl));
+        return;
+    }
+
+    // the stored validators belong to the subscribed URL, not to a discovered one
+    const Backend::FetchValidators validators = d->storage && d->fetchTries == 0 ? d->storage->fetchValidatorsFor(d->xmlUrl) : Backend::FetchValidators();
+    ConditionalRetriever *retriever = new ConditionalRetriever(validators);
+    connect(retriever, &ConditionalRetriever::documentUnchanged, this, [this]() {
+        d->documentUnchanged = true;
+    });
+    connect(retriever, &ConditionalRetriever::validatorsReceived, this, [this](const Backend::FetchValidators &received) {
+        d->fetchedValidators = received;
+    });
+    d->loader->loadFrom(QUrl(d->xmlUrl), retriever);
 }
 
 void Akregator::Feed::slotImageFetched(const QPixmap &image)
@@ -694,6 +871,14 @@ void Akregator::Feed::fetchCompleted(Syndication::Loader *l, Syndication::FeedPt
     // Note that loader instances delete themselves
     d->loader = 0;
 
+    // same document as last time: there is nothing to parse or merge
+    if (d->documentUnchanged && status != Syndication::Aborted) {
+        d->fetchErrorCode = Syndication::Success;
+        markAsFetchedNow();
+        Q_EMIT fetched(this);
+        return;
+    }
+
     // fetching wasn't successful:
     if (status != Syndication::Success) {
         if (status == Syndication::Aborted) {
@@ -712,7 +897,7 @@ void Akregator::Feed::fetchCompleted(Syndication::Loader *l, Syndication::FeedPt
         return;
     }
 
-    loadArticles(); // TODO: make me fly: make this delayed
+    loadArticles();
 
     loadFavicon(QUrl(xmlUrl()));
 
@@ -730,16 +915,46 @@ void Akregator::Feed::fetchCompleted(Syndication::Loader *l, Syndication::FeedPt
     d->description = doc->description();
     d->htmlUrl = doc->link();
 
-    appendArticles(doc);
+    // computing the article changes means stripping HTML and hashing every item,
+    // so do it on a worker thread and only apply the result here
+    FeedSnapshot snapshot;
+    snapshot.hashes.reserve(d->articles.count());
+    for (const Article &article : qAsConst(d->articles)) {
+        if (article.isDeleted()) {
+            snapshot.deleted.insert(article.guid());
+        } else {
+            snapshot.hashes.insert(article.guid(), article.hash());
+        }
+    }
+
+    d->diffJob = new FeedDiffJob(doc, snapshot, markImmediatelyAsRead());
+    connect(d->diffJob, &FeedDiffJob::finished, this, &Feed::slotDiffFinished);
+    QThreadPool::globalInstance()->start(d->diffJob);
+}
+
+void Akregator::Feed::slotDiffFinished(FeedDiffJob *job)
+{
+    if (job != d->diffJob) { // aborted, or superseded by a newer fetch
+        return;
+    }
+    d->diffJob = 0;
 
+    appendArticles(job->diff());
+
+    if (d->archive && !d->fetchedValidators.isEmpty()) {
+        d->archive->setFetchValidators(d->fetchedValidators);
+    }
     markAsFetchedNow();
     Q_EMIT fetched(this);
 }
 
 void Akregator::Feed::markAsFetchedNow()
 {
+    const int now = QDateTime::currentDateTimeUtc().toTime_t();
     if (d->archive) {
-        d->archive->setLastFetch(QDateTime::currentDateTimeUtc().toTime_t());
+        d->archive->setLastFetch(now);
+    } else if (d->storage) {
+        d->storage->setLastFetchFor(d->xmlUrl, now);
     }
 }
 
@@ -752,20 +967,63 @@ QIcon Akregator::Feed::icon() const
     return !d->favicon.isNull() ? d->favicon : QIcon::fromTheme(QStringLiteral("text-html"));
 }
 
+uint Akregator::Feed::purgeDeletedArticlesBefore() const
+{
+    // the feed may still list older articles, which it would add again without the deleted ones.
+    // Expiry by age deletes them again right away, so only then the deleted articles can go
+    if (!usesExpiryByAge()) {
+        return 0;
+    }
+    const uint now = QDateTime::currentDateTime().toTime_t();
+    const uint expiryAge = d->expiryAge();
+    return now > expiryAge ? now - expiryAge : 0;
+}
+
+void Akregator::Feed::forgetPurgedArticles()
+{
+    if (!d->articlesLoaded || !d->archive) {
+        return;
+    }
+    for (int i = d->deletedArticles.count() - 1; i >= 0; --i) {
+        const Article article = d->deletedArticles.at(i);
+        if (!d->archive->contains(article.guid())) {
+            d->removeArticle(article);
+            d->deletedArticles.remove(i);
+        }
+    }
+}
+
 void Akregator::Feed::deleteExpiredArticles(ArticleDeleteJob *deleteJob)
 {
     if (!usesExpiryByAge()) {
         return;
     }
 
+    const bool useKeep = Settings::doNotExpireImportantArticles();
+
+    // articles published before the cutoff are expired
+    const uint now = QDateTime::currentDateTime().toTime_t();
+    const uint expiryAge = d->expiryAge();
+    const uint cutoff = now > expiryAge ? now - expiryAge : 0;
+
+    if (!d->articlesLoaded) {
+        // no need to load the feed, the archive finds the expired articles by date
+        if (d->storage && d->expireArchivedArticles(cutoff, useKeep)) {
+            nodeModified();
+        }
+        return;
+    }
+
     setNotificationMode(false);
 
     QList<ArticleId> toDelete;
     const QString feedUrl = xmlUrl();
-    const bool useKeep = Settings::doNotExpireImportantArticles();
 
-    for (const Article &i : qAsConst(d->articles)) {
-        if ((!useKeep || !i.keep()) && isExpired(i)) {
+    // the expired articles come first in the index
+    const QMultiMap<uint, Article> &index = d->articlesByPubDate;
+    for (auto it = index.constBegin(), end = index.lowerBound(cutoff); it != end; ++it) {
+        const Article &i = it.value();
+        if (!i.isDeleted() && (!useKeep || !i.keep())) {
             const ArticleId aid = { feedUrl, i.guid() };
             toDelete.append(aid);
         }
@@ -801,12 +1059,19 @@ Akregator::Feed::ArchiveMode Akregator::Feed::archiveMode() const
 
 void Akregator::Feed::setArchiveMode(ArchiveMode archiveMode)
 {
-    d->archiveMode = archiveMode;
+    if (d->archiveMode != archiveMode) {
+        d->archiveMode = archiveMode;
+        propertiesModified();
+    }
 }
 
 int Akregator::Feed::unread() const
 {
-    return d->archive ? d->archive->unread() : 0;
+    // the archive index keeps the count, no need to open the archive of the feed
+    if (d->archive) {
+        return d->archive->unread();
+    }
+    return d->storage ? d->storage->unreadFor(d->xmlUrl) : 0;
 }
 
 void Akregator::Feed::setUnread(int unread)
@@ -820,6 +1085,8 @@ void Akregator::Feed::setUnread(int unread)
 void Akregator::Feed::setArticleDeleted(Article &a)
 {
     d->setTotalCountDirty();
+    // the total count is shown, and summed up by the parent folders
+    nodeModified();
     if (!d->deletedArticles.contains(a)) {
         d->deletedArticles.append(a);
     }
@@ -844,6 +1111,9 @@ void Akregator::Feed::setArticleChanged(Article &a, int oldStatus)
 
 int Akregator::Feed::totalCount() const
 {
+    if (!d->articlesLoaded) {
+        return d->storage ? d->storage->totalCountFor(d->xmlUrl) : 0;
+    }
     if (d->totalCount == -1) {
         d->totalCount = std::count_if(d->articles.constBegin(), d->articles.constEnd(), [](const Article &art) -> bool {
             return !art.isDeleted();
@@ -925,18 +1195,20 @@ void Akregator::Feed::enforceLimitArticleNumber()
         return;
     }
 
-    QVector<Article> articles = valuesToVector(d->articles);
-    std::sort(articles.begin(), articles.end());
-
     int c = 0;
     const bool useKeep = Settings::doNotExpireImportantArticles();
 
-    for (Article i : qAsConst(articles)) {
+    // walk the index from the newest article; everything after the first limit articles is deleted
+    const QMultiMap<uint, Article> &index = d->articlesByPubDate;
+    auto it = index.constEnd();
+    while (it != index.constBegin()) {
+        --it;
+        Article i = it.value();
         if (c < limit) {
             if (!i.isDeleted() && (!useKeep || !i.keep())) {
                 ++c;
             }
-        } else if (!useKeep || !i.keep()) {
+        } else if (!i.isDeleted() && (!useKeep || !i.keep())) {
             i.setDeleted();
         }
     }
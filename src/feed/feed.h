@@ -34,12 +34,15 @@
 #include <QIcon>
 #include <QList>
 
-class QDomElement;
 class QString;
+class QXmlStreamAttributes;
+class QXmlStreamWriter;
 
 namespace Akregator {
 class Article;
+class FeedDiffJob;
 class FetchQueue;
+struct FeedDiff;
 class TreeNodeVisitor;
 class ArticleDeleteJob;
 
@@ -73,8 +76,8 @@ public:
     /** converts ArchiveMode values to corresponding strings */
     static QString archiveModeToString(ArchiveMode mode);
 
-    /** creates a Feed object from a description in OPML format */
-    static Feed *fromOPML(QDomElement e, Akregator::Backend::Storage *storage);
+    /** creates a Feed object from the attributes of an OPML outline element */
+    static Feed *fromOPML(const QXmlStreamAttributes &attributes, Akregator::Backend::Storage *storage);
 
     /** default constructor */
     explicit Feed(Akregator::Backend::Storage *storage);
@@ -83,7 +86,7 @@ public:
     bool accept(TreeNodeVisitor *visitor) override;
 
     /** exports the feed settings to OPML */
-    QDomElement toOPML(QDomElement parent, QDomDocument document) const override;
+    void toOPML(QXmlStreamWriter &writer) const override;
 
     /**
         returns whether this feed uses its own fetch interval or the global setting
@@ -209,6 +212,13 @@ public:
     /** deletes expired articles */
     void deleteExpiredArticles(Akregator::ArticleDeleteJob *job);
 
+    /** returns the publication date (as time_t) before which compaction may drop deleted articles from
+        the archive, 0 if it must keep them as the feed does not expire its articles by age */
+    uint purgeDeletedArticlesBefore() const;
+
+    /** forgets the loaded deleted articles that compaction dropped from the archive */
+    void forgetPurgedArticles();
+
     bool isFetching() const;
 
     QVector<const Feed *> feeds() const override;
@@ -271,7 +281,8 @@ private:
         */
     void setArticleChanged(Article &a, int oldStatus = -1);
 
-    void appendArticles(const Syndication::FeedPtr &feed);
+    /** applies the changes computed by a FeedDiffJob to the article list and the archive */
+    void appendArticles(const FeedDiff &diff);
 
     /** appends article @c a to the article list */
     void appendArticle(const Article &a);
@@ -290,6 +301,7 @@ private:
 private Q_SLOTS:
 
     void fetchCompleted(Syndication::Loader *loader, Syndication::FeedPtr doc, Syndication::ErrorCode errorCode);
+    void slotDiffFinished(Akregator::FeedDiffJob *job);
     void slotImageFetched(const QPixmap &image);
 
 private:
@@ -0,0 +1,91 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "feeddiffjob.h"
+#include "article.h"
+
+#include <Syndication/Item>
+
+using namespace Akregator;
+
+FeedDiffJob::FeedDiffJob(const Syndication::FeedPtr &document, const FeedSnapshot &snapshot, bool markAsRead)
+    : QObject(nullptr)
+    , m_document(document)
+    , m_snapshot(snapshot)
+    , m_markAsRead(markAsRead)
+{
+    setAutoDelete(false);
+    connect(this, &FeedDiffJob::finished, this, &QObject::deleteLater);
+}
+
+FeedDiffJob::~FeedDiffJob()
+{
+}
+
+void FeedDiffJob::run()
+{
+    const QList<Syndication::ItemPtr> items = m_document->items();
+    m_diff.added.reserve(items.count());
+
+    QSet<QString> guids;
+    guids.reserve(items.count());
+    int nudge = 0;
+
+    for (const Syndication::ItemPtr &item : items) {
+        const QString guid = item->id();
+        if (guids.contains(guid)) { // the source lists the same article more than once
+            continue;
+        }
+        guids.insert(guid);
+
+        if (m_snapshot.deleted.contains(guid)) {
+            continue;
+        }
+
+        const auto it = m_snapshot.hashes.constFind(guid);
+        if (it == m_snapshot.hashes.constEnd()) { // article not in list
+            Backend::FeedStorage::ItemRecord record = Article::recordForItem(item, m_markAsRead);
+            record.record.pubDate += nudge;
+            nudge--;
+            m_diff.added.append(record);
+        } else if (Article::hashForItem(item) != it.value()) {
+            m_diff.updated.append(Article::recordForItem(item));
+        }
+    }
+
+    // deleted articles which aren't in the current feed source anymore
+    for (const QString &guid : qAsConst(m_snapshot.deleted)) {
+        if (!guids.contains(guid)) {
+            m_diff.purged.append(guid);
+        }
+    }
+
+    // the document is not needed anymore, release it here instead of on the GUI thread
+    m_document.reset();
+
+    Q_EMIT finished(this);
+}
+
+FeedDiff FeedDiffJob::diff() const
+{
+    return m_diff;
+}
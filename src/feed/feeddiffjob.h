@@ -0,0 +1,88 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef AKREGATOR_FEEDDIFFJOB_H
+#define AKREGATOR_FEEDDIFFJOB_H
+
+#include "feedstorage.h"
+
+#include <Syndication/Feed>
+
+#include <QHash>
+#include <QObject>
+#include <QRunnable>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+namespace Akregator {
+/** Plain data describing how a fetched document changes the article list of a feed.
+    Computed by FeedDiffJob, applied on the GUI thread by Feed. Items the document lists more
+    than once occur only once, so the records can be passed to Backend::FeedStorage::ingest() */
+struct FeedDiff {
+    /** items not in the article list, in document order, with nudged publication dates */
+    QVector<Backend::FeedStorage::ItemRecord> added;
+
+    /** items in the article list whose content hash changed */
+    QVector<Backend::FeedStorage::ItemRecord> updated;
+
+    /** guids of deleted articles that are no longer in the document and can be removed from the archive */
+    QStringList purged;
+};
+
+/** The article list of a feed as seen by FeedDiffJob, copied on the GUI thread before the job starts. */
+struct FeedSnapshot {
+    /** hashes of the articles that are not deleted, by guid */
+    QHash<QString, uint> hashes;
+
+    /** guids of the deleted articles */
+    QSet<QString> deleted;
+};
+
+/** Turns a parsed feed document into a FeedDiff on a worker thread. The job does not touch the feed
+    or its archive, it only works on the document and on a snapshot of the article list.
+    Start it with QThreadPool::start(), it deletes itself after finished() was delivered. */
+class FeedDiffJob : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    FeedDiffJob(const Syndication::FeedPtr &document, const FeedSnapshot &snapshot, bool markAsRead);
+    ~FeedDiffJob();
+
+    void run() override;
+
+    /** the result, valid once finished() was emitted */
+    FeedDiff diff() const;
+
+Q_SIGNALS:
+    /** emitted from the worker thread when the diff is complete */
+    void finished(Akregator::FeedDiffJob *job);
+
+private:
+    Syndication::FeedPtr m_document;
+    FeedSnapshot m_snapshot;
+    bool m_markAsRead;
+    FeedDiff m_diff;
+};
+} // namespace Akregator
+
+#endif // AKREGATOR_FEEDDIFFJOB_H
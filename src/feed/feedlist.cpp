@@ -37,10 +37,11 @@
 #include <KLocalizedString>
 #include <krandom.h>
 
-#include <qdom.h>
+#include <QBuffer>
 #include <QHash>
 #include <QSet>
-#include <QTime>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 #include <cassert>
 
@@ -60,6 +61,8 @@ public:
     RemoveNodeVisitor *removeNodeVisitor;
     QHash<QString, QList<Feed *> > urlMap;
     mutable int unreadCache;
+    /** whether the list changed in a way that affects its OPML since the last save */
+    bool modified;
 };
 
 class FeedList::AddNodeVisitor : public TreeNodeVisitor
@@ -105,6 +108,8 @@ public:
 
         connect(node, &TreeNode::signalDestroyed, m_list, &FeedList::slotNodeDestroyed);
         connect(node, &TreeNode::signalChanged, m_list, &FeedList::signalNodeChanged);
+        connect(node, &TreeNode::signalPropertiesChanged, m_list, &FeedList::slotNodePropertiesChanged);
+        m_list->d->modified = true;
         Q_EMIT m_list->signalNodeAdded(node);
 
         return true;
@@ -170,6 +175,7 @@ FeedList::Private::Private(Backend::Storage *st, FeedList *qq)
     , addNodeVisitor(new AddNodeVisitor(q))
     , removeNodeVisitor(new RemoveNodeVisitor(q))
     , unreadCache(-1)
+    , modified(false)
 {
     Q_ASSERT(storage);
 }
@@ -195,11 +201,7 @@ QVector<int> FeedList::feedIds() const
 
 QVector<const Feed *> FeedList::feeds() const
 {
-    QVector<const Feed *> constList;
-    Q_FOREACH (const Feed *const i, d->rootNode->feeds()) {
-        constList.append(i);
-    }
-    return constList;
+    return static_cast<const Folder *>(d->rootNode)->feeds();
 }
 
 QVector<Feed *> FeedList::feeds()
@@ -209,11 +211,7 @@ QVector<Feed *> FeedList::feeds()
 
 QVector<const Folder *> FeedList::folders() const
 {
-    QVector<const Folder *> constList;
-    Q_FOREACH (const Folder *const i, d->rootNode->folders()) {
-        constList.append(i);
-    }
-    return constList;
+    return static_cast<const Folder *>(d->rootNode)->folders();
 }
 
 QVector<Folder *> FeedList::folders()
@@ -231,78 +229,74 @@ void FeedList::removeNode(TreeNode *node)
     d->removeNodeVisitor->visit(node);
 }
 
-void FeedList::parseChildNodes(QDomNode &node, Folder *parent)
+void FeedList::parseChildNodes(QXmlStreamReader &reader, Folder *parent)
 {
-    QDomElement e = node.toElement(); // try to convert the node to an element.
+    while (reader.readNextStartElement()) {
+        const QXmlStreamAttributes attributes = reader.attributes();
 
-    if (!e.isNull()) {
-        //QString title = e.hasAttribute("text") ? e.attribute("text") : e.attribute("title");
-
-        if (e.hasAttribute(QStringLiteral("xmlUrl")) || e.hasAttribute(QStringLiteral("xmlurl")) || e.hasAttribute(QStringLiteral("xmlURL"))) {
-            Feed *feed = Feed::fromOPML(e, d->storage);
+        if (attributes.hasAttribute(QLatin1String("xmlUrl")) || attributes.hasAttribute(QLatin1String("xmlurl")) || attributes.hasAttribute(QLatin1String("xmlURL"))) {
+            Feed *feed = Feed::fromOPML(attributes, d->storage);
             if (feed) {
                 if (!d->urlMap[feed->xmlUrl()].contains(feed)) {
                     d->urlMap[feed->xmlUrl()].append(feed);
                 }
                 parent->appendChild(feed);
             }
+            // feeds have no children, ignore whatever is nested in them
+            reader.skipCurrentElement();
         } else {
-            Folder *fg = Folder::fromOPML(e);
+            Folder *fg = Folder::fromOPML(attributes);
             parent->appendChild(fg);
-
-            if (e.hasChildNodes()) {
-                QDomNode child = e.firstChild();
-                while (!child.isNull()) {
-                    parseChildNodes(child, fg);
-                    child = child.nextSibling();
-                }
-            }
+            parseChildNodes(reader, fg);
         }
     }
 }
 
-bool FeedList::readFromOpml(const QDomDocument &doc)
+bool FeedList::readFromOpml(QXmlStreamReader &reader)
 {
-    QDomElement root = doc.documentElement();
-
-    qCDebug(AKREGATOR_LOG) << "loading OPML feed" << root.tagName().toLower();
+    if (!reader.readNextStartElement()) {
+        return false;
+    }
 
-    qCDebug(AKREGATOR_LOG) << "measuring startup time: START";
-    QTime spent;
-    spent.start();
+    qCDebug(AKREGATOR_LOG) << "loading OPML feed" << reader.name().toString().toLower();
 
-    if (root.tagName().toLower() != QLatin1String("opml")) {
+    if (reader.name().compare(QLatin1String("opml"), Qt::CaseInsensitive) != 0) {
         return false;
     }
-    QDomNode bodyNode = root.firstChild();
 
-    while (!bodyNode.isNull() && bodyNode.toElement().tagName().toLower() != QLatin1String("body")) {
-        bodyNode = bodyNode.nextSibling();
+    bool bodyFound = false;
+    while (reader.readNextStartElement()) {
+        if (!bodyFound && reader.name().compare(QLatin1String("body"), Qt::CaseInsensitive) == 0) {
+            bodyFound = true;
+            parseChildNodes(reader, allFeedsFolder());
+        } else {
+            reader.skipCurrentElement();
+        }
     }
 
-    if (bodyNode.isNull()) {
-        qCDebug(AKREGATOR_LOG) << "Failed to acquire body node, markup broken?";
+    if (reader.hasError()) {
+        qCDebug(AKREGATOR_LOG) << "Failed to parse OPML:" << reader.errorString();
         return false;
     }
 
-    QDomElement body = bodyNode.toElement();
-
-    QDomNode i = body.firstChild();
-
-    while (!i.isNull()) {
-        parseChildNodes(i, allFeedsFolder());
-        i = i.nextSibling();
+    if (!bodyFound) {
+        qCDebug(AKREGATOR_LOG) << "Failed to acquire body node, markup broken?";
+        return false;
     }
 
+    bool idsGenerated = false;
     for (TreeNode *i = allFeedsFolder()->firstChild(); i && i != allFeedsFolder(); i = i->next()) {
         if (i->id() == 0) {
             uint id = generateID();
             i->setId(id);
             d->idMap.insert(id, i);
+            idsGenerated = true;
         }
     }
 
-    qCDebug(AKREGATOR_LOG) << "measuring startup time: STOP," << spent.elapsed() << "ms";
+    // what was just read is what is stored, unless ids had to be assigned
+    d->modified = idsGenerated;
+
     qCDebug(AKREGATOR_LOG) << "Number of articles loaded:" << allFeedsFolder()->totalCount();
     return true;
 }
@@ -360,29 +354,47 @@ void FeedList::append(FeedList *list, Folder *parent, TreeNode *after)
     }
 }
 
-QDomDocument FeedList::toOpml() const
+void FeedList::writeOpml(QXmlStreamWriter &writer) const
 {
-    QDomDocument doc;
-    doc.appendChild(doc.createProcessingInstruction(QStringLiteral("xml"), QStringLiteral("version=\"1.0\" encoding=\"UTF-8\"")));
+    writer.writeStartDocument();
 
-    QDomElement root = doc.createElement(QStringLiteral("opml"));
-    root.setAttribute(QStringLiteral("version"), QStringLiteral("1.0"));
-    doc.appendChild(root);
+    writer.writeStartElement(QStringLiteral("opml"));
+    writer.writeAttribute(QStringLiteral("version"), QStringLiteral("1.0"));
 
-    QDomElement head = doc.createElement(QStringLiteral("head"));
-    root.appendChild(head);
+    writer.writeStartElement(QStringLiteral("head"));
+    writer.writeEmptyElement(QStringLiteral("text"));
+    writer.writeEndElement();
 
-    QDomElement ti = doc.createElement(QStringLiteral("text"));
-    head.appendChild(ti);
+    writer.writeStartElement(QStringLiteral("body"));
+    for (const TreeNode *i = allFeedsFolder()->firstChild(); i; i = i->nextSibling()) {
+        i->toOPML(writer);
+    }
+    writer.writeEndElement();
 
-    QDomElement body = doc.createElement(QStringLiteral("body"));
-    root.appendChild(body);
+    writer.writeEndElement();
+    writer.writeEndDocument();
+}
 
-    foreach (const TreeNode *const i, allFeedsFolder()->children()) {
-        body.appendChild(i->toOPML(body, doc));
-    }
+QByteArray FeedList::toOpml() const
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
 
-    return doc;
+    QXmlStreamWriter writer(&buffer);
+    writer.setAutoFormatting(true);
+    writeOpml(writer);
+    return data;
+}
+
+bool FeedList::isModified() const
+{
+    return d->modified;
+}
+
+void FeedList::setModified(bool modified)
+{
+    d->modified = modified;
 }
 
 const TreeNode *FeedList::findByID(int id) const
@@ -484,9 +496,15 @@ void FeedList::slotNodeRemoved(Folder * /*parent*/, TreeNode *node)
         return;
     }
     removeNode(node);
+    d->modified = true;
     Q_EMIT signalNodeRemoved(node);
 }
 
+void FeedList::slotNodePropertiesChanged()
+{
+    d->modified = true;
+}
+
 int FeedList::unread() const
 {
     if (d->unreadCache == -1) {
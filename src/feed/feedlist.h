@@ -33,8 +33,9 @@
 
 #include <QSharedPointer>
 
-class QDomDocument;
-class QDomNode;
+class QByteArray;
+class QXmlStreamReader;
+class QXmlStreamWriter;
 template<class T> class QList;
 template<class K, class T> class QHash;
 class QString;
@@ -117,14 +118,21 @@ public:
 
     void append(FeedList *list, Folder *parent = nullptr, TreeNode *after = nullptr);
 
-    /** reads an OPML document and appends the items to this list
-        @param doc the OPML document to parse
-        @return whether parsing was successful or not (TODO: make errors more detailed)
+    /** reads an OPML document and appends the items to this list. Nodes are created while the document is streamed, no DOM is built.
+        @param reader the reader positioned at the start of the OPML document
+        @return whether parsing was successful or not. If @c reader has an error afterwards, the document was not well-formed XML
     */
-    bool readFromOpml(const QDomDocument &doc);
+    bool readFromOpml(QXmlStreamReader &reader);
 
-    /** exports the feed list as OPML. The root node ("All Feeds") is ignored! */
-    QDomDocument toOpml() const;
+    /** writes the feed list as OPML document to @c writer. The root node ("All Feeds") is ignored! */
+    void writeOpml(QXmlStreamWriter &writer) const;
+
+    /** exports the feed list as UTF-8 encoded OPML. The root node ("All Feeds") is ignored! */
+    QByteArray toOpml() const;
+
+    /** returns whether nodes were added, removed or had their saved properties changed since the list was read or setModified(false) was called */
+    bool isModified() const;
+    void setModified(bool modified);
 
     /** returns a feed object for a given feed URL. If the feed list does not contain a feed with @c url, NULL is returned. If it contains the same feed multiple times, any of the Feed objects is returned. */
     const Feed *findByURL(const QString &feedURL) const;
@@ -175,13 +183,14 @@ private:
     int generateID() const;
     void setRootNode(Folder *folder);
 
-    void parseChildNodes(QDomNode &node, Folder *parent);
+    void parseChildNodes(QXmlStreamReader &reader, Folder *parent);
 
 private Q_SLOTS:
 
     void slotNodeDestroyed(Akregator::TreeNode *node);
     void slotNodeAdded(Akregator::TreeNode *node);
     void slotNodeRemoved(Akregator::Folder *parent, Akregator::TreeNode *node);
+    void slotNodePropertiesChanged();
     void rootNodeChanged();
 
 private:
@@ -28,23 +28,180 @@
 #include "feed.h"
 #include "treenode.h"
 
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QList>
+#include <QSet>
+#include <QTimer>
+#include <QUrl>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
 
 #include <cassert>
 
 using namespace Akregator;
 
+namespace {
+/** backoff after the first failed fetch, doubled with every further failure */
+const qint64 initialBackoff = 60 * 1000;
+const qint64 maximumBackoff = 24 * 3600 * 1000;
+
+QString hostForFeed(const Feed *feed)
+{
+    return QUrl(feed->xmlUrl()).host().toLower();
+}
+}
+
 class FetchQueue::FetchQueuePrivate
 {
 public:
+    /** an entry of the due-time ordered queue */
+    struct QueueEntry {
+        qint64 due;
+        quint64 sequence;
+        Feed *feed;
+        QString host;
+
+        // std::push_heap builds a max-heap, so order the earliest entry last
+        bool operator<(const QueueEntry &other) const
+        {
+            return due > other.due || (due == other.due && sequence > other.sequence);
+        }
+    };
+
+    struct RunningFetch {
+        QString host;
+        QElapsedTimer timer;
+    };
+
+    struct Backoff {
+        Backoff() : failures(0)
+            , retryAt(0)
+        {
+        }
+
+        int failures;
+        qint64 retryAt;
+    };
+
+    FetchQueuePrivate() : nextSequence(0)
+        , limit(Settings::concurrentFetches())
+        , averageLatency(0)
+        , errorRate(0)
+        , started(false)
+    {
+    }
+
+    /** the current concurrency limit, adapted between 1 and the configured number of concurrent fetches */
+    int concurrencyLimit() const
+    {
+        return qBound(1, static_cast<int>(limit), qMax(1, Settings::concurrentFetches()));
+    }
+
+    void push(const QueueEntry &entry)
+    {
+        heap.push_back(entry);
+        std::push_heap(heap.begin(), heap.end());
+    }
+
+    QueueEntry pop()
+    {
+        std::pop_heap(heap.begin(), heap.end());
+        const QueueEntry entry = heap.back();
+        heap.pop_back();
+        return entry;
+    }
+
+    bool hasDueEntries(qint64 now) const
+    {
+        return !heap.empty() && heap.front().due <= now;
+    }
+
+    /** whether @p feed is queued with a due time after @p now; entries waiting for their host are already due */
+    bool isDeferred(const Feed *feed, qint64 now) const
+    {
+        return std::any_of(heap.begin(), heap.end(), [feed, now](const QueueEntry &entry) {
+            return entry.feed == feed && entry.due > now;
+        });
+    }
+
+    /** drops the queued entry of @p feed, which is either in the heap or waiting for its host */
+    void remove(Feed *feed)
+    {
+        const auto end = std::remove_if(heap.begin(), heap.end(), [feed](const QueueEntry &entry) {
+            return entry.feed == feed;
+        });
+        if (end != heap.end()) {
+            heap.erase(end, heap.end());
+            std::make_heap(heap.begin(), heap.end());
+            return;
+        }
+        for (auto it = blocked.begin(); it != blocked.end(); ++it) {
+            QList<QueueEntry> &entries = it.value();
+            for (int i = 0; i < entries.count(); ++i) {
+                if (entries.at(i).feed == feed) {
+                    entries.removeAt(i);
+                    if (entries.isEmpty()) {
+                        blocked.erase(it);
+                    }
+                    return;
+                }
+            }
+        }
+    }
+
+    /** frees the connection to @p host used by a fetch that finished or was dropped, and requeues the feeds waiting for it */
+    void releaseHost(const QString &host)
+    {
+        if (--hostLoad[host] <= 0) {
+            hostLoad.remove(host);
+        }
+        const QList<QueueEntry> waiting = blocked.take(host);
+        for (const QueueEntry &entry : waiting) {
+            push(entry);
+        }
+    }
+
+    void clear()
+    {
+        heap.clear();
+        queued.clear();
+        blocked.clear();
+        running.clear();
+        hostLoad.clear();
+        dueTimer.stop();
+    }
 
-    QList<Feed *> queuedFeeds;
-    QList<Feed *> fetchingFeeds;
+    /** the queued feeds, ordered by due time, then by insertion */
+    std::vector<QueueEntry> heap;
+    /** index of the queued feeds, whose entry is in the heap or in blocked */
+    QSet<Feed *> queued;
+    /** due entries waiting for a free connection to their host */
+    QHash<QString, QList<QueueEntry> > blocked;
+    QHash<Feed *, RunningFetch> running;
+    /** number of running fetches per host */
+    QHash<QString, int> hostLoad;
+    QHash<Feed *, Backoff> backoff;
+    quint64 nextSequence;
+
+    /** adaptive concurrency limit, fractional to allow additive increase */
+    double limit;
+    /** moving averages of the fetch latency (ms) and of the share of congestion errors */
+    double averageLatency;
+    double errorRate;
+    bool started;
+
+    QTimer dueTimer;
 };
 
 FetchQueue::FetchQueue(QObject *parent) : QObject(parent)
     , d(new FetchQueuePrivate)
 {
+    d->dueTimer.setSingleShot(true);
+    connect(&d->dueTimer, &QTimer::timeout, this, &FetchQueue::fetchNextFeed);
 }
 
 FetchQueue::~FetchQueue()
@@ -56,52 +213,107 @@ FetchQueue::~FetchQueue()
 
 void FetchQueue::slotAbort()
 {
-    for (Feed *const i : qAsConst(d->fetchingFeeds)) {
+    const QList<Feed *> fetching = d->running.keys();
+    for (Feed *const i : fetching) {
         disconnectFromFeed(i);
         i->slotAbortFetch();
     }
-    d->fetchingFeeds.clear();
 
-    for (Feed *const i : qAsConst(d->queuedFeeds)) {
+    for (Feed *const i : qAsConst(d->queued)) {
         disconnectFromFeed(i);
     }
-    d->queuedFeeds.clear();
+    d->clear();
+    d->started = false;
 
     Q_EMIT signalStopped();
 }
 
-void FetchQueue::addFeed(Feed *f)
+void FetchQueue::addFeed(Feed *f, bool intervalFetch)
 {
-    if (!d->queuedFeeds.contains(f) && !d->fetchingFeeds.contains(f)) {
+    if (d->running.contains(f)) {
+        return;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (d->queued.contains(f)) {
+        // an explicit fetch replaces an interval fetch still waiting for its backoff
+        if (intervalFetch || !d->isDeferred(f, now)) {
+            return;
+        }
+        d->remove(f);
+    } else {
         connectToFeed(f);
-        d->queuedFeeds.append(f);
-        fetchNextFeed();
+        d->queued.insert(f);
+    }
+
+    FetchQueuePrivate::QueueEntry entry;
+    entry.due = now;
+    if (intervalFetch) {
+        entry.due = qMax(entry.due, d->backoff.value(f).retryAt);
     }
+    entry.sequence = d->nextSequence++;
+    entry.feed = f;
+    entry.host = hostForFeed(f);
+    d->push(entry);
+    fetchNextFeed();
 }
 
 void FetchQueue::fetchNextFeed()
 {
-    if (!d->queuedFeeds.isEmpty() && d->fetchingFeeds.count() < Settings::concurrentFetches()) {
-        if (d->fetchingFeeds.isEmpty() && d->queuedFeeds.count() == 1) {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const int maxPerHost = qMax(1, Settings::maxFetchesPerHost());
+
+    while (d->running.count() < d->concurrencyLimit() && d->hasDueEntries(now)) {
+        const FetchQueuePrivate::QueueEntry entry = d->pop();
+        if (d->hostLoad.value(entry.host) >= maxPerHost) {
+            // wait until a fetch from this host finished
+            d->blocked[entry.host].append(entry);
+            continue;
+        }
+
+        if (!d->started) {
+            d->started = true;
             Q_EMIT signalStarted();
         }
-        Feed *f = *(d->queuedFeeds.begin());
-        d->queuedFeeds.pop_front();
-        d->fetchingFeeds.append(f);
-        f->fetch(false);
+
+        d->queued.remove(entry.feed);
+        FetchQueuePrivate::RunningFetch &fetch = d->running[entry.feed];
+        fetch.host = entry.host;
+        fetch.timer.start();
+        ++d->hostLoad[entry.host];
+        startFetch(entry.feed);
     }
+
+    // wake up when the next deferred feed is due
+    if (!d->heap.empty() && d->heap.front().due > now) {
+        d->dueTimer.start(static_cast<int>(qMin<qint64>(d->heap.front().due - now, std::numeric_limits<int>::max())));
+    }
+}
+
+void FetchQueue::startFetch(Feed *f)
+{
+    f->fetch(false);
 }
 
 void FetchQueue::slotFeedFetched(Feed *f)
 {
+    d->backoff.remove(f);
     Q_EMIT fetched(f);
     feedDone(f);
 }
 
 void FetchQueue::slotFetchError(Feed *f)
 {
+    FetchQueuePrivate::Backoff &backoff = d->backoff[f];
+    const int shift = qMin(backoff.failures, 20);
+    ++backoff.failures;
+    backoff.retryAt = QDateTime::currentMSecsSinceEpoch() + qMin(initialBackoff << shift, maximumBackoff);
+
+    const Syndication::ErrorCode error = f->fetchErrorCode();
+    const bool congested = error == Syndication::Timeout || error == Syndication::OtherRetrieverError;
+
     Q_EMIT fetchError(f);
-    feedDone(f);
+    feedDone(f, congested);
 }
 
 void FetchQueue::slotFetchAborted(Feed *f)
@@ -112,15 +324,43 @@ void FetchQueue::slotFetchAborted(Feed *f)
 
 bool FetchQueue::isEmpty() const
 {
-    return d->queuedFeeds.isEmpty() && d->fetchingFeeds.isEmpty();
+    return d->running.isEmpty() && !d->hasDueEntries(QDateTime::currentMSecsSinceEpoch());
 }
 
-void FetchQueue::feedDone(Feed *f)
+void FetchQueue::feedDone(Feed *f, bool congested)
 {
     disconnectFromFeed(f);
-    d->fetchingFeeds.removeAll(f);
+
+    const auto it = d->running.find(f);
+    if (it != d->running.end()) {
+        const QString host = it.value().host;
+        const qint64 latency = it.value().timer.elapsed();
+        d->running.erase(it);
+        d->releaseHost(host);
+
+        // additive increase, multiplicative decrease: back off when fetches time out
+        // or take much longer than usual, grow again while they are fast and succeed
+        const bool slow = d->averageLatency > 0 && latency > 2 * d->averageLatency;
+        d->averageLatency = d->averageLatency > 0 ? 0.8 * d->averageLatency + 0.2 * latency : latency;
+        d->errorRate = 0.8 * d->errorRate + (congested ? 0.2 : 0.0);
+        const int maximum = qMax(1, Settings::concurrentFetches());
+        if (congested || slow) {
+            d->limit = qMax(1.0, qMin<double>(d->limit, maximum) * 0.75);
+        } else if (d->errorRate < 0.2) {
+            d->limit = qMin<double>(maximum, d->limit + 1.0 / d->limit);
+        }
+    }
+
+    fetchNextFeedOrStop();
+}
+
+void FetchQueue::fetchNextFeedOrStop()
+{
     if (isEmpty()) {
-        Q_EMIT signalStopped();
+        if (d->started) {
+            d->started = false;
+            Q_EMIT signalStopped();
+        }
     } else {
         fetchNextFeed();
     }
@@ -144,6 +384,21 @@ void FetchQueue::slotNodeDestroyed(TreeNode *node)
     Feed *const feed = qobject_cast<Feed *>(node);
     Q_ASSERT(feed);
 
-    d->fetchingFeeds.removeAll(feed);
-    d->queuedFeeds.removeAll(feed);
+    d->backoff.remove(feed);
+    const bool wasQueued = d->queued.remove(feed);
+    if (wasQueued) {
+        d->remove(feed);
+    }
+
+    const auto it = d->running.find(feed);
+    if (it != d->running.end()) {
+        const QString host = it.value().host;
+        d->running.erase(it);
+        d->releaseHost(host);
+    } else if (!wasQueued) {
+        return;
+    }
+
+    // like a finished fetch, the destroyed feed may have been the last one or blocked others
+    fetchNextFeedOrStop();
 }
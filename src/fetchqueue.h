@@ -42,11 +42,14 @@ public:
     explicit FetchQueue(QObject *parent = nullptr);
     ~FetchQueue();
 
-    /** returns true when no feeds are neither fetching nor queued */
+    /** returns true when no feeds are fetching or waiting to be fetched. Feeds whose interval
+        fetch was deferred because of repeated errors are not counted */
     bool isEmpty() const;
 
-    /** adds a feed to the queue */
-    void addFeed(Feed *f);
+    /** adds a feed to the queue
+        @param intervalFetch if @c true, the fetch is deferred while the feed is backing off after errors.
+        Explicitly requested fetches are never deferred */
+    void addFeed(Feed *f, bool intervalFetch = false);
 
 public Q_SLOTS:
 
@@ -62,10 +65,16 @@ Q_SIGNALS:
 
 protected:
 
-    /** fetches the next feed in the queue, unless the maximum of concurrent fetches is reached */
+    /** fetches the due feeds in the queue, as long as the concurrency limit and the per-host limit allow */
     void fetchNextFeed();
 
-    void feedDone(Feed *f);
+    /** starts fetching a feed taken from the queue. Tests override it to fetch nothing */
+    virtual void startFetch(Feed *f);
+
+    /** @param congested whether the fetch failed in a way that hints at an overloaded network or host */
+    void feedDone(Feed *f, bool congested = false);
+    /** emits signalStopped() if the queue was started and no feed is fetching or due anymore, otherwise fetches the next ones */
+    void fetchNextFeedOrStop();
     void connectToFeed(Feed *feed);
     void disconnectFromFeed(Feed *feed);
 
@@ -30,29 +30,18 @@
 #include "fetchqueue.h"
 #include "treenodevisitor.h"
 
-#include <qdom.h>
 #include <QList>
+#include <QXmlStreamAttributes>
+#include <QXmlStreamWriter>
 
 #include <QIcon>
+#include <QTimer>
 #include "akregator_debug.h"
 
 #include <cassert>
 
 using namespace Akregator;
 
-// efficient alternative so we don't convert first to a temporary QList then to QVector
-template<typename T>
-static QVector<T> hashValuesToVector(const QHash<int, T> &hash)
-{
-    QVector<T> result;
-    result.reserve(hash.count());
-    for (auto it = hash.cbegin(), end = hash.cend(); it != end; ++it) {
-        result.append(it.value());
-    }
-
-    return result;
-}
-
 class Folder::FolderPrivate
 {
     Folder *const q;
@@ -62,8 +51,28 @@ public:
 
     /** List of children */
     QList<TreeNode *> children;
-    /** caching unread count of children */
-    mutable int unread;
+
+    struct Counts {
+        int unread;
+        int total;
+    };
+    /** the counts of each child as last added to the counts of this folder */
+    QHash<const TreeNode *, Counts> childCounts;
+    /** sum of the unread counts of the children */
+    int unread;
+    /** sum of the total counts of the children */
+    int total;
+    /** whether a change notification is scheduled for the next event loop turn */
+    bool changePending;
+
+    /** the feeds and folders of the subtree in tree order, rebuilt on first use after the subtree changed.
+        Returned as implicitly shared copies, so iterating them does not allocate */
+    QVector<Feed *> feeds;
+    QVector<const Feed *> constFeeds;
+    QVector<Folder *> folders;
+    QVector<const Folder *> constFolders;
+    bool cacheValid;
+
     /** whether or not the folder is expanded */
     bool open;
 
@@ -75,6 +84,9 @@ public:
 
 Folder::FolderPrivate::FolderPrivate(Folder *qq) : q(qq)
     , unread(0)
+    , total(0)
+    , changePending(false)
+    , cacheValid(false)
     , open(false)
 {
 }
@@ -97,11 +109,11 @@ bool Folder::accept(TreeNodeVisitor *visitor)
     }
 }
 
-Folder *Folder::fromOPML(const QDomElement &e)
+Folder *Folder::fromOPML(const QXmlStreamAttributes &attributes)
 {
-    Folder *fg = new Folder(e.hasAttribute(QStringLiteral("text")) ? e.attribute(QStringLiteral("text")) : e.attribute(QStringLiteral("title")));
-    fg->setOpen(e.attribute(QStringLiteral("isOpen")) == QLatin1String("true"));
-    fg->setId(e.attribute(QStringLiteral("id")).toUInt());
+    Folder *fg = new Folder((attributes.hasAttribute(QLatin1String("text")) ? attributes.value(QLatin1String("text")) : attributes.value(QLatin1String("title"))).toString());
+    fg->setOpen(attributes.value(QLatin1String("isOpen")) == QLatin1String("true"));
+    fg->setId(attributes.value(QLatin1String("id")).toUInt());
     return fg;
 }
 
@@ -126,18 +138,17 @@ QVector<Article> Folder::articles()
     return seq;
 }
 
-QDomElement Folder::toOPML(QDomElement parent, QDomDocument document) const
+void Folder::toOPML(QXmlStreamWriter &writer) const
 {
-    QDomElement el = document.createElement(QStringLiteral("outline"));
-    el.setAttribute(QStringLiteral("text"), title());
-    parent.appendChild(el);
-    el.setAttribute(QStringLiteral("isOpen"), d->open ? QStringLiteral("true") : QStringLiteral("false"));
-    el.setAttribute(QStringLiteral("id"), QString::number(id()));
+    writer.writeStartElement(QStringLiteral("outline"));
+    writer.writeAttribute(QStringLiteral("text"), title());
+    writer.writeAttribute(QStringLiteral("isOpen"), d->open ? QStringLiteral("true") : QStringLiteral("false"));
+    writer.writeAttribute(QStringLiteral("id"), QString::number(id()));
 
-    Q_FOREACH (const Akregator::TreeNode *i, d->children) {
-        el.appendChild(i->toOPML(el, document));
+    for (const Akregator::TreeNode *i : qAsConst(d->children)) {
+        i->toOPML(writer);
     }
-    return el;
+    writer.writeEndElement();
 }
 
 QList<const TreeNode *> Folder::children() const
@@ -155,63 +166,84 @@ QList<TreeNode *> Folder::children()
     return d->children;
 }
 
-QVector<const Akregator::Feed *> Folder::feeds() const
+void Folder::updateCaches() const
 {
-    QHash<int, const Akregator::Feed *> feedsById;
-    for (const TreeNode *i : qAsConst(d->children)) {
-        Q_FOREACH (const Akregator::Feed *j, i->feeds()) {
-            feedsById.insert(j->id(), j);
+    if (d->cacheValid) {
+        return;
+    }
+    d->feeds.clear();
+    d->constFeeds.clear();
+    d->folders.clear();
+    d->constFolders.clear();
+    d->folders.append(const_cast<Folder *>(this));
+    for (TreeNode *const i : qAsConst(d->children)) {
+        if (Folder *const folder = qobject_cast<Folder *>(i)) {
+            folder->updateCaches();
+            d->feeds += folder->d->feeds;
+            d->folders += folder->d->folders;
+        } else if (Feed *const feed = qobject_cast<Feed *>(i)) {
+            d->feeds.append(feed);
         }
     }
+    d->constFeeds.reserve(d->feeds.count());
+    for (const Feed *const i : qAsConst(d->feeds)) {
+        d->constFeeds.append(i);
+    }
+    d->constFolders.reserve(d->folders.count());
+    for (const Folder *const i : qAsConst(d->folders)) {
+        d->constFolders.append(i);
+    }
+    d->cacheValid = true;
+}
 
-    return hashValuesToVector<const Akregator::Feed *>(feedsById);
+QVector<const Akregator::Feed *> Folder::feeds() const
+{
+    updateCaches();
+    return d->constFeeds;
 }
 
 QVector<Akregator::Feed *> Folder::feeds()
 {
-    QHash<int, Akregator::Feed *> feedsById;
-    for (TreeNode *i : qAsConst(d->children)) {
-        Q_FOREACH (Akregator::Feed *j, i->feeds()) {
-            feedsById.insert(j->id(), j);
-        }
-    }
-
-    return hashValuesToVector<Akregator::Feed *>(feedsById);
+    updateCaches();
+    return d->feeds;
 }
 
 QVector<const Folder *> Folder::folders() const
 {
-    QHash<int, const Folder *> foldersById;
-    foldersById.insert(id(), this);
-    for (const TreeNode *i : qAsConst(d->children)) {
-        Q_FOREACH (const Folder *j, i->folders()) {
-            foldersById.insert(j->id(), j);
-        }
-    }
-
-    return hashValuesToVector<const Folder *>(foldersById);
+    updateCaches();
+    return d->constFolders;
 }
 
 QVector<Folder *> Folder::folders()
 {
-    QHash<int, Folder *> foldersById;
-    foldersById.insert(id(), this);
-    for (TreeNode *i : qAsConst(d->children)) {
-        Q_FOREACH (Folder *j, i->folders()) {
-            foldersById.insert(j->id(), j);
-        }
-    }
-    return hashValuesToVector<Folder *>(foldersById);
+    updateCaches();
+    return d->folders;
 }
 
 int Folder::indexOf(const TreeNode *node) const
 {
-    return children().indexOf(node);
+    if (!node || node->parent() != this) {
+        return -1;
+    }
+    const int index = node->indexInParent();
+    return index >= 0 && index < d->children.count() && d->children.at(index) == node ? index : -1;
+}
+
+void Folder::childrenChanged(int first)
+{
+    const int count = d->children.count();
+    for (int i = qMax(first, 0); i < count; ++i) {
+        d->children.at(i)->setIndexInParent(i);
+    }
+    // a valid cache implies valid caches in the whole subtree, so the walk can stop at the first invalid one
+    for (Folder *folder = this; folder && folder->d->cacheValid; folder = folder->parent()) {
+        folder->d->cacheValid = false;
+    }
 }
 
 void Folder::insertChild(TreeNode *node, TreeNode *after)
 {
-    int pos = d->children.indexOf(after);
+    int pos = indexOf(after);
 
     if (pos < 0) {
         prependChild(node);
@@ -230,13 +262,15 @@ void Folder::insertChild(int index, TreeNode *node)
 //    qCDebug(AKREGATOR_LOG) <<"enter Folder::insertChild(int, node)" << node->title();
     if (node) {
         if (index >= d->children.size()) {
+            index = d->children.size();
             d->children.append(node);
         } else {
             d->children.insert(index, node);
         }
+        childrenChanged(index);
         node->setParent(this);
         connectToNode(node);
-        updateUnreadCount();
+        addChildCounts(node);
         Q_EMIT signalChildAdded(node);
         d->addedArticlesNotify += node->articles();
         articlesModified();
@@ -250,9 +284,10 @@ void Folder::appendChild(TreeNode *node)
 //    qCDebug(AKREGATOR_LOG) <<"enter Folder::appendChild()" << node->title();
     if (node) {
         d->children.append(node);
+        childrenChanged(d->children.size() - 1);
         node->setParent(this);
         connectToNode(node);
-        updateUnreadCount();
+        addChildCounts(node);
         Q_EMIT signalChildAdded(node);
         d->addedArticlesNotify += node->articles();
         articlesModified();
@@ -266,9 +301,10 @@ void Folder::prependChild(TreeNode *node)
 //    qCDebug(AKREGATOR_LOG) <<"enter Folder::prependChild()" << node->title();
     if (node) {
         d->children.prepend(node);
+        childrenChanged(0);
         node->setParent(this);
         connectToNode(node);
-        updateUnreadCount();
+        addChildCounts(node);
         Q_EMIT signalChildAdded(node);
         d->addedArticlesNotify += node->articles();
         articlesModified();
@@ -279,15 +315,18 @@ void Folder::prependChild(TreeNode *node)
 
 void Folder::removeChild(TreeNode *node)
 {
-    if (!node || !d->children.contains(node)) {
+    const int index = indexOf(node);
+    if (index < 0) {
         return;
     }
 
     Q_EMIT signalAboutToRemoveChild(node);
     node->setParent(0);
-    d->children.removeOne(node);
+    d->children.removeAt(index);
+    node->setIndexInParent(-1);
+    childrenChanged(index);
     disconnectFromNode(node);
-    updateUnreadCount();
+    removeChildCounts(node);
     Q_EMIT signalChildRemoved(this, node);
     d->removedArticlesNotify += node->articles();
     articlesModified(); // articles were removed, TODO: add guids to a list
@@ -296,22 +335,22 @@ void Folder::removeChild(TreeNode *node)
 
 TreeNode *Folder::firstChild()
 {
-    return d->children.isEmpty() ? 0 : children().first();
+    return d->children.isEmpty() ? 0 : d->children.first();
 }
 
 const TreeNode *Folder::firstChild() const
 {
-    return d->children.isEmpty() ? 0 : children().first();
+    return d->children.isEmpty() ? 0 : d->children.first();
 }
 
 TreeNode *Folder::lastChild()
 {
-    return d->children.isEmpty() ? 0 : children().last();
+    return d->children.isEmpty() ? 0 : d->children.last();
 }
 
 const TreeNode *Folder::lastChild() const
 {
-    return d->children.isEmpty() ? 0 : children().last();
+    return d->children.isEmpty() ? 0 : d->children.last();
 }
 
 bool Folder::isOpen() const
@@ -321,7 +360,10 @@ bool Folder::isOpen() const
 
 void Folder::setOpen(bool open)
 {
-    d->open = open;
+    if (d->open != open) {
+        d->open = open;
+        propertiesModified();
+    }
 }
 
 int Folder::unread() const
@@ -331,20 +373,54 @@ int Folder::unread() const
 
 int Folder::totalCount() const
 {
-    int total = 0;
-    Q_FOREACH (const Feed *const i, feeds()) {
-        total += i->totalCount();
+    return d->total;
+}
+
+void Folder::addChildCounts(const TreeNode *node)
+{
+    const FolderPrivate::Counts counts = { node->unread(), node->totalCount() };
+    d->childCounts.insert(node, counts);
+    addToCounts(counts.unread, counts.total);
+}
+
+void Folder::removeChildCounts(const TreeNode *node)
+{
+    if (!d->childCounts.contains(node)) {
+        return;
     }
-    return total;
+    const FolderPrivate::Counts counts = d->childCounts.take(node);
+    addToCounts(-counts.unread, -counts.total);
 }
 
-void Folder::updateUnreadCount() const
+void Folder::addToCounts(int unreadDelta, int totalDelta)
 {
-    int unread = 0;
-    Q_FOREACH (const Feed *const i, feeds()) {
-        unread += i->unread();
+    for (Folder *folder = this; folder; folder = folder->parent()) {
+        folder->d->unread += unreadDelta;
+        folder->d->total += totalDelta;
+        // the parent already knows about the change, so the folder's own signalChanged must not count it again
+        if (Folder *const parent = folder->parent()) {
+            const QHash<const TreeNode *, FolderPrivate::Counts>::Iterator it = parent->d->childCounts.find(folder);
+            if (it != parent->d->childCounts.end()) {
+                it->unread += unreadDelta;
+                it->total += totalDelta;
+            }
+        }
+        folder->scheduleNodeModified();
     }
-    d->unread = unread;
+}
+
+void Folder::scheduleNodeModified()
+{
+    if (!d->changePending) {
+        d->changePending = true;
+        QTimer::singleShot(0, this, &Folder::slotEmitNodeModified);
+    }
+}
+
+void Folder::slotEmitNodeModified()
+{
+    d->changePending = false;
+    nodeModified();
 }
 
 KJob *Folder::createMarkAsReadJob()
@@ -356,16 +432,27 @@ KJob *Folder::createMarkAsReadJob()
     return job;
 }
 
-void Folder::slotChildChanged(TreeNode * /*node*/)
+void Folder::slotChildChanged(TreeNode *node)
 {
-    updateUnreadCount();
-    nodeModified();
+    const QHash<const TreeNode *, FolderPrivate::Counts>::Iterator it = d->childCounts.find(node);
+    if (it == d->childCounts.end()) {
+        return;
+    }
+    const int unreadDelta = node->unread() - it->unread;
+    const int totalDelta = node->totalCount() - it->total;
+    if (unreadDelta == 0 && totalDelta == 0) {
+        return;
+    }
+    it->unread += unreadDelta;
+    it->total += totalDelta;
+    addToCounts(unreadDelta, totalDelta);
 }
 
 void Folder::slotChildDestroyed(TreeNode *node)
 {
     d->children.removeAll(node);
-    updateUnreadCount();
+    childrenChanged(0);
+    removeChildCounts(node);
     nodeModified();
 }
 
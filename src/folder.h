@@ -29,8 +29,8 @@
 #include "akregator_export.h"
 #include "treenode.h"
 
-class QDomDocument;
-class QDomElement;
+class QXmlStreamAttributes;
+class QXmlStreamWriter;
 template<class T> class QList;
 
 namespace Akregator {
@@ -44,11 +44,11 @@ class AKREGATOR_EXPORT Folder : public TreeNode
 {
     Q_OBJECT
 public:
-    /** creates a feed group parsed from a XML dom element.
+    /** creates a feed group from the attributes of an OPML outline element.
     Child nodes are not inserted or parsed.
-    @param e the element representing the feed group
+    @param attributes the attributes of the element representing the feed group
     @return a freshly created feed group */
-    static Folder *fromOPML(const QDomElement &e);
+    static Folder *fromOPML(const QXmlStreamAttributes &attributes);
 
     /** Creates a new folder with a given title
     @param title The title of the feed group
@@ -59,7 +59,7 @@ public:
 
     bool accept(TreeNodeVisitor *visitor) override;
 
-    /** returns the number of unread articles in all children
+    /** returns the number of unread articles in all children. The count is kept up to date incrementally
     @return number of unread articles */
     int unread() const override;
 
@@ -79,12 +79,10 @@ public:
         return true;
     }
 
-    /** converts the feed group into OPML format for save and export and appends it to node @c parent in document @document.
-    Children are processed and appended recursively.
-    @param parent The parent element
-    @param document The DOM document
-    @return The newly created element representing this feed group */
-    QDomElement toOPML(QDomElement parent, QDomDocument document) const override;
+    /** writes the feed group in OPML format for save and export.
+    Children are written recursively into the group's outline element.
+    @param writer The writer, positioned inside the parent element */
+    void toOPML(QXmlStreamWriter &writer) const override;
 
     /** returns the (direct) children of this node.
     @return a list of pointers to the child nodes
@@ -196,8 +194,23 @@ private:
     void connectToNode(TreeNode *child);
     void disconnectFromNode(TreeNode *child);
 
-    void updateUnreadCount() const;
+    /** updates the sibling indices from position @p first on and invalidates the cached feed lists of this folder and its ancestors */
+    void childrenChanged(int first);
+    /** rebuilds the cached feed and folder lists of the subtree if they are out of date */
+    void updateCaches() const;
+    /** adds the counts of a new child to this folder and its ancestors */
+    void addChildCounts(const TreeNode *node);
+    /** subtracts the counts of a removed child from this folder and its ancestors */
+    void removeChildCounts(const TreeNode *node);
+    /** adds the count changes of a child to this folder and all its ancestors, and schedules their change notifications */
+    void addToCounts(int unreadDelta, int totalDelta);
+    /** emits signalChanged once per event loop turn, however often the counts changed */
+    void scheduleNodeModified();
+
+private Q_SLOTS:
+    void slotEmitNodeModified();
 
+private:
     class FolderPrivate;
     FolderPrivate *d;
 };
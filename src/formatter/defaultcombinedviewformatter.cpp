@@ -31,6 +31,7 @@
 #include <KLocalizedString>
 
 #include <QApplication>
+#include <QCryptographicHash>
 #include <QPaintDevice>
 #include <QPalette>
 #include <QString>
@@ -44,16 +45,56 @@ DefaultCombinedViewFormatter::DefaultCombinedViewFormatter(const QString &grantl
                                                         QStringLiteral("akregator/grantleetheme/%1/").arg(grantleeDirectory),
                                                         QStandardPaths::LocateDirectory);
     mGrantleeViewFormatter = new GrantleeViewFormatter(QStringLiteral("combinedview.html"), combinedPath, imageDir, device->logicalDpiY());
+    mGrantleeArticleFormatter = new GrantleeViewFormatter(QStringLiteral("combinedviewarticle.html"), combinedPath, imageDir, device->logicalDpiY());
 }
 
 DefaultCombinedViewFormatter::~DefaultCombinedViewFormatter()
 {
     delete mGrantleeViewFormatter;
+    delete mGrantleeArticleFormatter;
 }
 
 QString DefaultCombinedViewFormatter::formatArticles(const QVector<Article> &articles, IconOption icon) const
 {
-    return mGrantleeViewFormatter->formatArticles(articles, icon);
+    QStringList fragments;
+    fragments.reserve(articles.count());
+    for (const Article &article : articles) {
+        fragments.append(formatArticleFragment(article, icon));
+    }
+    return formatPage(fragments, 0, 0);
+}
+
+QString DefaultCombinedViewFormatter::formatArticleFragment(const Article &article, IconOption icon) const
+{
+    return QStringLiteral("<div class=\"combinedarticle\" id=\"%1\">").arg(fragmentId(article))
+           + mGrantleeArticleFormatter->formatArticle(article, icon)
+           + QStringLiteral("</div>");
+}
+
+QString DefaultCombinedViewFormatter::formatPage(const QStringList &fragments, int generation, int remaining) const
+{
+    return mGrantleeViewFormatter->formatCombinedPage(fragments, generation, formatMoreArticlesLink(remaining));
+}
+
+QString DefaultCombinedViewFormatter::formatMoreArticlesLink(int remaining) const
+{
+    if (remaining <= 0) {
+        return QString();
+    }
+    return QStringLiteral("<p><a class=\"contentlink\" href=\"akregatoraction:showMoreArticles\">%1</a></p>")
+           .arg(i18np("Show 1 more article", "Show %1 more articles", remaining));
+}
+
+QString DefaultCombinedViewFormatter::fragmentId(const Article &article)
+{
+    // guids are only unique within a feed, and may contain anything
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    if (article.feed()) {
+        hash.addData(article.feed()->xmlUrl().toUtf8());
+    }
+    hash.addData("\n", 1);
+    hash.addData(article.guid().toUtf8());
+    return QLatin1Char('a') + QString::fromLatin1(hash.result().toHex());
 }
 
 QString DefaultCombinedViewFormatter::formatSummary(TreeNode *) const
@@ -35,9 +35,24 @@ public:
 
     QString formatSummary(TreeNode *node) const override;
 
+    /** renders a single article as a fragment of the combined view, wrapped in an element
+        with the id fragmentId() returns, so that it can be replaced in a loaded page */
+    QString formatArticleFragment(const Article &article, IconOption option) const;
+
+    /** renders the combined view page around @p fragments. @p generation is stored in the page,
+        @p remaining is the number of articles not shown yet */
+    QString formatPage(const QStringList &fragments, int generation, int remaining) const;
+
+    /** returns the html of the link to show @p remaining more articles, or an empty string */
+    QString formatMoreArticlesLink(int remaining) const;
+
+    /** returns the id of the element an article fragment is wrapped in */
+    static QString fragmentId(const Article &article);
+
 private:
     DefaultCombinedViewFormatter();
     GrantleeViewFormatter *mGrantleeViewFormatter;
+    GrantleeViewFormatter *mGrantleeArticleFormatter;
 };
 }
 #endif // DEFAULTCOMBINEDVIEWFORMATTER_H
@@ -104,3 +104,8 @@ QString DefaultNormalViewFormatter::formatArticles(const QVector<Article> &artic
     }
     return mGrantleeViewFormatter->formatArticles(articles, icon);
 }
+
+void DefaultNormalViewFormatter::clearCache()
+{
+    mGrantleeViewFormatter->clearCache();
+}
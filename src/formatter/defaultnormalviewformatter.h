@@ -36,6 +36,9 @@ public:
 
     QString formatSummary(TreeNode *node) const override;
 
+    /** drops the rendered articles kept by formatArticles() */
+    void clearCache();
+
 private:
     DefaultNormalViewFormatter();
 
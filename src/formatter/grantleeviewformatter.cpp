@@ -34,12 +34,19 @@
 
 using namespace Akregator;
 
+namespace {
+// size of the rendered article cache, in kilobytes
+const int articleCacheSize = 4096;
+}
+
 GrantleeViewFormatter::GrantleeViewFormatter(const QString &htmlFileName, const QString &themePath, const QUrl &imageDir, int deviceDpiY, QObject *parent)
     : PimCommon::GenericGrantleeFormatter(htmlFileName, themePath, parent)
     , mImageDir(imageDir)
     , mHtmlArticleFileName(htmlFileName)
+    , mCurrentHtmlFileName(htmlFileName)
     , mGrantleeThemePath(QStringLiteral("file://") + themePath + QLatin1Char('/'))
     , mDeviceDpiY(deviceDpiY)
+    , mArticleCache(articleCacheSize)
 {
     mDirectionString = QApplication::isRightToLeft() ? QStringLiteral("rtl") : QStringLiteral("ltr");
 }
@@ -53,6 +60,15 @@ int GrantleeViewFormatter::pointsToPixel(int pointSize) const
     return (pointSize * mDeviceDpiY + 36) / 72;
 }
 
+bool GrantleeViewFormatter::setMainTemplate(const QString &fileName)
+{
+    if (fileName != mCurrentHtmlFileName) {
+        setDefaultHtmlMainFile(fileName);
+        mCurrentHtmlFileName = fileName;
+    }
+    return errorMessage().isEmpty();
+}
+
 void GrantleeViewFormatter::addStandardObject(QVariantHash &grantleeObject)
 {
     grantleeObject.insert(QStringLiteral("absoluteThemePath"), mGrantleeThemePath);
@@ -63,8 +79,7 @@ void GrantleeViewFormatter::addStandardObject(QVariantHash &grantleeObject)
 
 QString GrantleeViewFormatter::formatFeed(Akregator::Feed *feed)
 {
-    setDefaultHtmlMainFile(QStringLiteral("defaultnormalvisitfeed.html"));
-    if (!errorMessage().isEmpty()) {
+    if (!setMainTemplate(QStringLiteral("defaultnormalvisitfeed.html"))) {
         return errorMessage();
     }
     QVariantHash feedObject;
@@ -113,8 +128,7 @@ QString GrantleeViewFormatter::formatFeed(Akregator::Feed *feed)
 
 QString GrantleeViewFormatter::formatFolder(Akregator::Folder *node)
 {
-    setDefaultHtmlMainFile(QStringLiteral("defaultnormalvisitfolder.html"));
-    if (!errorMessage().isEmpty()) {
+    if (!setMainTemplate(QStringLiteral("defaultnormalvisitfolder.html"))) {
         return errorMessage();
     }
     QVariantHash folderObject;
@@ -132,13 +146,38 @@ QString GrantleeViewFormatter::formatFolder(Akregator::Folder *node)
     return render(folderObject);
 }
 
+QString GrantleeViewFormatter::cacheKey(const Article &article, ArticleFormatter::IconOption icon) const
+{
+    // the guid identifies the article within its feed, the hash its content. Status and
+    // keep flag change the actions the templates show
+    return mGrantleeThemePath + mHtmlArticleFileName + QLatin1Char('\n')
+           + (article.feed() ? article.feed()->xmlUrl() : QString()) + QLatin1Char('\n')
+           + article.guid() + QLatin1Char('\n')
+           + QString::number(article.hash()) + QLatin1Char(' ')
+           + QString::number(article.status()) + QLatin1Char(' ')
+           + QString::number(article.keep()) + QLatin1Char(' ')
+           + QString::number(icon);
+}
+
+void GrantleeViewFormatter::clearCache()
+{
+    mArticleCache.clear();
+}
+
 QString GrantleeViewFormatter::formatArticles(const QVector<Article> &article, ArticleFormatter::IconOption icon)
 {
-    setDefaultHtmlMainFile(mHtmlArticleFileName);
-    if (!errorMessage().isEmpty()) {
+    if (!setMainTemplate(mHtmlArticleFileName)) {
         return errorMessage();
     }
 
+    QString key;
+    if (article.count() == 1) {
+        key = cacheKey(article.first(), icon);
+        if (const QString *html = mArticleCache.object(key)) {
+            return *html;
+        }
+    }
+
     QVariantHash articleObject;
 
     QVariantList articlesList;
@@ -154,14 +193,49 @@ QString GrantleeViewFormatter::formatArticles(const QVector<Article> &article, A
     articleObject.insert(QStringLiteral("articles"), articlesList);
 
     addStandardObject(articleObject);
-
-    articleObject.insert(QStringLiteral("dateI18n"), i18n("Date"));
-    articleObject.insert(QStringLiteral("commentI18n"), i18n("Comment"));
-    articleObject.insert(QStringLiteral("completeStoryI18n"), i18n("Complete Story"));
-    articleObject.insert(QStringLiteral("authorI18n"), i18n("Author"));
-    articleObject.insert(QStringLiteral("enclosureI18n"), i18n("Enclosure"));
+    addArticleStrings(articleObject);
 
     const QString str = render(articleObject);
     qDeleteAll(lstObj);
+    if (!key.isEmpty() && errorMessage().isEmpty()) {
+        mArticleCache.insert(key, new QString(str), str.size() * sizeof(QChar) / 1024 + 1);
+    }
     return str;
 }
+
+void GrantleeViewFormatter::addArticleStrings(QVariantHash &grantleeObject)
+{
+    grantleeObject.insert(QStringLiteral("dateI18n"), i18n("Date"));
+    grantleeObject.insert(QStringLiteral("commentI18n"), i18n("Comment"));
+    grantleeObject.insert(QStringLiteral("completeStoryI18n"), i18n("Complete Story"));
+    grantleeObject.insert(QStringLiteral("authorI18n"), i18n("Author"));
+    grantleeObject.insert(QStringLiteral("enclosureI18n"), i18n("Enclosure"));
+}
+
+QString GrantleeViewFormatter::formatArticle(const Article &article, ArticleFormatter::IconOption icon)
+{
+    if (!setMainTemplate(mHtmlArticleFileName)) {
+        return errorMessage();
+    }
+
+    ArticleGrantleeObject articleObj(mImageDir, article, icon);
+    QVariantHash articleObject;
+    articleObject.insert(QStringLiteral("article"), QVariant::fromValue(static_cast<QObject *>(&articleObj)));
+    addStandardObject(articleObject);
+    addArticleStrings(articleObject);
+    return render(articleObject);
+}
+
+QString GrantleeViewFormatter::formatCombinedPage(const QStringList &fragments, int generation, const QString &moreArticles)
+{
+    if (!setMainTemplate(mHtmlArticleFileName)) {
+        return errorMessage();
+    }
+
+    QVariantHash pageObject;
+    pageObject.insert(QStringLiteral("fragments"), fragments);
+    pageObject.insert(QStringLiteral("generation"), generation);
+    pageObject.insert(QStringLiteral("moreArticles"), moreArticles);
+    addStandardObject(pageObject);
+    return render(pageObject);
+}
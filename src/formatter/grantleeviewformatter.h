@@ -24,6 +24,8 @@
 #include "article.h"
 #include "articleformatter.h"
 
+#include <QCache>
+
 namespace Akregator {
 class Folder;
 class GrantleeViewFormatter : public PimCommon::GenericGrantleeFormatter
@@ -36,14 +38,31 @@ public:
     QString formatArticles(const QVector<Article> &article, ArticleFormatter::IconOption icon);
     QString formatFolder(Akregator::Folder *node);
     QString formatFeed(Akregator::Feed *feed);
+
+    /** renders a single article with a template that shows it in the variable "article" */
+    QString formatArticle(const Article &article, ArticleFormatter::IconOption icon);
+    /** renders a combined view page around already rendered articles */
+    QString formatCombinedPage(const QStringList &fragments, int generation, const QString &moreArticles);
+
+    /** drops all rendered articles kept by formatArticles(). Call this when settings used by the templates change */
+    void clearCache();
 private:
+    /** returns the key of @p article in the cache of rendered articles */
+    QString cacheKey(const Article &article, ArticleFormatter::IconOption icon) const;
+    /** makes @p fileName the main template unless it is already. Templates are parsed when they are set,
+        so alternating between templates is expensive. @return false if the template could not be loaded */
+    bool setMainTemplate(const QString &fileName);
     void addStandardObject(QVariantHash &grantleeObject);
+    void addArticleStrings(QVariantHash &grantleeObject);
     int pointsToPixel(int pointSize) const;
     QUrl mImageDir;
     QString mHtmlArticleFileName;
+    QString mCurrentHtmlFileName;
     QString mDirectionString;
     QString mGrantleeThemePath;
     int mDeviceDpiY;
+    /** articles rendered by formatArticles(), least recently used ones are dropped first. Costs are in kilobytes */
+    QCache<QString, QString> mArticleCache;
 };
 }
 
@@ -28,6 +28,7 @@
 #include "utils.h"
 #include "actionmanagerimpl.h"
 #include "addfeeddialog.h"
+#include "widgets/archivesearchdialog.h"
 #include "articlelistview.h"
 #include "articleviewerwidget.h"
 #include "abstractselectioncontroller.h"
@@ -36,6 +37,8 @@
 #include "akregatorconfig.h"
 #include "akregator_part.h"
 #include "Libkdepim/BroadcastStatus"
+#include "Libkdepim/ProgressManager"
+#include "compactarchivecommand.h"
 #include "createfeedcommand.h"
 #include "createfoldercommand.h"
 #include "deletesubscriptioncommand.h"
@@ -50,11 +53,13 @@
 #include "folder.h"
 #include "framemanager.h"
 #include "kernel.h"
+#include "storage.h"
 #include "notificationmanager.h"
 #include "openurlrequest.h"
 #include "progressmanager.h"
 #include "widgets/searchbar.h"
 #include "selectioncontroller.h"
+#include "startupprofile.h"
 #include "subscriptionlistjobs.h"
 #include "subscriptionlistmodel.h"
 #include "subscriptionlistview.h"
@@ -68,6 +73,7 @@
 
 #include <QAction>
 #include <kfileitem.h>
+#include <KFormat>
 #include <KLocalizedString>
 #include <kmessagebox.h>
 #include <krandom.h>
@@ -80,7 +86,6 @@
 #include <QNetworkConfigurationManager>
 #include <QSplitter>
 #include <QTextDocument>
-#include <QDomDocument>
 #include <QTimer>
 #include <QDesktopServices>
 #include <QUrlQuery>
@@ -334,6 +339,7 @@ void MainWidget::slotOnShutdown()
     }
 
     Kernel::self()->fetchQueue()->slotAbort();
+    StartupProfile::finishPostStartup();
     setFeedList(QSharedPointer<FeedList>());
 
     delete m_feedListManagementInterface;
@@ -443,11 +449,11 @@ void MainWidget::sendArticle(const QByteArray &text, const QString &title, bool
     }
 }
 
-void MainWidget::importFeedList(const QDomDocument &doc)
+void MainWidget::importFeedList(const QByteArray &opml)
 {
     ImportFeedListCommand *cmd = new ImportFeedListCommand;
     cmd->setParentWidget(this);
-    cmd->setFeedListDocument(doc);
+    cmd->setFeedListData(opml);
     cmd->setTargetList(m_feedList);
     cmd->start();
 }
@@ -470,7 +476,11 @@ void MainWidget::setFeedList(const QSharedPointer<FeedList> &list)
     m_feedListManagementInterface->setFeedList(m_feedList);
     Kernel::self()->setFeedList(m_feedList);
     ProgressManager::self()->setFeedList(m_feedList);
-    m_selectionController->setFeedList(m_feedList);
+    {
+        StartupProfile::Scope scope(StartupProfile::ModelBuild);
+        m_selectionController->setFeedList(m_feedList);
+    }
+    StartupProfile::finish();
 
     if (oldList) {
         oldList->disconnect(this);
@@ -496,13 +506,25 @@ void MainWidget::slotDeleteExpiredArticles()
     deleteExpiredArticles(m_feedList);
 }
 
-QDomDocument MainWidget::feedListToOPML()
+QByteArray MainWidget::feedListToOPML()
 {
-    QDomDocument dom;
+    QByteArray opml;
     if (m_feedList) {
-        dom = m_feedList->toOpml();
+        opml = m_feedList->toOpml();
+    }
+    return opml;
+}
+
+bool MainWidget::isFeedListModified() const
+{
+    return m_feedList && m_feedList->isModified();
+}
+
+void MainWidget::setFeedListModified(bool modified)
+{
+    if (m_feedList) {
+        m_feedList->setModified(modified);
     }
-    return dom;
 }
 
 void MainWidget::addFeedToGroup(const QString &url, const QString &groupName)
@@ -738,6 +760,49 @@ void MainWidget::slotFeedAddGroup()
     cmd->start();
 }
 
+void MainWidget::slotSearchArchive()
+{
+    ArchiveSearchDialog *dlg = new ArchiveSearchDialog(Kernel::self()->storage(), m_feedList, this);
+    dlg->setAttribute(Qt::WA_DeleteOnClose);
+    connect(dlg, &ArchiveSearchDialog::articleActivated, this, &MainWidget::slotShowArchivedArticle);
+    dlg->show();
+}
+
+void MainWidget::slotCompactArchive()
+{
+    CompactArchiveCommand *const cmd = new CompactArchiveCommand(this);
+    cmd->setParentWidget(this);
+    cmd->setStorage(Kernel::self()->storage());
+    cmd->setFeedList(m_feedList);
+
+    KPIM::ProgressItem *const progressItem = KPIM::ProgressManager::createProgressItem(KPIM::ProgressManager::getUniqueID(), i18n("Compacting archive"), QString(), true);
+    connect(progressItem, &KPIM::ProgressItem::progressItemCanceled, cmd, &Command::abort);
+    connect(cmd, &Command::progress, progressItem, [progressItem](int percent) {
+        progressItem->setProgress(percent);
+    });
+    connect(cmd, &Command::finished, this, [this, cmd, progressItem]() {
+        progressItem->setComplete();
+        const Backend::Storage::CompactionResult result = cmd->result();
+        const KFormat format;
+        KMessageBox::information(this,
+                                 i18np("Compacted one archive file from %2 to %3.",
+                                       "Compacted %1 archive files from %2 to %3.",
+                                       result.files,
+                                       format.formatByteSize(result.sizeBefore),
+                                       format.formatByteSize(result.sizeAfter)),
+                                 i18n("Archive Compacted"));
+    });
+    cmd->start();
+}
+
+void MainWidget::slotShowArchivedArticle(const QString &feedUrl, const QString &guid)
+{
+    const Article article = m_feedList->findArticle(feedUrl, guid);
+    if (!article.isNull()) {
+        m_articleViewer->showArticle(article);
+    }
+}
+
 void MainWidget::slotFeedRemove()
 {
     TreeNode *selectedNode = m_selectionController->selectedSubscription();
@@ -887,6 +952,7 @@ void MainWidget::slotArticleSelected(const Akregator::Article &article)
     maai->setChecked(article.keep());
 
     m_articleViewer->showArticle(article);
+    m_articleViewer->prefetchArticles(m_selectionController->neighbourArticles());
     if (m_selectionController->selectedArticles().isEmpty()) {
         m_articleListView->setCurrentIndex(m_selectionController->currentArticleIndex());
     }
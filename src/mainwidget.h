@@ -42,7 +42,7 @@
 class KConfig;
 class KConfigGroup;
 
-class QDomDocument;
+class QByteArray;
 class QNetworkConfigurationManager;
 class QSplitter;
 
@@ -84,14 +84,18 @@ public:
     /** saves settings. Make sure that the Settings singleton is not destroyed yet when saveSettings is called */
     void saveSettings();
 
-    /** Adds the feeds in @c doc to the "Imported Folder"
-    @param doc the DOM tree (OPML) of the feeds to import */
-    void importFeedList(const QDomDocument &doc);
+    /** Adds the feeds in @c opml to the "Imported Folder"
+    @param opml the OPML document of the feeds to import */
+    void importFeedList(const QByteArray &opml);
 
     /**
-     * @return the displayed Feed List in OPML format
+     * @return the displayed Feed List in OPML format, UTF-8 encoded
      */
-    QDomDocument feedListToOPML();
+    QByteArray feedListToOPML();
+
+    /** returns whether the displayed feed list changed since it was last saved */
+    bool isFeedListModified() const;
+    void setFeedListModified(bool modified);
 
     void setFeedList(const QSharedPointer<FeedList> &feedList);
 
@@ -184,6 +188,12 @@ public Q_SLOTS:
     /** opens the homepage of the currently selected feed */
     void slotOpenHomepage();
 
+    /** opens the full-text search over the articles of all feeds */
+    void slotSearchArchive();
+
+    /** rewrites the archive files without their unused space */
+    void slotCompactArchive();
+
     /** reloads all open tabs */
     void slotReloadAllTabs();
 
@@ -252,6 +262,7 @@ private Q_SLOTS:
     void slotCurrentFrameChanged(int frameId);
     void slotArticleAction(Akregator::ArticleViewerWebEngine::ArticleAction type, const QString &articleId, const QString &feed);
     void slotSettingsChanged();
+    void slotShowArchivedArticle(const QString &feedUrl, const QString &guid);
 
 private:
     void sendArticle(const QByteArray &text, const QString &title, bool attach);
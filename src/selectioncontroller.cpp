@@ -163,6 +163,32 @@ QVector<Akregator::Article> Akregator::SelectionController::selectedArticles() c
     return ::articlesForIndexes(m_articleLister->articleSelectionModel()->selectedRows(), m_feedList.data());
 }
 
+QVector<Akregator::Article> Akregator::SelectionController::neighbourArticles() const
+{
+    if (!m_articleLister || !m_articleLister->articleSelectionModel()) {
+        return QVector<Akregator::Article>();
+    }
+    const QModelIndex current = m_articleLister->articleSelectionModel()->currentIndex();
+    if (!current.isValid()) {
+        return QVector<Akregator::Article>();
+    }
+
+    QModelIndexList indexes;
+    indexes << current.sibling(current.row() + 1, 0) << current.sibling(current.row() - 1, 0);
+
+    const QAbstractItemModel *const model = current.model();
+    const int rowCount = model->rowCount(current.parent());
+    for (int row = current.row() + 2; row < rowCount; ++row) {
+        const QModelIndex index = model->index(row, 0, current.parent());
+        if (index.data(ArticleModel::StatusRole).toInt() != Akregator::Read) {
+            indexes << index;
+            break;
+        }
+    }
+
+    return ::articlesForIndexes(indexes, m_feedList.data());
+}
+
 Akregator::TreeNode *Akregator::SelectionController::selectedSubscription() const
 {
     return ::subscriptionForIndex(m_feedSelector->selectionModel()->currentIndex(), m_feedList.data());
@@ -60,6 +60,9 @@ public:
     //impl
     QVector<Akregator::Article> selectedArticles() const override;
 
+    //impl
+    QVector<Akregator::Article> neighbourArticles() const override;
+
     //impl
     void setSingleArticleDisplay(Akregator::SingleArticleDisplay *display) override;
 
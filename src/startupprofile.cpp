@@ -0,0 +1,157 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "startupprofile.h"
+#include "akregator_startup_debug.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+using namespace Akregator;
+
+namespace {
+struct PhaseTotal {
+    qint64 nsecs;
+    int calls;
+    int items;
+};
+
+struct Profile {
+    /** set from start() until finishPostStartup() */
+    bool enabled;
+    /** set from start() until finish() */
+    bool running;
+    QElapsedTimer timer;
+    PhaseTotal phases[StartupProfile::PhaseCount];
+    PhaseTotal postStartupPhases[StartupProfile::PhaseCount];
+};
+
+Profile profile = { false, false, QElapsedTimer(), {}, {} };
+
+const char *const phaseNames[StartupProfile::PhaseCount] = {
+    "opmlParse",
+    "archiveOpen",
+    "articleLoad",
+    "unreadRecount",
+    "modelBuild"
+};
+
+QString traceFileName()
+{
+    return QString::fromLocal8Bit(qgetenv("AKREGATOR_STARTUP_TRACE"));
+}
+
+void report(const QString &event, const PhaseTotal *totals)
+{
+    QJsonObject phases;
+    for (int i = 0; i < StartupProfile::PhaseCount; ++i) {
+        QJsonObject phase;
+        phase.insert(QStringLiteral("ms"), totals[i].nsecs / 1000000.0);
+        phase.insert(QStringLiteral("calls"), totals[i].calls);
+        phase.insert(QStringLiteral("items"), totals[i].items);
+        phases.insert(QLatin1String(phaseNames[i]), phase);
+    }
+
+    QJsonObject object;
+    object.insert(QStringLiteral("event"), event);
+    object.insert(QStringLiteral("totalMs"), profile.timer.nsecsElapsed() / 1000000.0);
+    object.insert(QStringLiteral("phases"), phases);
+    const QByteArray line = QJsonDocument(object).toJson(QJsonDocument::Compact);
+
+    qCInfo(AKREGATOR_STARTUP_LOG).noquote() << QString::fromUtf8(line);
+
+    const QString fileName = traceFileName();
+    if (!fileName.isEmpty()) {
+        QFile file(fileName);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            file.write(line + '\n');
+        }
+    }
+}
+}
+
+StartupProfile::Scope::Scope(Phase phase) : m_phase(phase)
+    , m_items(0)
+{
+    if (profile.enabled) {
+        m_timer.start();
+    }
+}
+
+StartupProfile::Scope::~Scope()
+{
+    // started before the profile, or the profile was finished meanwhile
+    if (!profile.enabled || !m_timer.isValid()) {
+        return;
+    }
+    PhaseTotal &total = profile.running ? profile.phases[m_phase] : profile.postStartupPhases[m_phase];
+    total.nsecs += m_timer.nsecsElapsed();
+    ++total.calls;
+    total.items += m_items;
+}
+
+void StartupProfile::Scope::setItems(int items)
+{
+    m_items = items;
+}
+
+void StartupProfile::start()
+{
+    // a feed list loaded again, e.g. after an import, ends the previous profile
+    finishPostStartup();
+
+    profile.enabled = AKREGATOR_STARTUP_LOG().isInfoEnabled() || !traceFileName().isEmpty();
+    profile.running = profile.enabled;
+    if (!profile.enabled) {
+        return;
+    }
+    for (int i = 0; i < PhaseCount; ++i) {
+        profile.phases[i] = PhaseTotal();
+        profile.postStartupPhases[i] = PhaseTotal();
+    }
+    profile.timer.start();
+}
+
+void StartupProfile::finish()
+{
+    if (!profile.running) {
+        return;
+    }
+    profile.running = false;
+    report(QStringLiteral("startup"), profile.phases);
+    profile.timer.start();
+}
+
+void StartupProfile::finishPostStartup()
+{
+    if (!profile.enabled || profile.running) {
+        return;
+    }
+    profile.enabled = false;
+    report(QStringLiteral("postStartup"), profile.postStartupPhases);
+}
+
+bool StartupProfile::isRunning()
+{
+    return profile.running;
+}
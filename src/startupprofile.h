@@ -0,0 +1,85 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef AKREGATOR_STARTUPPROFILE_H
+#define AKREGATOR_STARTUPPROFILE_H
+
+#include "akregator_export.h"
+
+#include <QElapsedTimer>
+
+namespace Akregator {
+/** Measures the phases of loading the feed list, from reading the OPML file until the
+    subscription model is set up, and reports them as one JSON object per startup.
+
+    Feeds load their archives and articles on first use, which is mostly after startup. Those
+    phases are collected separately from the finished startup and reported as a second
+    "postStartup" object by finishPostStartup().
+
+    The reports are written to the org.kde.pim.akregator.startup logging category at info level,
+    and appended as one line to the file named by the AKREGATOR_STARTUP_TRACE environment variable.
+    When neither is enabled, nothing is measured. */
+class AKREGATOR_EXPORT StartupProfile
+{
+public:
+
+    enum Phase {
+        OpmlParse = 0, /**< streaming the OPML file, which creates the feeds and folders as it goes */
+        ArchiveOpen, /**< opening the archives of feeds, usually post-startup */
+        ArticleLoad, /**< creating the articles of feeds from their archives, usually post-startup */
+        UnreadRecount, /**< recounting unread articles of loaded feeds, usually post-startup */
+        ModelBuild, /**< setting up the subscription list model */
+        PhaseCount
+    };
+
+    /** measures the time spent until it goes out of scope */
+    class AKREGATOR_EXPORT Scope
+    {
+    public:
+        explicit Scope(Phase phase);
+        ~Scope();
+
+        /** the number of items (feeds, articles...) handled in this scope */
+        void setItems(int items);
+
+    private:
+        Q_DISABLE_COPY(Scope)
+        QElapsedTimer m_timer;
+        const Phase m_phase;
+        int m_items;
+    };
+
+    /** starts a new profile, discarding one that was not finished */
+    static void start();
+
+    /** reports the collected startup profile. Phases measured from now on are post-startup */
+    static void finish();
+
+    /** reports the phases measured since finish() and stops measuring */
+    static void finishPostStartup();
+
+    /** whether the startup is being measured, i.e. start() was called and finish() was not */
+    static bool isRunning();
+};
+} // namespace Akregator
+
+#endif // AKREGATOR_STARTUPPROFILE_H
@@ -46,6 +46,7 @@ public:
     bool articleChangeOccurred;
     QString title;
     Folder *parent;
+    int index;
     uint id;
     bool signalDestroyedEmitted;
     QPoint scrollBarPositions;
@@ -56,6 +57,7 @@ TreeNode::TreeNodePrivate::TreeNodePrivate() : doNotify(true)
     , articleChangeOccurred(false)
     , title()
     , parent(0)
+    , index(-1)
     , id(0)
     , signalDestroyedEmitted(false)
 {
@@ -95,50 +97,28 @@ void TreeNode::setTitle(const QString &title)
     if (d->title != title) {
         d->title = title;
         nodeModified();
+        propertiesModified();
     }
 }
 
 TreeNode *TreeNode::nextSibling()
 {
-    if (!d->parent) {
-        return nullptr;
-    }
-    const QList<TreeNode *> children = parent()->children();
-    const int idx = children.indexOf(this);
-
-    return (idx + 1 < children.size()) ? children.at(idx + 1) : nullptr;
+    return d->parent ? d->parent->childAt(d->index + 1) : nullptr;
 }
 
 const TreeNode *TreeNode::nextSibling() const
 {
-    if (!d->parent) {
-        return nullptr;
-    }
-    const QList<const TreeNode *> children = parent()->children();
-    const int idx = children.indexOf(this);
-
-    return (idx + 1 < children.size()) ? children.at(idx + 1) : nullptr;
+    return d->parent ? static_cast<const Folder *>(d->parent)->childAt(d->index + 1) : nullptr;
 }
 
 TreeNode *TreeNode::prevSibling()
 {
-    if (!d->parent) {
-        return nullptr;
-    }
-    const QList<TreeNode *> children = parent()->children();
-
-    const int idx = children.indexOf(this);
-    return (idx > 0) ? children.at(idx - 1) : nullptr;
+    return d->parent ? d->parent->childAt(d->index - 1) : nullptr;
 }
 
 const TreeNode *TreeNode::prevSibling() const
 {
-    if (!d->parent) {
-        return nullptr;
-    }
-    const QList<const TreeNode *> children = parent()->children();
-    const int idx = children.indexOf(this);
-    return (idx > 0) ? children.at(idx - 1) : nullptr;
+    return d->parent ? static_cast<const Folder *>(d->parent)->childAt(d->index - 1) : nullptr;
 }
 
 const Folder *TreeNode::parent() const
@@ -178,6 +158,16 @@ void TreeNode::setParent(Folder *parent)
     d->parent = parent;
 }
 
+int TreeNode::indexInParent() const
+{
+    return d->index;
+}
+
+void TreeNode::setIndexInParent(int index)
+{
+    d->index = index;
+}
+
 void TreeNode::setNotificationMode(bool doNotify)
 {
     if (doNotify && !d->doNotify) { // turned on
@@ -216,6 +206,11 @@ void TreeNode::nodeModified()
     }
 }
 
+void TreeNode::propertiesModified()
+{
+    Q_EMIT signalPropertiesChanged(this);
+}
+
 void TreeNode::articlesModified()
 {
     if (d->doNotify) {
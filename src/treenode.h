@@ -31,12 +31,11 @@
 
 class KJob;
 
-class QDomDocument;
-class QDomElement;
 class QIcon;
 class QPoint;
 class QString;
 class QStringList;
+class QXmlStreamWriter;
 template<class T> class QList;
 
 namespace Akregator {
@@ -144,10 +143,9 @@ public:
     virtual bool isAggregation() const = 0;
 
     /** exports node and child nodes to OPML (with akregator settings)
-        @param parent the dom element the child node will be attached to
-        @param document the opml document */
+        @param writer the writer, positioned inside the parent outline or body element */
 
-    virtual QDomElement toOPML(QDomElement parent, QDomDocument document) const = 0;
+    virtual void toOPML(QXmlStreamWriter &writer) const = 0;
 
     /**
     @param doNotify notification on changes on/off flag
@@ -189,6 +187,9 @@ Q_SIGNALS:
     /** Notification mechanism: emitted, when the node was modified and notification is enabled. A node change is renamed title, icon, unread count. Added, updated or removed articles are not notified via this signal */
     void signalChanged(Akregator::TreeNode *);
 
+    /** emitted when a property saved to the feed list (title, URLs, folder state, per-feed settings) changed. Unlike signalChanged(), this is not emitted for unread count or icon changes */
+    void signalPropertiesChanged(Akregator::TreeNode *);
+
     /** emitted when new articles were added to this node or any node in the subtree (for folders). Note that this has nothing to do with fetching, the article might have been moved from somewhere else in the tree into this subtree, e.g. by moving the feed the article is in.
         @param TreeNode* the node articles were added to
         @param QStringList the guids of the articles added
@@ -208,6 +209,9 @@ protected:
      Will do notification immediately or cache it, depending on @c m_doNotify. */
     virtual void nodeModified();
 
+    /** call this if a property that is saved to the feed list was changed. Emits signalPropertiesChanged() immediately, regardless of the notification mode */
+    void propertiesModified();
+
     /** call this if the articles in the node were changed. Sends signalArticlesAdded/Updated/Removed signals
      Will do notification immediately or cache it, depending on @c m_doNotify. */
     virtual void articlesModified();
@@ -226,6 +230,10 @@ private:
     virtual QVector<Article> articles() = 0;
 
 private:
+    /** position of the node among its siblings, maintained by the parent Folder */
+    int indexInParent() const;
+    void setIndexInParent(int index);
+
     class TreeNodePrivate;
     TreeNodePrivate *d;
 };
@@ -123,6 +123,8 @@ QString ActionURLHandlerWebEngine::statusBarMessage(const QUrl &url, ArticleView
             return i18n("Share");
         } else if (urlPath == QLatin1String("openInBackgroundTab")) {
             return i18n("Open In Background Tab");
+        } else if (urlPath == QLatin1String("showMoreArticles")) {
+            return i18n("Show More Articles");
         }
         return {};
     }
@@ -133,6 +135,10 @@ bool ActionURLHandlerWebEngine::handleClick(const QUrl &url, ArticleViewerWebEng
 {
     if (url.scheme() == QLatin1String("akregatoraction")) {
         const QString urlPath(url.path());
+        if (urlPath == QLatin1String("showMoreArticles")) {
+            articleViewer->showMoreArticles();
+            return true;
+        }
         if (url.hasQuery()) {
             const QUrlQuery urlQuery(url);
             const QString articleId = urlQuery.queryItemValue(QStringLiteral("id"));
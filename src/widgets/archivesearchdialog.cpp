@@ -0,0 +1,137 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "archivesearchdialog.h"
+#include "feed.h"
+#include "feedlist.h"
+#include "storage.h"
+
+#include <KLocalizedString>
+#include <QDateTime>
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QLineEdit>
+#include <QLocale>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+using namespace Akregator;
+
+namespace {
+const int maxHits = 200;
+const int searchDelay = 300; // ms
+
+enum Column {
+    TitleColumn = 0,
+    FeedColumn,
+    DateColumn
+};
+
+enum Role {
+    FeedUrlRole = Qt::UserRole,
+    GuidRole
+};
+}
+
+ArchiveSearchDialog::ArchiveSearchDialog(Backend::Storage *storage, const QSharedPointer<FeedList> &feedList, QWidget *parent)
+    : QDialog(parent)
+    , m_storage(storage)
+    , m_feedList(feedList)
+{
+    setWindowTitle(i18n("Search Archive"));
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    m_searchLine = new QLineEdit(this);
+    m_searchLine->setClearButtonEnabled(true);
+    m_searchLine->setPlaceholderText(i18n("Search articles of all feeds..."));
+    mainLayout->addWidget(m_searchLine);
+
+    m_results = new QTreeWidget(this);
+    m_results->setRootIsDecorated(false);
+    m_results->setUniformRowHeights(true);
+    m_results->setHeaderLabels(QStringList() << i18n("Title") << i18n("Feed") << i18n("Date"));
+    m_results->header()->setSectionResizeMode(TitleColumn, QHeaderView::Stretch);
+    m_results->header()->setStretchLastSection(false);
+    mainLayout->addWidget(m_results);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &ArchiveSearchDialog::reject);
+    mainLayout->addWidget(buttonBox);
+
+    // searching on every keystroke would query the index for every prefix of a word
+    m_searchTimer = new QTimer(this);
+    m_searchTimer->setSingleShot(true);
+    m_searchTimer->setInterval(searchDelay);
+    connect(m_searchTimer, &QTimer::timeout, this, &ArchiveSearchDialog::slotSearch);
+    connect(m_searchLine, &QLineEdit::textChanged, m_searchTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(m_searchLine, &QLineEdit::returnPressed, this, &ArchiveSearchDialog::slotSearch);
+    connect(m_results, &QTreeWidget::itemActivated, this, &ArchiveSearchDialog::slotItemActivated);
+
+    m_searchLine->setFocus();
+}
+
+ArchiveSearchDialog::~ArchiveSearchDialog()
+{
+}
+
+QSize ArchiveSearchDialog::sizeHint() const
+{
+    return QSize(700, 450);
+}
+
+void ArchiveSearchDialog::slotSearch()
+{
+    m_searchTimer->stop();
+    m_results->clear();
+    if (!m_storage || !m_feedList) {
+        return;
+    }
+
+    const QVector<Backend::Storage::SearchHit> hits = m_storage->search(m_searchLine->text(), maxHits);
+    QList<QTreeWidgetItem *> items;
+    items.reserve(hits.count());
+    for (const Backend::Storage::SearchHit &hit : hits) {
+        // the archive may still contain articles of feeds that were removed from the feed list
+        const Feed *const feed = m_feedList->findByURL(hit.feedUrl);
+        if (!feed) {
+            continue;
+        }
+        Backend::FeedStorage::ArticleRecord record;
+        if (!m_storage->archiveFor(hit.feedUrl)->readRecord(hit.guid, record, Backend::FeedStorage::ArticleRecord::Title | Backend::FeedStorage::ArticleRecord::PubDate)) {
+            continue;
+        }
+        QTreeWidgetItem *item = new QTreeWidgetItem;
+        item->setText(TitleColumn, record.title);
+        item->setText(FeedColumn, feed->title());
+        item->setText(DateColumn, QLocale().toString(QDateTime::fromTime_t(record.pubDate), QLocale::ShortFormat));
+        item->setData(TitleColumn, FeedUrlRole, hit.feedUrl);
+        item->setData(TitleColumn, GuidRole, hit.guid);
+        items.append(item);
+    }
+    m_results->addTopLevelItems(items);
+}
+
+void ArchiveSearchDialog::slotItemActivated(QTreeWidgetItem *item)
+{
+    Q_EMIT articleActivated(item->data(TitleColumn, FeedUrlRole).toString(), item->data(TitleColumn, GuidRole).toString());
+}
@@ -0,0 +1,71 @@
+/*
+    This file is part of Akregator.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef AKREGATOR_ARCHIVESEARCHDIALOG_H
+#define AKREGATOR_ARCHIVESEARCHDIALOG_H
+
+#include <QDialog>
+#include <QSharedPointer>
+
+class QLineEdit;
+class QTimer;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+namespace Akregator {
+class FeedList;
+
+namespace Backend {
+class Storage;
+}
+
+/**
+ * Searches the full-text index of the article archive, including articles of feeds
+ * that are not selected, and lists the best matches.
+ */
+class ArchiveSearchDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    ArchiveSearchDialog(Backend::Storage *storage, const QSharedPointer<FeedList> &feedList, QWidget *parent = nullptr);
+    ~ArchiveSearchDialog();
+
+    QSize sizeHint() const override;
+
+Q_SIGNALS:
+    /** emitted when the user activates a hit */
+    void articleActivated(const QString &feedUrl, const QString &guid);
+
+private Q_SLOTS:
+    void slotSearch();
+    void slotItemActivated(QTreeWidgetItem *item);
+
+private:
+    Backend::Storage *m_storage;
+    QSharedPointer<FeedList> m_feedList;
+    QLineEdit *m_searchLine;
+    QTreeWidget *m_results;
+    QTimer *m_searchTimer;
+};
+} // namespace Akregator
+
+#endif // AKREGATOR_ARCHIVESEARCHDIALOG_H
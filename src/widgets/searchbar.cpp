@@ -199,8 +199,9 @@ void SearchBar::slotActivateSearch()
 
     std::vector<QSharedPointer<const AbstractMatcher> > matchers;
 
-    matchers.push_back(QSharedPointer<const AbstractMatcher>(new ArticleMatcher(textCriteria, ArticleMatcher::LogicalOr)));
+    // the status matcher does not need the archive, let it reject articles first
     matchers.push_back(QSharedPointer<const AbstractMatcher>(new ArticleMatcher(statusCriteria, ArticleMatcher::LogicalOr)));
+    matchers.push_back(QSharedPointer<const AbstractMatcher>(new ArticleMatcher(textCriteria, ArticleMatcher::LogicalOr)));
     Settings::setStatusFilter(d->searchLine->status());
     Settings::setTextFilter(d->searchText);
     d->matchers = matchers;